@@ -0,0 +1,211 @@
+/*
+ * acc_caustics.c: accuracy of the caustic ring kernels against the long
+ * double reference in caustic_ref.h
+ *
+ * For each kernel and point distribution of caustic_samples.h the relative
+ * error of every evaluation is measured, and the maximum and RMS reported:
+ *
+ *   tvals     flow times T of the closed form T1..T4 (caustics.h)
+ *   mwtvals   flow times from getTVals (Milkyway@Home)
+ *   close     gfield_close, error in |(g_rho,g_z)|
+ *   far       gfield_far, idem
+ *   pot       apply_caustic_pot_double, worst of |acc| and pot
+ *   mw        causticHaloAccel (Milkyway@Home), error in |acc|
+ *
+ * For the flow times, points where the kernel finds a different number of
+ * real roots than the reference are counted as misses (nmiss), and not
+ * included in the error statistics. Use the edge distribution, with its
+ * points piled up against the envelopes, to stress the root finders.
+ *
+ * Output columns: kernel dist nsample max_rel rms_rel nmiss and the worst
+ * point (n rho z). With tol= the program fails if any max_rel exceeds it.
+ *
+ * 19-oct-2026  V1.0  created
+ */
+
+#include <stdinc.h>
+#include <getparam.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../caustics.h"
+#include "caustic_samples.h"
+#include "caustic_ref.h"
+
+string defv[] = {
+  "nsample=100000\n Points per distribution",
+  "kernels=tvals,mwtvals,close,far,pot,mw\n  Kernels to check",
+  "dists=far,envelope,edge,cusp,axis\n    Point distributions to use",
+  "out=-\n          Table of errors",
+  "tol=\n           If given, fail when a max_rel exceeds this",
+  "seed=123\n       Random seed",
+  "VERSION=1.0\n    19-oct-2026",
+  NULL,
+};
+
+string usage = "accuracy of the caustic ring halo kernels against a long double reference";
+
+/* the Milkyway@Home kernels, from mw_caustic.c */
+extern void mw_halo_accel(const double *pos, double *acc);
+extern int  mw_tvals(double rho, double z, int n, double *T);
+
+#define MISS  -1.0     /* error value flagging a different number of roots */
+
+/* relative error of vector a against reference b, both of length n */
+local double relerr(int n, double *a, long double *b)
+{
+  long double d = 0.0L, r = 0.0L;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    d += (a[i] - b[i]) * (a[i] - b[i]);
+    r += b[i] * b[i];
+  }
+  if (isnan((double) d)) return HUGE_VAL;
+  return r > 0.0L ? (double) sqrtl(d / r) : (double) sqrtl(d);
+}
+
+local double roots_err(int count, double *T, int rcount, long double *R)
+{
+  double err = 0.0, e;
+  int i;
+
+  if (count != rcount) return MISS;
+  for (i = 0; i < count; i++) {
+    e = fabs(T[i] - R[i]) / fmax(1.0, fabs((double) R[i]));
+    if (!(e <= err)) err = isnan(e) ? HUGE_VAL : e;
+  }
+  return err;
+}
+
+/* closed form flow times, selected and sorted as in gfield_close() */
+local int cf_tvals(double rho, double z, int n, double *T)
+{
+  double complex x = (rho - a_n[n]) / p_n[n], zs = z / p_n[n];
+  double complex t[4];
+  double tmp;
+  int i, j, count;
+
+  t[0] = T1(x, zs);
+  t[1] = T2(x, zs);
+  t[2] = T3(x, zs);
+  t[3] = T4(x, zs);
+  for (i = 0, count = 0; i < 4; i++)
+    if (fabs(cimag(t[i])) < TOLERANCE_caustics)
+      T[count++] = creal(t[i]);
+  for (i = 0; i < count - 1; i++)
+    for (j = i + 1; j < count; j++)
+      if (T[i] > T[j]) {
+        tmp = T[i];
+        T[i] = T[j];
+        T[j] = tmp;
+      }
+  return count;
+}
+
+local double check(string kernel, sample *s)
+{
+  double T[4], g[4] = {0, 0, 0, 0};
+  long double R[4], ref[4] = {0, 0, 0, 0};
+  double e1, e2;
+
+  if (streq(kernel, "tvals") || streq(kernel, "mwtvals")) {
+    int count = streq(kernel, "tvals") ? cf_tvals(s->rho, s->z, s->n, T)
+                                       : mw_tvals(s->rho, s->z, s->n, T);
+    return roots_err(count, T, ref_tvals(s->rho, s->z, s->n, R), R);
+  } else if (streq(kernel, "close")) {
+    gfield_close(s->rho, s->z, s->n, &g[0], &g[1]);
+    ref_gfield_close(s->rho, s->z, s->n, &ref[0], &ref[1]);
+    return relerr(2, g, ref);
+  } else if (streq(kernel, "far")) {
+    gfield_far(s->rho, s->z, s->n, &g[0], &g[1]);
+    ref_gfield_far(s->rho, s->z, s->n, &ref[0], &ref[1]);
+    return relerr(2, g, ref);
+  } else if (streq(kernel, "pot")) {
+    apply_caustic_pot_double(s->pos, g, &g[3]);
+    ref_caustic_pot(s->pos, ref, &ref[3]);
+    e1 = relerr(3, g, ref);
+    e2 = relerr(1, &g[3], &ref[3]);
+    return MAX(e1, e2);
+  } else if (streq(kernel, "mw")) {
+    mw_halo_accel(s->pos, g);
+    ref_caustic_pot(s->pos, ref, &ref[3]);
+    return relerr(3, g, ref);
+  }
+  error("Unknown kernel %s", kernel);
+  return 0.0;
+}
+
+local bool in_list(string *list, string word)
+{
+  for (; *list; list++)
+    if (streq(*list, word)) return TRUE;
+  return FALSE;
+}
+
+local string kernels[] = { "tvals", "mwtvals", "close", "far", "pot", "mw", NULL };
+
+void nemo_main(void)
+{
+  int ns = getiparam("nsample"), i, j, k, nmiss, nused, iworst, nfail = 0;
+  string *klist = burststring(getparam("kernels"), ", ");
+  string *dlist = burststring(getparam("dists"), ", ");
+  string stol = getparam("tol");
+  bool Qtol = *stol != 0;
+  real tol = Qtol ? natof(stol) : 0.0;
+  double emax, esum2, *err;
+  stream outstr;
+  sample *s;
+
+  for (i = 0; klist[i]; i++)
+    if (!in_list(kernels, klist[i])) error("Unknown kernel %s", klist[i]);
+  init_xrandom(getparam("seed"));
+  s = (sample *) allocate(ns * sizeof(sample));
+  err = (double *) allocate(ns * sizeof(double));
+
+  outstr = stropen(getparam("out"), "w");
+  fprintf(outstr, "# acc_caustics nsample=%d\n", ns);
+  fprintf(outstr, "# kernel  dist     nsample   max_rel    rms_rel  nmiss  worst: n rho z\n");
+
+  for (j = 0; dists[j]; j++) {
+    if (!in_list(dlist, dists[j])) continue;
+    make_samples(dists[j], ns, s);
+    for (k = 0; kernels[k]; k++) {
+      if (!in_list(klist, kernels[k])) continue;
+      if (!streq(kernels[k], "far") && !streq(kernels[k], "pot") && !streq(kernels[k], "mw")
+          && (streq(dists[j], "far") || streq(dists[j], "axis")))
+        continue;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+      for (i = 0; i < ns; i++)
+        err[i] = check(kernels[k], &s[i]);
+
+      emax = esum2 = 0.0;
+      nmiss = nused = 0;
+      iworst = 0;
+      for (i = 0; i < ns; i++) {
+        if (err[i] == MISS) {
+          nmiss++;
+          continue;
+        }
+        nused++;
+        esum2 += err[i] * err[i];
+        if (err[i] > emax) {
+          emax = err[i];
+          iworst = i;
+        }
+      }
+      fprintf(outstr, "%-8s %-8s %8d %10.3e %10.3e %6d  %2d %.10g %.10g\n",
+              kernels[k], dists[j], ns, emax, nused > 0 ? sqrt(esum2 / nused) : 0.0,
+              nmiss, s[iworst].n, s[iworst].rho, s[iworst].z);
+      if (Qtol && emax > tol) {
+        warning("%s on %s: max relative error %g > tol=%g", kernels[k], dists[j], emax, tol);
+        nfail++;
+      }
+    }
+  }
+  strclose(outstr);
+  if (nfail > 0)
+    error("%d kernel/distribution pairs exceed tol=%g", nfail, tol);
+}
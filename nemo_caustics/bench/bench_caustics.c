@@ -0,0 +1,254 @@
+/*
+ * bench_caustics.c: micro-benchmarks for the caustic ring halo kernels
+ *
+ * Times apply_caustic_pot_double, gfield_close and gfield_far (caustics.h),
+ * and getTVals and causticHaloAccel (Milkyway@Home, see mw_caustic.c) over
+ * the point distributions of caustic_samples.h (far, envelope, edge, cusp,
+ * axis), for a range of thread counts. The result is a plain table that
+ * can be kept as a baseline and compared against later (baseline=), so
+ * optimizations and regressions show up as ratios.
+ *
+ * Output columns: kernel dist threads nsample ns/eval evals/s/core speedup
+ * where ns/eval and evals/s are per core, and speedup is relative to the
+ * first thread count in threads=.
+ *
+ * 19-oct-2026  V1.0  created
+ * 19-oct-2026  V1.1  sampling moved to caustic_samples.h, added edge
+ * 19-oct-2026  V1.1a nrep < 1 is an error
+ */
+
+#include <stdinc.h>
+#include <getparam.h>
+#include <unistd.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../caustics.h"
+#include "caustic_samples.h"
+
+string defv[] = {
+  "nsample=20000\n  Points per distribution",
+  "nrep=3\n         Repeat each timing, the fastest is kept",
+  "threads=\n       Thread counts for the scaling curve [1,2,4,... all cores]",
+  "kernels=pot,close,far,tvals,mw\n  Kernels to time",
+  "dists=far,envelope,edge,cusp,axis\n    Point distributions to use",
+  "out=-\n          Table of timings (use as a later baseline)",
+  "baseline=\n      Compare with this earlier out= table",
+  "tol=0.2\n        Fractional increase in ns/eval reported as regression",
+  "seed=123\n       Random seed",
+  "VERSION=1.1a\n   19-oct-2026",
+  NULL,
+};
+
+string usage = "benchmark the caustic ring halo kernels";
+
+#define MAXTHREADS 256
+#define MAXBASE    1024
+
+/* the Milkyway@Home kernels, from mw_caustic.c */
+extern void mw_halo_accel(const double *pos, double *acc);
+extern int  mw_tvals(double rho, double z, int n, double *T);
+
+typedef double (*kernel)(sample *);
+
+local double k_pot(sample *s)
+{
+  double acc[3] = {0,0,0}, pot = 0;
+  apply_caustic_pot_double(s->pos, acc, &pot);
+  return acc[0] + acc[2] + pot;
+}
+
+local double k_close(sample *s)
+{
+  double rf = 0, zf = 0;
+  gfield_close(s->rho, s->z, s->n, &rf, &zf);
+  return rf + zf;
+}
+
+local double k_far(sample *s)
+{
+  double rf = 0, zf = 0;
+  gfield_far(s->rho, s->z, s->n, &rf, &zf);
+  return rf + zf;
+}
+
+local double k_tvals(sample *s)
+{
+  double T[4];
+  return mw_tvals(s->rho, s->z, s->n, T) + T[0];
+}
+
+local double k_mw(sample *s)
+{
+  double acc[3];
+  mw_halo_accel(s->pos, acc);
+  return acc[0] + acc[2];
+}
+
+local struct {
+  string name;
+  kernel fn;
+  bool near_only;       /* only meaningful inside an envelope */
+} kernels[] = {
+  { "pot",   k_pot,   FALSE },
+  { "close", k_close, TRUE  },
+  { "far",   k_far,   FALSE },
+  { "tvals", k_tvals, TRUE  },
+  { "mw",    k_mw,    FALSE },
+  { NULL,    NULL,    FALSE },
+};
+
+local double wallclock(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/* best wall time of nrep passes over all samples, with nthreads threads */
+local double time_kernel(kernel fn, sample *s, int ns, int nthreads, int nrep, double *sum)
+{
+  int i, rep;
+  double t0, dt, best = -1.0, acc = 0.0;
+
+  for (rep = 0; rep < nrep; rep++) {
+    acc = 0.0;
+    t0 = wallclock();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nthreads) schedule(static) reduction(+:acc)
+#endif
+    for (i = 0; i < ns; i++)
+      acc += fn(&s[i]);
+    dt = wallclock() - t0;
+    if (best < 0 || dt < best) best = dt;
+  }
+  *sum = acc;
+  return best;
+}
+
+/* a previous out= table, for baseline= comparisons */
+local struct {
+  char kernel[16], dist[16];
+  int threads;
+  double ns;
+} base[MAXBASE];
+local int nbase = 0;
+
+local void read_baseline(string name)
+{
+  stream fp = stropen(name, "r");
+  char line[256];
+  int ns;
+
+  while (fgets(line, sizeof(line), fp)) {
+    if (line[0] == '#') continue;
+    if (nbase == MAXBASE) {
+      warning("Only %d baseline entries used", MAXBASE);
+      break;
+    }
+    if (sscanf(line, "%15s %15s %d %d %lf", base[nbase].kernel, base[nbase].dist,
+               &base[nbase].threads, &ns, &base[nbase].ns) == 5)
+      nbase++;
+  }
+  strclose(fp);
+  dprintf(1, "Read %d baseline entries from %s\n", nbase, name);
+}
+
+local double find_baseline(string k, string d, int t)
+{
+  int i;
+
+  for (i = 0; i < nbase; i++)
+    if (streq(base[i].kernel, k) && streq(base[i].dist, d) && base[i].threads == t)
+      return base[i].ns;
+  return -1.0;
+}
+
+local bool in_list(string *list, string word)
+{
+  for (; *list; list++)
+    if (streq(*list, word)) return TRUE;
+  return FALSE;
+}
+
+void nemo_main(void)
+{
+  int ns = getiparam("nsample"), nrep = getiparam("nrep");
+  int nthreads[MAXTHREADS], nt, ncpu = 1, i, j, k, nreg = 0;
+  string *klist = burststring(getparam("kernels"), ", ");
+  string *dlist = burststring(getparam("dists"), ", ");
+  real tol = getrparam("tol");
+  double t, t1, sum, old, nspe;
+  char host[64];
+  stream outstr;
+  sample *s;
+
+  if (nrep < 1) error("nrep=%d must be at least 1", nrep);
+#ifdef _OPENMP
+  ncpu = omp_get_num_procs();
+#endif
+  if (hasvalue("threads")) {
+    nt = nemoinpi(getparam("threads"), nthreads, MAXTHREADS);
+    if (nt < 1) error("Bad threads=%s", getparam("threads"));
+  } else {
+    for (nt = 0, k = 1; k < ncpu && nt < MAXTHREADS-1; k *= 2)
+      nthreads[nt++] = k;
+    nthreads[nt++] = ncpu;
+  }
+#ifndef _OPENMP
+  for (i = 0; i < nt; i++)
+    if (nthreads[i] != 1) {
+      warning("Not compiled with OpenMP, only threads=1 is timed");
+      nthreads[0] = 1;
+      nt = 1;
+      break;
+    }
+#endif
+  if (hasvalue("baseline")) read_baseline(getparam("baseline"));
+
+  init_xrandom(getparam("seed"));
+  s = (sample *) allocate(ns * sizeof(sample));
+  gethostname(host, sizeof(host));
+  host[sizeof(host)-1] = 0;
+
+  outstr = stropen(getparam("out"), "w");
+  fprintf(outstr, "# bench_caustics host=%s ncpu=%d nsample=%d nrep=%d\n",
+          host, ncpu, ns, nrep);
+  fprintf(outstr, "# kernel dist threads nsample ns/eval evals/s/core speedup\n");
+
+  for (j = 0; dists[j]; j++) {
+    if (!in_list(dlist, dists[j])) continue;
+    make_samples(dists[j], ns, s);
+    for (k = 0; kernels[k].name; k++) {
+      if (!in_list(klist, kernels[k].name)) continue;
+      if (kernels[k].near_only && (streq(dists[j], "far") || streq(dists[j], "axis")))
+        continue;
+      t1 = 0.0;
+      for (i = 0; i < nt; i++) {
+        t = time_kernel(kernels[k].fn, s, ns, nthreads[i], nrep, &sum);
+        if (i == 0) t1 = t;
+        nspe = 1e9 * t * nthreads[i] / ns;
+        fprintf(outstr, "%-6s %-8s %3d %d %10.2f %12.4g %6.2f\n",
+                kernels[k].name, dists[j], nthreads[i], ns,
+                nspe, 1e9 / nspe, t1 / t);
+        dprintf(1, "%s %s %d: checksum %g\n", kernels[k].name, dists[j], nthreads[i], sum);
+        if (nbase > 0) {
+          old = find_baseline(kernels[k].name, dists[j], nthreads[i]);
+          if (old <= 0) continue;
+          dprintf(0, "%-6s %-8s %3d  %10.2f -> %10.2f ns/eval  (x%.3f)\n",
+                  kernels[k].name, dists[j], nthreads[i], old, nspe, nspe / old);
+          if (nspe > (1.0 + tol) * old) {
+            warning("Regression: %s on %s with %d threads is %.1f%% slower",
+                    kernels[k].name, dists[j], nthreads[i], 100.0 * (nspe / old - 1.0));
+            nreg++;
+          }
+        }
+      }
+    }
+  }
+  strclose(outstr);
+  if (nreg > 0)
+    error("%d timings regressed by more than tol=%g against %s",
+          nreg, tol, getparam("baseline"));
+}
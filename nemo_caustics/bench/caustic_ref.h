@@ -0,0 +1,145 @@
+/*
+ * caustic_ref.h: long double reference for the caustic ring kernels of
+ * caustics.h, used by acc_caustics to validate faster code paths.
+ * Include after caustics.h.
+ *
+ * In the scaled coordinates x = (rho-a_n)/p_n, z = z/p_n the flow times T
+ * are the roots of the quartic
+ *
+ *     T^2 ((T-1)^2 - x) = z^2/4
+ *
+ * for which T1..T4 in caustics.h are the closed form (Ferrari) solution.
+ * Here all four roots are found with Aberth iterations in long double
+ * complex, which does not lose digits where roots coalesce, i.e. on the
+ * tricusp envelope and near its cusps. Field and potential then follow
+ * the same formulae as gfield_close(), gfield_far() and apply_caustic_rz(),
+ * in long double. The choice between close and far field uses the same
+ * in_caustic_envelope() test as the kernels, so differences measure the
+ * arithmetic, not the model.
+ *
+ * 19-oct-2026  created
+ */
+
+#include <float.h>
+
+#define REF_PI     3.14159265358979323846264338327950288L
+#define REF_IMTOL  1e-8L
+#define REF_MAXIT  500
+
+typedef long double complex ref_complex;
+
+/* the quartic T^4 - 2T^3 + (1-x)T^2 - z^2/4 and its derivative */
+local ref_complex ref_quartic(ref_complex t, long double x, long double z, ref_complex *dp)
+{
+  *dp = ((4.0L*t - 6.0L)*t + 2.0L*(1.0L - x))*t;
+  return ((t - 2.0L)*t + (1.0L - x))*t*t - 0.25L*z*z;
+}
+
+/* flow times of flow n at (rho,z): the real roots, ascending; returns 2 or 4 */
+local int ref_tvals(long double rho, long double z, int n, long double *T)
+{
+  long double x = (rho - a_n[n]) / p_n[n];
+  long double zs = z / p_n[n];
+  long double bound, step, last = HUGE_VALL, tmp;
+  ref_complex r[4], p, dp, w, s;
+  int i, j, it, count;
+
+  /* Cauchy bound on the roots, for the starting circle */
+  bound = 1.0L + fmaxl(fmaxl(2.0L, fabsl(1.0L - x)), 0.25L*zs*zs);
+  for (i = 0; i < 4; i++)
+    r[i] = 0.5L + 0.5L * bound * cexpl(I * (0.4L + 0.5L * REF_PI * i));
+
+  for (it = 0; it < REF_MAXIT; it++) {
+    step = 0.0L;
+    for (i = 0; i < 4; i++) {
+      p = ref_quartic(r[i], x, zs, &dp);
+      if (p == 0.0L) continue;
+      for (j = 0, s = 0.0L; j < 4; j++)
+        if (j != i) s += 1.0L / (r[i] - r[j]);
+      w = p / dp;
+      w = w / (1.0L - w * s);
+      r[i] -= w;
+      step = fmaxl(step, cabsl(w));
+    }
+    /* converged, or stalled at the rounding level of a multiple root */
+    if (step <= 4.0L * LDBL_EPSILON * bound) break;
+    if (step >= last && step < REF_IMTOL * bound) break;
+    last = step;
+  }
+  if (step >= REF_IMTOL * bound)
+    dprintf(1, "ref_tvals: no convergence at x=%Lg z=%Lg\n", x, zs);
+
+  /* complex roots come in conjugate pairs, so this gives 2 or 4 */
+  for (i = 0, count = 0; i < 4; i++)
+    if (fabsl(cimagl(r[i])) <= REF_IMTOL * fmaxl(1.0L, cabsl(r[i])))
+      T[count++] = creall(r[i]);
+  for (i = 0; i < count - 1; i++)
+    for (j = i + 1; j < count; j++)
+      if (T[i] > T[j]) {
+        tmp = T[i];
+        T[i] = T[j];
+        T[j] = tmp;
+      }
+  return count;
+}
+
+local ref_complex ref_f5(long double x, long double z, long double t)
+{
+  return csqrtl(2.0L*t - 1.0L + x - I*z) / 2.0L;
+}
+
+/* long double gfield_close() */
+local void ref_gfield_close(long double rho, long double z, int n, long double *rfield, long double *zfield)
+{
+  long double x = (rho - a_n[n]) / p_n[n];
+  long double zs = z / p_n[n];
+  long double T[4], factor;
+  ref_complex d;
+  int count = ref_tvals(rho, z, n, T);
+
+  factor = -8.0L * REF_PI * G_caustics * rate_n[n] * 4498.6589L / (rho * V_n[n] * 1.0226831L);
+  d = ref_f5(x, zs, T[1]) - ref_f5(x, zs, T[0]) - 0.5L;
+  if (count == 4)
+    d += ref_f5(x, zs, T[3]) - ref_f5(x, zs, T[2]);
+  *rfield += factor * creall(d);
+  *zfield += factor * cimagl(d);
+}
+
+/* long double gfield_far() */
+local void ref_gfield_far(long double rho, long double z, int n, long double *rfield, long double *zfield)
+{
+  long double r_squared = rho*rho + z*z;
+  long double shift = a_n[n] + p_n[n] / 4.0L;
+  long double A_n = 8.0L * REF_PI * G_caustics * rate_n[n] * 4498.6589L / (V_n[n] * 1.0226831L);
+  long double s = hypotl(r_squared - shift*shift, 2.0L * shift * z);
+  long double factor = -A_n / (s * (2.0L * shift*shift + s));
+
+  *rfield += factor * (r_squared * rho - shift * shift * rho);
+  *zfield += factor * (r_squared * z   + shift * shift * z);
+}
+
+/* long double apply_caustic_pot_double() */
+local void ref_caustic_pot(double *pos, long double *acc, long double *pot)
+{
+  long double x = pos[0], y = pos[1], z = pos[2];
+  long double rho = sqrtl(x*x + y*y), r_squared, shift, A_n, s;
+  long double rfield = 0.0L, zfield = 0.0L;
+  int n;
+
+  if (rho < 0.000001L) rho = 0.000001L;
+  r_squared = rho*rho + z*z;
+  *pot = 0.0L;
+  for (n = 1; n <= 20; n++) {
+    if (in_caustic_envelope((double) rho, pos[2], n))
+      ref_gfield_close(rho, z, n, &rfield, &zfield);
+    else
+      ref_gfield_far(rho, z, n, &rfield, &zfield);
+    shift = a_n[n] + p_n[n] / 4.0L;
+    A_n = 8.0L * REF_PI * G_caustics * rate_n[n] * 4498.6589L / (V_n[n] * 1.0226831L);
+    s = hypotl(r_squared - shift*shift, 2.0L * shift * z);
+    *pot += (A_n / 2.0L) * log1pl(s / (2.0L * a_n[n]*a_n[n]));
+  }
+  acc[0] = rfield * x / rho;
+  acc[1] = rfield * y / rho;
+  acc[2] = zfield;
+}
@@ -0,0 +1,88 @@
+/*
+ * caustic_samples.h: random test points for the caustic ring kernels,
+ * shared by bench_caustics and acc_caustics. Include after caustics.h.
+ *
+ *   far       isotropic 1 < r < 100 kpc, outside every envelope
+ *   envelope  inside the tricusp envelope of a random flow n=1..20
+ *   edge      within 1e-8..1e-1 p_n of the envelope boundary of flow n
+ *   cusp      within 1e-3 p_n of one of the three cusps of flow n
+ *   axis      rho ~ 1e-7, -50 < z < 50
+ *
+ * The tricusp boundary of flow n is, for 0 <= T <= 1,
+ *   rho = a_n + p_n (2T-1)(T-1),   z = +/- 2 p_n sqrt(T^3 (1-T))
+ * with cusps at T=0 (rho=a+p, z=0) and T=3/4 (rho=a-p/8, z=+/-0.65p).
+ *
+ * 19-oct-2026  created, from bench_caustics.c
+ */
+
+typedef struct sample {
+  double pos[3];
+  double rho, z;
+  int n;
+} sample;
+
+local string dists[] = { "far", "envelope", "edge", "cusp", "axis", NULL };
+
+local void set_sample(sample *s, double rho, double z, int n)
+{
+  double phi = xrandom(0.0, TWO_PI);
+
+  s->rho = rho;
+  s->z = z;
+  s->n = n;
+  s->pos[0] = rho * cos(phi);
+  s->pos[1] = rho * sin(phi);
+  s->pos[2] = z;
+}
+
+/* point on the tricusp boundary of flow n at parameter T */
+local void envelope_point(int n, double t, double *rho, double *z)
+{
+  *rho = a_n[n] + p_n[n] * (2.0*t - 1.0) * (t - 1.0);
+  *z = 2.0 * p_n[n] * sqrt(t*t*t * (1.0 - t));
+}
+
+local void make_samples(string dist, int ns, sample *s)
+{
+  int i, k, n;
+  bool inside;
+  double r, ct, rho, z, d, phi;
+
+  for (i = 0; i < ns; i++) {
+    n = 1 + (int) xrandom(0.0, 20.0);
+    if (n > 20) n = 20;
+    if (streq(dist, "far")) {
+      do {
+        r  = xrandom(1.0, 100.0);
+        ct = xrandom(-1.0, 1.0);
+        rho = r * sqrt(1.0 - ct*ct);
+        z = r * ct;
+        for (k = 1, inside = FALSE; k <= 20 && !inside; k++)
+          inside = in_caustic_envelope(rho, z, k);
+      } while (inside);
+    } else if (streq(dist, "envelope")) {
+      do {
+        rho = xrandom(a_n[n] - p_n[n] / 8.0, a_n[n] + p_n[n]);
+        z   = xrandom(-0.65 * p_n[n], 0.65 * p_n[n]);
+      } while (!in_caustic_envelope(rho, z, n));
+    } else if (streq(dist, "edge")) {
+      envelope_point(n, xrandom(0.0, 1.0), &rho, &z);
+      if (xrandom(0.0, 1.0) < 0.5) z = -z;
+      d = pow(10.0, xrandom(-8.0, -1.0)) * p_n[n];
+      phi = xrandom(0.0, TWO_PI);
+      rho += d * cos(phi);
+      z   += d * sin(phi);
+    } else if (streq(dist, "cusp")) {
+      k = (int) xrandom(0.0, 3.0);
+      envelope_point(n, k == 0 ? 0.0 : 0.75, &rho, &z);
+      if (k == 2) z = -z;
+      rho += xrandom(-1e-3, 1e-3) * p_n[n];
+      z   += xrandom(-1e-3, 1e-3) * p_n[n];
+    } else if (streq(dist, "axis")) {
+      rho = xrandom(1e-8, 1e-7);
+      z = xrandom(-50.0, 50.0);
+    } else
+      error("Unknown distribution %s", dist);
+    set_sample(&s[i], rho, z, n);
+  }
+}
@@ -0,0 +1,22 @@
+/*
+ * mw_caustic.c: the Milkyway@Home caustic halo (nbody_caustic.c) built
+ * standalone, with plain double[3] entry points for bench_caustics.
+ */
+
+#include "nbody_caustic.h"
+#include "../../milkywayathome/nbody_caustic.c"
+
+void mw_halo_accel(const double *pos, double *acc)
+{
+  mwvector p = mw_vec(pos[0], pos[1], pos[2]), a;
+
+  a = causticHaloAccel(NULL, p, mw_absv(p));
+  acc[0] = X(a);
+  acc[1] = Y(a);
+  acc[2] = Z(a);
+}
+
+int mw_tvals(double rho, double z, int n, double *T)
+{
+  return getTVals(rho, z, n, T);
+}
@@ -0,0 +1,78 @@
+/*
+ * nbody_caustic.h: minimal stand-in for the Milkyway@Home headers, so that
+ * ../../milkywayathome/nbody_caustic.c can be compiled outside the
+ * Milkyway@Home tree for benchmarking (see mw_caustic.c).
+ *
+ * Only what nbody_caustic.c uses is provided. Its global names are
+ * prefixed with mw_ so that it can be linked next to caustics.h.
+ */
+
+#ifndef _nbody_caustic_h
+#define _nbody_caustic_h
+
+#include <math.h>
+#include <complex.h>
+#include <stdio.h>
+
+#define a_n                 mw_a_n
+#define V_n                 mw_V_n
+#define p_n                 mw_p_n
+#define rate_n              mw_rate_n
+#define G_caustics          mw_G_caustics
+#define delta_V_max         mw_delta_V_max
+#define avg_delta_V_sum2    mw_avg_delta_V_sum2
+#define f1                  mw_f1
+#define f2                  mw_f2
+#define f3                  mw_f3
+#define f4                  mw_f4
+#define f5                  mw_f5
+#define T1                  mw_T1
+#define T2                  mw_T2
+#define T3                  mw_T3
+#define T4                  mw_T4
+#define getTVals            mw_getTVals
+#define gfield_close        mw_gfield_close
+#define gfield_far          mw_gfield_far
+#define get_density_close   mw_get_density_close
+#define in_caustic_envelope mw_in_caustic_envelope
+#define crossed_tb_sheet    mw_crossed_tb_sheet
+#define try_caustic_collision mw_try_caustic_collision
+#define apply_dynamical_friction_voluminous mw_apply_dynamical_friction_voluminous
+#define apply_dynamical_friction mw_apply_dynamical_friction
+#define causticHaloAccel    mw_causticHaloAccel
+
+typedef double real;
+
+typedef struct { real x, y, z, w; } mwvector;
+
+#define X(v) ((v).x)
+#define Y(v) ((v).y)
+#define Z(v) ((v).z)
+
+#define mw_sqrt sqrt
+#define sqr(x)  ((x)*(x))
+#define cube(x) ((x)*(x)*(x))
+#define mw_assume_aligned(p, n) (p)
+
+static inline mwvector mw_vec(real x, real y, real z)
+{ mwvector v; v.x = x; v.y = y; v.z = z; v.w = 0; return v; }
+static inline mwvector mw_addv(mwvector a, mwvector b)
+{ return mw_vec(a.x+b.x, a.y+b.y, a.z+b.z); }
+static inline mwvector mw_subv(mwvector a, mwvector b)
+{ return mw_vec(a.x-b.x, a.y-b.y, a.z-b.z); }
+static inline mwvector mw_mulvs(mwvector a, real s)
+{ return mw_vec(a.x*s, a.y*s, a.z*s); }
+static inline real mw_dotv(mwvector a, mwvector b)
+{ return a.x*b.x + a.y*b.y + a.z*b.z; }
+static inline real mw_absv(mwvector a)
+{ return sqrt(mw_dotv(a, a)); }
+
+typedef struct { mwvector pos, vel; } Body;
+#define Pos(b) ((b)->pos)
+#define Vel(b) ((b)->vel)
+
+typedef struct { int nbody; Body *bodytab; mwvector *acctab; } NBodyState;
+typedef struct { real timestep; } NBodyCtx;
+typedef struct { int type; } Halo;
+
+#endif
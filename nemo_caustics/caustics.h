@@ -178,51 +178,59 @@ void gfield_far(double rho, double z, int n, double *rfield, double *zfield) {
   *zfield += factor * (r_squared * z   + shift * shift * z);
 }
 
-// call this from your own potential file (double version)
-void apply_caustic_pot_double(double *pos, double *acc, double *pot) {
-  double rho, z, rfield, zfield;
+// return 1 if (rho,z) is inside the tricusp boundary/caustic ring envelope of flow n (see Tam 2012)
+int in_caustic_envelope(double rho, double z, int n) {
   double r, l, tr, tl; // r (right), l (left), tr (top right), tl (top left)
-  int n;
 
-  rfield = 0.0;
-  zfield = 0.0;
-  rho = sqrt(pos[X_caustics]*pos[X_caustics] + pos[Y_caustics]*pos[Y_caustics]);
-  z = pos[Z_caustics];
+  r  = (3.0 - sqrt( 1.0 + (8.0 / p_n[n]) * (rho - a_n[n]) )) / 4.0;
+  l  = (3.0 + sqrt( 1.0 + (8.0 / p_n[n]) * (rho - a_n[n]) )) / 4.0;
+  tr = 2.0 * p_n[n] * sqrt(r*r*r * (1.0 - r));
+  tl = 2.0 * p_n[n] * sqrt(l*l*l * (1.0 - l));
 
-  // rho cannot be zero (causes nan in near field and ax and ay at origin)
-  if (rho < 0.000001) {
-    rho = 0.000001;
-  }
+  return ( (z <= tr && z >= 0.0 && rho >= a_n[n] && rho <= a_n[n] + p_n[n])
+        || (z >= tl  && z <= tr  && rho >= (a_n[n] - p_n[n] / 8.0) && rho <= a_n[n])
+        || (z >= -tr && z <= 0.0 && rho >= a_n[n] && rho <= a_n[n] + p_n[n])
+        || (z <= -tl && z >= -tr && rho >= (a_n[n] - p_n[n] / 8.0) && rho <= a_n[n]) );
+}
 
-  // calculate gfield at a position (x,y,z) by adding the contributions from all n caustic ring flows
-  for (n = 1; n <= 20; ++n) {
+// caustic field and potential at cylindrical (rho,z); rho must already be clamped away from zero.
+// Used by apply_caustic_pot_double() and by composite potentials (e.g. mpc.c) that have rho at hand.
+void apply_caustic_rz(double rho, double z, double *rfield, double *zfield, double *pot) {
+  double r_squared = rho*rho + z*z;
+  int n;
 
-    //the caustic ring has a tricusp boundary (see Tam 2012)
-    r  = (3.0 - sqrt( 1.0 + (8.0 / p_n[n]) * (rho - a_n[n]) )) / 4.0;
-    l  = (3.0 + sqrt( 1.0 + (8.0 / p_n[n]) * (rho - a_n[n]) )) / 4.0;
-    tr = 2.0 * p_n[n] * sqrt(pow(r, 3.0) * (1.0 - r));
-    tl = 2.0 * p_n[n] * sqrt(pow(l, 3.0) * (1.0 - l));
+  // calculate gfield and potential at (rho,z) by adding the contributions from all n caustic ring flows
+  for (n = 1; n <= 20; ++n) {
 
     //if position (rho,z) is inside ring use gfield_close, else use gfield_far
-    if ( (z <= tr && z >= 0.0 && rho >= a_n[n] && rho <= a_n[n] + p_n[n])
-     || (z >= tl  && z <= tr  && rho >= (a_n[n] - p_n[n] / 8.0) && rho <= a_n[n])
-     || (z >= -tr && z <= 0.0 && rho >= a_n[n] && rho <= a_n[n] + p_n[n])
-     || (z <= -tl && z >= -tr && rho >= (a_n[n] - p_n[n] / 8.0) && rho <= a_n[n]) )
-    {
-      gfield_close(rho, z, n, &rfield, &zfield);
+    if (in_caustic_envelope(rho, z, n)) {
+      gfield_close(rho, z, n, rfield, zfield);
     } else {
-      gfield_far(rho, z, n, &rfield, &zfield);        
+      gfield_far(rho, z, n, rfield, zfield);
     }
-  }
 
-  // calculate potential at a position (x,y,z) by adding the contributions from all n caustic ring flows
-  for (n = 1; n <= 20; ++n) {
-    double r_squared = rho*rho + z*z;
     double shift = a_n[n] + p_n[n] / 4.0;  //caustic radius shifted by 0.25 so that g goes to zero beyond a_n[n]
     double A_n = (8.0 * M_PI * G_caustics * rate_n[n] * 4498.6589) / (V_n[n] * 1.0226831);  //convert from M_sun/yr*sr to m_sim/gyr*sr with 4498 and km/s to kpc/gyr with 1.0226
     double s = hypot(r_squared - shift*shift, 2.0 * shift *z);
     *pot += (A_n / 2.0) * log(1.0 + ( s / (2.0 * a_n[n]*a_n[n]) ));
   }
+}
+
+// call this from your own potential file (double version)
+void apply_caustic_pot_double(double *pos, double *acc, double *pot) {
+  double rho, z, rfield, zfield;
+
+  rfield = 0.0;
+  zfield = 0.0;
+  rho = sqrt(pos[X_caustics]*pos[X_caustics] + pos[Y_caustics]*pos[Y_caustics]);
+  z = pos[Z_caustics];
+
+  // rho cannot be zero (causes nan in near field and ax and ay at origin)
+  if (rho < 0.000001) {
+    rho = 0.000001;
+  }
+
+  apply_caustic_rz(rho, z, &rfield, &zfield, pot);
 
   acc[X_caustics] += rfield * pos[X_caustics] / rho;
   acc[Y_caustics] += rfield * pos[Y_caustics] / rho;
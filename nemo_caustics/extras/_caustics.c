@@ -1,7 +1,7 @@
 /*
  * This file provides a caustic ring halo potential for use in stellar models. To add the
- * caustic ring potential to another potential, source the add_caustics_call script like this:
- * $ source add_caustics_call [potname]
+ * caustic ring potential to another potential, use a composite potential name like this:
+ * $ potlist potname=[potname]+caustics
  * Where potname is the potential you wish to add cautics to.
  * Alternatively, follow the caustics.h method explained in the comments of caustics.h
  *
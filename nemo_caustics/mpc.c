@@ -78,33 +78,97 @@ void inipotential (int *npar, double *par, string name) {
 
 // galaxy disk calculations (acc[] and pot)
 void apply_miyamoto_pot(double *pos, double *acc, double *pot) {
-  double qpar, apar, spar;
+  double qpar, apar, spar, sinv, sinv3;
   qpar = hypot(pos[Z], miya_bscal);
   apar = miya_ascal + qpar;
-  spar = pos[X]*pos[X] + pos[Y]*pos[Y] + (miya_ascal + qpar)*(miya_ascal + qpar);
+  spar = pos[X]*pos[X] + pos[Y]*pos[Y] + apar*apar;
+  sinv = 1.0 / sqrt(spar);              // one rsqrt replaces three pow(spar,1.5)
+  sinv3 = miya_mass * sinv*sinv*sinv;
 
-  *pot -= miya_mass / sqrt(spar);
+  *pot -= miya_mass * sinv;
 
-  acc[X] -= miya_mass * pos[X] / pow(spar, 1.5);
-  acc[Y] -= miya_mass * pos[Y] / pow(spar, 1.5);
-  acc[Z] -= miya_mass * pos[Z] * apar / (qpar * pow(spar, 1.5));
+  acc[X] -= sinv3 * pos[X];
+  acc[Y] -= sinv3 * pos[Y];
+  acc[Z] -= sinv3 * pos[Z] * apar / qpar;
 }
 
 // galaxy bulge calculations (acc[] and pot)
 void apply_plummer_pot(double *pos, double *acc, double *pot) {
-  double ppar, rpar;
+  double ppar, rpar, fac;
   ppar = sqrt(pos[X]*pos[X] + pos[Y]*pos[Y] + pos[Z]*pos[Z]) + plu_rc;
   rpar = ppar - plu_rc;
   if (rpar < 0.000001) // make sure rpar != zero (causes nan in accx accy accz at origin)
     rpar = 0.000001;
+  fac = plu_mass / (rpar * ppar * ppar);
 
   *pot -= plu_mass / ppar;
 
-  acc[X] -= plu_mass * pos[X] / (rpar * ppar * ppar);
-  acc[Y] -= plu_mass * pos[Y] / (rpar * ppar * ppar);
-  acc[Z] -= plu_mass * pos[Z] / (rpar * ppar * ppar);
+  acc[X] -= fac * pos[X];
+  acc[Y] -= fac * pos[Y];
+  acc[Z] -= fac * pos[Z];
 }
 
+/*
+ * fused disk + bulge + halo kernel: R^2, z^2, r and rho are computed once and
+ * shared by the three components, instead of each apply_*_pot recomputing
+ * them from pos. Results agree with the sequential calls to roundoff.
+ */
+void apply_mpc_pot(double *pos, double *acc, double *pot) {
+  double R2, z2, rho, rpar, ppar, qpar, apar, sinv, fac;
+  double rfield = 0.0, zfield = 0.0;
+
+  R2 = pos[X]*pos[X] + pos[Y]*pos[Y];
+  z2 = pos[Z]*pos[Z];
+
+  // disk
+  qpar = sqrt(z2 + miya_bscal*miya_bscal);
+  apar = miya_ascal + qpar;
+  sinv = 1.0 / sqrt(R2 + apar*apar);
+  fac  = miya_mass * sinv*sinv*sinv;
+  *pot   -= miya_mass * sinv;
+  acc[X] -= fac * pos[X];
+  acc[Y] -= fac * pos[Y];
+  acc[Z] -= fac * pos[Z] * apar / qpar;
+
+  // bulge
+  rpar = sqrt(R2 + z2);
+  ppar = rpar + plu_rc;
+  if (rpar < 0.000001) rpar = 0.000001;
+  fac  = plu_mass / (rpar * ppar * ppar);
+  *pot   -= plu_mass / ppar;
+  acc[X] -= fac * pos[X];
+  acc[Y] -= fac * pos[Y];
+  acc[Z] -= fac * pos[Z];
+
+  // halo
+  rho = sqrt(R2);
+  if (rho < 0.000001) rho = 0.000001;
+  apply_caustic_rz(rho, pos[Z], &rfield, &zfield, pot);
+  fac = rfield / rho;
+  acc[X] += fac * pos[X];
+  acc[Y] += fac * pos[Y];
+  acc[Z] += zfield;
+}
+
+/*
+ * batched form: npos positions stored as x,y,z triplets in pos[];
+ * acc[] (3*npos) and pot[] (npos) are overwritten with the summed
+ * disk + bulge + halo values.
+ */
+void apply_mpc_pot_array(int npos, double *pos, double *acc, double *pot) {
+  int i;
+
+  for (i = 0; i < npos; i++, pos += 3, acc += 3, pot++) {
+    *pot = 0;
+    acc[X] = acc[Y] = acc[Z] = 0;
+    apply_mpc_pot(pos, acc, pot);
+  }
+}
+
+// batched entry point picked up by composite potentials (see get_potential_double_array)
+void potential_double_array(int *npos, int *ndim, double *pos, double *acc, double *pot, double *time) {
+  apply_mpc_pot_array(*npos, pos, acc, pot);
+}
 
 void potential_double(int *ndim, double *pos, double *acc, double *pot, double *time) {
 
@@ -112,9 +176,7 @@ void potential_double(int *ndim, double *pos, double *acc, double *pot, double *
   acc[X] = 0;
   acc[Y] = 0;
   acc[Z] = 0;
-  apply_miyamoto_pot(pos, acc, pot);
-  apply_plummer_pot(pos, acc, pot);
-  apply_caustic_pot_double(pos, acc, pot);
+  apply_mpc_pot(pos, acc, pot);
 }
 /*
  * Unused stuff:
@@ -25,10 +25,16 @@
  *    If bit 0 is set, the potential    is added, otherwise assigned,
  *    If bit 1 is set, the acceleration is added, otherwise assigned.
  *    So, 0 means both are assigned.
+ *  7 reentrant_acceleration() tells whether an acceleration() obtained from
+ *    get_acceleration() may be called concurrently by several threads, each
+ *    for a different set of bodies at the same time, provided it has been
+ *    called once for that time beforehand (possibly with no bodies). This is
+ *    the case only if the acceleration field said so (see defacc.h).
  *
  ******************************************************************************
  * version 0.0  17/06/2004  WD
  * version 0.1  22/06/2004  WD   allow for up to 10 fallbacks, no last_...
+ * version 0.2  19/10/2026       reentrant_acceleration()
  *
  */
 
@@ -67,6 +73,14 @@ acc_pter get_acceleration(               /* return: acceleration()         */
 			  const char*,   /* input:  acc_file               */
 			  bool      *,   /* output: need masses?           */
 			  bool      *);  /* output: need velocities?       */
+
+/*
+ * may acceleration() be called concurrently? see note 7
+ */
+
+extern
+bool reentrant_acceleration(             /* return: reentrant?             */
+			    acc_pter);   /* input:  from get_acceleration()*/
   
 #ifdef __cplusplus
 }
@@ -49,6 +49,8 @@
  * version 3.4  12/06/2008  WD  #including stdinc.h
  * version 3.5  11/09/2008  WD  no inclusion of NEMO header files
  * version 3.6  24/04/2009  WD  avoid compiler warning with -Wshadow
+ * version 3.7  19/10/2026      optional reentrantacceleration(),
+ *                              macro __DEF__REENTRANT
  *
  *******************************************************************************
  *
@@ -111,6 +113,14 @@
  *    If bit 0 is set, the potential    is added, otherwise assigned,           
  *    If bit 1 is set, the acceleration is added, otherwise assigned.           
  *    So, 0 means both are assigned.                                            
+ *  7 optionally, reentrantacceleration() may be defined to return true if      
+ *    acceleration() may be called concurrently by several threads, each for    
+ *    a different set of bodies, once it has been called for the current time   
+ *    (possibly with no bodies). This requires that the acceleration of a       
+ *    body does not depend on the other bodies passed, that acceleration()      
+ *    uses no static or other shared scratch data, and that any update for a    
+ *    new time depends on the time only. Otherwise, do not define it, and       
+ *    acceleration() is always called serially. See __DEF__REENTRANT below.     
  *                                                                              
  */
 
@@ -122,6 +132,8 @@ void iniacceleration(                 /* return: void                         */
 		     bool*,           /* output: acceleration() needs masses? */
 		     bool*);          /* output: acceleration() needs vel's?  */
 
+bool reentrantacceleration(void);     /* optional: see note 7 above           */
+
 /*
  * NOTE 1
  * the routine pointed to by the pointer returned from iniacceleration() must   
@@ -681,6 +693,20 @@ void iniacceleration(const double*pars,					\
   *accel = Accs[AccN++];						\
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//                                                                            //
+// macro __DEF__REENTRANT                                                     //
+//                                                                            //
+// defines reentrantacceleration() to return true (see note 7 above). Only    //
+// use it if the acceleration class has no mutable or static data and its     //
+// set_time() does nothing or depends on the time only, as is the case for    //
+// SphericalPot<> below.                                                      //
+//                                                                            //
+////////////////////////////////////////////////////////////////////////////////
+
+#define __DEF__REENTRANT						\
+bool reentrantacceleration() { return true; }
+
 #ifdef POT_DEF
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                            //
@@ -5,6 +5,11 @@
  *     12-apr-95  prototypes without ARGS       PJT
  *      2-jun-05  blocked I/O as a flavor of random I/O     PJT
  *     11-dec-09  half precision type                       PJT
+ *     19-oct-26  get_pos/get_goto, snapshot index (strindex.c)
+ *     19-oct-26  put_zip: compressed large items
+ *     19-oct-26  asynchronous output (strasync.c)
+ *     19-oct-26  partitioned snapshots (strpart.c)
+ *     19-oct-26  put_prec/prec_type: per item storage precision
  */
 #ifndef _filestruct_h
 #define _filestruct_h
@@ -73,6 +78,8 @@ extern void get_data ( stream, string, string, void *, int, ...);
 extern void get_data_coerced ( stream, string, string, void *, int, ...);
 			 
 extern void get_data_sub ( stream, string, string, void *, int *, bool);
+extern const void *get_data_ptr ( stream, string, string, int, ...);
+extern const void *get_data_ptr_sub ( stream, string, string, int *, bool);
 		     
 extern bool get_tag_ok ( stream, string);
 extern bool skip_item ( stream);
@@ -94,4 +101,30 @@ extern void put_data_ran     ( stream , string , void *, int , int  );
 extern void put_data_blocked ( stream , string , void *, int );
 
 extern bool qsf ( stream );
+
+extern off_t get_pos  ( stream );
+extern bool  get_goto ( stream, off_t, string );
+
+extern void put_zip ( stream, int, int );
+extern void put_prec ( stream, string );
+extern string prec_type ( stream, string, string );
+
+/* strindex.c: sidecar index of top level sets */
+extern void put_index_set ( stream, string, double );
+extern void put_index_tes ( stream );
+extern void put_index_off ( stream );
+extern bool get_index     ( stream, string, string, double );
+extern void end_index     ( stream );
+
+/* strasync.c: top level sets written by a background thread */
+extern stream put_async_set ( stream );
+extern void   put_async_tes ( stream );
+extern void   end_async     ( stream );
+
+/* strpart.c: snapshots partitioned over part files, in parallel */
+extern stream *put_parts     ( stream, int, int *, int ** );
+extern void    put_parts_tes ( stream );
+extern stream *get_parts     ( stream, string, int *, int ** );
+extern void    run_parts     ( int, void (*)(int, void *), void * );
+extern void    end_parts     ( stream );
 #endif
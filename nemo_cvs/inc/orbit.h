@@ -16,6 +16,7 @@
  *  11-apr-95    V3.1b no more ARGS, included more header files here
  *   1-mar-03    V3.3  added iom_err, errors in the integrals of motion
  *  25-jul-13    V4.0  added Key
+ *  19-oct-26    V4.1  streamed orbits, in OrbitChunk sets; EnergyPath
  */
 
 #include <filestruct.h>
@@ -34,6 +35,7 @@ typedef struct {
         int   maxsteps;
         real  *time;
         real  *phase;
+        real  *energy;          /* optional, NULL if not used */
 	a_potential pot;
 } orbit, *orbitptr;
 
@@ -48,6 +50,7 @@ typedef struct {
 #define MAXsteps(optr)  ((optr)->maxsteps)
 #define TimePath(optr)  ((optr)->time)
 #define PhasePath(optr) ((optr)->phase)
+#define EnergyPath(optr) ((optr)->energy)
 #define Potential(optr) ((optr)->pot)
 
 /*      a few dangerous (does not check for ndim) access functions */
@@ -77,6 +80,7 @@ typedef struct {
 #define Uorb(optr,i)    (*(PhasePath(optr)+Ndim(optr)*2*(i)+Ndim(optr)))
 #define Vorb(optr,i)    (*(PhasePath(optr)+Ndim(optr)*2*(i)+Ndim(optr)+1))
 #define Worb(optr,i)    (*(PhasePath(optr)+Ndim(optr)*2*(i)+Ndim(optr)+2))
+#define Eorb(optr,i)    (*(EnergyPath(optr)+(i)))
 
 #define PotName(optr)   (Potential(optr).name)
 #define PotPars(optr)   (Potential(optr).pars)
@@ -104,6 +108,9 @@ typedef struct {
 #define     NstepsTag           "Nsteps"
 #define     TimePathTag         "TimePath"
 #define     PhasePathTag        "PhasePath"
+#define     EnergyPathTag       "EnergyPath"
+
+#define OrbitChunkTag           "OrbitChunk"
 
 
 
@@ -114,3 +121,6 @@ void free_orbit     ( orbitptr );
 int  allocate_orbit ( orbitptr *, int, int );
 void copy_orbit     ( orbitptr, orbitptr );
 void list_orbit     ( orbitptr, double, double, int, string );
+void write_orbit_head  ( stream, orbitptr );
+void write_orbit_chunk ( stream, orbitptr );
+int  read_orbit_window ( stream, orbitptr *, real, real );
@@ -4,6 +4,8 @@
  *
  *	jul 1987:	original implementation
  *	sep 2001:	added C++ support, including const'ing 
+ *	oct 2026:	batched potarr_double for composite potentials
+ *			potreg_entry for precompiled potential registries
  */
 
 #ifndef _potential_h
@@ -21,6 +23,19 @@ typedef struct a_potential {
 
 typedef void (*potproc_double)(const int *, const double *, double *, double *, const double *);
 typedef void (*potproc_float) (const int *, const float *,  float *,  float *,  const float *);
+/* batched form: npos positions, each ndim consecutive values in pos/acc */
+typedef void (*potarr_double)(const int *, const int *, const double *, double *, double *, const double *);
+
+/* one entry in a potential registry (see mkpotreg); NULL name ends the table */
+typedef struct potreg_entry {
+    string name;
+    proc ini;                   /* inipotential */
+    proc pot_d;                 /* potential_double */
+    proc pot_f;                 /* potential_float */
+    potarr_double pot_a;        /* potential_double_array */
+    proc pot;                   /* old style potential */
+} potreg_entry;
+
 #ifdef SINGLEPREC
 typedef potproc_float potproc_real;
 #else
@@ -35,6 +50,7 @@ extern "C" {
 potproc_real   get_potential        (const string, const string, const string);
 potproc_float  get_potential_float  (const string, const string, const string);
 potproc_double get_potential_double (const string, const string, const string);
+potarr_double  get_potential_double_array (const string, const string, const string);
 proc           get_inipotential     (void);
 real           get_pattern          (void);
 
@@ -13,6 +13,8 @@
  *      17-jan-02 detect split Pos/Vel		pjt
  *       2-apr-02 add UdotIntTag for ZENO	pjt
  *      30-may-07 allocate() needs size_t args for > 44.7M      pjt
+ *      19-oct-26 get_snap_by_t skips sets using the snapshot index
+ *      19-oct-26 partitioned snapshots (see strpart.c)
  */
 
 /*
@@ -497,6 +499,8 @@ int *ifptr;			/* pointer to input bit flags */
 
 #endif
 
+#include <snapshot/get_snap_parts.c>
+
 /*
  * GET_SNAP: control routine for snapshot input.
  */
@@ -517,7 +521,8 @@ int *ifptr;			/* pointer to input bit flags */
     if (get_tag_ok(instr, SnapShotTag)) {
 	get_set(instr, SnapShotTag);
 	get_snap_parameters(instr, btptr, nbptr, tsptr, ifptr);
-	get_snap_particles(instr, btptr, nbptr, ifptr);
+	if (!get_snap_parts(instr, btptr, nbptr, ifptr))
+	    get_snap_particles(instr, btptr, nbptr, ifptr);
 	get_snap_diagnostics(instr, ifptr);
 	get_tes(instr, SnapShotTag);
 	return 1;
@@ -549,12 +554,14 @@ int *ifptr;			/* pointer to input bit flags */
 string times;
 {
     *ifptr = 0;
+    get_index(instr, SnapShotTag, times, TimeFuzz);	/* skip unwanted sets */
     if (get_tag_ok(instr, SnapShotTag)) {
 	get_set(instr, SnapShotTag);
 	get_snap_parameters(instr, btptr, nbptr, tsptr, ifptr);
 	if (streq(times, "all") ||
 	      (*ifptr & TimeBit && within(*tsptr, times, TimeFuzz))) {
-	    get_snap_particles(instr, btptr, nbptr, ifptr);
+	    if (!get_snap_parts(instr, btptr, nbptr, ifptr))
+		get_snap_particles(instr, btptr, nbptr, ifptr);
 	    get_snap_diagnostics(instr, ifptr);
 	}
 	get_tes(instr, SnapShotTag);
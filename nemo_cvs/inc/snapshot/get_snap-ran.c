@@ -11,6 +11,7 @@
  *	22-feb-94 ansi headers (w/ allocate)    pjt
  *	26-jun-96 no more local definitions, use extern		PJT
  *	 8-jan-98 converted to use random + common I/O		pjt
+ *      19-oct-26 partitioned snapshots (see strpart.c)
  */
 
 /*
@@ -451,6 +452,9 @@ int *ifptr;			/* pointer to input bit flags */
 
 #endif
 
+#define SerialParts		/* the workers share the common buffer */
+#include <snapshot/get_snap_parts.c>
+
 /*
  * GET_SNAP: control routine for snapshot input.
  */
@@ -478,7 +482,8 @@ int *ifptr;			/* pointer to input bit flags */
     if (get_tag_ok(instr, SnapShotTag)) {
 	get_set(instr, SnapShotTag);
 	get_snap_parameters(instr, btptr, nbptr, tsptr, ifptr);
-	get_snap_particles(instr, btptr, nbptr, ifptr);
+	if (!get_snap_parts(instr, btptr, nbptr, ifptr))
+	    get_snap_particles(instr, btptr, nbptr, ifptr);
 	get_snap_diagnostics(instr, ifptr);
 	get_tes(instr, SnapShotTag);
 	return 1;
@@ -517,12 +522,14 @@ string times;
         first_io_get = 0;
     }
 #endif
+    get_index(instr, SnapShotTag, times, TimeFuzz);	/* skip unwanted sets */
     if (get_tag_ok(instr, SnapShotTag)) {
 	get_set(instr, SnapShotTag);
 	get_snap_parameters(instr, btptr, nbptr, tsptr, ifptr);
 	if (streq(times, "all") ||
 	      (*ifptr & TimeBit && within(*tsptr, times, TimeFuzz))) {
-	    get_snap_particles(instr, btptr, nbptr, ifptr);
+	    if (!get_snap_parts(instr, btptr, nbptr, ifptr))
+		get_snap_particles(instr, btptr, nbptr, ifptr);
 	    get_snap_diagnostics(instr, ifptr);
 	}
 	get_tes(instr, SnapShotTag);
@@ -0,0 +1,78 @@
+/*
+ * GET_SNAP_PARTS.C: input of the bodies of a partitioned snapshot.
+ *	Note: this file is included by get_snap-old.c and get_snap-ran.c,
+ *	      after the worker routines
+ *
+ *	19-oct-2026  created
+ */
+
+/*
+ * If a snapshot has a Parts set instead of Particles (see strpart.c),
+ * get_snap reads the bodies from the part files, each by its own thread
+ * with get_snap_particles for its range of bodies, so worker routines
+ * supplied by the program must not share buffers between calls; if they
+ * do, define SerialParts to read the parts one after the other.
+ * The input bits are those all parts have.
+ */
+
+#ifndef get_snap_parts
+
+#define get_snap_parts  _get_snap_parts
+
+typedef struct {
+    stream *part;		/* part streams */
+    Body *btab;			/* all bodies */
+    int *nobj, *first;		/* bodies in each part, and where they start */
+    int *bits;			/* input bits of each part */
+} _get_part_arg;
+
+local void _get_snap_part(int k, void *arg)
+{
+    _get_part_arg *pa = (_get_part_arg *) arg;
+    Body *bp = pa->btab + pa->first[k];
+    int nb = pa->nobj[k];
+
+    pa->bits[k] = 0;
+    get_set(pa->part[k], SnapShotTag);
+    get_snap_particles(pa->part[k], &bp, &nb, &pa->bits[k]);
+    get_tes(pa->part[k], SnapShotTag);
+}
+
+local bool
+_get_snap_parts(
+stream instr,			/* input stream, of course */
+Body **btptr,			/* pointer to body array */
+int *nbptr,			/* pointer to number of bodies */
+int *ifptr)			/* pointer to input bit flags */
+{
+    _get_part_arg pa;
+    int nparts, k, bits;
+
+    pa.part = get_parts(instr, SnapShotTag, &nparts, &pa.nobj);
+    if (pa.part == NULL)
+	return FALSE;
+    pa.first = (int *) allocate(2 * nparts * sizeof(int));
+    pa.bits = pa.first + nparts;
+    for (k = 1; k < nparts; k++)
+	pa.first[k] = pa.first[k-1] + pa.nobj[k-1];
+    if (pa.first[nparts-1] + pa.nobj[nparts-1] != *nbptr)
+	error("get_snap_parts: parts have %d bodies, %s = %d",
+	      pa.first[nparts-1] + pa.nobj[nparts-1], NobjTag, *nbptr);
+    if (*btptr == NULL)
+	*btptr = (Body *) allocate((size_t)(*nbptr) * sizeof(Body));
+    pa.btab = *btptr;
+#if defined(SerialParts)
+    for (k = 0; k < nparts; k++)
+	_get_snap_part(k, &pa);
+#else
+    run_parts(nparts, _get_snap_part, &pa);
+#endif
+    bits = pa.bits[0];
+    for (k = 1; k < nparts; k++)
+	bits &= pa.bits[k];
+    *ifptr |= bits;
+    free(pa.first);
+    return TRUE;
+}
+
+#endif
@@ -0,0 +1,351 @@
+/*
+ * GET_SNAP_SOA.C: snapshot input into column (structure of arrays) storage.
+ *	Note: this file is to be included at the source level,
+ *	      after <stdinc.h>, <filestruct.h> and <snapshot/snapshot.h>
+ *
+ *	19-oct-2026  created, after get_snap-old.c
+ *	19-oct-2026  get_snap_soa_by_t uses the snapshot index
+ *	19-oct-2026  partitioned snapshots, in parallel (see strpart.c)
+ */
+
+/*
+ * get_snap_soa reads a snapshot straight into one array per field, instead
+ * of scattering every field into a table of Body structures as get_snap
+ * does. The arrays are kept in a SnapSoA, and reused from one snapshot to
+ * the next; they only grow when a snapshot has more bodies than any before.
+ *
+ *	#include <snapshot/snapshot.h>
+ *	#include <snapshot/get_snap_soa.c>
+ *
+ *	stream instr;
+ *	SnapSoA ss;
+ *
+ *	ini_snap_soa(&ss);
+ *	while (get_snap_soa(instr, &ss)) {
+ *	    if ((ss.bits & <required_bits>) == <required_bits>)
+ *		<process ss.nbody bodies at time ss.time>;
+ *	}
+ *	free_snap_soa(&ss);
+ *
+ * Each column is aligned to SOA_ALIGN bytes. Vectors are stored as
+ * pos[NDIM*i+k], i.e. as the x,y,z triplets that batched potential
+ * routines such as potential_double_array() and apply_mpc_pot_array()
+ * take directly, so with real=double no copy is needed at all.
+ *
+ * Mass, Position, Velocity, Potential, Acceleration, Aux, Key, Density and
+ * Eps are read with get_data_coerced() directly into their column. Only a
+ * PhaseSpace item (NDIM positions followed by NDIM velocities per body)
+ * must be split over pos and vel; this is done from get_data_ptr_sub(),
+ * which for a large item in a file points into the mapped file, so again
+ * no temporary buffer is allocated.
+ * Columns for which a snapshot has no data are left alone; check bits.
+ *
+ * The parts of a partitioned snapshot (see strpart.c) are read in parallel,
+ * straight into their range of each column; part 0 first, so the columns
+ * exist before the other parts are read.
+ */
+
+#include <filestruct.h>
+
+#ifndef SOA_ALIGN
+#define SOA_ALIGN  64			/* cache line, also fits AVX-512 */
+#endif
+
+typedef struct snapsoa {
+    int nbody;			/* number of bodies in the last snapshot */
+    int nmax;			/* bodies the columns have room for */
+    int bits;			/* input bit flags, see snapshot.h */
+    real time;			/* time of the last snapshot, if TimeBit */
+    real *mass;			/* [nbody] */
+    real *pos;			/* [nbody][NDIM] */
+    real *vel;			/* [nbody][NDIM] */
+    real *phi;			/* [nbody] */
+    real *acc;			/* [nbody][NDIM] */
+    real *aux;			/* [nbody] */
+    int  *key;			/* [nbody] */
+    real *dens;			/* [nbody] */
+    real *eps;			/* [nbody] */
+} SnapSoA;
+
+local void ini_snap_soa(SnapSoA *ss)
+{
+    memset(ss, 0, sizeof(SnapSoA));
+}
+
+local void *soa_column(void **col, int nbody, size_t size)
+{
+    if (*col == NULL) {
+	if (posix_memalign(col, SOA_ALIGN, (size_t) nbody * size) != 0)
+	    error("get_snap_soa: cannot allocate %d x %d bytes",
+		  nbody, (int) size);
+    }
+    return *col;
+}
+
+/* drop all columns; they are reallocated when next read into */
+local void soa_free_columns(SnapSoA *ss)
+{
+    free(ss->mass);
+    free(ss->pos);
+    free(ss->vel);
+    free(ss->phi);
+    free(ss->acc);
+    free(ss->aux);
+    free(ss->key);
+    free(ss->dens);
+    free(ss->eps);
+    ss->mass = ss->pos = ss->vel = ss->phi = ss->acc = NULL;
+    ss->aux = ss->dens = ss->eps = NULL;
+    ss->key = NULL;
+}
+
+local void free_snap_soa(SnapSoA *ss)
+{
+    soa_free_columns(ss);
+    ss->nbody = ss->nmax = 0;
+}
+
+/*
+ * GET_SNAP_SOA_PARAMETERS: read Nobj and Time; columns that are too small
+ * for nbody are dropped.
+ */
+
+local void get_snap_soa_parameters(stream instr, SnapSoA *ss)
+{
+    int nbody;
+
+    if (!get_tag_ok(instr, ParametersTag))
+	return;
+    get_set(instr, ParametersTag);
+    if (get_tag_ok(instr, NobjTag))
+	get_data(instr, NobjTag, IntType, &nbody, 0);
+    else if (get_tag_ok(instr, NBodyTag)) {
+	get_data(instr, NBodyTag, IntType, &nbody, 0);
+	warning("Reading a ZENO file with NBody=%d", nbody);
+    } else
+	error("Cannot find Nobj or NBody in snapshot");
+    if (nbody > ss->nmax) {
+	dprintf(1, "get_snap_soa: columns grow from %d to %d bodies\n",
+		ss->nmax, nbody);
+	soa_free_columns(ss);
+	ss->nmax = nbody;
+    }
+    ss->nbody = nbody;
+    if (get_tag_ok(instr, TimeTag)) {
+	get_data_coerced(instr, TimeTag, RealType, &ss->time, 0);
+	ss->bits |= TimeBit;
+    }
+    get_tes(instr, ParametersTag);
+}
+
+/* read a [nbody] or [nbody][NDIM] real item straight into its column */
+local void get_snap_soa_real(stream instr, SnapSoA *ss, string tag,
+			     real **col, int ndim, int bit)
+{
+    if (!get_tag_ok(instr, tag))
+	return;
+    soa_column((void **) col, ss->nmax, ndim * sizeof(real));
+    if (ndim == 1)
+	get_data_coerced(instr, tag, RealType, *col, ss->nbody, 0);
+    else
+	get_data_coerced(instr, tag, RealType, *col, ss->nbody, ndim, 0);
+    ss->bits |= bit;
+}
+
+local void get_snap_soa_phase(stream instr, SnapSoA *ss)
+{
+    int dims[4], i;
+    const real *rv;
+    real *rp, *vp;
+
+    if (get_tag_ok(instr, PhaseSpaceTag)) {
+	dims[0] = ss->nbody;
+	dims[1] = 2;
+	dims[2] = NDIM;
+	dims[3] = 0;
+	rv = (const real *) get_data_ptr_sub(instr, PhaseSpaceTag, RealType,
+					     dims, TRUE);
+	rp = soa_column((void **) &ss->pos, ss->nmax, NDIM * sizeof(real));
+	vp = soa_column((void **) &ss->vel, ss->nmax, NDIM * sizeof(real));
+	for (i = 0; i < ss->nbody; i++) {
+	    SETV(rp, rv);
+	    SETV(vp, rv + NDIM);
+	    rp += NDIM;
+	    vp += NDIM;
+	    rv += 2 * NDIM;
+	}
+	ss->bits |= PhaseSpaceBit;
+    } else {
+	get_snap_soa_real(instr, ss, PosTag, &ss->pos, NDIM, PosBit);
+	get_snap_soa_real(instr, ss, VelTag, &ss->vel, NDIM, VelBit);
+	if ((ss->bits & (PosBit | VelBit)) == (PosBit | VelBit))
+	    ss->bits |= PhaseSpaceBit;
+    }
+}
+
+local void get_snap_soa_particles(stream instr, SnapSoA *ss)
+{
+    int cs;
+
+    if (!get_tag_ok(instr, ParticlesTag))
+	return;
+    get_set(instr, ParticlesTag);
+    if (get_tag_ok(instr, CoordSystemTag)) {
+	get_data(instr, CoordSystemTag, IntType, &cs, 0);
+	if (cs != CSCode(Cartesian, NDIM, 2))
+	    error("get_snap_soa: cant handle %s = %#o\n", CoordSystemTag, cs);
+    }
+    get_snap_soa_real(instr, ss, MassTag, &ss->mass, 1, MassBit);
+    get_snap_soa_phase(instr, ss);
+    get_snap_soa_real(instr, ss, PotentialTag, &ss->phi, 1, PotentialBit);
+    get_snap_soa_real(instr, ss, AccelerationTag, &ss->acc, NDIM,
+		      AccelerationBit);
+    get_snap_soa_real(instr, ss, AuxTag, &ss->aux, 1, AuxBit);
+    if (get_tag_ok(instr, KeyTag)) {
+	soa_column((void **) &ss->key, ss->nmax, sizeof(int));
+	get_data(instr, KeyTag, IntType, ss->key, ss->nbody, 0);
+	ss->bits |= KeyBit;
+    }
+    get_snap_soa_real(instr, ss, DensityTag, &ss->dens, 1, DensBit);
+    get_snap_soa_real(instr, ss, EpsTag, &ss->eps, 1, EpsBit);
+    get_tes(instr, ParticlesTag);
+}
+
+typedef struct {
+    SnapSoA *ss;		/* all bodies */
+    stream *part;		/* part streams */
+    int *nobj, *first;		/* bodies in each part, and where they start */
+    int *bits;			/* input bits of each part */
+} soa_part_arg;
+
+/* point the columns of view v at body f of the columns of ss */
+local void soa_view(SnapSoA *v, SnapSoA *ss, size_t f)
+{
+#define SOA_AT(col, n)  v->col = ss->col ? ss->col + (n) * f : NULL
+    SOA_AT(mass, 1);
+    SOA_AT(pos, NDIM);
+    SOA_AT(vel, NDIM);
+    SOA_AT(phi, 1);
+    SOA_AT(acc, NDIM);
+    SOA_AT(aux, 1);
+    SOA_AT(key, 1);
+    SOA_AT(dens, 1);
+    SOA_AT(eps, 1);
+#undef SOA_AT
+}
+
+/* drop columns a part allocated for itself: part 0 did not have them */
+local void soa_unview(SnapSoA *v, SnapSoA *ss)
+{
+#define SOA_OWN(col)  if (ss->col == NULL) free(v->col)
+    SOA_OWN(mass);
+    SOA_OWN(pos);
+    SOA_OWN(vel);
+    SOA_OWN(phi);
+    SOA_OWN(acc);
+    SOA_OWN(aux);
+    SOA_OWN(key);
+    SOA_OWN(dens);
+    SOA_OWN(eps);
+#undef SOA_OWN
+}
+
+local void get_snap_soa_part(int k, void *arg)
+{
+    soa_part_arg *pa = (soa_part_arg *) arg;
+    SnapSoA view;
+
+    view = *pa->ss;
+    if (k > 0)
+	soa_view(&view, pa->ss, (size_t) pa->first[k]);
+    view.nbody = pa->nobj[k];
+    view.bits = 0;
+    get_set(pa->part[k], SnapShotTag);
+    get_snap_soa_particles(pa->part[k], &view);
+    get_tes(pa->part[k], SnapShotTag);
+    pa->bits[k] = view.bits;
+    if (k == 0)					/* columns now allocated */
+	soa_view(pa->ss, &view, 0);
+    else
+	soa_unview(&view, pa->ss);
+}
+
+local void get_snap_soa_rest(int k, void *arg)
+{
+    get_snap_soa_part(k + 1, arg);
+}
+
+/*
+ * GET_SNAP_SOA_PARTS: if the snapshot is partitioned, read the particles
+ * from its parts and return TRUE.
+ */
+
+local bool get_snap_soa_parts(stream instr, SnapSoA *ss)
+{
+    soa_part_arg pa;
+    int nparts, k, bits;
+
+    pa.part = get_parts(instr, SnapShotTag, &nparts, &pa.nobj);
+    if (pa.part == NULL)
+	return FALSE;
+    pa.first = (int *) allocate(2 * nparts * sizeof(int));
+    pa.bits = pa.first + nparts;
+    for (k = 1; k < nparts; k++)
+	pa.first[k] = pa.first[k-1] + pa.nobj[k-1];
+    if (pa.first[nparts-1] + pa.nobj[nparts-1] != ss->nbody)
+	error("get_snap_soa: parts have %d bodies, %s = %d",
+	      pa.first[nparts-1] + pa.nobj[nparts-1], NobjTag, ss->nbody);
+    pa.ss = ss;
+    get_snap_soa_part(0, &pa);			/* allocates the columns    */
+    if (nparts > 1)
+	run_parts(nparts - 1, get_snap_soa_rest, &pa);
+    bits = pa.bits[0];
+    for (k = 1; k < nparts; k++)
+	bits &= pa.bits[k];
+    ss->bits |= bits;
+    free(pa.first);
+    return TRUE;
+}
+
+/*
+ * GET_SNAP_SOA: read the next snapshot into ss; returns 0 at end of input.
+ */
+
+local int get_snap_soa(stream instr, SnapSoA *ss)
+{
+    ss->bits = 0;
+    if (!get_tag_ok(instr, SnapShotTag))
+	return 0;
+    get_set(instr, SnapShotTag);
+    get_snap_soa_parameters(instr, ss);
+    if (!get_snap_soa_parts(instr, ss))
+	get_snap_soa_particles(instr, ss);
+    get_tes(instr, SnapShotTag);
+    return 1;
+}
+
+/*
+ * GET_SNAP_SOA_BY_T: as get_snap_soa, but only read the particles if the
+ * time is in the range times (see within(3NEMO)), or times="all".
+ */
+
+#ifndef TimeFuzz
+#define TimeFuzz  0.001			/* slop allowed in time comparison  */
+#endif
+
+local int get_snap_soa_by_t(stream instr, SnapSoA *ss, string times)
+{
+    ss->bits = 0;
+    get_index(instr, SnapShotTag, times, TimeFuzz);	/* skip unwanted sets */
+    if (!get_tag_ok(instr, SnapShotTag))
+	return 0;
+    get_set(instr, SnapShotTag);
+    get_snap_soa_parameters(instr, ss);
+    if (streq(times, "all") ||
+	  (ss->bits & TimeBit && within(ss->time, times, TimeFuzz))) {
+	if (!get_snap_soa_parts(instr, ss))
+	    get_snap_soa_particles(instr, ss);
+    }
+    get_tes(instr, SnapShotTag);
+    return 1;
+}
@@ -11,6 +11,10 @@
  *      29-sep-05  fix for gcc4 supplying default prototypes
  *                 ** only potcode needed this,but we clearly need better solution for this **
  *      30-may-07  allocate() needs size_t argument casting for > 44.7M particles
+ *      19-oct-26  write the snapshot index (see strindex.c)
+ *      19-oct-26  partitioned snapshots (see strpart.c)
+ *      19-oct-26  separate Position and Velocity if stored in other
+ *                 precision (see put_prec)
  */
 
 /*
@@ -148,9 +152,24 @@ int *ofptr;			/* pointer to output bit flags */
 {
     real *rvbuf, *rvp;
     Body *bp;
+    int k;
 
     if (*ofptr & PhaseSpaceBit) {
 #ifdef Phase
+	if (! streq(prec_type(outstr, PosTag, RealType), RealType) ||
+	      ! streq(prec_type(outstr, VelTag, RealType), RealType)) {
+	    rvbuf = (real *) allocate((size_t)(*nbptr) * NDIM * sizeof(real));
+	    for (k = 0; k < 2; k++) {		/* each in its own precision */
+		for (bp = *btptr, rvp = rvbuf; bp < *btptr + *nbptr; bp++) {
+		    SETV(rvp, Phase(bp)[k]);
+		    rvp += NDIM;
+		}
+		put_data(outstr, k == 0 ? PosTag : VelTag, RealType, rvbuf,
+			 *nbptr, NDIM, 0);
+	    }
+	    free(rvbuf);
+	    return;
+	}
         rvbuf = (real *) allocate((size_t)(*nbptr) * 2 * NDIM * sizeof(real));
 	for (bp = *btptr, rvp = rvbuf; bp < *btptr + *nbptr; bp++) {
 	    SETV(rvp, Phase(bp)[0]);
@@ -425,6 +444,8 @@ int *ofptr)			/* pointer to output bit flags */
 local void put_snap_diagnostics(stream outstr, int *ofptr); 
 #endif
 
+#include <snapshot/put_snap_parts.c>
+
 /*
  * PUT_SNAP: controling routine for snapshot output.
  */
@@ -442,12 +463,16 @@ real *tsptr;			/* pointer to time of output */
 int *ofptr;			/* pointer to output bit flags */
 {
     if (ofptr) {
+	put_index_set(outstr, SnapShotTag,
+		      (*ofptr & TimeBit) ? (double) *tsptr : NAN);
 	put_set(outstr, SnapShotTag);
 	put_snap_param(outstr, btptr, nbptr, tsptr, ofptr);
-	put_snap_body(outstr, btptr, nbptr, ofptr);
+	if (!put_snap_parts(outstr, btptr, nbptr, tsptr, ofptr))
+	    put_snap_body(outstr, btptr, nbptr, ofptr);
 	put_snap_diagnostics(outstr, ofptr);
 	put_tes(outstr, SnapShotTag);
 	fflush(outstr);
+	put_index_tes(outstr);
     }
 }
 
@@ -8,6 +8,7 @@
  *	22-feb-94  ansi header (w/ allocate)	PJT
  *	25-mar-97  removed nested decl fflush() PJT
  *       7-jan-99  random + common I/O          PJT
+ *      19-oct-26  partitioned snapshots (see strpart.c)
  */
 
 /*
@@ -430,6 +431,9 @@ int *ofptr;			/* pointer to output bit flags */
 
 #endif
 
+#define SerialParts		/* the workers share the common buffer */
+#include <snapshot/put_snap_parts.c>
+
 /*
  * PUT_SNAP: controling routine for snapshot output.
  */
@@ -454,12 +458,16 @@ int *ofptr;			/* pointer to output bit flags */
         first_io_put = 0;
     }
 #endif
+	put_index_set(outstr, SnapShotTag,
+		      (*ofptr & TimeBit) ? (double) *tsptr : NAN);
 	put_set(outstr, SnapShotTag);
 	put_snap_param(outstr, btptr, nbptr, tsptr, ofptr);
-	put_snap_body(outstr, btptr, nbptr, ofptr);
+	if (!put_snap_parts(outstr, btptr, nbptr, tsptr, ofptr))
+	    put_snap_body(outstr, btptr, nbptr, ofptr);
 	put_snap_diagnostics(outstr, ofptr);
 	put_tes(outstr, SnapShotTag);
 	fflush(outstr);
+	put_index_tes(outstr);
     }
 }
 
@@ -0,0 +1,75 @@
+/*
+ * PUT_SNAP_PARTS.C: output of the bodies of a partitioned snapshot.
+ *	Note: this file is included by put_snap-old.c and put_snap-ran.c,
+ *	      after the worker routines
+ *
+ *	19-oct-2026  created
+ */
+
+/*
+ * With $NEMOPARTS set to more than 1, put_snap writes the bodies of a
+ * snapshot into that many part files, each by its own thread, and in the
+ * output file itself only the Parameters and a Parts set saying where the
+ * bodies went; see strpart.c. Each part is written with put_snap_param and
+ * put_snap_body for its range of bodies, so worker routines supplied by
+ * the program must not share buffers between calls; if they do, define
+ * SerialParts to write the parts one after the other.
+ */
+
+#ifndef put_snap_parts
+
+#define put_snap_parts  _put_snap_parts
+
+typedef struct {
+    stream *part;		/* part streams */
+    Body *btab;			/* all bodies */
+    int *nobj, *first;		/* bodies in each part, and where they start */
+    real *tsptr;
+    int *ofptr;
+} _put_part_arg;
+
+local void _put_snap_part(int k, void *arg)
+{
+    _put_part_arg *pa = (_put_part_arg *) arg;
+    Body *bp = pa->btab + pa->first[k];
+    int nb = pa->nobj[k];
+
+    put_set(pa->part[k], SnapShotTag);
+    put_snap_param(pa->part[k], &bp, &nb, pa->tsptr, pa->ofptr);
+    put_snap_body(pa->part[k], &bp, &nb, pa->ofptr);
+    put_tes(pa->part[k], SnapShotTag);
+    fflush(pa->part[k]);
+}
+
+local bool
+_put_snap_parts(
+stream outstr,			/* output stream, of course */
+Body **btptr,			/* pointer to body array */
+int *nbptr,			/* pointer to number of bodies */
+real *tsptr,			/* pointer to time of output */
+int *ofptr)			/* pointer to output bit flags */
+{
+    _put_part_arg pa;
+    int nparts, k;
+
+    pa.part = put_parts(outstr, *nbptr, &nparts, &pa.nobj);
+    if (pa.part == NULL)
+	return FALSE;
+    pa.first = (int *) allocate(nparts * sizeof(int));
+    for (k = 1; k < nparts; k++)
+	pa.first[k] = pa.first[k-1] + pa.nobj[k-1];
+    pa.btab = *btptr;
+    pa.tsptr = tsptr;
+    pa.ofptr = ofptr;
+#if defined(SerialParts)
+    for (k = 0; k < nparts; k++)
+	_put_snap_part(k, &pa);
+#else
+    run_parts(nparts, _put_snap_part, &pa);
+#endif
+    free(pa.first);
+    put_parts_tes(outstr);
+    return TRUE;
+}
+
+#endif
@@ -7,6 +7,7 @@
  *      nov-2003        removed Yanc tags (YANC is also called gyrfalcON now)
  *      feb-2004        added some new SPH stuff (GasDensity, NPartners, NSPHPartners)
  *      may-2010        added in a few tag from atos.c for handling its' SPH 
+ *      oct-2026        added Parts tags for partitioned snapshots (strpart.c)
  */
 
 #ifndef _snapshot_h
@@ -55,6 +56,10 @@
 #define     CMPhaseSpaceTag	"CMPhaseSpace"
 #define     CPUTimeTag          "cputime"
 
+#define   PartsTag		"Parts"         /* partitioned snapshots */
+#define     NPartsTag           "Nparts"
+#define     PartOffsetTag       "Offset"
+
 /* Some ZENO compatible tags */
 
 #define	AccTag         	AccelerationTag
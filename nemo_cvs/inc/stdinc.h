@@ -424,6 +424,7 @@ extern "C" {
 /* io/stropen.c */
 
 extern stream stropen(const_string, string);
+extern stream strmem(char **, size_t *);
 extern int    strdelete(stream, bool);
 extern string strname(stream);
 extern bool   strseek(stream);
@@ -11,6 +11,12 @@ int get_atable(stream , int , int *, real **, int);
 int get_itable(stream , int , int *, int **, int);
 int get_ftable(stream , int , int *, string *, real **, int);
 
+/* tabread.c */
+int get_btable(stream, int, int *, real **, int);
+int parse_row(string, real *, int);
+int table_rows(string, int);
+void put_btable(stream, int, real **, int, string, string);
+
 /* table.c */
 int get_line(stream, string);		/* should be deprecated */
 void parse(int, string, double *, int);
@@ -40,6 +40,13 @@
  * V 3.4  12-dec-09   pjt    support the new halfp type for I/O (see also csf)
  *        27-Sep-10   jcl    MINGW32/WINDOWS support
  *   3.5   8-jun-13   pjt    eltcnt type fixed for 64bit so it handles > 2B
+ *   3.6  19-oct-26          map large items of seekable input (MMAP), get_data_ptr
+ *   3.7  19-oct-26          get_pos/get_goto: reposition top level input
+ *   3.8  19-oct-26          chunked compressed items (ZIP), put_zip, $NEMOZIP
+ *        19-oct-26          strclose waits for asynchronous output (strasync.c)
+ *        19-oct-26          per thread findstream cache, strclose closes parts
+ *   3.9  19-oct-26          per item storage precision (put_prec, $NEMOPREC),
+ *                           blocked f/d/h conversion on input
  *
  *  Although the SWAP test is done on input for every item - for deferred
  *  input it may fail if in the mean time another file was read which was
@@ -56,6 +63,16 @@
 #include <extstring.h>
 #include "filesecret.h"
 #include <stdarg.h>
+#include <stdint.h>
+#if defined(MMAP)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
+#if defined(ZIP)
+#include <zlib.h>
+#endif
 
 extern int convert_d2f(int, double *, float  *);
 extern int convert_f2d(int, float  *, double *);
@@ -322,11 +339,93 @@ void put_data_sub(
     bool con)		/* coercion flag (not used) */
 {
     itemptr ipt;
+    string styp;
+    void *buf = NULL;
+    long n;
 
     ipt = makeitem(typ, tag, dat, dim);		/* make item wo/ copying    */
+    styp = prec_type(str, tag, typ);		/* precision to store it in */
+    if (dat != NULL && ! streq(styp, typ)) {	/* convert a copy first?    */
+	n = eltcnt(ipt, 0);
+	buf = allocate(MAX(n, 1) * baselen(styp));
+	cvtdata(typ, styp, n, dat, buf);
+	ItemTyp(ipt) = styp;
+	ItemLen(ipt) = baselen(styp);
+	ItemDat(ipt) = buf;
+    }
     if (! putitem(str, ipt)) 			/* output external rep.     */
 	error("put_data_sub: putitem failed");
     freeitem(ipt, FALSE);			/* and reclaim storage      */
+    if (buf != NULL)
+	free(buf);
+}
+
+/*
+ * PUT_ZIP: compress large plural items written from now on with deflate
+ * level (1..9, 0 turns it off), keeping only bits mantissa bits of Float
+ * and Double items (0 keeps all). The default comes from $NEMOZIP.
+ */
+void put_zip(stream str, int level, int bits)
+{
+    strstkptr sspt;
+
+    sspt = findstream(str);			/* get stream-stack struct  */
+#if defined(ZIP)
+    sspt->ss_zip = MAX(0, MIN(level, 9));
+    sspt->ss_zipbits = MAX(0, bits);
+#else
+    if (level > 0)
+	warning("put_zip: no zlib, output not compressed");
+#endif
+}
+
+/*
+ * PUT_PREC: store Float, Double and Halfp items written from now on in the
+ * precision given for their tag in prec, a list of tag:type with type
+ * d(ouble), f(loat) or h(alf), e.g. "Velocity:f,Potential:h"; other items,
+ * and all of them if prec is NULL or empty, are stored as given. The
+ * default comes from $NEMOPREC. Half precision holds 11 significant bits
+ * and magnitudes up to 65504.
+ */
+void put_prec(stream str, string prec)
+{
+    strstkptr sspt;
+
+    sspt = findstream(str);			/* get stream-stack struct  */
+    sspt->ss_prec = (prec != NULL && *prec != 0) ? scopy(prec) : NULL;
+}
+
+/*
+ * PREC_TYPE: type in which str stores an item tag handed to it as typ.
+ */
+string prec_type(stream str, string tag, string typ)
+{
+    strstkptr sspt;
+    string cp;
+    size_t n;
+
+    if (tag == NULL || ! (streq(typ, DoubleType) || streq(typ, FloatType) ||
+			  streq(typ, HalfpType)))
+	return typ;				/* only reals are converted */
+    sspt = findstream(str);
+    if ((cp = sspt->ss_prec) == NULL)
+	return typ;
+    n = strlen(tag);
+    for (;;) {					/* scan tag:type list       */
+	while (*cp == ',' || *cp == ' ')
+	    cp++;
+	if (*cp == 0)
+	    return typ;
+	if (strncmp(cp, tag, n) == 0 && cp[n] == ':')
+	    switch (cp[n+1]) {
+	      case 'd': return DoubleType;
+	      case 'f': return FloatType;
+	      case 'h': return HalfpType;
+	      default:  return typ;
+	    }
+	while (*cp != 0 && *cp != ',')
+	    cp++;
+    }
 }
 
 /************************************************************************/
@@ -576,6 +675,99 @@ void get_data_sub(
     ipt = scantag(sspt, tag);			/* scan input for tag	    */
     if (ipt == NULL)				/* check input succeeded    */
 	error("get_data: at EOF");
+    cop = checkdata(ipt, tag, typ, dim, con);	/* match type and shape     */
+    (cop)(dat, 0, eltcnt(ipt,0), ipt, str);    	/* copy data from input     */ /*C++*/
+    if (sspt->ss_stp == -1)			/* was input at top level?  */
+	freeitem(ipt, TRUE);			/*   yes, free saved item   */
+}
+
+/*
+ * GET_DATA_PTR: like get_data, but return a read-only pointer to the
+ * data instead of copying it out.
+ * Synopsis: dat = get_data_ptr(str, tag, typ, dimN, ..., dim1, 0)
+ */
+const void *get_data_ptr(stream str, string tag, string typ, int dim1, ...)
+{
+    va_list ap;
+    int dim[MaxVecDim], n = 0;
+
+    dim[0] = dim1;
+    va_start(ap, dim1);				/* access argument list     */
+    while (dim[n++] > 0) {			/* loop reading dimensions  */
+	if (n >= MaxVecDim)			/*   no room for any more?  */
+	    error("get_data_ptr: item %s: too many dims", tag);
+	dim[n] = va_arg(ap, int);		/*   else get next argument */
+    } 
+    va_end(ap);
+    						/* call next level routine  */
+    return get_data_ptr_sub(str, tag, typ, (dim[0] != 0 ? dim : NULL), FALSE);
+}
+
+/*
+ * GET_DATA_PTR_SUB: worker for get_data_ptr.  If the item is in core or
+ * mapped (see getdat) and needs no conversion, a pointer to it is handed
+ * out as is; a deferred item is first read in, and a converted one goes
+ * to a buffer owned by the item.  The data is valid until the enclosing
+ * set is closed by get_tes, for a top level item until the next top level
+ * get_data_ptr or strclose, and a converted copy until the next converted
+ * get_data_ptr of the same item.
+ */
+const void *get_data_ptr_sub(
+    stream str,             	/* stream to read data from */
+    string tag,             	/* expected item tag */
+    string typ,               	/* expected data type */
+    int *dim,			/* array of dimensions */
+    bool con)			/* coercion flag */
+{
+    strstkptr sspt;
+    itemptr ipt;
+    copyproc cop;
+    size_t len;
+    void *buf;
+
+    sspt = findstream(str);			/* access assoc. info	    */
+    ipt = scantag(sspt, tag);			/* scan input for tag	    */
+    if (ipt == NULL)				/* check input succeeded    */
+	error("get_data_ptr: at EOF");
+    cop = checkdata(ipt, tag, typ, dim, con);	/* match type and shape     */
+    if (sspt->ss_stp == -1) {			/* input at top level?      */
+	if (sspt->ss_hold != NULL)		/*   release previous one   */
+	    freeitem(sspt->ss_hold, TRUE);
+	sspt->ss_hold = ipt;			/*   and keep this one      */
+    }
+    if (cop == copydata) {			/* no conversion needed?    */
+	if (ItemDat(ipt) == NULL) {		/*   still deferred: load   */
+	    len = datlen(ipt,0);
+	    buf = calloc(len > 0 ? len : 1, 1);
+	    if (buf == NULL)
+		error("get_data_ptr: item %s: no memory (%ld bytes)", tag, (long) len);
+	    copydata(buf, 0, eltcnt(ipt,0), ipt, str);
+	    ItemDat(ipt) = buf;			/*   now it is in core      */
+	}
+#if defined(MMAP)
+	if (ItemMap(ipt) != NULL)		/*   start reading ahead    */
+	    madvise(ItemMap(ipt), ItemMapLen(ipt), MADV_WILLNEED);
+#endif
+	return ItemDat(ipt);
+    }
+    if (ItemBuf(ipt) != NULL)			/* drop earlier conversion  */
+	free(ItemBuf(ipt));
+    len = eltcnt(ipt,0) * baselen(typ);
+    ItemBuf(ipt) = calloc(len > 0 ? len : 1, 1);
+    if (ItemBuf(ipt) == NULL)
+	error("get_data_ptr: item %s: no memory (%ld bytes)", tag, (long) len);
+    (cop)(ItemBuf(ipt), 0, eltcnt(ipt,0), ipt, str);
+    return ItemBuf(ipt);
+}
+
+/*
+ * CHECKDATA: check that an input item can be delivered in the requested
+ * type and shape; returns the copy routine to use.
+ */
+local copyproc checkdata(itemptr ipt, string tag, string typ, int *dim, bool con)
+{
+    copyproc cop;
+
     if (! con) {				/* rigid type checking?     */
 	if(! streq(typ, ItemTyp(ipt)))		/*   and types dont match?  */
 	    error("get_data_sub: item %s: types %s, %s don't match",
@@ -584,7 +776,7 @@ void get_data_sub(
     } else {
 	cop = copyfun(ItemTyp(ipt), typ);	/*   get specialist routine */
 	if (cop == NULL)			/*   but be sure one exists */
-	    error("get_data_sub: item %s: types %d, %d don't convert",
+	    error("get_data_sub: item %s: types %s, %s don't convert",
 		  tag, ItemTyp(ipt), typ);
     }
     if (dim != NULL && ItemDim(ipt) != NULL &&	/* check layout of data     */
@@ -594,11 +786,9 @@ void get_data_sub(
 	error("get_data_sub: item %s: can't copy plural to scalar", tag);
     else if (dim != NULL && ItemDim(ipt) == NULL)
 	error("get_data_sub: item %s: can't copy scalar to plural", tag);
-    (cop)(dat, 0, eltcnt(ipt,0), ipt, str);    	/* copy data from input     */ /*C++*/
-    if (sspt->ss_stp == -1)			/* was input at top level?  */
-	freeitem(ipt, TRUE);			/*   yes, free saved item   */
+    return cop;
 }
-
+
 /************************************************************************/
 /*                          USER INPUT FUNCTIONS (RANDOM)               */
 /************************************************************************/
@@ -866,6 +1056,82 @@ bool skip_item(
     }
 }
 
+/*
+ * GET_POS: file offset of the next top level item, i.e. the one the next
+ * get_tag_ok() or put_set() at top level sees. Returns -1 if the stream
+ * cannot seek or is not at top level.
+ */
+
+off_t get_pos(
+    stream str			/* stream obtained from stropen */
+) {
+    strstkptr sspt;
+
+    sspt = findstream(str);			/* lookup associated entry  */
+    if (sspt->ss_stp != -1 || !strseek(str))	/* within set, or a pipe?   */
+	return -1;
+    if (sspt->ss_stk[0] != NULL)		/* pending item read ahead? */
+	return sspt->ss_top;			/*   then where it started  */
+    return ftello(str);
+}
+
+/*
+ * GET_GOTO: continue top level input at offset pos, as found by get_pos,
+ * if a set named tag starts there. The pending item is dropped; data lent
+ * out by get_data_ptr stays valid. Returns FALSE, and leaves the stream
+ * alone, if there is no such set at pos.
+ */
+
+bool get_goto(
+    stream str,			/* input stream obtained from stropen */
+    off_t pos,			/* offset of a top level set */
+    string tag			/* tag of that set */
+) {
+    strstkptr sspt;
+
+    sspt = findstream(str);			/* lookup associated entry  */
+    if (sspt->ss_stp != -1)			/* only at top level	    */
+	error("get_goto: not at top level");
+    if (!strseek(str) || !peekset(str, pos, tag))
+	return FALSE;
+    if (sspt->ss_stk[0] != NULL) {		/* pending item read ahead? */
+	freeitem(sspt->ss_stk[0], TRUE);	/*   forget about it        */
+	sspt->ss_stk[0] = NULL;
+    }
+    safeseek(str, pos, 0);			/* next item comes from pos */
+    return TRUE;
+}
+
+/*
+ * PEEKSET: check if a set named tag starts at pos, without disturbing the
+ * stream or calling error() on garbage, as gethdr would.
+ */
+
+local bool peekset(stream str, off_t pos, string tag)
+{
+    off_t oldpos = ftello(str);
+    short num;
+    char buf[MaxTagLen+1];
+    int i, c;
+    bool ok = FALSE;
+
+    if (pos < 0 || fseeko(str, pos, 0) == -1)
+	return FALSE;
+    if (fread(&num, sizeof(short), 1, str) == 1) {
+#if defined(CHKSWAP)
+	if (num != SingMagic && num != PlurMagic)
+	    bswap(&num, sizeof(short), 1);
+#endif
+	if (num == SingMagic && getc(str) == SetType[0] && getc(str) == 0) {
+	    for (i = 0; i <= MaxTagLen && (c = getc(str)) != EOF; i++)
+		if ((buf[i] = c) == 0) break;
+	    ok = i <= MaxTagLen && c == 0 && streq(buf, tag);
+	}
+    }
+    safeseek(str, oldpos, 0);
+    return ok;
+}
+
 /************************************************************************/
 /*                                OUTPUT                                */
 /************************************************************************/
@@ -901,6 +1167,12 @@ local bool writeitem(stream str, itemptr ipt)
 
 local bool putitem(stream str, itemptr ipt)
 {
+#if defined(ZIP)
+    strstkptr sspt = findstream(str);
+
+    if (zipout(sspt, ipt))			/* large enough to compress?*/
+	return putzip(str, ipt, sspt->ss_zip, sspt->ss_zipbits);
+#endif
     if (! puthdr(str, ipt))                     /* write item header        */
         return (FALSE);
     if (! streq(ItemTyp(ipt), SetType) && ! streq(ItemTyp(ipt), TesType))
@@ -919,7 +1191,8 @@ local bool puthdr(stream str, itemptr ipt)
     short num;
 
     
-    num = (ItemDim(ipt) == NULL) ? SingMagic : PlurMagic;
+    num = (ItemDim(ipt) == NULL) ? SingMagic :
+	  (ItemZip(ipt) == NULL) ? PlurMagic : ZipMagic;
     						/* determine magic number   */
     if (fwrite((char *)&num, sizeof(short), 1, str) != 1)
 	return (FALSE);				/* return FALSE on failure  */
@@ -991,6 +1264,8 @@ local itemptr nextitem(strstkptr sspt)
     if (sspt->ss_stk[0] != NULL)		/* pending item exists?     */
 	ipt = sspt->ss_stk[0];			/*   then use it	    */
     else {					/* nothing pending?	    */
+	sspt->ss_top = strseek(sspt->ss_str) ? ftello(sspt->ss_str) : -1;
+						/*   remember where it was  */
 	ipt = readitem(sspt->ss_str, NULL);	/*   read next item in      */
 	sspt->ss_stk[0] = ipt;			/*   and save for later     */
     }
@@ -1069,11 +1344,13 @@ local itemptr gethdr(stream str)
     short num;
     string typ, tag;
     int *dim, *ip;  /* ISSWAP */
+    itemptr ipt;
     permanent bool firsttime = TRUE;
 
     if (fread(&num, sizeof(short), 1, str) != 1)/* read magic number*/
 	return NULL;				/*   return NULL on EOF     */
-    if (num == SingMagic || num == PlurMagic) {	/* new-style magic number?  */
+    if (num == SingMagic || num == PlurMagic || ZIPMAGIC(num)) {
+						/* new-style magic number?  */
 	typ = (string) getxstr(str, sizeof(char));
 						/*   read type string       */
 	if (typ == NULL)			/*   check for EOF          */
@@ -1083,7 +1360,8 @@ local itemptr gethdr(stream str)
 #if defined(CHKSWAP)
     else {        /* ISSWAP */
         bswap((char *)&num,sizeof(short int),1);        /* swap the bytes */
-        if (num == SingMagic || num == PlurMagic) {    /* test the swapped */
+        if (num == SingMagic || num == PlurMagic || ZIPMAGIC(num)) {
+						/* test the swapped */
             if (firsttime)
                 fprintf(stderr,"[filestruct: reading swapped]");
 	    typ = (string) getxstr(str, sizeof(char));
@@ -1108,7 +1386,7 @@ local itemptr gethdr(stream str)
 	    error("gethdr: EOF reading tag");
     } else
 	tag = NULL;				/*   item is not tagged     */
-    if (num == PlurMagic) {			/* are dimensions next?     */
+    if (num != SingMagic) {			/* are dimensions next?     */
 	dim = (int *) getxstr(str, sizeof(int));
 	if (dim == NULL)			/*   check for EOF          */
 	    error("gethdr: EOF reading dimensions");
@@ -1123,7 +1401,19 @@ local itemptr gethdr(stream str)
 #endif
     } else
 	dim = NULL;
-    return (makeitem(typ, tag, NULL, dim));	/* return item less data    */
+    ipt = makeitem(typ, tag, NULL, dim);	/* make item less data      */
+#if defined(ZIP)
+    if (num == ZipMagic) {			/* compressed data follows? */
+	ItemZip(ipt) = (zipdir *) calloc(1, sizeof(zipdir));
+	if (ItemZip(ipt) == NULL)
+	    error("gethdr: item %s: no memory", tag);
+	ItemZip(ipt)->zipcached = -1;
+#if defined(CHKSWAP)
+	ItemZip(ipt)->zipswap = swap;
+#endif
+    }
+#endif
+    return ipt;					/* return item less data    */
 } /* gethdr */
 /*
  * GETHDR: read a item header from a stream.
@@ -1138,13 +1428,13 @@ bool qsf(stream str)
 
     if (fread(&num, sizeof(short), 1, str) != 1)/* read magic number        */
 	return FALSE;				/*   return NULL on EOF     */
-    if (num == SingMagic || num == PlurMagic) {	/* new-style magic number?  */
+    if (num == SingMagic || num == PlurMagic || ZIPMAGIC(num)) {
         return TRUE;
     }
 #if defined(CHKSWAP)
     else {
         bswap(&num,sizeof(short int),1);        /* swap the bytes */
-        if (num == SingMagic || num == PlurMagic) {    /* test the swapped */
+        if (num == SingMagic || num == PlurMagic || ZIPMAGIC(num)) {
             return TRUE;
         } else {
             return FALSE;
@@ -1162,11 +1452,20 @@ bool qsf(stream str)
  */
 
 #define MaxReadNow  256
+#define MinMapLen   65536
+#define MinZipLen   65536			/* smallest item to compress */
+#define ZipChunkLen (1<<20)			/* raw bytes per chunk */
 
 local void getdat(itemptr ipt, stream str)
 {
     size_t dlen, elen;
 
+#if defined(ZIP)
+    if (ItemZip(ipt) != NULL) {			/* compressed item?         */
+	getzip(ipt, str);
+	return;
+    }
+#endif
     elen = eltcnt(ipt, 0);
     dlen = elen * ItemLen(ipt);                 /* count bytes of data	    */
 #if 0
@@ -1183,10 +1482,398 @@ local void getdat(itemptr ipt, stream str)
     } else {					/* too big, so skip now     */
 	ItemDat(ipt) = NULL;			/*   no data in core	    */
 	ItemPos(ipt) = ftello(str);		/*   remember this place    */
+#if defined(MMAP)
+	if (dlen >= MinMapLen && !swap)		/*   large and native?      */
+	    mapdat(ipt, str, dlen);		/*     map it if we can     */
+#endif
 	safeseek(str, dlen, 1);			/*   skip over data	    */
     }
 } /* getdat */
+
+#if defined(MMAP)
+/*
+ * MAPDAT: map the data of a deferred item read-only, so get_data can copy
+ * straight from the page cache and get_data_ptr need not copy at all.
+ * Only plain files opened read-only are mapped; NEMOMMAP=0 turns it off.
+ * Returns FALSE, leaving the item deferred, if the item was not mapped.
+ */
+
+local bool mapdat(itemptr ipt, stream str, size_t dlen)
+{
+    permanent int usemap = -1;
+    permanent long pagesize = 0;
+    struct stat st;
+    string cp;
+    int fd = fileno(str);
+    off_t base;
+    size_t len;
+    void *map;
+
+    if (usemap < 0) {
+	cp = getenv("NEMOMMAP");
+	usemap = (cp == NULL || *cp != '0');
+	pagesize = sysconf(_SC_PAGESIZE);
+    }
+    if (!usemap || fd < 0)
+	return FALSE;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode))
+	return FALSE;
+    if ((fcntl(fd, F_GETFL) & O_ACCMODE) != O_RDONLY)
+	return FALSE;
+    if (ItemPos(ipt) + (off_t) dlen > st.st_size)	/* let saferead complain    */
+	return FALSE;
+    base = ItemPos(ipt) - ItemPos(ipt) % pagesize;	/* mmap wants page offsets  */
+    len = dlen + (size_t) (ItemPos(ipt) - base);
+    map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, base);
+    if (map == MAP_FAILED) {
+	dprintf(1, "mapdat: %s: mmap of %ld bytes failed\n", ItemTag(ipt), (long) len);
+	return FALSE;
+    }
+    madvise(map, len, MADV_SEQUENTIAL);
+    ItemMap(ipt) = map;
+    ItemMapLen(ipt) = len;
+    ItemDat(ipt) = (char *) map + (ItemPos(ipt) - base);
+    return TRUE;
+}
+#endif
 
+#if defined(ZIP)
+/************************************************************************/
+/*                          COMPRESSED ITEMS                            */
+/************************************************************************/
+
+/*
+ * A plural item of at least MinZipLen bytes is written compressed if the
+ * output stream asks for it (put_zip, $NEMOZIP). Its data is cut in chunks
+ * of ZipChunkLen bytes, whose bytes are shuffled (all first bytes of the
+ * elements, then all second bytes, ...) and deflated independently, so
+ * chunks can be compressed and inflated in parallel (OpenMP) and
+ * get_data_ran/get_data_blocked only inflate the chunks they need. Readers
+ * older than V3.8 stop at such an item with "bad magic"; csf with
+ * NEMOZIP=0 rewrites a file without compression.
+ */
+
+/*
+ * ZIPENV: set the compression of a new stream from $NEMOZIP=level[,bits].
+ */
+
+local void zipenv(strstkptr sspt)
+{
+    permanent int level = -1, bits = 0;
+    string cp;
+
+    if (level < 0) {				/* first time: parse it     */
+	level = 0;
+	if ((cp = getenv("NEMOZIP")) != NULL)
+	    sscanf(cp, "%d,%d", &level, &bits);
+	level = MAX(0, MIN(level, 9));
+	bits = MAX(0, bits);
+    }
+    sspt->ss_zip = level;
+    sspt->ss_zipbits = bits;
+}
+
+/*
+ * ZIPOUT: should this item go out compressed?
+ */
+
+local bool zipout(strstkptr sspt, itemptr ipt)
+{
+    return sspt->ss_zip > 0 && ItemDim(ipt) != NULL && ItemDat(ipt) != NULL &&
+	   datlen(ipt, 0) >= MinZipLen;
+}
+
+/*
+ * ZIPROUND: round a float or double to bits mantissa bits; the stored
+ * value is still a normal float or double, only easier to compress.
+ */
+
+local void zipround(char *e, int len, int bits)
+{
+    uint32_t u, m32;
+    uint64_t v, m64;
+
+    if (len == sizeof(float) && bits < 23) {
+	memcpy(&u, e, len);
+	if ((u & 0x7f800000) == 0x7f800000) return;	/* inf or nan   */
+	m32 = ((uint32_t) 1 << (23 - bits)) - 1;
+	u += (m32 >> 1) + 1;				/* round        */
+	if ((u & 0x7f800000) == 0x7f800000)		/* not to inf   */
+	    u -= (m32 >> 1) + 1;
+	u &= ~m32;
+	memcpy(e, &u, len);
+    } else if (len == sizeof(double) && bits < 52) {
+	memcpy(&v, e, len);
+	if ((v & 0x7ff0000000000000ULL) == 0x7ff0000000000000ULL) return;
+	m64 = ((uint64_t) 1 << (52 - bits)) - 1;
+	v += (m64 >> 1) + 1;
+	if ((v & 0x7ff0000000000000ULL) == 0x7ff0000000000000ULL)
+	    v -= (m64 >> 1) + 1;
+	v &= ~m64;
+	memcpy(e, &v, len);
+    }
+}
+
+/*
+ * PUTZIP: write a plural item compressed: header, chunk directory, chunks.
+ */
+
+local bool putzip(stream str, itemptr ipt, int level, int bits)
+{
+    zipdir zd;
+    long n = eltcnt(ipt, 0), len = ItemLen(ipt);
+    int c, hdr[3];
+    bool ok, bad = FALSE;
+    char **cbuf;
+    int64_t *csize, zlen = 0;
+
+    if (! streq(ItemTyp(ipt), FloatType) && ! streq(ItemTyp(ipt), DoubleType))
+	bits = 0;				/* only round reals         */
+    zd.zipcodec = ZipDeflate | (len > 1 ? ZipShuffle : 0);
+    zd.zipchunk = MAX(1, ZipChunkLen / len);
+    zd.zipnchunk = (n + zd.zipchunk - 1) / zd.zipchunk;
+    cbuf = (char **) allocate(zd.zipnchunk * sizeof(char *));
+    csize = (int64_t *) allocate(zd.zipnchunk * sizeof(int64_t));
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (c = 0; c < zd.zipnchunk; c++) {	/* compress each chunk      */
+	long first = (long) c * zd.zipchunk, m = MIN(zd.zipchunk, n - first), i;
+	char *raw = (char *) ItemDat(ipt) + first * len, *tmp, e[8];
+	uLongf clen = compressBound(m * len);
+	int k;
+
+	tmp = (char *) malloc(m * len);
+	cbuf[c] = (char *) malloc(clen);
+	if (tmp == NULL || cbuf[c] == NULL) {
+	    bad = TRUE;
+	    free(tmp);
+	    continue;
+	}
+	if (zd.zipcodec & ZipShuffle) {		/*   byte k of element i    */
+	    for (i = 0; i < m; i++) {		/*   goes to tmp[k*m+i]     */
+		memcpy(e, raw + i * len, len);
+		if (bits > 0) zipround(e, len, bits);
+		for (k = 0; k < len; k++)
+		    tmp[k * m + i] = e[k];
+	    }
+	} else
+	    memcpy(tmp, raw, m * len);
+	if (compress2((Bytef *) cbuf[c], &clen, (Bytef *) tmp, m * len, level) != Z_OK ||
+	      clen >= m * len) {		/*   did not compress:      */
+	    memcpy(cbuf[c], raw, m * len);	/*     store chunk as is    */
+	    clen = m * len;
+	}
+	csize[c] = clen;
+	free(tmp);
+    }
+    if (bad)
+	error("putzip: item %s: no memory to compress", ItemTag(ipt));
+    ItemZip(ipt) = &zd;				/* write ZipMagic header    */
+    ok = puthdr(str, ipt);
+    ItemZip(ipt) = NULL;
+    hdr[0] = zd.zipcodec;
+    hdr[1] = zd.zipchunk;
+    hdr[2] = zd.zipnchunk;
+    ok = ok && fwrite(hdr, sizeof(int), 3, str) == 3 &&
+	 fwrite(csize, sizeof(int64_t), zd.zipnchunk, str) == zd.zipnchunk;
+    for (c = 0; c < zd.zipnchunk; c++) {
+	ok = ok && fwrite(cbuf[c], 1, csize[c], str) == csize[c];
+	zlen += csize[c];
+	free(cbuf[c]);
+    }
+    dprintf(2, "putzip: %s: %ld -> %ld bytes in %d chunks\n", ItemTag(ipt),
+	    (long) datlen(ipt, 0), (long) zlen, zd.zipnchunk);
+    free(cbuf);
+    free(csize);
+    return ok;
+}
+
+/*
+ * GETZIP: read the chunk directory of a compressed item. The chunks are
+ * deferred like the data of a large plain item, and mapped if possible;
+ * from a pipe, or if they are small, they are inflated right away.
+ */
+
+local void getzip(itemptr ipt, stream str)
+{
+    zipdir *zd = ItemZip(ipt);
+    long n = eltcnt(ipt, 0);
+    int64_t *csize;
+    int hdr[3], c;
+    size_t zlen;
+
+    saferead(hdr, sizeof(int), 3, str);
+    zd->zipcodec = hdr[0];
+    zd->zipchunk = hdr[1];
+    zd->zipnchunk = hdr[2];
+    if ((zd->zipcodec & ~(ZipShuffle | ZipDeflate)) != 0 || zd->zipchunk <= 0 ||
+	  zd->zipnchunk != (n + zd->zipchunk - 1) / zd->zipchunk)
+	error("getzip: item %s: unknown compression or bad chunks", ItemTag(ipt));
+    csize = (int64_t *) allocate(zd->zipnchunk * sizeof(int64_t));
+    saferead(csize, sizeof(int64_t), zd->zipnchunk, str);
+    zd->zipoff = (off_t *) allocate((zd->zipnchunk + 1) * sizeof(off_t));
+    zd->zipoff[0] = 0;
+    for (c = 0; c < zd->zipnchunk; c++) {
+	if (csize[c] <= 0)
+	    error("getzip: item %s: bad chunk size", ItemTag(ipt));
+	zd->zipoff[c+1] = zd->zipoff[c] + csize[c];
+    }
+    free(csize);
+    zlen = zd->zipoff[zd->zipnchunk];
+    if (zlen <= MaxReadNow || !strseek(str)) {	/* read and inflate now     */
+	zd->zipsrc = (char *) allocate(zlen);
+	if (fread(zd->zipsrc, 1, zlen, str) != zlen)
+	    error("getzip: item %s: error reading %ld bytes", ItemTag(ipt), (long) zlen);
+	zipload(ipt, str);
+	free(zd->zipsrc);
+	free(zd->zipoff);
+	free(zd);
+	ItemZip(ipt) = NULL;			/*   now a plain item       */
+    } else {					/* defer, as getdat does    */
+	ItemPos(ipt) = ftello(str);
+#if defined(MMAP)
+	if (zlen >= MinMapLen && mapdat(ipt, str, zlen)) {
+	    zd->zipsrc = (char *) ItemDat(ipt);	/*   chunks are mapped      */
+	    ItemDat(ipt) = NULL;
+	}
+#endif
+	safeseek(str, zlen, 1);			/*   skip over chunks	    */
+    }
+}
+
+/*
+ * ZIPLOAD: inflate all of a compressed item into ItemDat.
+ */
+
+local void zipload(itemptr ipt, stream str)
+{
+    size_t len = datlen(ipt, 0);
+
+    if (ItemDat(ipt) != NULL)
+	return;
+    ItemDat(ipt) = calloc(len > 0 ? len : 1, 1);
+    if (ItemDat(ipt) == NULL)
+	error("zipload: item %s: no memory (%ld bytes)", ItemTag(ipt), (long) len);
+    unzipdata((char *) ItemDat(ipt), 0, eltcnt(ipt, 0), ipt, str);
+}
+
+/*
+ * ZIPCHUNK: inflate elements a..b-1 of chunk c into dst. Safe to call in
+ * parallel; returns FALSE on bad data.
+ */
+
+local bool zipchunk(itemptr ipt, int fd, int c, char *dst, long a, long b)
+{
+    zipdir *zd = ItemZip(ipt);
+    long len = ItemLen(ipt), first = (long) c * zd->zipchunk, i;
+    long m = MIN(zd->zipchunk, eltcnt(ipt, 0) - first);
+    size_t clen = zd->zipoff[c+1] - zd->zipoff[c];
+    uLongf rlen = m * len;
+    char *src, *in = NULL, *out = NULL;
+    bool ok = TRUE;
+    int k;
+
+    if (zd->zipsrc != NULL)			/* chunks in core or mapped */
+	src = zd->zipsrc + zd->zipoff[c];
+    else {					/* else read chunk, without */
+	in = src = (char *) malloc(clen);	/* moving the file pointer  */
+	if (in == NULL || pread(fd, in, clen, ItemPos(ipt) + zd->zipoff[c]) != (ssize_t) clen) {
+	    free(in);
+	    return FALSE;
+	}
+    }
+    if (clen == m * len)			/* stored as is             */
+	memcpy(dst, src + (a - first) * len, (b - a) * len);
+    else if ((out = (char *) malloc(rlen)) == NULL ||
+	       uncompress((Bytef *) out, &rlen, (Bytef *) src, clen) != Z_OK ||
+	       rlen != m * len)
+	ok = FALSE;
+    else if (zd->zipcodec & ZipShuffle) {	/* unshuffle what we need   */
+	for (i = a; i < b; i++)
+	    for (k = 0; k < len; k++)
+		*dst++ = out[k * m + (i - first)];
+	dst -= (b - a) * len;
+    } else
+	memcpy(dst, out + (a - first) * len, (b - a) * len);
+#if defined(CHKSWAP)
+    if (ok && zd->zipswap)
+	bswap(dst, len, b - a);
+#endif
+    free(in);
+    free(out);
+    return ok;
+}
+
+/*
+ * UNZIPDATA: copy elements off..off+len-1 of a compressed item to dat,
+ * inflating the chunks they are in. The last chunk of a small request is
+ * kept, so get_data_blocked does not inflate a chunk for every block.
+ */
+
+local void unzipdata(char *dat, long off, long len, itemptr ipt, stream str)
+{
+    zipdir *zd = ItemZip(ipt);
+    long elen = ItemLen(ipt), n = eltcnt(ipt, 0), first, m;
+    int c, c0, c1, fd = fileno(str);
+    bool bad = FALSE;
+
+    if (len <= 0)
+	return;
+    if (off < 0 || off + len > n)
+	error("unzipdata: item %s: elements %ld..%ld out of range",
+	      ItemTag(ipt), off, off + len - 1);
+    c0 = off / zd->zipchunk;
+    c1 = (off + len - 1) / zd->zipchunk;
+    if (c0 == c1 && len < zd->zipchunk) {	/* part of one chunk        */
+	first = (long) c0 * zd->zipchunk;
+	m = MIN(zd->zipchunk, n - first);
+	if (zd->zipcached != c0) {
+	    if (zd->zipcache == NULL)
+		zd->zipcache = (char *) allocate(zd->zipchunk * elen);
+	    zd->zipcached = -1;
+	    if (! zipchunk(ipt, fd, c0, zd->zipcache, first, first + m))
+		bad = TRUE;
+	    else
+		zd->zipcached = c0;
+	}
+	if (! bad)
+	    memcpy(dat, zd->zipcache + (off - first) * elen, len * elen);
+    } else {
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) if (c1 > c0)
+#endif
+	for (c = c0; c <= c1; c++) {		/* whole chunks, in parallel */
+	    long a = MAX(off, (long) c * zd->zipchunk);
+	    long b = MIN(off + len, (long) (c + 1) * zd->zipchunk);
+
+	    if (! zipchunk(ipt, fd, c, dat + (a - off) * elen, a, b))
+		bad = TRUE;
+	}
+    }
+    if (bad)
+	error("unzipdata: item %s: cannot read or inflate data", ItemTag(ipt));
+}
+#endif
+
+/*
+ * PRECENV: set the storage precision of a new stream from $NEMOPREC.
+ */
+
+local void precenv(strstkptr sspt)
+{
+    permanent bool first = TRUE;
+    permanent string prec = NULL;
+
+    if (first) {				/* first time: look it up   */
+	first = FALSE;
+	prec = getenv("NEMOPREC");
+	if (prec != NULL && *prec == 0)
+	    prec = NULL;
+    }
+    sspt->ss_prec = prec;
+}
+
 /*
  * COPYFUN: select copy routine for given data types.
  */
@@ -1195,10 +1882,12 @@ local copyproc copyfun(string srctyp, string destyp)
 {
     if (streq(srctyp, destyp))
 	return copydata;
-    if (streq(srctyp, FloatType) && streq(destyp, DoubleType))
-	return (copyproc) copydata_f2d;
-    if (streq(srctyp, DoubleType) && streq(destyp, FloatType))
-	return (copyproc) copydata_d2f;
+    if ((streq(srctyp, FloatType) || streq(srctyp, HalfpType)) &&
+	  streq(destyp, DoubleType))
+	return (copyproc) copydata_2d;
+    if ((streq(srctyp, DoubleType) || streq(srctyp, HalfpType)) &&
+	  streq(destyp, FloatType))
+	return (copyproc) copydata_2f;
     return NULL;
 } /* copyfun */
 
@@ -1216,12 +1905,16 @@ local void copydata(
     char *src, *dat = (char *) vdat;
     off_t oldpos;
       
+#if defined(ZIP)
+    if (ItemDat(ipt) == NULL && ItemZip(ipt) != NULL) {
+	unzipdata(dat, off, len, ipt, str);	/* inflate just those parts */
+	return;
+    }
+#endif
     off *= ItemLen(ipt);                        /* offset bytes from start  */
     if (ItemDat(ipt) != NULL) {			/* data already in core?    */
 	src = (char *) ItemDat(ipt) + off;	/*   get pointer to source  */
-    	len *= ItemLen(ipt);			/* number of bytes to copy  */
-	while (--len >= 0)			/*   loop copying data      */
-	    *dat++ = *src++;			/*     byte by byte         */
+	memcpy(dat, src, (size_t) len * ItemLen(ipt));	/*   copy it all    */
     } else {					/* time to read data in     */
 	oldpos = ftello(str);                   /*   save current place     */
 	safeseek(str, ItemPos(ipt) + off, 0);   /*   seek back to data      */
@@ -1230,70 +1923,128 @@ local void copydata(
     }
 } /* copydata */
 
-local void copydata_f2d(
-    double *dat,
+/*
+ * COPYDATA_CVT: copy real or virtual data, converting between Double, Float
+ * and Halfp; data not in core are read and converted CvtBlock at a time.
+ */
+
+#define CvtBlock  2048
+
+local void copydata_cvt(
+    char *dat,
     int off,
     int len,
     itemptr ipt,
-    stream str)
+    stream str,
+    string typ)
 {
-    float *src;
+    double buf[CvtBlock];			/* room for any source type */
+    size_t dlen = baselen(typ);
     off_t oldpos;
-      
-    off *= ItemLen(ipt);
+    int n;
+
+#if defined(ZIP)
+    if (ItemDat(ipt) == NULL && ItemZip(ipt) != NULL)
+	zipload(ipt, str);			/* inflate it all first     */
+#endif
     if (ItemDat(ipt) != NULL) {			/* data already in core?    */
-	src = (float *) ItemDat(ipt) + off;	/*   get pointer to source  */
-	/*    	len *= ItemLen(ipt);		==> BUG */
-	while (--len >= 0)			/*   loop converting data   */
-	    *dat++ = (double) *src++;		/*     float to double      */
+	cvtdata(ItemTyp(ipt), typ, len,
+		(char *) ItemDat(ipt) + (size_t) off * ItemLen(ipt), dat);
     } else {					/* time to read data in     */
 	oldpos = ftello(str);                   /*   save this position     */
-	safeseek(str, ItemPos(ipt) + off, 0);	/*   seek back to data      */
-	while (--len >= 0)			/*   loop reading data      */
-	    *dat++ = (double) getflt(str);	/*     float to double      */
+	safeseek(str, ItemPos(ipt) + (off_t) off * ItemLen(ipt), 0);
+	while (len > 0) {			/*   loop reading blocks    */
+	    n = MIN(len, CvtBlock);
+	    saferead(buf, ItemLen(ipt), n, str);
+	    cvtdata(ItemTyp(ipt), typ, n, buf, dat);
+	    dat += n * dlen;
+	    len -= n;
+	}
 	safeseek(str, oldpos, 0);               /*   reset file pointer     */
     }
-} /* copydata_f2d */
+}
+
+local void copydata_2d(
+    double *dat,
+    int off,
+    int len,
+    itemptr ipt,
+    stream str)
+{
+    copydata_cvt((char *) dat, off, len, ipt, str, DoubleType);
+}
 
-local void copydata_d2f(
+local void copydata_2f(
     float *dat,
     int off,
     int len,
     itemptr ipt,
     stream str)
 {
-    double *src;
-    off_t oldpos;
-      
-    off *= ItemLen(ipt);
-    if (ItemDat(ipt) != NULL) {			/* data already in core?    */
-	src = (double *) ItemDat(ipt) + off;	/*   get pointer to source  */
-    	/* len *= ItemLen(ipt);		BUG <===	*/
-	while (--len >= 0)			/*   loop converting data   */
-	    *dat++ = (float) *src++;		/*     double to float      */
-    } else {					/* time to read data in     */
-	oldpos = ftello(str);                   /*   save this position     */
-	safeseek(str, ItemPos(ipt) + off, 0);	/*   seek back to data      */
-	while (--len >= 0)			/*   loop reading data      */
-	    *dat++ = (float) getdbl(str);	/*     double to float      */
-	safeseek(str, oldpos, 0);               /*   reset file pointer     */
-    }
-} /* copydata_d2f */
-
-local float getflt(stream str)
+    copydata_cvt((char *) dat, off, len, ipt, str, FloatType);
+}
+
+/*
+ * CVTDATA: convert n reals of type srctyp at src to type destyp at dst.
+ * Half to float is done bit-wise, without branches, so it vectorizes;
+ * a half is converted to float exactly, so also to double via float.
+ */
+
+local void cvtdata(string srctyp, string destyp, long n, void *src, void *dst)
 {
-    float x;
+    float tmp[CvtBlock];
+    double *dp;
+    long i, m;
 
-    saferead((char *)&x, sizeof(float), 1, str);
-    return x; 
+    if (streq(srctyp, destyp))
+	memcpy(dst, src, n * baselen(srctyp));
+    else if (streq(srctyp, DoubleType) && streq(destyp, FloatType))
+	for (i = 0; i < n; i++)
+	    ((float *) dst)[i] = (float) ((double *) src)[i];
+    else if (streq(srctyp, FloatType) && streq(destyp, DoubleType))
+	for (i = 0; i < n; i++)
+	    ((double *) dst)[i] = (double) ((float *) src)[i];
+    else if (streq(srctyp, HalfpType) && streq(destyp, FloatType))
+	h2f(n, (unsigned short *) src, (float *) dst);
+    else if (streq(srctyp, HalfpType) && streq(destyp, DoubleType))
+	for (dp = (double *) dst; n > 0; n -= m, dp += m) {
+	    m = MIN(n, CvtBlock);
+	    h2f(m, (unsigned short *) src, tmp);
+	    for (i = 0; i < m; i++)
+		dp[i] = (double) tmp[i];
+	    src = (unsigned short *) src + m;
+	}
+    else if (streq(srctyp, FloatType) && streq(destyp, HalfpType))
+	convert_f2h((int) n, (float *) src, (halfp *) dst);
+    else if (streq(srctyp, DoubleType) && streq(destyp, HalfpType))
+	convert_d2h((int) n, (double *) src, (halfp *) dst);
+    else
+	error("cvtdata: cannot convert %s to %s", srctyp, destyp);
 }
 
-local double getdbl(stream str)
+/*
+ * H2F: half to single precision. The exponent and mantissa bits of the
+ * half, shifted into place, are a float 2^-112 times the value, which
+ * also takes care of denormals; infinities and NaNs keep their mantissa.
+ */
+
+local void h2f(long n, unsigned short *h, float *f)
 {
-    double x;
+    long i;
+    uint32_t em, u;
+    float x;
 
-    saferead((char *)&x, sizeof(double), 1, str);
-    return x;
+    for (i = 0; i < n; i++) {
+	em = h[i] & 0x7fff;
+	u = em << 13;
+	memcpy(&x, &u, sizeof(x));
+	x *= 5.192296858534828e+33f;		/* 2^112 */
+	memcpy(&u, &x, sizeof(u));
+	if (em >= 0x7c00)			/* Inf or NaN */
+	    u = 0x7f800000 | ((em & 0x3ff) << 13);
+	u |= (uint32_t) (h[i] & 0x8000) << 16;
+	memcpy(&f[i], &u, sizeof(u));
+    }
 }
 
 local void saferead(
@@ -1404,8 +2155,24 @@ local void freeitem(
         free(ItemTag(ipt));                     /*   then free copy of tag  */
     if (flg && ItemDim(ipt) != NULL)
         free(ItemDim(ipt));
+#if defined(MMAP)
+    if (flg && ItemMap(ipt) != NULL) {		/* data is a mapped file?   */
+        munmap(ItemMap(ipt), ItemMapLen(ipt));
+        if (ItemZip(ipt) == NULL)		/*   (or its chunks are)    */
+            ItemDat(ipt) = NULL;
+    }
+#endif
+#if defined(ZIP)
+    if (flg && ItemZip(ipt) != NULL) {
+        free(ItemZip(ipt)->zipoff);
+        free(ItemZip(ipt)->zipcache);
+        free(ItemZip(ipt));
+    }
+#endif
     if (flg && ItemDat(ipt) != NULL)
         free(ItemDat(ipt));
+    if (flg && ItemBuf(ipt) != NULL)
+        free(ItemBuf(ipt));
     free(ipt);                                  /* free item itself         */
 }
 
@@ -1472,11 +2239,12 @@ local string findtype(string *a, string type)
  * If none is found, a new entry is initialized.
  * The table is small, no hash table is needed, although a quick
  * lookup is provided by first comparing it with the one used in 
- * the previous findstream() call.
+ * the previous findstream() call of the same thread.
  * A small degrading in performance may be the result in alternating I/O
  */
 
-local strstk strtable[StrTabLen], *last = NULL;
+local strstk strtable[StrTabLen];
+local ThreadLocal strstk *last = NULL;
 
 local strstkptr findstream(stream str)
 {
@@ -1502,6 +2270,14 @@ local strstkptr findstream(stream str)
     stfree->ss_stk[0] = NULL;			/* clear pending item	    */
     stfree->ss_stp = -1;			/* empty item stack	    */
     stfree->ss_seek = TRUE;			/* permit seeks on stream   */
+    stfree->ss_hold = NULL;			/* no data lent out         */
+    stfree->ss_top = -1;			/* nothing read ahead yet   */
+#if defined(ZIP)
+    zipenv(stfree);				/* compress output?         */
+#else
+    stfree->ss_zip = stfree->ss_zipbits = 0;
+#endif
+    precenv(stfree);				/* convert reals on output? */
 #if defined(RANDOM)
     stfree->ss_ran = NULL;                      /* mark as no item random   */
     stfree->ss_pos = 0L;                        /* set at start of file     */
@@ -1536,12 +2312,17 @@ void strclose(stream str)
 {
     strstkptr sspt;
 
+    end_async(str);				/* finish background output */
+    end_parts(str);				/* close its part files     */
     sspt = findstream(str);			/* lookup associated entry  */
     if (sspt->ss_stp != -1)			/* dont close if incomplete */
 	error("strclose: not at top level");
     if (sspt->ss_stk[0] != NULL)		/* anything on the stack?   */
 	freeitem(sspt->ss_stk[0], TRUE);	/*   free bottom item	    */
+    if (sspt->ss_hold != NULL)			/* data lent by get_data_ptr */
+	freeitem(sspt->ss_hold, TRUE);
     sspt->ss_str = NULL;			/* remove from strtable	    */
+    end_index(str);				/* drop its snapshot index  */
     last = NULL;                                /* also removed quick access*/
     strdelete(str,FALSE);                       /* delete file if scratch   */
     fclose(str);				/* and close it up for sure */
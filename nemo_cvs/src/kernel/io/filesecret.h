@@ -10,11 +10,22 @@
  *	  14-mar-95   minor cleanup
  *   3.2  15-mar-05   finally using (g++ enforced) cleaned up function prototypes
  *   3.5   8-jun-13   element counter type fixed to handle > 2B
+ *   3.6  19-oct-26   memory mapped input of large items
+ *   3.7  19-oct-26   get_pos/get_goto, for snapshot index files
+ *   3.8  19-oct-26   chunked compressed (ZipMagic) items
+ *        19-oct-26   ThreadLocal swap, so threads can read separate streams
+ *   3.9  19-oct-26   ss_prec: per item storage precision of reals
  */
  
 #define RANDOM  /* allow random access */
+#if !defined(__MINGW32__)
+#define MMAP    /* map large items of seekable input files */
+#endif
 #define CHKSWAP /* allow mixed endian datasets - 
                    this can be dangerous if you are multi-plexing them */
+#if defined(HAVE_LIBZ) && !defined(__MINGW32__)
+#define ZIP     /* chunked, deflated storage of large plural items */
+#endif
 
 /*
  * New-style magic numbers, for (bigendian) FITS type machines (like SUN)
@@ -23,6 +34,33 @@
 
 #define SingMagic  ((011<<8) + 0222)		/* singular items */
 #define PlurMagic  ((013<<8) + 0222)		/* plural items */
+#define ZipMagic   ((015<<8) + 0222)		/* compressed plural items */
+#if defined(ZIP)
+#define ZIPMAGIC(num)  ((num) == ZipMagic)
+#else
+#define ZIPMAGIC(num)  FALSE			/* cannot read them */
+#endif
+
+/*
+ * ZIPDIR: chunk directory of a compressed item. On disk the header of a
+ * ZipMagic item is that of a plural item, followed by the ints codec,
+ * chunk and nchunk, nchunk 64 bit compressed chunk sizes, and the chunks.
+ * A chunk whose size equals its raw size is stored as is.
+ */
+
+#define ZipShuffle  1			/* bytes of elements were shuffled */
+#define ZipDeflate  2			/* chunks were deflated (zlib) */
+
+typedef struct {
+  int    zipcodec;		/* ZipShuffle | ZipDeflate */
+  int    zipchunk;		/* elements per chunk, the last may be short */
+  int    zipnchunk;		/* number of chunks */
+  bool   zipswap;		/* item was written with other endianness */
+  off_t *zipoff;		/* [nchunk+1] offsets of chunks from itempos */
+  char  *zipsrc;		/* mapped chunks, or NULL */
+  int    zipcached;		/* chunk held in zipcache, or -1 */
+  char  *zipcache;		/* last chunk inflated by get_data_blocked/ran */
+} zipdir;
 
 /*
  * ITEM: structure representing data-token.
@@ -36,6 +74,10 @@ typedef struct {
   void  *itemdat;		/* the real goodies, if any, or NULL */
   off_t  itempos;		/* where the item began in stream (i/o) */
   off_t  itemoff;               /* RAN/SEQ offset where the current data ptr is */
+  void  *itemmap;               /* page aligned mapping holding itemdat, or NULL */
+  size_t itemmaplen;            /* length of that mapping */
+  void  *itembuf;               /* converted copy handed out by get_data_ptr */
+  zipdir *itemzip;              /* chunk directory if compressed, or NULL */
 } item, *itemptr;    
 
 #define ItemTyp(ip)  ((ip)->itemtyp)
@@ -45,6 +87,10 @@ typedef struct {
 #define ItemDat(ip)  ((ip)->itemdat)
 #define ItemPos(ip)  ((ip)->itempos)
 #define ItemOff(ip)  ((ip)->itemoff)
+#define ItemMap(ip)  ((ip)->itemmap)
+#define ItemMapLen(ip) ((ip)->itemmaplen)
+#define ItemBuf(ip)  ((ip)->itembuf)
+#define ItemZip(ip)  ((ip)->itemzip)
 
 
 /*
@@ -64,6 +110,11 @@ typedef struct {
   off_t   ss_pos;                 /* tail of file, in case random access */
   itemptr ss_ran;                 /* pointer to random access item */
 #endif
+  itemptr ss_hold;                /* top level item whose data get_data_ptr lent out */
+  off_t   ss_top;                 /* file offset of pending top level item, or -1 */
+  int     ss_zip;                 /* deflate level of large output items, 0=off */
+  int     ss_zipbits;             /* mantissa bits kept of zipped reals, 0=all */
+  string  ss_prec;                /* tag:type storage precision of reals, or NULL */
 } strstk, *strstkptr;
 
 /*
@@ -101,12 +152,18 @@ local itemptr readitem ( stream str, itemptr first );
 local itemptr getitem  ( stream str );
 local itemptr gethdr   ( stream str );
 local void getdat      ( itemptr ipt, stream str );
+#if defined(MMAP)
+local bool mapdat      ( itemptr ipt, stream str, size_t dlen );
+#endif
 local copyproc copyfun ( string srctyp, string destyp );
+local copyproc checkdata ( itemptr ipt, string tag, string typ, int *dim, bool con );
 local void copydata    ( void *dat,   int off, int len, itemptr ipt, stream str );
-local void copydata_f2d( double *dat, int off, int len, itemptr ipt, stream str );
-local void copydata_d2f( float  *dat, int off, int len, itemptr ipt, stream str );
-local float getflt     ( stream str );
-local double getdbl    ( stream str );
+local void copydata_cvt( char *dat,   int off, int len, itemptr ipt, stream str, string typ );
+local void copydata_2d ( double *dat, int off, int len, itemptr ipt, stream str );
+local void copydata_2f ( float  *dat, int off, int len, itemptr ipt, stream str );
+local void cvtdata     ( string srctyp, string destyp, long n, void *src, void *dst );
+local void h2f         ( long n, unsigned short *h, float *f );
+local void precenv     ( strstkptr sspt );
 local void saferead    ( void *dat, int siz, int cnt, stream str );
 local void safeseek    ( stream str, off_t offset, int key );
 local long eltcnt      ( itemptr ipt, int skp );
@@ -118,9 +175,26 @@ local strstkptr findstream ( stream str );
 local void ss_push     ( strstkptr sspt, itemptr ipt );
 local void ss_pop      ( strstkptr sspt );
 local string findtype  ( string *a, string type );
+local bool peekset     ( stream str, off_t pos, string tag );
+#if defined(ZIP)
+local bool zipout      ( strstkptr sspt, itemptr ipt );
+local bool putzip      ( stream str, itemptr ipt, int level, int bits );
+local void getzip      ( itemptr ipt, stream str );
+local void zipload     ( itemptr ipt, stream str );
+local bool zipchunk    ( itemptr ipt, int fd, int c, char *dst, long a, long b );
+local void zipenv      ( strstkptr sspt );
+local void unzipdata   ( char *dat, long off, long len, itemptr ipt, stream str );
+#endif
+
 
+/* state of the last item or stream used: one per thread, see strpart.c */
+#if defined(__GNUC__)
+#define ThreadLocal  __thread
+#else
+#define ThreadLocal
+#endif
 
 #if defined(CHKSWAP)
- local bool swap=FALSE;
+ local ThreadLocal bool swap=FALSE;
 #endif
 
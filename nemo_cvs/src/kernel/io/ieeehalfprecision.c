@@ -60,13 +60,16 @@
 // Includes -------------------------------------------------------------------
 
 #include <string.h>
+#include <stdint.h>
 
 // Macros ---------------------------------------------------------------------
+// (NEMO 19-oct-26: fixed width types, long is 64 bits on LP64 machines,
+//  where the routines refused to convert)
 
-#define  INT16_TYPE          short
-#define UINT16_TYPE unsigned short
-#define  INT32_TYPE          long
-#define UINT32_TYPE unsigned long
+#define  INT16_TYPE  int16_t
+#define UINT16_TYPE uint16_t
+#define  INT32_TYPE  int32_t
+#define UINT32_TYPE uint32_t
 
 // Prototypes -----------------------------------------------------------------
 
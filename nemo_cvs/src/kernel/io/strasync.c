@@ -0,0 +1,235 @@
+/*
+ * STRASYNC:   asynchronous output of top level sets (snapshots), so a
+ *             simulation can go on integrating while its output is written
+ *
+ *   19-oct-2026  created, for potcode and hackcode1
+ *   19-oct-2026  synchronous when snapshots are partitioned (strpart.c)
+ *   19-oct-2026  remove a stale snapshot index (put_index_off)
+ *
+ * Instead of writing a snapshot to its output stream str directly, as in
+ *
+ *	put_snap(str, &btab, &nbody, &tnow, &bits);
+ *
+ * the program writes it into a memory stream, which is then written to str
+ * by a background thread:
+ *
+ *	put_snap(put_async_set(str), &btab, &nbody, &tnow, &bits);
+ *	put_async_tes(str);
+ *
+ * put_async_set() returns the memory stream to write into; put_async_tes()
+ * closes it and queues its buffer for output. Writing into memory is just
+ * a copy of the data, so the caller only waits for the disk when all
+ * $NEMOASYNC buffers (default 2: double buffering) are still waiting to
+ * be written; that limits the memory used if output cannot keep up.
+ * NEMOASYNC=0 writes synchronously, straight to str, as does NEMOPARTS
+ * above 1, as memory streams cannot be partitioned.
+ *
+ * Once a set went out asynchronously, str itself must not be written to
+ * by the program; strclose(str) (via end_async) waits for all buffers to
+ * be written. Anything written before that, e.g. the history, goes out
+ * first. Sets written through memory are not in the snapshot index
+ * (strindex.c), as their file offsets are not known when they are made;
+ * the index an earlier run left for a rewritten file is removed.
+ */
+
+#include <stdinc.h>
+#include <filestruct.h>
+#if !defined(__MINGW32__)
+#define ASYNC
+#include <pthread.h>
+#endif
+
+#define MaxAsyncBuf  16
+
+typedef struct {
+    char *buf;			/* bytes of a set, from strmem() */
+    size_t len;
+} abuf;
+
+local struct sasync {
+    stream str;			/* the real output stream */
+    stream mem;			/* memory stream being written, or NULL */
+    int nbuf;			/* number of buffers */
+    abuf ring[MaxAsyncBuf];	/* queued buffers, oldest at head */
+    int head, count;		/* count buffers queued from head on */
+    size_t size;		/* bytes in the buffer being made */
+    char *data;
+    bool fail;			/* writer could not write */
+    bool stop;			/* writer should quit when queue is empty */
+#if defined(ASYNC)
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t more, less;	/* signal queue grew, shrank */
+#endif
+    struct sasync *next;
+} *alist = NULL;
+
+typedef struct sasync sasync;
+
+local int async_env(void)
+{
+    string cp = getenv("NEMOASYNC");
+    int n = 2;
+
+    if (cp != NULL) n = atoi(cp);
+    cp = getenv("NEMOPARTS");
+    if (cp != NULL && atoi(cp) > 1)
+	n = 0;				/* partitioned output is parallel already */
+    return MAX(0, MIN(n, MaxAsyncBuf));
+}
+
+#if defined(ASYNC)
+/* the background writer: write queued buffers in order */
+local void *async_writer(void *arg)
+{
+    sasync *sa = (sasync *) arg;
+    abuf *ab;
+    bool ok;
+
+    pthread_mutex_lock(&sa->lock);
+    for (;;) {
+	while (sa->count == 0 && !sa->stop)
+	    pthread_cond_wait(&sa->more, &sa->lock);
+	if (sa->count == 0)			/* stopped and all written  */
+	    break;
+	ab = &sa->ring[sa->head];
+	pthread_mutex_unlock(&sa->lock);	/* write without the lock   */
+	ok = fwrite(ab->buf, 1, ab->len, sa->str) == ab->len &&
+	     fflush(sa->str) == 0;
+	free(ab->buf);
+	pthread_mutex_lock(&sa->lock);
+	if (!ok) sa->fail = TRUE;
+	ab->buf = NULL;
+	sa->head = (sa->head + 1) % sa->nbuf;
+	sa->count--;
+	pthread_cond_signal(&sa->less);
+    }
+    pthread_mutex_unlock(&sa->lock);
+    return NULL;
+}
+#endif
+
+local sasync *findasync(stream str)
+{
+    sasync *sa;
+
+    for (sa = alist; sa; sa = sa->next)
+	if (sa->str == str) return sa;
+    sa = (sasync *) allocate(sizeof(sasync));
+    sa->str = str;
+    sa->nbuf = async_env();
+#if defined(ASYNC)
+    if (sa->nbuf > 0) {
+	pthread_mutex_init(&sa->lock, NULL);
+	pthread_cond_init(&sa->more, NULL);
+	pthread_cond_init(&sa->less, NULL);
+	fflush(str);				/* earlier output goes first */
+	if (pthread_create(&sa->writer, NULL, async_writer, sa) != 0) {
+	    warning("put_async_set: cannot start writer, output is synchronous");
+	    sa->nbuf = 0;
+	} else {
+	    put_index_off(str);			/* sets will not be indexed */
+	    dprintf(1, "put_async_set: %s written with %d buffers\n",
+		    strname(str), sa->nbuf);
+	}
+    }
+#else
+    sa->nbuf = 0;
+#endif
+    sa->next = alist;
+    alist = sa;
+    return sa;
+}
+
+/*
+ * PUT_ASYNC_SET: stream to write the next top level set(s) for str into,
+ * until put_async_tes(str).
+ */
+
+stream put_async_set(stream str)
+{
+    sasync *sa = findasync(str);
+
+    if (sa->mem != NULL)
+	error("put_async_set: previous set not closed by put_async_tes");
+    if (sa->nbuf == 0)				/* synchronous output       */
+	return str;
+#if defined(ASYNC)
+    pthread_mutex_lock(&sa->lock);
+    if (sa->fail) {
+	pthread_mutex_unlock(&sa->lock);
+	error("put_async_set: error writing %s", strname(str));
+    }
+    pthread_mutex_unlock(&sa->lock);
+#endif
+    sa->mem = strmem(&sa->data, &sa->size);
+    return sa->mem;
+}
+
+/*
+ * PUT_ASYNC_TES: hand the sets written since put_async_set(str) to the
+ * writer; waits while all buffers are still queued.
+ */
+
+void put_async_tes(stream str)
+{
+    sasync *sa;
+
+    for (sa = alist; sa; sa = sa->next)
+	if (sa->str == str) break;
+    if (sa == NULL || sa->nbuf == 0)
+	return;
+    if (sa->mem == NULL)
+	error("put_async_tes: no put_async_set");
+    strclose(sa->mem);				/* finishes data and size   */
+    sa->mem = NULL;
+#if defined(ASYNC)
+    pthread_mutex_lock(&sa->lock);
+    while (sa->count == sa->nbuf) {		/* back pressure            */
+	dprintf(2, "put_async_tes: waiting for writer\n");
+	pthread_cond_wait(&sa->less, &sa->lock);
+    }
+    sa->ring[(sa->head + sa->count) % sa->nbuf].buf = sa->data;
+    sa->ring[(sa->head + sa->count) % sa->nbuf].len = sa->size;
+    sa->count++;
+    pthread_cond_signal(&sa->more);
+    pthread_mutex_unlock(&sa->lock);
+#endif
+    sa->data = NULL;
+}
+
+/*
+ * END_ASYNC: write all queued sets of str and stop its writer; called by
+ * strclose().
+ */
+
+void end_async(stream str)
+{
+    sasync *sa, **psa;
+    bool fail;
+
+    for (psa = &alist; (sa = *psa) != NULL; psa = &sa->next)
+	if (sa->str == str) break;
+    if (sa == NULL)
+	return;
+    if (sa->mem != NULL)
+	error("end_async: set not closed by put_async_tes");
+    fail = FALSE;
+#if defined(ASYNC)
+    if (sa->nbuf > 0) {
+	pthread_mutex_lock(&sa->lock);
+	sa->stop = TRUE;
+	pthread_cond_signal(&sa->more);
+	pthread_mutex_unlock(&sa->lock);
+	pthread_join(sa->writer, NULL);		/* writes what is left      */
+	fail = sa->fail;
+	pthread_mutex_destroy(&sa->lock);
+	pthread_cond_destroy(&sa->more);
+	pthread_cond_destroy(&sa->less);
+    }
+#endif
+    *psa = sa->next;
+    free(sa);
+    if (fail)
+	error("end_async: error writing %s", strname(str));
+}
@@ -0,0 +1,301 @@
+/*
+ * STRINDEX:   sidecar index of the top level sets (snapshots) of a
+ *             structured file, so a reader can go straight to the set
+ *             at a given time instead of scanning every set before it
+ *
+ *   19-oct-2026  created, for get_snap_by_t and put_snap
+ *   19-oct-2026  put_index_off, for asynchronous output
+ *   19-oct-2026  #stat lines: index ignored if its file changed
+ *
+ * The index of file foo is the text file foo.idx, one line per set:
+ *
+ *	tag time start end
+ *
+ * with start and end the file offsets of the set. put_index_set() and
+ * put_index_tes(), around put_set() and put_tes(), append a line once the
+ * set has been written, so the index is always valid for the sets that
+ * are complete, also while a simulation is still running. Each is followed
+ * by the line
+ *
+ *	#stat size mtime inode
+ *
+ * of the file at that point; if the last one does not match the file, it
+ * was written or replaced since and the index is not used. Writing is off
+ * unless $NEMOINDEX is set (to anything but 0); without it, the old index
+ * of a file that is rewritten (not appended to) is removed. Reading is on
+ * unless NEMOINDEX=0.
+ *
+ * get_index() only jumps over runs of consecutive indexed sets, so
+ * anything written without an index (history, other sets) is still read
+ * in sequence, and get_goto() checks a set with the right tag starts where
+ * the index says.
+ */
+
+#include <stdinc.h>
+#include <filestruct.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+typedef struct {
+    double time;		/* time of the set, NaN if none */
+    off_t start, end;		/* file offsets of set and what follows */
+} ientry;
+
+local struct sindex {
+    stream str;			/* the indexed stream */
+    FILE *out;			/* index being written, or NULL */
+    off_t start;		/* start of set being written, or -1 */
+    char tag[MaxTagLen+1];	/* and its tag */
+    double time;		/* and its time */
+    ientry *ent;		/* index read, sorted by offset */
+    int nent;
+    bool started;		/* a set has been written */
+    bool loaded;		/* index file has been read */
+    bool ok;			/* FALSE if not usable for reading */
+    bool off;			/* sets are not indexed (put_index_off) */
+    struct sindex *next;
+} *slist = NULL;
+
+typedef struct sindex sindex;
+
+local bool index_env(bool def)
+{
+    string cp = getenv("NEMOINDEX");
+
+    if (cp == NULL) return def;
+    return *cp != '0';
+}
+
+local string index_name(stream str)
+{
+    string name = strname(str);
+    string iname;
+
+    if (name == NULL || *name == '-' || streq(name, "."))
+	return NULL;				/* pipes have no index      */
+    iname = (string) allocate(strlen(name) + 5);
+    sprintf(iname, "%s.idx", name);
+    return iname;
+}
+
+local sindex *findindex(stream str)
+{
+    sindex *sx;
+
+    for (sx = slist; sx; sx = sx->next)
+	if (sx->str == str) return sx;
+    sx = (sindex *) allocate(sizeof(sindex));
+    sx->str = str;
+    sx->out = NULL;
+    sx->start = -1;
+    sx->ent = NULL;
+    sx->nent = 0;
+    sx->started = sx->loaded = sx->ok = sx->off = FALSE;
+    sx->next = slist;
+    slist = sx;
+    return sx;
+}
+
+/*
+ * PUT_INDEX_SET: call before put_set(str, tag) at the top level to index
+ * that set under time.
+ */
+
+void put_index_set(stream str, string tag, double time)
+{
+    sindex *sx;
+    string iname;
+    off_t pos;
+    bool append;
+
+    pos = get_pos(str);
+    if (pos < 0) return;			/* pipe, or within a set    */
+    sx = findindex(str);
+    if (!sx->started) {				/* first set of this stream */
+	sx->started = TRUE;
+	if ((iname = index_name(str)) == NULL) return;
+	append = (fcntl(fileno(str), F_GETFL) & O_APPEND) != 0;
+	if (!index_env(FALSE) || sx->off) {
+	    if (!append) unlink(iname);		/* old index would be wrong */
+	} else {
+	    sx->out = fopen(iname, append ? "a" : "w");
+	    if (sx->out == NULL)
+		warning("put_index_set: cannot write %s", iname);
+	    else {
+		if (!append) fprintf(sx->out, "# tag time start end\n");
+		dprintf(1, "put_index_set: writing %s\n", iname);
+	    }
+	}
+	free(iname);
+    }
+    if (sx->out == NULL) return;
+    strncpy(sx->tag, tag, MaxTagLen);
+    sx->tag[MaxTagLen] = 0;
+    sx->time = time;
+    sx->start = pos;
+}
+
+/*
+ * PUT_INDEX_OFF: the sets of str will be written without put_index_set,
+ * e.g. from memory (strasync.c). Before the first set, this removes the
+ * index a previous run left for a file that is rewritten; sets already
+ * indexed stay valid, as get_index() stops at the first set not indexed.
+ */
+
+void put_index_off(stream str)
+{
+    sindex *sx;
+
+    if (get_pos(str) < 0) return;		/* pipe, or within a set    */
+    sx = findindex(str);
+    sx->off = TRUE;
+    if (!sx->started)
+	put_index_set(str, "", 0.0);		/* removes an old index     */
+}
+
+/*
+ * PUT_INDEX_TES: call after the matching put_tes(str, tag).
+ */
+
+void put_index_tes(stream str)
+{
+    sindex *sx;
+    struct stat st;
+    off_t pos;
+
+    for (sx = slist; sx; sx = sx->next)
+	if (sx->str == str) break;
+    if (sx == NULL || sx->out == NULL || sx->start < 0)
+	return;
+    fflush(str);				/* set on disk before index */
+    pos = get_pos(str);
+    if (pos > sx->start && fstat(fileno(str), &st) == 0) {
+	fprintf(sx->out, "%s %.17g %lld %lld\n", sx->tag, sx->time,
+		(long long) sx->start, (long long) pos);
+	fprintf(sx->out, "#stat %lld %lld %llu\n", (long long) st.st_size,
+		(long long) st.st_mtime, (unsigned long long) st.st_ino);
+	fflush(sx->out);
+    }
+    sx->start = -1;
+}
+
+local void load_index(sindex *sx, string tag)
+{
+    string iname = index_name(sx->str);
+    struct stat st;
+    FILE *fp;
+    char line[256], t[MaxTagLen+1];
+    long long start, end, size, mtime;
+    unsigned long long ino;
+    double time;
+    int nmax = 0;
+    bool stamped = FALSE;
+
+    sx->ok = FALSE;
+    if (iname == NULL) return;
+    fp = fopen(iname, "r");
+    if (fp == NULL || fstat(fileno(sx->str), &st) < 0) {
+	if (fp) fclose(fp);
+	free(iname);
+	return;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+	if (sscanf(line, "#stat %lld %lld %llu", &size, &mtime, &ino) == 3) {
+	    stamped = TRUE;			/* file after the last set  */
+	    continue;
+	}
+	if (line[0] == '#') continue;
+	if (sscanf(line, "%65s %lf %lld %lld", t, &time, &start, &end) != 4 ||
+	      start >= end || end > st.st_size ||
+	      (sx->nent > 0 && start < sx->ent[sx->nent-1].end)) {
+	    warning("get_index: %s is not an index of this file, ignored", iname);
+	    sx->nent = 0;
+	    break;
+	}
+	if (!streq(t, tag)) continue;
+	if (sx->nent == nmax) {
+	    nmax = nmax ? 2 * nmax : 1024;
+	    sx->ent = (ientry *) reallocate(sx->ent, nmax * sizeof(ientry));
+	}
+	sx->ent[sx->nent].time = time;
+	sx->ent[sx->nent].start = start;
+	sx->ent[sx->nent].end = end;
+	sx->nent++;
+    }
+    fclose(fp);
+    if (sx->nent > 0 && (!stamped || size != st.st_size ||
+	    mtime != (long long) st.st_mtime || ino != st.st_ino)) {
+	warning("get_index: %s is older than its file, ignored", iname);
+	sx->nent = 0;
+    }
+    dprintf(1, "get_index: %d %s sets indexed in %s\n", sx->nent, tag, iname);
+    free(iname);
+    sx->ok = sx->nent > 0;
+}
+
+/*
+ * GET_INDEX: before get_tag_ok(str, tag) at top level, skip over indexed
+ * sets whose time is not within times, as get_snap_by_t would have done
+ * after reading them. Returns TRUE if any sets were skipped.
+ */
+
+bool get_index(stream str, string tag, string times, double fuzz)
+{
+    sindex *sx;
+    off_t pos;
+    int lo, hi, mid, i, j;
+
+    if (streq(times, "all") || !index_env(TRUE))
+	return FALSE;
+    sx = findindex(str);
+    if (!sx->loaded) {				/* first time: read index   */
+	load_index(sx, tag);
+	sx->loaded = TRUE;
+    }
+    if (!sx->ok || (pos = get_pos(str)) < 0)
+	return FALSE;
+
+    lo = 0;					/* find set starting at pos */
+    hi = sx->nent;
+    while (lo < hi) {
+	mid = (lo + hi) / 2;
+	if (sx->ent[mid].start < pos) lo = mid + 1;
+	else hi = mid;
+    }
+    i = lo;
+    if (i == sx->nent || sx->ent[i].start != pos)
+	return FALSE;				/* not at an indexed set    */
+    for (j = i; j < sx->nent - 1; j++) {	/* follow consecutive sets  */
+	if (within(sx->ent[j].time, times, fuzz)) break;
+	if (sx->ent[j+1].start != sx->ent[j].end) break;
+    }
+    if (j == i)
+	return FALSE;
+    if (!get_goto(str, sx->ent[j].start, tag)) {
+	warning("get_index: index does not match %s, ignored", strname(str));
+	sx->ok = FALSE;
+	return FALSE;
+    }
+    dprintf(1, "get_index: skipped %d %s sets, to time %g\n", j - i, tag,
+	    sx->ent[j].time);
+    return TRUE;
+}
+
+/*
+ * END_INDEX: forget the index of a stream; called by strclose().
+ */
+
+void end_index(stream str)
+{
+    sindex *sx, **psx;
+
+    for (psx = &slist; (sx = *psx) != NULL; psx = &sx->next)
+	if (sx->str == str) {
+	    if (sx->out) fclose(sx->out);
+	    if (sx->ent) free(sx->ent);
+	    *psx = sx->next;
+	    free(sx);
+	    return;
+	}
+}
@@ -1,4 +1,4 @@
-/* stropen(), strdelete(), strname(), strseek()
+/* stropen(), strmem(), strdelete(), strname(), strseek()
  *
  * STROPEN: open a STDIO stream much like fopen does, with these
  * additional features: 
@@ -43,6 +43,7 @@
  *      27-Sep-10    MINGW32/WINDOWS i/o support                        jcl
  *      18-oct-10    assume unlink/dup in unistd.h                      pjt
  *      19-oct-10    unlimited number of open files                     wd
+ *      19-oct-26    strmem: output stream into memory, for strasync
  */
 #include <stdinc.h>
 #include <strlib.h>
@@ -210,6 +211,36 @@ stream stropen(const_string name, string mode)
     return res;
 }
 
+/*
+ *  STRMEM:     open an output stream into a growing memory buffer
+ *              (open_memstream(3)), known as "-mem" and not seekable.
+ *              After strclose(), *buf holds the *len bytes written,
+ *              and must be freed by the caller.
+ */
+
+stream strmem(char **buf, size_t *len)
+{
+    fentry *fe;
+    stream res;
+
+#if defined(__MINGW32__)
+    error("strmem: no memory streams");
+    res = NULL;
+#else
+    res = open_memstream(buf, len);
+    if (res == NULL)
+        error("strmem: cannot open memory stream");
+#endif
+    fe = (fentry*) allocate(sizeof(fentry));
+    fe->next = flist;
+    flist = fe;                /* hook into the list */
+    fe->name = scopy("-mem");
+    fe->str = res;
+    fe->scratch = FALSE;
+    fe->seek = FALSE;
+    return res;
+}
+
 /*
  *  STRDELETE:   delete a file, associated with a stream, and free our
  *               table entry. Called by strclose().
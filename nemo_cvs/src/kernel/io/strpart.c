@@ -0,0 +1,287 @@
+/*
+ * STRPART:   partitioned snapshots: the bodies of each snapshot are
+ *            spread over N part files, which are written and read in
+ *            parallel, one thread per part
+ *
+ *   19-oct-2026  created, for put_snap and get_snap
+ *
+ * A partitioned snapshot file foo is a small manifest plus the part files
+ * foo.0, foo.1, ... foo.N-1. Each part file is an ordinary snapshot file,
+ * holding a consecutive range of the bodies of every snapshot. The manifest
+ * is an ordinary structured file too, with the history of the data and for
+ * every snapshot its Parameters (Nobj is the total) and a Parts set with
+ * where the rest went:
+ *
+ *	set SnapShot
+ *	  set Parameters ... tes
+ *	  set Parts
+ *	    int Nparts N
+ *	    int Nobj[N]		bodies in each part
+ *	    long Offset[N]	file offset of this snapshot in each part
+ *	  tes
+ *	tes
+ *
+ * Output is partitioned when $NEMOPARTS is more than 1, for files (not
+ * pipes) that put_snap writes; a snapshot with fewer bodies than that uses
+ * fewer parts. Input of a partitioned file needs no settings. Because the
+ * manifest knows the offsets, the snapshot index (strindex.c) and
+ * get_snap_by_t work on the manifest as for any other file, and a part file
+ * can also be read on its own (e.g. by tsf or snapprint) as a snapshot with
+ * just its bodies.
+ *
+ * The streams of a manifest are handed out by put_parts() and get_parts(),
+ * positioned at the snapshot; run_parts() calls a worker for each part in
+ * its own thread. filesecret.c allows different threads to use different
+ * streams, as long as streams are only opened and closed by the main thread.
+ */
+
+#include <stdinc.h>
+#include <filestruct.h>
+#include <snapshot/snapshot.h>
+#include <unistd.h>
+#include <fcntl.h>
+#if !defined(__MINGW32__)
+#define PARTS
+#include <pthread.h>
+#endif
+
+#define MaxParts  32		/* each part needs a slot in filesecret's table */
+
+local struct sparts {
+    stream str;			/* the manifest */
+    stream *part;		/* the part files opened */
+    int npart;
+    int nused;			/* parts used by the current snapshot */
+    int *nobj;			/* [nused] bodies in each part */
+    long *pos;			/* [nused] offset of the snapshot in each part */
+    int nmax;			/* allocated length of nobj and pos */
+    struct sparts *next;
+} *plist = NULL;
+
+typedef struct sparts sparts;
+
+local int parts_env(void)
+{
+    string cp = getenv("NEMOPARTS");
+    int n = 0;
+
+    if (cp != NULL) n = atoi(cp);
+    return MAX(0, MIN(n, MaxParts));
+}
+
+local sparts *findparts(stream str)
+{
+    sparts *sp;
+
+    for (sp = plist; sp; sp = sp->next)
+	if (sp->str == str) return sp;
+    sp = (sparts *) allocate(sizeof(sparts));
+    sp->str = str;
+    sp->next = plist;
+    plist = sp;
+    return sp;
+}
+
+local void grow_parts(sparts *sp, int n)
+{
+    if (n <= sp->nmax) return;
+    sp->nobj = (int *) reallocate(sp->nobj, n * sizeof(int));
+    sp->pos = (long *) reallocate(sp->pos, n * sizeof(long));
+    sp->nmax = n;
+}
+
+/* open parts up to part n-1 of manifest str */
+local void open_parts(sparts *sp, int n, string mode)
+{
+    string name = strname(sp->str);
+    string pname;
+    int k;
+
+    if (n <= sp->npart) return;
+    pname = (string) allocate(strlen(name) + 16);
+    sp->part = (stream *) reallocate(sp->part, n * sizeof(stream));
+    for (k = sp->npart; k < n; k++) {
+	sprintf(pname, "%s.%d", name, k);
+	sp->part[k] = stropen(pname, mode);
+	if (*mode == 'a')
+	    fseeko(sp->part[k], 0, SEEK_END);
+	(void) get_pos(sp->part[k]);	/* into filesecret's table now */
+	dprintf(1, "parts: %s opened\n", pname);
+    }
+    free(pname);
+    sp->npart = n;
+}
+
+/*
+ * PUT_PARTS: if snapshots of str are written partitioned, split nbody
+ * bodies over *nparts parts, with (*nobj)[k] bodies in part k, and return
+ * the part streams; else return NULL. Call within the SnapShot set of str,
+ * and put_parts_tes(str) after the parts have been written.
+ */
+
+stream *put_parts(stream str, int nbody, int *nparts, int **nobj)
+{
+    sparts *sp;
+    string name;
+    int n, k;
+    bool append;
+
+    for (sp = plist; sp; sp = sp->next)
+	if (sp->str == str) break;
+    if (sp == NULL) {				/* first snapshot of str    */
+	sp = findparts(str);
+	n = parts_env();
+	name = strname(str);
+	if (n > 1 && (name == NULL || *name == '-' || streq(name, "."))) {
+	    warning("put_parts: cannot partition %s, written as one file",
+		    name ? name : "stream");
+	    n = 0;
+	}
+	if (n > 1) {
+	    append = (fcntl(fileno(str), F_GETFL) & O_APPEND) != 0;
+	    open_parts(sp, n, append ? "a" : "w!");
+	    dprintf(1, "put_parts: %s written in %d parts\n", name, n);
+	}
+    }
+    if (sp->npart < 2)
+	return NULL;
+    n = MIN(sp->npart, MAX(nbody, 1));
+    grow_parts(sp, n);
+    for (k = 0; k < n; k++) {
+	sp->nobj[k] = nbody / n + (k < nbody % n ? 1 : 0);
+	sp->pos[k] = get_pos(sp->part[k]);
+	if (sp->pos[k] < 0)
+	    error("put_parts: part %d of %s not at top level", k, strname(str));
+    }
+    sp->nused = n;
+    *nparts = n;
+    *nobj = sp->nobj;
+    return sp->part;
+}
+
+/*
+ * PUT_PARTS_TES: write the Parts set of the snapshot to str, once the parts
+ * handed out by put_parts(str, ...) have been written.
+ */
+
+void put_parts_tes(stream str)
+{
+    sparts *sp;
+
+    for (sp = plist; sp; sp = sp->next)
+	if (sp->str == str) break;
+    if (sp == NULL || sp->nused == 0)
+	error("put_parts_tes: no put_parts");
+    put_set(str, PartsTag);
+    put_data(str, NPartsTag, IntType, &sp->nused, 0);
+    put_data(str, NobjTag, IntType, sp->nobj, sp->nused, 0);
+    put_data(str, PartOffsetTag, LongType, sp->pos, sp->nused, 0);
+    put_tes(str, PartsTag);
+    sp->nused = 0;
+}
+
+/*
+ * GET_PARTS: if the set being read from str has a Parts set, read it and
+ * return the streams of the *nparts parts, each positioned at its set
+ * named tag, with (*nobj)[k] bodies in part k; else return NULL.
+ */
+
+stream *get_parts(stream str, string tag, int *nparts, int **nobj)
+{
+    sparts *sp;
+    int n, k;
+
+    if (!get_tag_ok(str, PartsTag))
+	return NULL;
+    sp = findparts(str);
+    get_set(str, PartsTag);
+    get_data(str, NPartsTag, IntType, &n, 0);
+    if (n < 1 || n > MaxParts)
+	error("get_parts: %s has %d parts, at most %d allowed",
+	      strname(str), n, MaxParts);
+    grow_parts(sp, n);
+    get_data(str, NobjTag, IntType, sp->nobj, n, 0);
+    get_data(str, PartOffsetTag, LongType, sp->pos, n, 0);
+    get_tes(str, PartsTag);
+    open_parts(sp, n, "r");
+    for (k = 0; k < n; k++)
+	if (!get_goto(sp->part[k], (off_t) sp->pos[k], tag))
+	    error("get_parts: part %d of %s has no %s at %ld", k,
+		  strname(str), tag, sp->pos[k]);
+    *nparts = n;
+    *nobj = sp->nobj;
+    return sp->part;
+}
+
+#if defined(PARTS)
+typedef struct {
+    int k;
+    void (*work)(int, void *);
+    void *arg;
+} pjob;
+
+local void *part_worker(void *arg)
+{
+    pjob *pj = (pjob *) arg;
+
+    (*pj->work)(pj->k, pj->arg);
+    return NULL;
+}
+#endif
+
+/*
+ * RUN_PARTS: call work(k, arg) for the parts k = 0..nparts-1, each in its
+ * own thread, and wait for them all.
+ */
+
+void run_parts(int nparts, void (*work)(int, void *), void *arg)
+{
+    int k;
+#if defined(PARTS)
+    pthread_t tid[MaxParts];
+    pjob job[MaxParts];
+    bool started[MaxParts];
+
+    if (nparts > MaxParts)
+	error("run_parts: %d parts, at most %d allowed", nparts, MaxParts);
+    for (k = 1; k < nparts; k++) {		/* part 0 is done right here */
+	job[k].k = k;
+	job[k].work = work;
+	job[k].arg = arg;
+	started[k] = pthread_create(&tid[k], NULL, part_worker, &job[k]) == 0;
+	if (!started[k])
+	    dprintf(1, "run_parts: no thread for part %d\n", k);
+    }
+    (*work)(0, arg);
+    for (k = 1; k < nparts; k++)
+	if (started[k])
+	    pthread_join(tid[k], NULL);
+	else
+	    (*work)(k, arg);
+#else
+    for (k = 0; k < nparts; k++)
+	(*work)(k, arg);
+#endif
+}
+
+/*
+ * END_PARTS: close the part files of a manifest; called by strclose().
+ */
+
+void end_parts(stream str)
+{
+    sparts *sp, **psp;
+    int k;
+
+    for (psp = &plist; (sp = *psp) != NULL; psp = &sp->next)
+	if (sp->str == str) {
+	    *psp = sp->next;
+	    for (k = 0; k < sp->npart; k++)
+		strclose(sp->part[k]);
+	    if (sp->part) free(sp->part);
+	    if (sp->nobj) free(sp->nobj);
+	    if (sp->pos) free(sp->pos);
+	    free(sp);
+	    return;
+	}
+}
@@ -47,6 +47,8 @@
  *      23-apr-13   6.2b  use compute_robust_mean               pjt
  *       7-aug-13   6.3   optional numrec routines              pjt
  *      15-jan-14   6.4   add MAD option
+ *      19-oct-26   6.5   read with get_btable
+ *      19-oct-26   6.5a  rows of a binary table from its Nrow
  *                
  * 
  * TODO:
@@ -67,6 +69,7 @@
 #include <yapp.h>
 #include <axis.h>
 #include <mdarray.h>
+#include <table.h>
 
 /**************** COMMAND LINE PARAMETERS **********************/
 
@@ -96,7 +99,7 @@ string defv[] = {
     "dual=f\n                     Dual pass for large number",
     "scale=1\n                    Scale factor for data",
     "out=\n                       Optional output file to select the robust points",
-    "VERSION=6.4\n		  15-jan-2014 PJT",
+    "VERSION=6.5a\n		  19-oct-2026",
     NULL
 };
 
@@ -235,7 +238,7 @@ local void setparams()
     if (ylog && streq(ylab,"N")) ylab = scopy("log(N)");
     Qdual = getbparam("dual");
 
-    nmax = nemo_file_lines(input,getiparam("nmax"));
+    nmax = table_rows(input,getiparam("nmax"));
     if (nmax<1) error("Problem reading from %s",input);
 
     nxcoord = nemoinpr(getparam("xcoord"),xcoord,MAXCOORD);
@@ -265,7 +268,7 @@ local void read_data()
     dprintf(0,"Reading %d column(s)\n",ncol);
     for (i=0; i<ncol; i++)
       coldat[i] = md2[i];
-    npt = get_atable(instr,ncol,col,coldat,nmax);        /* read it */
+    npt = get_btable(instr,ncol,col,coldat,nmax);        /* read it */
     if (npt == -nmax) {
     	warning("Could only read %d data",nmax);
     	npt = nmax;
@@ -10,6 +10,7 @@
  * iscomment(line)			is this line a blank or comment line?
  * 
  *    1-jan-04      get_line::  changed EOF to return -1, and empty line to 0
+ *   19-oct-26      get_line::  one stream lock per line, not per character
  */
  
 #include <stdinc.h>
@@ -23,6 +24,12 @@
 #define MAX_LINELEN  16384
 #endif
 
+#if defined(__MINGW32__)
+#define flockfile(s)
+#define funlockfile(s)
+#define getc_unlocked(s)  getc(s)
+#endif
+
 /*
  * insert a string 'b' into 'a' replacing the first 'n' positions into 'a'
  *      (see als hsh.h in ..../hermes/lib  --  PJT)
@@ -54,18 +61,22 @@ int get_line(stream instr, char *line)
 {
 	int  c, i=0;
 	
+	flockfile(instr);
 	for(;;) {
-		c=getc(instr);
-		if (c==EOF)
+		c=getc_unlocked(instr);
+		if (c==EOF) {
+			funlockfile(instr);
 			return -1;	/* error code: EOF */
-		else if (c=='\n')
+		} else if (c=='\n')
 			break;
 		line[i++]=c;
 		if (i>MAX_LINELEN) {
+			funlockfile(instr);
 			warning("get_line: max linelen (%d) exceeded; return 0",MAX_LINELEN);
 			return 0;
 		}
 	}
+	funlockfile(instr);
 	line[i]=0;
 	return strlen(line);
 }
@@ -33,6 +33,7 @@
  *      13-nov-03  V3.3  handle null's (now that herinp sort of knows what to do?)  [unfinished]
  *      31-dec-03  V3.4  added colname=
  *       1-jan-04     a  changed interface to get_line
+ *      19-oct-26  V3.5  numbers converted with parse_row
  *
  */
 
@@ -58,7 +59,7 @@ string defv[] = {                /* DEFAULT INPUT PARAMETERS */
     "seed=0\n           Initial random number",
     "colname=\n         (unchecked) commented column names to add into output",
     "comments=f\n       Pass through comments?",
-    "VERSION=3.4a\n     1-jan-04 PJT",
+    "VERSION=3.5\n      19-oct-2026",
     NULL
 };
 
@@ -213,7 +214,7 @@ local void convert(int ninput, stream *instr, stream outstr)
         nlines++;
         tab2space(line);	          /* work around a Gipsy (?) problem */
         if (nfies>0 || *selfie) {              	/* if a new column requested */
-            nval = nemoinpr(line,dval,MAXCOL);         /* split into numbers */
+            nval = parse_row(line,dval,MAXCOL);        /* split into numbers */
 	    /* this could contain some NULL's, so how do we measure this ??? */
             dprintf (3,"nval=%d \n",nval);
             if (nval>MAXCOL)
@@ -41,6 +41,8 @@
  *                     b : fix bug in bins with no dispersive data, switch to moment.h
  *       9-oct-06      d : Implemented the dxcol= and dycol=
  *       8-apr-11      e : fixed dycol reference bug
+ *      19-oct-26  V3.1  : read with get_btable
+ *                     a : rows of a binary table from its Nrow
  */
 
 /* TODO:
@@ -56,6 +58,7 @@
 #include <axis.h>
 #include <layout.h>
 #include <moment.h>
+#include <table.h>
                     /* undefined values trick !!!  MACHINE DEP  !!! */
 #ifdef SINGLEPREC
 #define NaN 0x7FFF
@@ -102,7 +105,7 @@ string defv[] = {                /* DEFAULT INPUT PARAMETERS */
     "layout=\n           Optional input layout file",
     "first=f\n           Layout first or last?",
     "readline=f\n        Interactively reading commands",
-    "VERSION=3.0f\n	 8-apr-11 PJT",
+    "VERSION=3.1a\n	 19-oct-2026",
     NULL
 };
 
@@ -194,7 +197,7 @@ void setparams()
     // TODO: some ndxycol/ndycol checks
     
 
-    nmax = nemo_file_lines(input,getiparam("nmax"));
+    nmax = table_rows(input,getiparam("nmax"));
     dprintf(1,"Allocated %d lines for table\n",nmax);
     for (j=0; j<nxcol; j++)
         x[j] = (real *) allocate(sizeof(real) * (nmax+1));   /* X data */
@@ -357,7 +360,7 @@ read_data()
     /* could also find out if any columns duplicated, and
        replace them with pointers */
 
-    npt = get_atable(instr,nxcol+nycol+ndxcol+ndycol,colnr,coldat,nmax);    /* get data */
+    npt = get_btable(instr,nxcol+nycol+ndxcol+ndycol,colnr,coldat,nmax);    /* get data */
     if (npt < 0) {
     	npt = -npt;
     	warning("Could only read first set of %d data",npt);
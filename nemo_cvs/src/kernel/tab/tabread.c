@@ -0,0 +1,871 @@
+/*
+ * TABREAD:  fast reading of large ASCII tables: blocked input, lines parsed
+ *           by several threads, only the columns asked for, and an optional
+ *           binary cache of the parsed columns for the next read
+ *
+ *   19-oct-2026  created, for tabhist, tabstat, tabplot and tabmath
+ *   19-oct-2026  binary tables: put_btable, and read by get_btable
+ *   19-oct-2026  table_rows: Nrow of a binary table
+ *   19-oct-2026  no cache (instead of an error) where it cannot be written,
+ *                inode added to its key
+ *
+ * get_btable() is a drop-in for get_atable() (gettab.c): same arguments,
+ * same rows, same warnings and the same return value, N rows read till end
+ * of file, or -ndat if the arrays are full before that. Instead of a line
+ * at a time it reads blocks of TabBlock bytes, splits them into lines and
+ * hands ranges of lines to $NEMOTHREADS threads (default: the number of
+ * processors), which convert only the columns asked for; a token is only
+ * scanned up to the last of those. Plain numbers are converted with
+ * strtod(); a line with anything else (an expression, a missing column, a
+ * bad number) is left to the main thread, which treats it exactly like
+ * get_atable does, nemoinpr() and warnings included, in line order.
+ * When the arrays are full, a file is left positioned at the next line, as
+ * for any other reader; of a pipe the rest of the block is kept for the
+ * next call on that stream.
+ *
+ * With $NEMOTABCACHE set (to anything but 0), reading a whole table file
+ * foo also writes foo.tcache, a structured file with the columns read:
+ *
+ *	set TableCache
+ *	  long Size, Time, Inode	size, modification time and inode of foo
+ *	  int Nline, Nrec	lines, and data (not comment) lines
+ *	  int Line[Nrec]	line number of each data line
+ *	  real Col<k>[Nrec]	column k, for all columns k read
+ *	  byte Bad<k>[Nrec]	if present: 1 where column k was not a number
+ *	tes
+ *
+ * A later get_btable on foo reads the columns from there instead, as long
+ * as foo did not change and the cache has all columns asked for; that is
+ * on unless NEMOTABCACHE=0. parse_row() is the same fast conversion for a
+ * whole line, as nemoinpr() would do it.
+ *
+ * A binary table, as written by put_btable() (e.g. potlist out=), is a
+ * structured file with, after the history, one or more sets
+ *
+ *	set Table
+ *	  int Ncol, Nrow
+ *	  char Names[]		optional column names, blank separated
+ *	  any Col1[Nrow] ... Col<Ncol>[Nrow]	float or double
+ *	tes
+ *
+ * get_btable() recognizes such a file by its magic number and reads the
+ * columns asked for straight from it, so the tab programs using it take
+ * ASCII and binary tables alike; column 0 is the row number. table_rows()
+ * is nemo_file_lines() for them: it adds up the Nrow of the Table sets.
+ */
+
+#include <stdinc.h>
+#include <getparam.h>
+#include <filestruct.h>
+#include <history.h>
+#include <table.h>
+#include <extstring.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if !defined(__MINGW32__)
+#define THREADS
+#include <pthread.h>
+#endif
+
+extern int nemo_file_lines(string, int);
+extern string *burststring(string, string);
+extern void freestrings(string *);
+
+#define TabBlock    (16*1024*1024)	/* bytes read at a time */
+#define MaxThreads  64
+#define MinLines    4096		/* lines for a thread to be worth it */
+
+#define CacheTag    "TableCache"
+#define TableTag    "Table"
+
+#ifndef MAXCOL
+#define MAXCOL      256			/* distinct columns to convert */
+#endif
+
+/* what a line turned out to be */
+#define L_SKIP  0			/* comment or blank line */
+#define L_OK    1			/* all columns converted */
+#define L_SLOW  2			/* for the main thread, as get_atable */
+
+typedef struct {
+    char **line;		/* [nline+1] line starts, each ends in '\n' */
+    int nline;
+    int nu;			/* distinct columns > 0 to convert */
+    int *ucol;			/* [nu] those columns */
+    int maxcol;			/* last of them */
+    real *val;			/* [nline*nu] converted values */
+    char *stat;			/* [nline] L_SKIP, L_OK or L_SLOW */
+} tblock;
+
+typedef struct {		/* the columns kept for the cache */
+    int nrec, nmax;
+    int *line;			/* [nmax] line number of each record */
+    real *val;			/* [nu][nmax] */
+    char *bad;			/* [nu][nmax] */
+    int nu;
+    bool anybad;
+} tcache;
+
+local struct {			/* what a pipe had beyond a full table */
+    stream str;
+    char *buf;
+    size_t len;
+} left = { NULL, NULL, 0 };
+
+local struct {			/* binary Table set being read */
+    stream str;
+    int nrow, row;		/* its rows, and rows handed out */
+    int nu, ucol[MAXCOL];	/* columns read */
+    real *val;			/* [nu][nrow] */
+} bin = { NULL, 0, 0, 0, { 0 }, NULL };
+
+local int thread_env(void)
+{
+    string cp = getenv("NEMOTHREADS");
+    int n = 0;
+
+    if (cp != NULL) n = atoi(cp);
+#if defined(_SC_NPROCESSORS_ONLN)
+    if (n <= 0) n = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return MAX(1, MIN(n, MaxThreads));
+}
+
+local bool cache_env(bool def)
+{
+    string cp = getenv("NEMOTABCACHE");
+
+    if (cp == NULL) return def;
+    return *cp != '0';
+}
+
+#define issep(c)    ((c)==' ' || (c)==',' || (c)=='\t' || (c)=='\r')
+#define isplain(c)  (isdigit(c) || (c)=='.' || (c)=='-' || (c)=='+' || (c)=='e' || (c)=='E')
+
+/* convert a token ending in a separator or newline, if it is a plain number */
+local bool plain_number(char *cp, real *val)
+{
+    char *ep, *tp;
+
+    for (tp = cp; isplain(*tp); tp++)
+	;
+    if (tp == cp || !(issep(*tp) || *tp == '\n' || *tp == '\0'))
+	return FALSE;
+    *val = (real) strtod(cp, &ep);
+    return ep == tp;
+}
+
+/* lines lo..hi-1 of a block: the fast path; anything odd is L_SLOW */
+local void parse_lines(tblock *tb, int lo, int hi)
+{
+    char *cp, **tok;
+    int l, n, u;
+
+    tok = (char **) allocate((tb->maxcol + 1) * sizeof(char *));
+    for (l = lo; l < hi; l++) {
+	cp = tb->line[l];
+	if (*cp == '#' || *cp == ';' || *cp == '!') {
+	    tb->stat[l] = L_SKIP;
+	    continue;
+	}
+	for (n = 0; n < tb->maxcol; n++) {	/* tokens up to the last one */
+	    while (issep(*cp)) cp++;
+	    if (*cp == '\n') break;
+	    tok[n] = cp;
+	    while (!issep(*cp) && *cp != '\n') cp++;
+	}
+	if (n == 0) {
+	    while (issep(*cp)) cp++;
+	    tb->stat[l] = *cp == '\n' ? L_SKIP : L_OK;	/* maxcol 0 */
+	    continue;
+	}
+	if (n < tb->maxcol) {			/* missing column: warn     */
+	    tb->stat[l] = L_SLOW;
+	    continue;
+	}
+	tb->stat[l] = L_OK;
+	for (u = 0; u < tb->nu; u++)
+	    if (!plain_number(tok[tb->ucol[u]-1], &tb->val[(size_t)l*tb->nu+u])) {
+		tb->stat[l] = L_SLOW;
+		break;
+	    }
+    }
+    free(tok);
+}
+
+#if defined(THREADS)
+typedef struct {
+    tblock *tb;
+    int lo, hi;
+} tjob;
+
+local void *parse_worker(void *arg)
+{
+    tjob *tj = (tjob *) arg;
+
+    parse_lines(tj->tb, tj->lo, tj->hi);
+    return NULL;
+}
+#endif
+
+/* parse all lines of a block, in parallel if there are enough */
+local void parse_block(tblock *tb, int nthread)
+{
+#if defined(THREADS)
+    pthread_t tid[MaxThreads];
+    tjob job[MaxThreads];
+    bool started[MaxThreads];
+    int k;
+
+    nthread = MIN(nthread, tb->nline / MinLines);
+    if (nthread > 1) {
+	for (k = 0; k < nthread; k++) {
+	    job[k].tb = tb;
+	    job[k].lo = (int) ((long) tb->nline * k / nthread);
+	    job[k].hi = (int) ((long) tb->nline * (k+1) / nthread);
+	}
+	for (k = 1; k < nthread; k++)
+	    started[k] = pthread_create(&tid[k], NULL, parse_worker, &job[k]) == 0;
+	parse_lines(tb, job[0].lo, job[0].hi);
+	for (k = 1; k < nthread; k++)
+	    if (started[k])
+		pthread_join(tid[k], NULL);
+	    else
+		parse_lines(tb, job[k].lo, job[k].hi);
+	return;
+    }
+#endif
+    parse_lines(tb, 0, tb->nline);
+}
+
+local void grow_cache(tcache *tc, int n)
+{
+    int u, nmax;
+
+    if (n <= tc->nmax) return;
+    nmax = MAX(n, MAX(2 * tc->nmax, 65536));
+    tc->line = (int *) reallocate(tc->line, nmax * sizeof(int));
+    tc->val = (real *) reallocate(tc->val, (size_t) tc->nu * nmax * sizeof(real));
+    tc->bad = (char *) reallocate(tc->bad, (size_t) tc->nu * nmax);
+    for (u = tc->nu - 1; u > 0; u--) {		/* spread out the columns   */
+	memmove(tc->val + (size_t) u * nmax, tc->val + (size_t) u * tc->nmax,
+		tc->nrec * sizeof(real));
+	memmove(tc->bad + (size_t) u * nmax, tc->bad + (size_t) u * tc->nmax,
+		tc->nrec);
+    }
+    tc->nmax = nmax;
+}
+
+local string cache_name(stream instr)
+{
+    string name = strname(instr);
+    string cname;
+
+    if (name == NULL || *name == '-' || streq(name, "."))
+	return NULL;
+    cname = (string) allocate(strlen(name) + 8);
+    sprintf(cname, "%s.tcache", name);
+    return cname;
+}
+
+local void put_cache(stream instr, tblock *tb, tcache *tc, int nline)
+{
+    string cname = cache_name(instr);
+    struct stat st;
+    stream cstr;
+    char tag[32];
+    long lval;
+    int u;
+
+    if (cname == NULL) return;
+    if (fstat(fileno(instr), &st) < 0 || (cstr = fopen(cname, "a")) == NULL) {
+	dprintf(1, "get_btable: cannot write %s, no cache\n", cname);
+	free(cname);
+	return;
+    }
+    fclose(cstr);				/* writable: stropen won't fail */
+    cstr = stropen(cname, "w!");
+    put_set(cstr, CacheTag);
+    lval = (long) st.st_size;
+    put_data(cstr, "Size", LongType, &lval, 0);
+    lval = (long) st.st_mtime;
+    put_data(cstr, "Time", LongType, &lval, 0);
+    lval = (long) st.st_ino;
+    put_data(cstr, "Inode", LongType, &lval, 0);
+    put_data(cstr, "Nline", IntType, &nline, 0);
+    put_data(cstr, "Nrec", IntType, &tc->nrec, 0);
+    if (tc->nrec > 0) {
+	put_data(cstr, "Line", IntType, tc->line, tc->nrec, 0);
+	for (u = 0; u < tc->nu; u++) {
+	    sprintf(tag, "Col%d", tb->ucol[u]);
+	    put_data(cstr, tag, RealType, tc->val + (size_t) u * tc->nmax,
+		     tc->nrec, 0);
+	}
+	for (u = 0; tc->anybad && u < tc->nu; u++) {
+	    sprintf(tag, "Bad%d", tb->ucol[u]);
+	    put_data(cstr, tag, ByteType, tc->bad + (size_t) u * tc->nmax,
+		     tc->nrec, 0);
+	}
+    }
+    put_tes(cstr, CacheTag);
+    strclose(cstr);
+    dprintf(1, "get_btable: wrote %d columns of %d lines to %s\n",
+	    tc->nu, tc->nrec, cname);
+    free(cname);
+}
+
+/*
+ * the columns from the cache, if it is there, up to date and complete,
+ * and the rows fit; returns the number of rows, or -1 if it cannot be used
+ */
+
+local int get_cache(stream instr, tblock *tb, int ncol, int colnr[],
+		    real *coldat[], int ndat)
+{
+    string cname = cache_name(instr);
+    struct stat st, cst;
+    stream cstr = NULL;
+    char tag[32];
+    long size, time, ino = -1;
+    int nline, nrec, i, r, u, npt, *line = NULL, *slot;
+    real *val = NULL;
+    char *bad = NULL;
+    bool ok = FALSE, inset = FALSE;
+
+    if (cname == NULL) return -1;
+    if (fstat(fileno(instr), &st) < 0 || stat(cname, &cst) < 0 ||
+	access(cname, R_OK) < 0) {
+	free(cname);
+	return -1;
+    }
+    cstr = stropen(cname, "r");
+    if (!get_tag_ok(cstr, CacheTag)) goto done;
+    get_set(cstr, CacheTag);
+    inset = TRUE;
+    get_data(cstr, "Size", LongType, &size, 0);
+    get_data(cstr, "Time", LongType, &time, 0);
+    if (get_tag_ok(cstr, "Inode"))
+	get_data(cstr, "Inode", LongType, &ino, 0);
+    if (size != (long) st.st_size || time != (long) st.st_mtime ||
+	ino != (long) st.st_ino) {
+	dprintf(1, "get_btable: %s is out of date\n", cname);
+	goto done;
+    }
+    get_data(cstr, "Nline", IntType, &nline, 0);
+    get_data(cstr, "Nrec", IntType, &nrec, 0);
+    for (u = 0; u < tb->nu; u++) {
+	sprintf(tag, "Col%d", tb->ucol[u]);
+	if (nrec > 0 && !get_tag_ok(cstr, tag)) {
+	    dprintf(1, "get_btable: %s has no column %d\n", cname, tb->ucol[u]);
+	    goto done;
+	}
+    }
+    if (nrec > 0) {
+	line = (int *) allocate(nrec * sizeof(int));
+	val = (real *) allocate((size_t) tb->nu * nrec * sizeof(real));
+	bad = (char *) allocate((size_t) tb->nu * nrec);
+	get_data(cstr, "Line", IntType, line, nrec, 0);
+	for (u = 0; u < tb->nu; u++) {
+	    sprintf(tag, "Col%d", tb->ucol[u]);
+	    get_data_coerced(cstr, tag, RealType, val + (size_t) u * nrec, nrec, 0);
+	    sprintf(tag, "Bad%d", tb->ucol[u]);
+	    if (get_tag_ok(cstr, tag))
+		get_data(cstr, tag, ByteType, bad + (size_t) u * nrec, nrec, 0);
+	}
+    }
+    for (r = 0, npt = 0; r < nrec; r++) {	/* rows with all columns    */
+	for (u = 0; u < tb->nu; u++)
+	    if (bad[(size_t) u * nrec + r]) break;
+	if (u == tb->nu) npt++;
+    }
+    if (npt > ndat) {
+	dprintf(1, "get_btable: %d rows in %s, room for %d\n", npt, cname, ndat);
+	goto done;
+    }
+    slot = (int *) allocate(ncol * sizeof(int));
+    for (i = 0; i < ncol; i++)
+	for (slot[i] = -1, u = 0; colnr[i] > 0 && u < tb->nu; u++)
+	    if (tb->ucol[u] == colnr[i]) slot[i] = u;
+    for (r = 0, npt = 0; r < nrec; r++) {
+	for (u = 0; u < tb->nu; u++)
+	    if (bad[(size_t) u * nrec + r]) break;
+	if (u < tb->nu) continue;
+	for (i = 0; i < ncol; i++)
+	    coldat[i][npt] = slot[i] < 0 ? line[r] : val[(size_t) slot[i]*nrec + r];
+	npt++;
+    }
+    free(slot);
+    if (npt < nrec)
+	warning("get_btable: skipped %d lines without all columns, see %s",
+		nrec - npt, cname);
+    fseeko(instr, 0, SEEK_END);			/* as if it was all read    */
+    dprintf(1, "%d lines read from table cache %s, %d data used\n",
+	    nline, cname, npt);
+    ok = TRUE;
+done:
+    if (line) free(line);
+    if (val) free(val);
+    if (bad) free(bad);
+    if (inset) get_tes(cstr, CacheTag);
+    strclose(cstr);
+    free(cname);
+    return ok ? npt : -1;
+}
+
+/* is instr a structured file? tells a file by its magic, a pipe by one byte */
+local bool is_binary(stream instr, bool file)
+{
+    unsigned char m[2];
+    int c, n;
+
+    if (bin.str == instr)
+	return TRUE;
+    if (!file) {
+	c = getc(instr);
+	if (c == EOF) return FALSE;
+	ungetc(c, instr);
+	return c == 0222;			/* little endian magic     */
+    }
+    n = fread(m, 1, 2, instr);
+    if (n > 0) fseeko(instr, -(off_t) n, SEEK_CUR);
+    if (n < 2) return FALSE;
+    return (m[0] == 0222 && (m[1] == 011 || m[1] == 013 || m[1] == 015)) ||
+	   (m[1] == 0222 && (m[0] == 011 || m[0] == 013 || m[0] == 015));
+}
+
+/* the rows of the binary Table sets of instr, up to ndat */
+local int get_bin(stream instr, tblock *tb, int ncol, int slot[],
+		  real *coldat[], int ndat)
+{
+    char tag[32];
+    int i, j, n, u, nc, npt = 0;
+
+    for (;;) {
+	if (bin.str != instr) {			/* the next Table set       */
+	    if (bin.str != NULL)
+		error("get_btable: still reading %s", strname(bin.str));
+	    get_history(instr);
+	    if (!get_tag_ok(instr, TableTag))
+		break;
+	    get_set(instr, TableTag);
+	    get_data(instr, "Ncol", IntType, &nc, 0);
+	    get_data(instr, "Nrow", IntType, &bin.nrow, 0);
+	    if (tb->maxcol > nc)
+		error("get_btable: %s has %d columns, column %d not present",
+		      strname(instr), nc, tb->maxcol);
+	    bin.nu = tb->nu;
+	    for (u = 0; u < tb->nu; u++)
+		bin.ucol[u] = tb->ucol[u];
+	    bin.val = (real *) allocate((size_t) MAX(tb->nu,1) * MAX(bin.nrow,1) *
+					sizeof(real));
+	    for (u = 0; u < tb->nu; u++) {
+		sprintf(tag, "Col%d", tb->ucol[u]);
+		get_data_coerced(instr, tag, RealType,
+				 bin.val + (size_t) u * bin.nrow, bin.nrow, 0);
+	    }
+	    get_tes(instr, TableTag);
+	    bin.str = instr;
+	    bin.row = 0;
+	    dprintf(1, "get_btable: binary table of %d rows, %d columns\n",
+		    bin.nrow, nc);
+	} else {				/* rest of the last one     */
+	    if (bin.nu != tb->nu)
+		error("get_btable: other columns asked for from %s", strname(instr));
+	    for (u = 0; u < tb->nu; u++)
+		if (bin.ucol[u] != tb->ucol[u])
+		    error("get_btable: other columns asked for from %s",
+			  strname(instr));
+	}
+	n = MIN(ndat - npt, bin.nrow - bin.row);
+	for (i = 0; i < ncol; i++)
+	    if (slot[i] < 0)
+		for (j = 0; j < n; j++)
+		    coldat[i][npt+j] = npt + j + 1;
+	    else
+		memcpy(coldat[i] + npt,
+		       bin.val + (size_t) slot[i] * bin.nrow + bin.row,
+		       n * sizeof(real));
+	npt += n;
+	bin.row += n;
+	if (bin.row < bin.nrow)			/* full, set not done       */
+	    return -ndat;
+	free(bin.val);
+	bin.val = NULL;
+	bin.str = NULL;
+	if (npt == ndat) {			/* full: more sets?         */
+	    get_history(instr);
+	    return get_tag_ok(instr, TableTag) ? -ndat : npt;
+	}
+    }
+    dprintf(1, "%d rows read from binary table\n", npt);
+    return npt;
+}
+
+/*
+ * TABLE_ROWS: rows to allocate for reading table file name, as given by
+ *             nemo_file_lines(name, deflen), but for a binary table file
+ *             without a row count hint (deflen <= 0), the sum of Nrow of
+ *             its Table sets, read from their headers.
+ */
+
+int table_rows(string name, int deflen)
+{
+    stream str;
+    struct stat st;
+    int nrow, n = 0;
+
+    if (deflen > 0 || stat(name, &st) < 0 || !S_ISREG(st.st_mode) ||
+	  st.st_size == 0)
+	return nemo_file_lines(name, deflen);
+    str = stropen(name, "r");
+    if (!is_binary(str, TRUE)) {
+	strclose(str);
+	return nemo_file_lines(name, deflen);
+    }
+    for (;;) {
+	get_history(str);
+	if (!get_tag_ok(str, TableTag))
+	    break;
+	get_set(str, TableTag);
+	get_data(str, "Nrow", IntType, &nrow, 0);
+	get_tes(str, TableTag);			/* columns not read         */
+	n += nrow;
+    }
+    strclose(str);
+    dprintf(1, "table_rows: %d rows in binary table %s\n", n, name);
+    return n;
+}
+
+/*
+ * a line the fast path did not take, as get_atable would do it; stores
+ * the values and whether they are good in val[] and bad[] for the cache,
+ * returns TRUE if the line is a row
+ */
+
+local bool slow_line(char *cp, int nline, tblock *tb, int ncol, int colnr[],
+		     real *val, char *bad, char **scratch, size_t *slen)
+{
+    string *sp;
+    size_t len;
+    int i, n, u, nret;
+    bool row;
+    real dummy;
+
+    for (len = 0; cp[len] != '\n'; len++)
+	;
+    if (len + 1 > *slen) {
+	*slen = len + 1;
+	*scratch = (char *) reallocate(*scratch, *slen);
+    }
+    memcpy(*scratch, cp, len);
+    (*scratch)[len] = '\0';
+    sp = burststring(*scratch, ", \t\r");
+    n = xstrlen(sp, sizeof(string)) - 1;
+    dprintf(3, "[%d] %s\n", n, *scratch);
+    for (u = 0; u < tb->nu; u++) {
+	if (tb->ucol[u] > n) {
+	    bad[u] = 1;
+	    continue;
+	}
+	nret = nemoinpr(sp[tb->ucol[u]-1], &val[u], 1);
+	bad[u] = nret != 1;
+    }
+    row = TRUE;
+    for (i = 0; i < ncol && row; i++) {		/* warn as get_atable does  */
+	if (colnr[i] > n) {
+	    warning("get_atable: skip line %d: %d columns, %d not present",
+		    nline, n, colnr[i]);
+	    row = FALSE;
+	} else if (colnr[i] > 0) {
+	    for (u = 0; tb->ucol[u] != colnr[i]; u++)
+		;
+	    if (bad[u]) {
+		nret = nemoinpr(sp[colnr[i]-1], &dummy, 1);
+		warning("get_atable: line %d: error %d reading %s",
+			nline, nret, sp[colnr[i]-1]);
+		row = FALSE;
+	    }
+	}
+    }
+    freestrings(sp);
+    return row;
+}
+
+/*
+ * GET_BTABLE: get_atable(), but faster for large tables; see above
+ */
+
+int get_btable(
+    stream instr,                   /* in: input ascii file */
+    int ncol,                       /* in: number of columns to read */
+    int colnr[],                    /* in: column numbers to read */
+    real *coldat[],                 /* out: array of pointers to data */
+    int ndat)                       /* in: length of dat arrays ; if < 0, repeat */
+{
+    tblock tb;
+    tcache tc;
+    struct stat st;
+    char *buf, *cp, *end, *scratch = NULL;
+    char rbad[MAXCOL];
+    real rval[MAXCOL];
+    size_t cap, have, used, slen = 0;
+    off_t base;
+    int i, l, u, lmax, nthread, nline = 0, npt = 0, *slot;
+    bool eof, file, full = FALSE, cache, row;
+
+    if (ndat==0 || ncol<=0) error("Illegal ndat=%d ncol=%d",ndat,ncol);
+    ndat = ABS(ndat);
+    dprintf(2,"get_btable: parsing into %d columns\n",ncol);
+
+    tb.ucol = (int *) allocate(ncol * sizeof(int));	/* columns to convert */
+    slot = (int *) allocate(ncol * sizeof(int));
+    tb.nu = tb.maxcol = 0;
+    for (i = 0; i < ncol; i++) {
+	slot[i] = -1;
+	if (colnr[i] <= 0) continue;			/* 0: line number */
+	for (u = 0; u < tb.nu; u++)
+	    if (tb.ucol[u] == colnr[i]) break;
+	if (u == tb.nu) {
+	    if (tb.nu == MAXCOL) error("get_btable: more than %d columns", MAXCOL);
+	    tb.ucol[tb.nu++] = colnr[i];
+	}
+	slot[i] = u;
+	tb.maxcol = MAX(tb.maxcol, colnr[i]);
+    }
+
+    file = fstat(fileno(instr), &st) == 0 && S_ISREG(st.st_mode) &&
+	   left.str != instr;
+    if (left.str != instr && is_binary(instr, file)) {
+	npt = get_bin(instr, &tb, ncol, slot, coldat, ndat);
+	free(tb.ucol);
+	free(slot);
+	return npt;
+    }
+    base = file ? ftello(instr) : -1;
+    if (file && base == 0 && cache_env(TRUE)) {
+	npt = get_cache(instr, &tb, ncol, colnr, coldat, ndat);
+	if (npt >= 0) {
+	    free(tb.ucol);
+	    free(slot);
+	    return npt;
+	}
+	npt = 0;
+    }
+    cache = file && base == 0 && cache_env(FALSE) && strname(instr) &&
+	    *strname(instr) != '-' && !streq(strname(instr), ".");
+    tc.nrec = tc.nmax = 0;
+    tc.nu = tb.nu;
+    tc.line = NULL;
+    tc.val = NULL;
+    tc.bad = NULL;
+    tc.anybad = FALSE;
+
+    nthread = thread_env();
+    cap = TabBlock + 1;
+    buf = (char *) allocate(cap);
+    have = 0;
+    if (left.str == instr) {				/* rest of a pipe   */
+	if (left.len + 1 > cap) {
+	    cap = left.len + 1;
+	    buf = (char *) reallocate(buf, cap);
+	}
+	memcpy(buf, left.buf, left.len);
+	have = left.len;
+	free(left.buf);
+	left.str = NULL;
+	left.buf = NULL;
+	left.len = 0;
+    }
+    tb.line = NULL;
+    tb.val = NULL;
+    tb.stat = NULL;
+    lmax = 0;
+    eof = FALSE;
+    while (!full) {
+	if (!eof && have < cap - 1) {
+	    have += fread(buf + have, 1, cap - 1 - have, instr);
+	    eof = have < cap - 1;
+	}
+	for (end = buf + have; end > buf && end[-1] != '\n'; end--)
+	    ;						/* after last newline */
+	if (end == buf && have > 0 && !eof) {		/* line beyond block  */
+	    cap *= 2;
+	    buf = (char *) reallocate(buf, cap);
+	    continue;
+	}
+	if (eof && have > 0 && buf[have-1] != '\n') {	/* unterminated last  */
+	    buf[have++] = '\n';
+	    end = buf + have;
+	}
+	if (end == buf) break;				/* all done           */
+	used = end - buf;
+
+	for (tb.nline = 0, cp = buf; cp < end; tb.nline++) {	/* split lines */
+	    if (tb.nline == lmax) {
+		lmax = lmax ? 2 * lmax : 65536;
+		tb.line = (char **) reallocate(tb.line, (lmax+1) * sizeof(char *));
+		tb.stat = (char *) reallocate(tb.stat, lmax);
+		tb.val = (real *) reallocate(tb.val,
+					     (size_t) lmax * MAX(tb.nu,1) * sizeof(real));
+	    }
+	    tb.line[tb.nline] = cp;
+	    cp = (char *) memchr(cp, '\n', end - cp) + 1;
+	}
+	tb.line[tb.nline] = end;
+	parse_block(&tb, nthread);
+
+	for (l = 0; l < tb.nline; l++) {		/* rows, in order     */
+	    if (tb.stat[l] == L_SKIP) {
+		nline++;
+		if (*tb.line[l] == '#' || *tb.line[l] == ';' || *tb.line[l] == '!')
+		    dprintf(2, "%.*s\n", (int)(tb.line[l+1] - tb.line[l] - 1),
+			    tb.line[l]);
+		continue;
+	    }
+	    if (npt >= ndat) {				/* full: stop here    */
+		full = TRUE;
+		break;
+	    }
+	    nline++;
+	    if (cache) {
+		grow_cache(&tc, tc.nrec + 1);
+		tc.line[tc.nrec] = nline;
+	    }
+	    if (tb.stat[l] == L_OK) {
+		for (i = 0; i < ncol; i++)
+		    coldat[i][npt] = slot[i] < 0 ? nline :
+			tb.val[(size_t) l * tb.nu + slot[i]];
+		for (u = 0; cache && u < tb.nu; u++) {
+		    tc.val[(size_t) u * tc.nmax + tc.nrec] = tb.val[(size_t) l * tb.nu + u];
+		    tc.bad[(size_t) u * tc.nmax + tc.nrec] = 0;
+		}
+		npt++;
+	    } else {
+		row = slow_line(tb.line[l], nline, &tb, ncol, colnr, rval, rbad,
+				&scratch, &slen);
+		if (row) {
+		    for (i = 0; i < ncol; i++)
+			coldat[i][npt] = slot[i] < 0 ? nline : rval[slot[i]];
+		    npt++;
+		}
+		for (u = 0; cache && u < tb.nu; u++) {
+		    tc.val[(size_t) u * tc.nmax + tc.nrec] = rval[u];
+		    tc.bad[(size_t) u * tc.nmax + tc.nrec] = rbad[u];
+		    if (rbad[u]) tc.anybad = TRUE;
+		}
+	    }
+	    if (cache) tc.nrec++;
+	}
+	if (full) {					/* keep what is left  */
+	    used = tb.line[l] - buf;
+	    if (file)
+		fseeko(instr, base + used, SEEK_SET);
+	    else {
+		left.str = instr;
+		left.len = have - used;
+		left.buf = (char *) allocate(left.len + 1);
+		memcpy(left.buf, tb.line[l], left.len);
+	    }
+	    npt = -ndat;
+	    break;
+	}
+	memmove(buf, end, have - used);			/* partial last line  */
+	have -= used;
+	if (base >= 0) base += used;
+	if (eof && have == 0) break;
+    }
+    if (cache && !full)
+	put_cache(instr, &tb, &tc, nline);
+    dprintf(1,"%d lines read from table file, %d data used \n",nline, ABS(npt));
+
+    free(buf);
+    if (scratch) free(scratch);
+    if (tb.line) free(tb.line);
+    if (tb.stat) free(tb.stat);
+    if (tb.val) free(tb.val);
+    if (tc.line) free(tc.line);
+    if (tc.val) free(tc.val);
+    if (tc.bad) free(tc.bad);
+    free(tb.ucol);
+    free(slot);
+    return npt;
+}
+
+/*
+ * PARSE_ROW: convert the numbers of a whole table line into dat[], like
+ *            nemoinpr(line,dat,ndat), but plain numbers separated by blanks
+ *            or single commas are converted right here; any other line goes
+ *            to nemoinpr(). Returns the number of values, or nemoinpr's
+ *            (negative) error code.
+ */
+
+int parse_row(string line, real *dat, int ndat)
+{
+    char *cp = line;
+    int n = 0;
+    bool comma = TRUE;				/* no comma before the first */
+
+    for (;;) {
+	while (*cp == ' ' || *cp == '\t') cp++;
+	if (*cp == ',') {
+	    if (comma) break;			/* ,, or leading comma       */
+	    comma = TRUE;
+	    cp++;
+	    continue;
+	}
+	if (*cp == '\0') {
+	    if (comma && n > 0) break;		/* trailing comma            */
+	    return n;
+	}
+	if (n == ndat || !plain_number(cp, &dat[n])) break;
+	n++;
+	comma = FALSE;
+	while (*cp && !issep(*cp)) cp++;
+    }
+    return nemoinpr(line, dat, ndat);
+}
+
+/*
+ * PUT_BTABLE: write ncol columns of nrow rows as a binary Table set, the
+ *             columns as type (DoubleType or FloatType); names, if not
+ *             NULL, are the blank separated column names.
+ */
+
+void put_btable(stream str, int ncol, real *coldat[], int nrow, string names,
+		string type)
+{
+    char tag[32];
+    void *buf = NULL;
+    int i, k;
+
+    put_set(str, TableTag);
+    put_data(str, "Ncol", IntType, &ncol, 0);
+    put_data(str, "Nrow", IntType, &nrow, 0);
+    if (names != NULL)
+	put_string(str, "Names", names);
+    if (!streq(type, RealType)) {
+	if (streq(type, FloatType))
+	    buf = allocate(MAX(nrow,1) * sizeof(float));
+	else if (streq(type, DoubleType))
+	    buf = allocate(MAX(nrow,1) * sizeof(double));
+	else
+	    error("put_btable: type %s not supported", type);
+    }
+    for (k = 0; k < ncol; k++) {
+	sprintf(tag, "Col%d", k+1);
+	if (buf == NULL)
+	    put_data(str, tag, type, coldat[k], nrow, 0);
+	else {
+	    for (i = 0; i < nrow; i++)
+		if (streq(type, FloatType))
+		    ((float *) buf)[i] = (float) coldat[k][i];
+		else
+		    ((double *) buf)[i] = (double) coldat[k][i];
+	    put_data(str, tag, type, buf, nrow, 0);
+	}
+    }
+    put_tes(str, TableTag);
+    if (buf) free(buf);
+}
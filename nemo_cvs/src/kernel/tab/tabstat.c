@@ -7,6 +7,8 @@
  * 	 2-mar-01   V1.2    added sum to the output			   pjt
  *      24-jan-12   V1.4    also report min/max in sigma from mean         pjt
  *      16-jan-13   V1.5    added MAD                                      pjt
+ *      19-oct-26   V1.6    read with get_btable
+ *      19-oct-26   V1.6a   rows of a binary table from its Nrow
  *
  *
  *  @todo:   xcol=0 should use the first data row to figure out all columns
@@ -15,6 +17,7 @@
 #include <stdinc.h>	
 #include <getparam.h>
 #include <moment.h>
+#include <table.h>
 
 
 #define MAXCOL  256
@@ -33,7 +36,7 @@ string defv[] = {                /* DEFAULT INPUT PARAMETERS */
     "nmax=100000\n       maximum number of data to be read if pipe",
     "xmin=\n             Set minimum ",
     "xmax=\n             Set maximum ",
-    "VERSION=1.5\n	 16-jan-2014 PJT",
+    "VERSION=1.6a\n	 19-oct-2026",
     NULL
 };
 
@@ -85,7 +88,7 @@ void setparams()
     nxcol = nemoinpi(getparam("xcol"),xcol,MAXCOL);
     if (nxcol < 1) error("Error parsing xcol=%s",getparam("xcol"));
 
-    nmax = nemo_file_lines(input,getiparam("nmax"));
+    nmax = table_rows(input,getiparam("nmax"));
     dprintf(1,"Allocated %d lines for table\n",nmax);
     for (j=0; j<nxcol; j++)
         x[j] = (real *) allocate(sizeof(real) * (nmax+1));   /* data */
@@ -118,7 +121,7 @@ read_data()
         colnr[j] = xcol[j];
         coldat[j] = x[j];
     }
-    npt = get_atable(instr,nxcol,colnr,coldat,nmax);    /* get data */
+    npt = get_btable(instr,nxcol,colnr,coldat,nmax);    /* get data */
     if (npt < 0) {
     	npt = -npt;
     	warning("Could only read %d data",npt);
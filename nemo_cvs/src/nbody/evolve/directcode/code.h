@@ -32,6 +32,7 @@ global bodyptr bodytab;		/* points to array of bodies */
 global real eps;                       /* grav softening length */
 
 global real gravc;                     /* gravitational constant [1] */
+global bool symmetric;                 /* each pair once in allgrav() */
 
 /* code.c */
 void nemo_main(void);
@@ -50,3 +51,4 @@ void pickvec(vector x, bool cf);
 
 /* grav.c */
 void hackgrav(bodyptr p);
+void allgrav(void);
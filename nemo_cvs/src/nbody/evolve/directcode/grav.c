@@ -1,67 +1,308 @@
 /*
  * GRAV.C: routines to compute gravity.
- *   
+ *
  *      16-feb-04    cloned from hackcode1 for DirectCode
  *      29-jul-09    eps < 0 allowed for pseudo-newtonian
+ *      19-oct-26    allgrav: blocked, vectorized, OpenMP; symmetric option
  *
  */
 
 #include "code.h"
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+extern int np_openmp;		/* system keyword np=, see getparam.c */
+
+/*
+ * The sums run over copies of the positions and masses in separate arrays
+ * (SoA), so the inner loops over source bodies are contiguous and can be
+ * vectorized; the choice between softened and pseudo-Newtonian force is
+ * made once, outside the loops. Targets are done in blocks of IBLOCK
+ * against tiles of JBLOCK sources, which stay in cache meanwhile, and the
+ * blocks of targets are shared among the OpenMP threads.
+ */
+
+#define IBLOCK  64		/* targets per block */
+#define JBLOCK  2048		/* sources per tile */
 
+local int nsoa = 0;		/* size of arrays below */
+local real *xs, *ys, *zs, *ms;	/* positions, masses */
+local real *sacc = NULL;	/* symmetric: per thread acc & pot */
+local int nsacc = 0;
 
-/* must define either USE_LOCAL *or* USE_STACK here  */
+local void loadsoa(void)
+{
+    int i;
+
+    if (nsoa != nbody) {
+	if (nsoa) free(xs);
+	xs = (real *) allocate(4 * nbody * sizeof(real));
+	ys = xs + nbody;
+	zs = ys + nbody;
+	ms = zs + nbody;
+	nsoa = nbody;
+    }
+    for (i = 0; i < nbody; i++) {
+	xs[i] = Pos(bodytab+i)[0];
+	ys[i] = Pos(bodytab+i)[1];
+	zs[i] = Pos(bodytab+i)[2];
+	ms[i] = Mass(bodytab+i);
+    }
+}
 
 /*
- * HACKGRAV: evaluate grav field at a given particle.
- *           for a Direct N-body code this is awfully simple:
- *           loop over all particles, but yourself, and accumulate
- *           the forces, and potential
+ * SUMNEWTON, SUMPN: add the field of sources j0 <= j < j1 at target i
+ * (which must not be among them); softened or pseudo-Newtonian force.
  */
 
+local void sumnewton(int i, int j0, int j1, real *phi, real acc[3])
+{
+    int j;
+    real x0 = xs[i], y0 = ys[i], z0 = zs[i], e2 = eps*eps;
+    real ph = 0.0, ax = 0.0, ay = 0.0, az = 0.0;
+    real dx, dy, dz, drsq, drinv, phii, mor3;
 
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:ph,ax,ay,az) private(dx,dy,dz,drsq,drinv,phii,mor3)
+#endif
+    for (j = j0; j < j1; j++) {
+	dx = xs[j] - x0;
+	dy = ys[j] - y0;
+	dz = zs[j] - z0;
+	drsq = dx*dx + dy*dy + dz*dz + e2;	/* use standard softening   */
+	drinv = 1.0 / sqrt(drsq);
+	phii = ms[j] * drinv;
+	ph -= phii;				/* add to grav. pot.        */
+	mor3 = phii * drinv * drinv;
+	ax += dx * mor3;			/* add to net accel.        */
+	ay += dy * mor3;
+	az += dz * mor3;
+    }
+    *phi += ph;
+    acc[0] += ax;
+    acc[1] += ay;
+    acc[2] += az;
+}
 
-void hackgrav(bodyptr p)
+local void sumpn(int i, int j0, int j1, real *phi, real acc[3], real *dmin)
+{
+    int j;
+    real x0 = xs[i], y0 = ys[i], z0 = zs[i];
+    real ph = 0.0, ax = 0.0, ay = 0.0, az = 0.0, dm = *dmin;
+    real dx, dy, dz, dr, drabs, phii, mor3;
+
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:ph,ax,ay,az) reduction(min:dm) private(dx,dy,dz,dr,drabs,phii,mor3)
+#endif
+    for (j = j0; j < j1; j++) {
+	dx = xs[j] - x0;
+	dy = ys[j] - y0;
+	dz = zs[j] - z0;
+	dr = sqrt(dx*dx + dy*dy + dz*dz);
+	drabs = dr + eps;			/* r-e */
+	dm = MIN(dm, drabs);			/* checked by caller        */
+	phii = ms[j] / drabs;
+	ph -= phii;				/* add to grav. pot.        */
+	mor3 = phii / (drabs * dr);
+	ax += dx * mor3;			/* add to net accel.        */
+	ay += dy * mor3;
+	az += dz * mor3;
+    }
+    *dmin = dm;
+    *phi += ph;
+    acc[0] += ax;
+    acc[1] += ay;
+    acc[2] += az;
+}
+
+local void sumfield(int i, int j0, int j1, real *phi, real acc[3], real *dmin)
 {
-  bodyptr p0;			/* body itself  */
-  vector pos0;			/* point to evaluate field at */
-  real phi0;			/* resulting potential at pos0 */
-  vector acc0;			/* resulting acceleration at pos0 */
-  vector dr;			/* between gravsub and subdivp */
-  real drsq;
-  real drabs, phii, mor3;
-  vector ai;
-
-  p0 = p;					/* exclude p from f.c.      */
-  SETV(pos0, Pos(p));				/* set field point          */
-  phi0 = 0.0;					/* init potential, etc      */
-  CLRV(acc0);
-
-  for (p=bodytab; p<bodytab+nbody; p++) {
-    if (p == p0) continue;
-    SUBV(dr,Pos(p),pos0);
-    DOTVP(drsq,dr,dr);
+    if (j1 <= j0)
+	return;
+    if (eps >= 0.0)
+	sumnewton(i, j0, j1, phi, acc);
+    else
+	sumpn(i, j0, j1, phi, acc, dmin);
+}
+
+/*
+ * FIELDBLOCK: potential and acceleration at targets i0 <= i < i1, summed
+ * over all other bodies tile by tile.
+ */
+
+local real fieldblock(int i0, int i1)
+{
+    int i, j0, j1, k;
+    real phi[IBLOCK], acc[IBLOCK][3], dmin = 1.0;
+
+    for (i = i0; i < i1; i++) {
+	phi[i-i0] = 0.0;
+	CLRV(acc[i-i0]);
+    }
+    for (j0 = 0; j0 < nbody; j0 = j1) {		/* loop over tiles          */
+	j1 = MIN(j0 + JBLOCK, nbody);
+	for (i = i0; i < i1; i++)
+	    if (i < j0 || i >= j1)		/*   target not in tile     */
+		sumfield(i, j0, j1, &phi[i-i0], acc[i-i0], &dmin);
+	    else {				/*   skip target itself     */
+		sumfield(i, j0, i, &phi[i-i0], acc[i-i0], &dmin);
+		sumfield(i, i+1, j1, &phi[i-i0], acc[i-i0], &dmin);
+	    }
+    }
+    for (i = i0; i < i1; i++) {			/* stash pot. and acc.      */
+	Phi(bodytab+i) = gravc * phi[i-i0];
+	for (k = 0; k < NDIM; k++)
+	    Acc(bodytab+i)[k] = gravc * acc[i-i0][k];
+    }
+    return dmin;
+}
+
+/*
+ * SYMPAIRS: symmetric option, add the interactions of body i with bodies
+ * j > i to both, in the accumulators of one thread.
+ */
+
+local void sympairs(int i, real *ax, real *ay, real *az, real *ph, real *dmin)
+{
+    int j;
+    real x0 = xs[i], y0 = ys[i], z0 = zs[i], m0 = ms[i], e2 = eps*eps;
+    real phi0 = 0.0, ax0 = 0.0, ay0 = 0.0, az0 = 0.0, dm = *dmin;
+    real dx, dy, dz, dr, drabs, drinv, f;
 
     if (eps >= 0.0) {
-      drsq += eps*eps;                         /* use standard softening   */
-      drabs = sqrt(drsq);
-      phii = gravc * Mass(p) / drabs;
-      phi0 -= phii;                               /* add to grav. pot.        */
-      mor3 = phii / drsq;
-      MULVS(ai, dr, mor3);
-      ADDV(acc0, acc0, ai);                       /* add to net accel.        */
-    } else if (eps < 0) {
-      drabs = sqrt(drsq) + eps;                   /* r-e */
-      if (drabs < 0) error("PN violation at time=%g",tnow);
-      phii = gravc * Mass(p) / drabs;
-      phi0 -= phii;                               /* add to grav. pot.        */
-      mor3 = phii / drabs / sqrt(drsq);
-      MULVS(ai, dr, mor3);
-      ADDV(acc0, acc0, ai);                       /* add to net accel.        */
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:phi0,ax0,ay0,az0) private(dx,dy,dz,drinv,f)
+#endif
+	for (j = i+1; j < nbody; j++) {
+	    dx = xs[j] - x0;
+	    dy = ys[j] - y0;
+	    dz = zs[j] - z0;
+	    drinv = 1.0 / sqrt(dx*dx + dy*dy + dz*dz + e2);
+	    f = drinv * drinv * drinv;		/* 1/r^3, softened          */
+	    phi0 -= ms[j] * drinv;
+	    ph[j] -= m0 * drinv;
+	    ax0 += ms[j] * f * dx;
+	    ay0 += ms[j] * f * dy;
+	    az0 += ms[j] * f * dz;
+	    ax[j] -= m0 * f * dx;
+	    ay[j] -= m0 * f * dy;
+	    az[j] -= m0 * f * dz;
+	}
+    } else {
+#if defined(_OPENMP)
+#pragma omp simd reduction(+:phi0,ax0,ay0,az0) reduction(min:dm) private(dx,dy,dz,dr,drabs,drinv,f)
+#endif
+	for (j = i+1; j < nbody; j++) {
+	    dx = xs[j] - x0;
+	    dy = ys[j] - y0;
+	    dz = zs[j] - z0;
+	    dr = sqrt(dx*dx + dy*dy + dz*dz);
+	    drabs = dr + eps;			/* r-e */
+	    dm = MIN(dm, drabs);
+	    drinv = 1.0 / drabs;
+	    f = drinv * drinv / dr;
+	    phi0 -= ms[j] * drinv;
+	    ph[j] -= m0 * drinv;
+	    ax0 += ms[j] * f * dx;
+	    ay0 += ms[j] * f * dy;
+	    az0 += ms[j] * f * dz;
+	    ax[j] -= m0 * f * dx;
+	    ay[j] -= m0 * f * dy;
+	    az[j] -= m0 * f * dz;
+	}
     }
-  }
+    *dmin = dm;
+    ph[i] += phi0;
+    ax[i] += ax0;
+    ay[i] += ay0;
+    az[i] += az0;
+}
+
+/*
+ * ALLGRAV: evaluate grav field at all particles. With symmetric each pair
+ * is done once, for half the work, but each thread then needs its own
+ * accumulators for all bodies, which are added up at the end.
+ */
+
+void allgrav(void)
+{
+    int nt = 1, i0;
+    real dmin = 1.0, dm;
 
-  Phi(p0) = phi0;				/* stash the pot.           */
-  SETV(Acc(p0), acc0);        			/* and the acceleration     */
+    loadsoa();
+#if defined(_OPENMP)
+    if (np_openmp > 0)				/* np= sets no. of threads  */
+	omp_set_num_threads(np_openmp);
+    nt = omp_get_max_threads();
+#endif
+    if (!symmetric) {
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic) private(dm) reduction(min:dmin)
+#endif
+	for (i0 = 0; i0 < nbody; i0 += IBLOCK) {	/* blocks of targets        */
+	    dm = fieldblock(i0, MIN(i0 + IBLOCK, nbody));
+	    dmin = MIN(dmin, dm);
+	}
+    } else {
+	if (nsacc != 4 * nt * nbody) {
+	    if (sacc) free(sacc);
+	    nsacc = 4 * nt * nbody;
+	    sacc = (real *) allocate(nsacc * sizeof(real));
+	}
+#if defined(_OPENMP)
+#pragma omp parallel reduction(min:dmin)
+#endif
+	{
+	    int t = 0, i, k;
+	    real *a, sum[4];
+#if defined(_OPENMP)
+	    t = omp_get_thread_num();
+#endif
+#if defined(_OPENMP)
+#pragma omp for
+#endif
+	    for (i = 0; i < nsacc; i++)		/* clear all accumulators   */
+		sacc[i] = 0.0;
+	    a = sacc + 4 * t * nbody;
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic,16)
+#endif
+	    for (i = 0; i < nbody-1; i++)	/* pairs (i,j>i)            */
+		sympairs(i, a, a+nbody, a+2*nbody, a+3*nbody, &dmin);
+#if defined(_OPENMP)
+#pragma omp for
+#endif
+	    for (i = 0; i < nbody; i++) {	/* add up threads           */
+		sum[0] = sum[1] = sum[2] = sum[3] = 0.0;
+		for (k = 0; k < nt; k++) {
+		    a = sacc + 4 * k * nbody + i;
+		    sum[0] += a[0];
+		    sum[1] += a[nbody];
+		    sum[2] += a[2*nbody];
+		    sum[3] += a[3*nbody];
+		}
+		for (k = 0; k < NDIM; k++)
+		    Acc(bodytab+i)[k] = gravc * sum[k];
+		Phi(bodytab+i) = gravc * sum[3];
+	    }
+	}
+    }
+    if (eps < 0 && dmin < 0) error("PN violation at time=%g",tnow);
 }
 
+/*
+ * HACKGRAV: evaluate grav field at a given particle.
+ *           for a Direct N-body code this is awfully simple:
+ *           loop over all particles, but yourself, and accumulate
+ *           the forces, and potential
+ */
+
+void hackgrav(bodyptr p)
+{
+    int i = p - bodytab;
 
+    loadsoa();
+    if (fieldblock(i, i+1) < 0 && eps < 0)
+	error("PN violation at time=%g",tnow);
+}
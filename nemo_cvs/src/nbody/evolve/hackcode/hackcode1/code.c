@@ -13,6 +13,9 @@
  *                plus LOTS of prototype cleanup
  *     23-jul-11  V1.5    Use log= to be able to bypass log  pjt
  *                        removed debug= to enable system key
+ *     19-oct-26  V1.6    snapshots written in the background
+ *     19-oct-26  V1.7    rebuild=: update tree between full builds,
+ *                        forces in tree order
  */
 
 #define global                                  /* don't default to extern  */
@@ -39,6 +42,7 @@ string defv[] = {		/* DEFAULT PARAMETER VALUES */
     "eps=0.05\n			  usual potential softening ",
     "tol=1.0\n			  cell subdivision tolerence ",
     "fcells=1.0\n		  cell allocation parameter ",
+    "rebuild=1\n		  steps between full tree builds; 0: update only ",
     "options=mass,phase\n	  misc. control options ",
 
     "tstop=2.0\n		  time to stop integration ",
@@ -46,7 +50,7 @@ string defv[] = {		/* DEFAULT PARAMETER VALUES */
     "minor_freqout=32.0\n	  minor data-output frequency ",
 
     "log=-\n                      logging output",
-    "VERSION=1.5a\n		  27-jul-11 PJT",
+    "VERSION=1.7\n		  19-oct-26",
     NULL,
 };
 
@@ -61,6 +65,7 @@ void nemo_main(void)
     while (tnow < tstop + 0.1/freq)		/* while not past tstop     */
 	stepsystem();				/*   advance N-body system  */
     stopoutput();				/* finish up output         */
+    freetree();					/* release tree memory      */
 }
 
 /*
@@ -119,6 +124,9 @@ void startrun(void)
 	SETVS(rmin, -2.0);			/*   init box scaling       */
 	rsize = -2.0 * rmin[0];
     }
+    rebuild = getiparam("rebuild");		/* not part of saved state  */
+    if (rebuild < 0)
+	error("startrun: rebuild=%d must not be negative", rebuild);
 }
 
 /*
@@ -160,13 +168,20 @@ void stepsystem(void)
 {
     real dthf, dt;
     register bodyptr p;
+    bodyptr *order;
+    int i;
     vector acc1, dacc, dvel, vel1, dpos;
 
     dt = 1.0 / freq;				/* get basic time-step      */
     dthf = 0.5 * dt;				/* and basic half-step      */
-    maketree(bodytab, nbody);			/* load bodies into tree    */
+    if (rebuild > 0 && nstep % rebuild == 0)	/* time for a new tree?     */
+	maketree(bodytab, nbody);		/*   load bodies into tree  */
+    else
+	updatetree(bodytab, nbody);		/*   move bodies in tree    */
+    order = treeorder();			/* bodies close in space    */
     nfcalc = n2bcalc = nbccalc = 0;		/* zero interaction counts  */
-    for (p = bodytab; p < bodytab+nbody; p++) { /* loop over particles      */
+    for (i = 0; i < nbody; i++) {		/* loop over particles      */
+	p = order[i];				/*   in tree order          */
 	SETV(acc1, Acc(p));			/*   save old acceleration  */
 	hackgrav(p);				/*   compute new acc for p  */
 	nfcalc++;				/*   count force calcs      */
@@ -27,6 +27,7 @@ global real rsize;			/* side-length of int. coord. box */
  */
 
 global real fcells;			/* ratio of cells/bodies allocated */
+global int rebuild;			/* steps between full tree builds */
 
 global real tol;                        /* accuracy parameter: 0.0 => exact */
 global real eps;                        /* potential softening parameter */
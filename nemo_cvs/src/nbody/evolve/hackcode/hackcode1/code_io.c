@@ -8,6 +8,7 @@
  *	26-jun-92 fixed allocate decl. once more ... ???   	PJT
  *	24-mar-94 ansi fixes
  *      29-mar-04 prototypes
+ *      19-oct-26 snapshots written in the background (put_async_set)
  */
 
 #include "code.h"
@@ -88,7 +89,7 @@ void initoutput(void)
 void stopoutput(void)
 {
     if (outstr != NULL)
-        strclose(outstr);
+        strclose(outstr);			/* waits for last output    */
 }
 
 /*
@@ -145,7 +146,8 @@ void output(void)
 	    bits |= AccelerationBit;
     }
     if (bits != 0 && outstr != NULL) {		/* output ready and able?   */
-	put_snap(outstr, &bodytab, &nbody, &tnow, &bits);
+	put_snap(put_async_set(outstr), &bodytab, &nbody, &tnow, &bits);
+	put_async_tes(outstr);			/*   written while we go on */
 	if (bits & PhaseSpaceBit)
 	  fprintf(logstr,"\n\tparticle data written\n");
     }
@@ -1,6 +1,6 @@
 /*
  * LOAD.C: routines to create body-tree.
- * Public routines: maketree().
+ * Public routines: maketree(), updatetree(), treeorder(), freetree().
  *
  *	4-nov-91  added decl. intcoord() for _trace_
  *	18-nov-91 malloc -> allocate
@@ -9,12 +9,46 @@
  *	 4-mar-96 removed redundant (bad prototype) floor() definition
  *      28-nov-00 fixed bad index bug in printf() - documented a leak
  *      29-mar-04 prototyped
+ *      19-oct-26 cells from chunks (freetree), updatetree, treeorder
+ *      19-oct-26 updatetree: body left as root by removebody
  */
 
 #include "code.h"
 
-local cellptr ctab = NULL;	/* cells are allocated from here */
-local int ncell, maxcell;	/* count cells in use, max available */
+/*
+ * Cells are allocated in chunks of maxcell cells, which are kept and reused
+ * for the next tree, and released by freetree(). Besides the cell itself,
+ * load.c keeps its parent, level and lower-left corner (integerized), so
+ * that updatetree() can tell whether a body is still in its place, and
+ * take it out of the tree if not.
+ */
+
+typedef struct {
+    cell c;			/* the cell proper, as seen by grav.c */
+    cellptr up;			/* parent cell, NULL for root */
+    int lev;			/* bit selecting subcells */
+    int xmin[NDIM];		/* integerized corner: bits above lev */
+} lcell, *lcellptr;
+
+#define Up(x)    (((lcellptr) (x))->up)
+#define Lev(x)   (((lcellptr) (x))->lev)
+#define Xmin(x)  (((lcellptr) (x))->xmin)
+
+typedef struct _chunk {
+    lcell *cells;		/* maxcell cells */
+    struct _chunk *next;
+} chunk;
+
+local chunk *cfirst = NULL;	/* chunks of cells */
+local chunk *cnow = NULL;	/* chunk in use */
+local int ncell, maxcell;	/* cells in use in cnow, cells per chunk */
+local cellptr cfree = NULL;	/* cells freed by updatetree, via Subp[0] */
+
+local bodyptr btree = NULL;	/* bodies the tree was made for */
+local int nbtree = 0;
+local cellptr *bcell = NULL;	/* per body: cell holding it, NULL for root */
+local bodyptr *border = NULL;	/* bodies in tree order, then massless */
+local int nborder;
 
 /* local forward declarations: */
 static void expandbox(bodyptr p);
@@ -23,6 +57,10 @@ static bool intcoord(int xp[3], vector rp);
 static int subindex(int x[3], int l);
 static void hackcofm(nodeptr q);
 static cellptr makecell(void);
+static void freecell(cellptr c);
+static void removebody(bodyptr p);
+static void setbodies(bodyptr btab, int nbody);
+static void finishtree(bodyptr btab, int nbody);
 
 /*
  * MAKETREE: initialize tree structure for hack force calculation.
@@ -34,21 +72,138 @@ void maketree(
 {
     register bodyptr p;
 
-    if (ctab == NULL) {				/* first time through?      */
-	maxcell = fcells * nbody;		/*   typ. need: 0.5 nbody   */
-	ctab = (cellptr) allocate(maxcell * sizeof(cell));   /* NEVER FREED */
-						/*   allocate cell space    */
-    }
+    setbodies(btab, nbody);			/* (re)allocate body tables */
+    cnow = cfirst;				/* reuse cells from start   */
     ncell = 0;					/* reset cells in use       */
+    cfree = NULL;
     troot = NULL;				/* deallocate current tree  */
     for (p = btab; p < btab+nbody; p++)		/* loop over all bodies     */
-	if (Mass(p) != 0.0) {			/*   only load massive ones */
+	if (Mass(p) != 0.0)			/*   only massive ones      */
 	    expandbox(p);			/*     expand root to fit   */
+    for (p = btab; p < btab+nbody; p++)		/* loop over all bodies     */
+	if (Mass(p) != 0.0)			/*   only load massive ones */
 	    loadtree(p);			/*     insert into tree     */
+    finishtree(btab, nbody);			/* find c-of-m coordinates  */
+}
+
+/*
+ * UPDATETREE: bring tree made by maketree() up to date with the bodies'
+ * present positions. Only bodies which left the part of space covered by
+ * their place in the tree are taken out and loaded again; the result is
+ * the same tree maketree() would have made, just cheaper if few bodies
+ * moved. Falls back on maketree() if the bodies or the box changed.
+ */
+
+void updatetree(
+  bodyptr btab,			/* array of bodies in tree */
+  int nbody)			/* number of bodies in above array */
+{
+    register bodyptr p;
+    int xp[NDIM], k, l, nmove;
+    cellptr c;
+    bool in;
+
+    if (btab != btree || nbody != nbtree || troot == NULL ||
+	  Type(troot) == BODY) {		/* nothing to update?       */
+	maketree(btab, nbody);
+	return;
+    }
+    nmove = 0;					/* collect movers in border */
+    for (p = btab; p < btab+nbody; p++) {	/* loop over all bodies     */
+	if (Mass(p) == 0.0)			/*   only massive ones      */
+	    continue;
+	if (! intcoord(xp, Pos(p))) {		/*   outside box: rebuild   */
+	    dprintf(1,"updatetree: body %d left box\n", (int)(p-btab));
+	    maketree(btab, nbody);
+	    return;
+	}
+	c = bcell[p-btab];
+	if (c == NULL)				/*   root itself, after the */
+	    continue;				/*     others moved out     */
+	l = Lev(c);
+	in = Subp(c)[subindex(xp, l)] == (nodeptr) p;
+	for (k = 0; in && k < NDIM; k++)	/*   still in cell c?       */
+	    in = (xp[k] & ~((l << 1) - 1)) == Xmin(c)[k];
+	if (! in) {
+	    removebody(p);			/*     take it out          */
+	    border[nmove++] = p;
 	}
-    hackcofm(troot);				/* find c-of-m coordinates  */
+    }
+    dprintf(2,"updatetree: %d of %d bodies moved\n", nmove, nbody);
+    for (k = 0; k < nmove; k++)			/* load movers again        */
+	loadtree(border[k]);
+    finishtree(btab, nbody);			/* find c-of-m coordinates  */
 }
-
+
+/*
+ * TREEORDER: bodies in the order of the tree made last, that is in Morton
+ * order, followed by the massless ones; consecutive bodies are close in
+ * space, which makes consecutive force calculations share their cells.
+ */
+
+bodyptr *treeorder(void)
+{
+    return border;
+}
+
+/*
+ * FREETREE: release the tree and all memory held for it.
+ */
+
+void freetree(void)
+{
+    chunk *ch;
+
+    while (cfirst != NULL) {
+	ch = cfirst;
+	cfirst = ch->next;
+	free(ch->cells);
+	free(ch);
+    }
+    cnow = NULL;
+    cfree = NULL;
+    troot = NULL;
+    if (bcell != NULL) free(bcell);
+    if (border != NULL) free(border);
+    bcell = NULL;
+    border = NULL;
+    btree = NULL;
+    nbtree = 0;
+}
+
+/*
+ * SETBODIES: allocate tables for the bodies, if not yet done.
+ */
+
+local void setbodies(bodyptr btab, int nbody)
+{
+    if (nbody != nbtree) {
+	if (bcell != NULL) free(bcell);
+	if (border != NULL) free(border);
+	bcell = (cellptr *) allocate(nbody * sizeof(cellptr));
+	border = (bodyptr *) allocate(nbody * sizeof(bodyptr));
+    }
+    btree = btab;
+    nbtree = nbody;
+}
+
+/*
+ * FINISHTREE: compute c-of-m coordinates, and the order of the bodies.
+ */
+
+local void finishtree(bodyptr btab, int nbody)
+{
+    register bodyptr p;
+
+    nborder = 0;
+    if (troot != NULL)
+	hackcofm(troot);			/* find c-of-m coordinates  */
+    for (p = btab; p < btab+nbody; p++)		/* massless bodies last     */
+	if (Mass(p) == 0.0)
+	    border[nborder++] = p;
+    assert(nborder == nbody);
+}
+
 /*
  * EXPANDBOX: enlarge cubical "box", salvaging existing tree structure.
  */
@@ -88,13 +243,14 @@ local void expandbox(bodyptr p)                       /* body to be loaded */
 
 local void loadtree(bodyptr p)			/* body to load into tree */
 {
-    int l, xp[NDIM], xq[NDIM];
+    int l, k, xp[NDIM], xq[NDIM];
     nodeptr *qptr;
-    cellptr c;
+    cellptr c, pc;
 
     assert(intcoord(xp, Pos(p)));		/* form integer coords      */
     l = IMAX >> 1;				/* start with top bit       */
     qptr = &troot;				/* start with tree root     */
+    pc = NULL;					/* cell qptr points into    */
     while (*qptr != NULL) {			/* loop descending tree     */
         if(debug_level)
           dprintf(1,"loadtree: descending tree  l = %o\n", l);
@@ -103,18 +259,66 @@ local void loadtree(bodyptr p)			/* body to load into tree */
 	    if(debug_level)
    	      dprintf(1,"loadtree: replacing body with cell\n");
 	    c = makecell();			/*     alloc a new cell     */
+	    Up(c) = pc;				/*     note where it is     */
+	    Lev(c) = l;
+	    for (k = 0; k < NDIM; k++)
+		Xmin(c)[k] = xp[k] & ~((l << 1) - 1);
 	    assert(intcoord(xq, Pos(*qptr)));	/*     get integer coords   */
 	    Subp(c)[subindex(xq, l)] = *qptr;	/*     put body in cell     */
+	    bcell[(bodyptr) *qptr - btree] = c;
 	    *qptr = (nodeptr) c;		/*     link cell in tree    */
 	}
+	pc = (cellptr) *qptr;
 	qptr = &Subp(*qptr)[subindex(xp, l)];	/*   move down one level    */
 	l = l >> 1;				/*   and test next bit      */
     }
     if(debug_level)
       dprintf(1,"loadtree: installing body  l = %o\n", l);
     *qptr = (nodeptr) p;			/* found place, store p     */
+    bcell[p - btree] = pc;
 }
-
+
+/*
+ * REMOVEBODY: take body out of the tree, and prune cells which are left
+ * empty or holding a single body, as loadtree() would not have made them.
+ */
+
+local void removebody(bodyptr p)		/* body to take out */
+{
+    int i, n;
+    cellptr c, up;
+    nodeptr r;
+
+    c = bcell[p - btree];
+    for (i = 0; i < NSUB; i++)			/* take p out of its cell   */
+	if (Subp(c)[i] == (nodeptr) p)
+	    Subp(c)[i] = NULL;
+    for (;;) {					/* loop pruning cells       */
+	n = 0;
+	r = NULL;
+	for (i = 0; i < NSUB; i++)		/*   count what is left     */
+	    if (Subp(c)[i] != NULL) {
+		n++;
+		r = Subp(c)[i];
+	    }
+	if (n > 1 || (n == 1 && Type(r) == CELL))
+	    return;				/*   c is still needed      */
+	up = Up(c);				/*   else replace c by r    */
+	if (r != NULL)
+	    bcell[(bodyptr) r - btree] = up;
+	if (up == NULL)
+	    troot = r;
+	else
+	    for (i = 0; i < NSUB; i++)
+		if (Subp(up)[i] == (nodeptr) c)
+		    Subp(up)[i] = r;
+	freecell(c);
+	if (up == NULL)
+	    return;
+	c = up;					/*   and go on with parent  */
+    }
+}
+
 /*
  * INTCOORD: compute integerized coordinates.
  * Returns: TRUE unless rp was out of bounds.
@@ -178,6 +382,10 @@ local void hackcofm(nodeptr q)                   /* pointer into body-tree */
     static real drsq;
     static matrix drdr, Idrsq, tmpm;
 #endif
+    if (Type(q) == BODY) {			/* is this a body?          */
+	border[nborder++] = (bodyptr) q;	/*   next in tree order     */
+	return;
+    }
     if (Type(q) == CELL) {                      /* is this a cell?          */
         Mass(q) = 0.0;                          /*   init total mass        */
         CLRV(Pos(q));				/*   and c. of m.           */
@@ -221,16 +429,47 @@ local cellptr makecell(void)
 {
     register cellptr c;
     register int i;
+    chunk *ch;
 
-    if (ncell >= maxcell)
-	error("makecell: need more than %d cells; increase fcells\n",
-	      maxcell);
-    c = ctab + ncell;
-    ncell++;
+    if (cfree != NULL) {			/* cell freed before?       */
+	c = cfree;
+	cfree = (cellptr) Subp(c)[0];
+    } else {
+	if (cnow == NULL || ncell >= maxcell) {	/* chunk in use full?       */
+	    if (cnow != NULL && cnow->next != NULL)
+		cnow = cnow->next;		/*   reuse next one         */
+	    else {				/*   or make another one    */
+		if (cfirst == NULL)		/*     typ. need: 0.5 nbody */
+		    maxcell = MAX(64, (int) (fcells * nbtree));
+		ch = (chunk *) allocate(sizeof(chunk));
+		ch->cells = (lcell *) allocate(maxcell * sizeof(lcell));
+		ch->next = NULL;
+		if (cnow != NULL)
+		    cnow->next = ch;
+		else
+		    cfirst = ch;
+		cnow = ch;
+		dprintf(1,"makecell: %d more cells allocated\n", maxcell);
+	    }
+	    ncell = 0;
+	}
+	c = (cellptr) (cnow->cells + ncell);
+	ncell++;
+    }
     if(debug_level)
-      dprintf(1,"cell %d allocated at address 0%o\n", ncell, (int) c);
+      dprintf(1,"cell allocated at address %p\n", (void *) c);
     Type(c) = CELL;
     for (i = 0; i < NSUB; i++)
 	Subp(c)[i] = NULL;
     return c;
 }
+
+/*
+ * FREECELL: return cell, for makecell to use again.
+ */
+
+local void freecell(cellptr c)
+{
+    Subp(c)[0] = (nodeptr) cfree;
+    cfree = c;
+}
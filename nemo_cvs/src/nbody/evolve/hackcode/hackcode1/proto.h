@@ -24,6 +24,9 @@ void write_snapshot(void);
 
 /* load.c */
 void maketree(bodyptr btab, int nbody);
+void updatetree(bodyptr btab, int nbody);
+bodyptr *treeorder(void);
+void freetree(void);
 
 /* util.c */
 void pickvec(vector x, bool cf);
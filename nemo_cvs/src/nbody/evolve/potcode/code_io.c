@@ -7,6 +7,7 @@
  *              as was done in hackcode1 ages ago                       PJT
  *   10-apr-01  gcc warnings
  *   29-sep-05  gcc4 fix for prototypes
+ *   19-oct-26  snapshots written in the background (put_async_set)
  */
 
 #include "defs.h"
@@ -90,7 +91,7 @@ initoutput()
 stopoutput()
 {
     if (outstr != NULL)
-        strclose(outstr);
+        strclose(outstr);			/* waits for last output */
 }
 
 /*
@@ -147,7 +148,8 @@ output()
     }
     if (bits != 0 && outstr != NULL) {
 	btab = &bodytab[0];
-	put_snap(outstr, &btab, &nbody, &tnow, &bits);
+	put_snap(put_async_set(outstr), &btab, &nbody, &tnow, &bits);
+	put_async_tes(outstr);			/* written while we go on */
 	if (bits & PhaseSpaceBit)
 	    printf("\n\tparticle data written\n");
     }
@@ -19,6 +19,7 @@
  *      6-jul-03     b  computed the guiding center             PJT/RPO
  *     29-sep-05     c  variuos gcc4 fixes in other routines    PJT
  *     12-aug-09 V5.1  modified Euler and Leapfrog implemented  PJT
+ *     19-oct-26 V5.2  snapshots written in the background
  *
  * To improve:  use allocate() for number of particles; not static
  */
@@ -45,7 +46,7 @@ string defv[] = {
     "sigma=0\n            diffusion angle (degrees) per timestep",
     "seed=0\n		  random seed",
     "headline=PotCode\n   random mumble for humans",
-    "VERSION=5.1a\n       5-sep-09 PJT",
+    "VERSION=5.2\n       19-oct-26",
     NULL,
 };
 
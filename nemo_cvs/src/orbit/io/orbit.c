@@ -1,4 +1,5 @@
-/* orbit.c - write_orbit, read_orbit, allocate_orbit, copy_orbit, list_orbit */
+/* orbit.c - write_orbit, read_orbit, allocate_orbit, copy_orbit, list_orbit,
+ *           write_orbit_head, write_orbit_chunk, read_orbit_window */
 
 /*------------------------------------------------------------------------------
  * ORBIT      proposed format for orbit paths
@@ -21,6 +22,9 @@
  *  19-apr-96       c initialize strings to "" instead of NULL  pjt
  *   1-mar-03   V3.3  added stuff for iom_err			pjt
  *  25-jul-13   V4.0  added support for key                     pjt
+ *  19-oct-26   V4.1  streamed orbits: write_orbit_head/chunk,
+ *                    read_orbit_window; optional EnergyPath
+ *  19-oct-26   V4.1a reallocate when ndim changes, EnergyPath of MAXsteps
  *------------------------------------------------------------------------------
  */
 
@@ -29,15 +33,20 @@
 
 #define ISSTRING(s) ( (s)!=NULL && *(s)!=0 )
 
-/*------------------------------------------------------------------------------
- *  WRITE_ORBIT: writes out one orbit
- *------------------------------------------------------------------------------
+local int read_orbit_sub(stream, orbitptr *, bool, real, real);
+
+/*
+ * A streamed orbit is written while it is being integrated: an Orbit set
+ * with the Parameters (Nsteps 0) and Potential, but no Path, followed by
+ * top level OrbitChunk sets, each with the Nsteps, TimePath, PhasePath
+ * (and EnergyPath) of the next part of the orbit, until the next Orbit.
+ * Chunks are flushed as they are written, and indexed under their last
+ * time (strindex.c) if $NEMOINDEX is set, so read_orbit_window can go
+ * straight to the part of the orbit it needs.
  */
 
-void write_orbit (stream outstr, orbitptr optr)
+local void put_orbit_head(stream outstr, orbitptr optr, int nsteps)
 {
-    /* No history written here, user should do this on his own */
-    put_set (outstr,OrbitTag);
         put_set (outstr,ParametersTag);
             put_data (outstr,NdimTag,    IntType, &(Ndim(optr)),   0);
             put_data (outstr,MassTag,    RealType,&(Masso(optr)),   0);
@@ -45,7 +54,7 @@ void write_orbit (stream outstr, orbitptr optr)
             put_data (outstr,IOMTag,     RealType,  IOM(optr), Ndim(optr), 0);
             put_data (outstr,IOMERRTag,  RealType,  IOMERR(optr), Ndim(optr), 0);
 	    /* note we don't write MAXsteps(optr) to disk */
-            put_data (outstr,NstepsTag,  IntType, &(Nsteps(optr)), 0);
+            put_data (outstr,NstepsTag,  IntType, &nsteps, 0);
         put_tes (outstr,ParametersTag);
 
         put_set (outstr,PotentialTag);
@@ -53,25 +62,184 @@ void write_orbit (stream outstr, orbitptr optr)
             if (ISSTRING(PotPars(optr))) put_string (outstr, PotParsTag, PotPars(optr));
             if (ISSTRING(PotFile(optr))) put_string (outstr, PotFileTag, PotFile(optr));
         put_tes (outstr,PotentialTag);
+}
 
-        put_set (outstr,PathTag);
+local void put_orbit_path(stream outstr, orbitptr optr)
+{
             put_data (outstr,TimePathTag, RealType, 
                                 TimePath(optr), Nsteps(optr), 0);
             put_data (outstr,PhasePathTag,RealType, 
                                 PhasePath(optr), Nsteps(optr), 2, Ndim(optr), 0);
+            if (EnergyPath(optr))
+                put_data (outstr,EnergyPathTag,RealType,
+                                EnergyPath(optr), Nsteps(optr), 0);
+}
+
+/*------------------------------------------------------------------------------
+ *  WRITE_ORBIT: writes out one orbit
+ *------------------------------------------------------------------------------
+ */
+
+void write_orbit (stream outstr, orbitptr optr)
+{
+    /* No history written here, user should do this on his own */
+    put_set (outstr,OrbitTag);
+        put_orbit_head (outstr, optr, Nsteps(optr));
+        put_set (outstr,PathTag);
+            put_orbit_path (outstr, optr);
         put_tes (outstr,PathTag);
     put_tes (outstr,OrbitTag);
 }
+
+/*------------------------------------------------------------------------------
+ *  WRITE_ORBIT_HEAD: start a streamed orbit, whose steps are written by
+ *                    write_orbit_chunk
+ *------------------------------------------------------------------------------
+ */
+
+void write_orbit_head (stream outstr, orbitptr optr)
+{
+    put_set (outstr,OrbitTag);
+        put_orbit_head (outstr, optr, 0);
+    put_tes (outstr,OrbitTag);
+    fflush(outstr);
+}
+
+/*------------------------------------------------------------------------------
+ *  WRITE_ORBIT_CHUNK: append the Nsteps(optr) steps in optr to the streamed
+ *                     orbit last started by write_orbit_head
+ *------------------------------------------------------------------------------
+ */
+
+void write_orbit_chunk (stream outstr, orbitptr optr)
+{
+    if (Nsteps(optr) < 1) return;
+    put_index_set (outstr, OrbitChunkTag, Torb(optr,Nsteps(optr)-1));
+    put_set (outstr,OrbitChunkTag);
+        put_data (outstr,NstepsTag, IntType, &(Nsteps(optr)), 0);
+        put_orbit_path (outstr, optr);
+    put_tes (outstr,OrbitChunkTag);
+    put_index_tes (outstr);
+    fflush(outstr);
+    dprintf(2,"write_orbit_chunk: %d steps to t=%g\n",
+            Nsteps(optr), Torb(optr,Nsteps(optr)-1));
+}
+
+/* make room for nsteps in an orbit, keeping the steps it has */
+
+local void grow_orbit(orbitptr optr, int nsteps, bool energy)
+{
+    int n = MAXsteps(optr);
+
+    if (nsteps > n) {
+        n = MAX(nsteps, 2*n);
+        TimePath(optr) = (real *) reallocate(TimePath(optr), n*sizeof(real));
+        PhasePath(optr) = (real *) reallocate(PhasePath(optr),
+                                              n*Ndim(optr)*2*sizeof(real));
+        if (EnergyPath(optr))
+            EnergyPath(optr) = (real *) reallocate(EnergyPath(optr), n*sizeof(real));
+        MAXsteps(optr) = n;
+        Size(optr) = Ndim(optr)*n;
+        dprintf(1,"Reallocated orbit with %d steps\n",n);
+    }
+    if (energy && EnergyPath(optr)==NULL)
+        EnergyPath(optr) = (real *) allocate(MAXsteps(optr)*sizeof(real));
+}
+
+/* keep only the steps from i0 on that are within tmin..tmax */
+
+local void trim_orbit(orbitptr optr, int i0, real tmin, real tmax)
+{
+    int i, j, k, nphase = 2*Ndim(optr);
+
+    for (i=j=i0; i<Nsteps(optr); i++) {
+        if (Torb(optr,i) < tmin || Torb(optr,i) > tmax) continue;
+        if (i != j) {
+            Torb(optr,j) = Torb(optr,i);
+            for (k=0; k<nphase; k++)
+                PhasePath(optr)[j*nphase+k] = PhasePath(optr)[i*nphase+k];
+            if (EnergyPath(optr)) Eorb(optr,j) = Eorb(optr,i);
+        }
+        j++;
+    }
+    Nsteps(optr) = j;
+}
+
+/*
+ * read the OrbitChunk sets of a streamed orbit, the ones with steps in
+ * tmin..tmax if window. Once a chunk lies beyond tmax (or, for an orbit
+ * going back in time, before tmin) the rest are skipped without reading.
+ */
+
+local void read_chunks(stream instr, orbitptr optr, bool window,
+                       real tmin, real tmax)
+{
+    char times[64];
+    int i, k, n;
+    real tlo, thi;
+    bool past = FALSE, skip;
+
+    Nsteps(optr) = 0;
+    if (window)
+        sprintf(times, "%.17g:1e300", (double) tmin);
+    for (;;) {
+        if (window && !past)                  /* index: skip to tmin */
+            (void) get_index(instr, OrbitChunkTag, times, 0.0);
+        if (!get_tag_ok(instr,OrbitChunkTag))
+            break;
+        get_set (instr,OrbitChunkTag);
+        if (past) {
+            get_tes (instr,OrbitChunkTag);
+            continue;
+        }
+        get_data (instr,NstepsTag, IntType, &n, 0);
+        grow_orbit(optr, Nsteps(optr)+n, get_tag_ok(instr,EnergyPathTag));
+        i = Nsteps(optr);
+        get_data (instr,TimePathTag, RealType, &Torb(optr,i), n, 0);
+        skip = FALSE;
+        if (window && n > 0) {
+            tlo = MIN(Torb(optr,i), Torb(optr,i+n-1));
+            thi = MAX(Torb(optr,i), Torb(optr,i+n-1));
+            skip = thi < tmin || tlo > tmax;
+            if (Torb(optr,i) <= Torb(optr,i+n-1) ? tlo > tmax : thi < tmin)
+                past = TRUE;
+        }
+        if (!skip) {
+            get_data (instr,PhasePathTag, RealType, &Posorb(optr,i,0),
+                      n, 2, Ndim(optr), 0);
+            if (get_tag_ok(instr,EnergyPathTag))
+                get_data (instr,EnergyPathTag, RealType, &Eorb(optr,i), n, 0);
+            else if (EnergyPath(optr))
+                for (k=0; k<n; k++) Eorb(optr,i+k) = 0.0;
+            Nsteps(optr) = i+n;
+            if (window) trim_orbit(optr, i, tmin, tmax);
+        }
+        get_tes (instr,OrbitChunkTag);
+    }
+    dprintf(1,"read_orbit: %d steps from chunks\n",Nsteps(optr));
+}
 
 /*------------------------------------------------------------------------------
  * READ_ORBIT: try and read another orbit
  *            returns 0 if not, or an error occurred,  1 if OK
+ * READ_ORBIT_WINDOW: same, but only the steps with tmin <= time <= tmax
  *------------------------------------------------------------------------------
  */
  
 int read_orbit (stream instr, orbitptr *optr)
 {
-    int  maxsize, ndim, nsteps;
+    return read_orbit_sub(instr, optr, FALSE, 0.0, 0.0);
+}
+
+int read_orbit_window (stream instr, orbitptr *optr, real tmin, real tmax)
+{
+    return read_orbit_sub(instr, optr, TRUE, tmin, tmax);
+}
+
+local int read_orbit_sub (stream instr, orbitptr *optr, bool window,
+                          real tmin, real tmax)
+{
+    int  ndim, nsteps;
     orbitptr otmp;
 
     get_history(instr);     /* always scan for history; allow sandwiched */
@@ -79,16 +247,12 @@ int read_orbit (stream instr, orbitptr *optr)
     if (!get_tag_ok (instr,OrbitTag))
         return 0;                      /* not another orbit available */
         
-    if (*optr!=NULL)
-        maxsize = Size(*optr);
-    else
-        maxsize = 0;
-        
     get_set (instr,OrbitTag);
         get_set (instr,ParametersTag);
             get_data (instr,NdimTag,    IntType, &ndim,   0);
             get_data (instr,NstepsTag,  IntType, &nsteps, 0);
-            if (ndim*nsteps > maxsize) {	      /* allocate more space */
+            if (*optr==NULL || ndim != Ndim(*optr) ||   /* IOM sized by ndim   */
+                nsteps > MAXsteps(*optr)) {             /* allocate more space */
                 if (*optr) free_orbit(*optr);         /* free the old one    */
                 allocate_orbit(&otmp,ndim,nsteps);
                 *optr = otmp;
@@ -130,13 +294,28 @@ int read_orbit (stream instr, orbitptr *optr)
             get_tes(instr,PotentialTag);
 	} 
 
+	if (!get_tag_ok(instr,PathTag)) {	/* streamed orbit: chunks */
+            get_tes (instr,OrbitTag);
+            read_chunks(instr, *optr, window, tmin, tmax);
+            return 1;
+        }
         get_set (instr,PathTag);
             get_data (instr,TimePathTag,    RealType, 
                       TimePath(*optr), Nsteps(*optr), 0);
             get_data (instr,PhasePathTag,RealType, 
                       PhasePath(*optr), Nsteps(*optr), 2, Ndim(*optr), 0);
+            if (get_tag_ok(instr,EnergyPathTag)) {
+                EnergyPath(*optr) = (real *) reallocate(EnergyPath(*optr),
+                                                 MAXsteps(*optr)*sizeof(real));
+                get_data (instr,EnergyPathTag, RealType,
+                          EnergyPath(*optr), Nsteps(*optr), 0);
+            } else if (EnergyPath(*optr)) {
+                free(EnergyPath(*optr));
+                EnergyPath(*optr) = NULL;
+            }
         get_tes (instr,PathTag);
     get_tes (instr,OrbitTag);
+    if (window) trim_orbit(*optr, 0, tmin, tmax);
     return 1;
 }
 
@@ -144,6 +323,7 @@ void free_orbit(orbitptr optr)
 {
     free( (char *) TimePath(optr) );
     free( (char *) PhasePath(optr) );
+    if (EnergyPath(optr)) free( (char *) EnergyPath(optr) );
     free( (char *) IOM(optr) );
     free( (char *) optr );
 }
@@ -207,6 +387,9 @@ void copy_orbit(orbitptr iptr, orbitptr optr)
             Vorb(optr,i) = Vorb(iptr,i);
             Worb(optr,i) = Worb(iptr,i);
         }
+        if (EnergyPath(iptr) && EnergyPath(optr))
+            for (i=0; i<nsteps; i++)
+                Eorb(optr,i) = Eorb(iptr,i);
 }
 
 /*------------------------------------------------------------------------------
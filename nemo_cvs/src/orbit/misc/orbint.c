@@ -33,6 +33,7 @@
  *      10-feb-04       V4.0 variable timestepping              PJT
  *      14-jul-09       V4.1 Bastille Day @ PiTP - added some extra integration modes PJT
  *                           after Tremaines nice lecture
+ *      19-oct-26       V4.2 chunk= to stream the orbit out as it is integrated
  *
  */
 
@@ -54,7 +55,8 @@ string defv[] = {
     "mode=rk4\n           integration method (euler,leapfrog,rk2,rk4)",
     "eta=\n               if used, stop if abs(de/e) > eta",
     "variable=f\n         Use variable timesteps (needs eta=)",
-    "VERSION=4.1c\n       14-aug-09 PJT",
+    "chunk=0\n            if > 0, write the orbit in chunks of this many steps",
+    "VERSION=4.2\n        19-oct-2026",
     NULL,
 };
 
@@ -80,6 +82,9 @@ real   tdum=0.0;                        /* time used in potential() */
 real   eta = -1.0;                      /* stop criterion parameter */
 bool   Qstop = FALSE;                   /* global flag to stop intgr. */
 bool   Qvar;
+int    nchunk;                          /* steps per chunk, 0=all at end */
+int    nsaved = 1;                      /* steps stored in o_out */
+bool   Qhead = FALSE;                   /* streamed orbit started */
 
 
 
@@ -88,7 +93,7 @@ extern int match(string, string, int *);
 
 proc pot;				/* pointer to the potential */
 real print_diag();                      /* returns total energy/hamiltonian */
-void setparams(), prepare();
+void setparams(), prepare(), save_step(), flush_chunk();
 void integrate_euler1(), integrate_euler2(), 
      integrate_leapfrog1(), integrate_leapfrog2(),
      integrate_rk2(), integrate_rk4();
@@ -112,7 +117,11 @@ void nemo_main ()
     if (hasvalue("potpars")) PotPars(o_in) = getparam("potpars");
     if (hasvalue("potfile")) PotFile(o_in) = getparam("potfile");
 
-    if (allocate_orbit (&o_out,Ndim(o_in),nsteps/nsave+1)==0)
+    if (nchunk > 0) {                   /* streamed: only one chunk */
+        if (allocate_orbit (&o_out,Ndim(o_in),MIN(nchunk,nsteps/nsave+1))==0)
+		error ("Error allocating output orbit");
+        EnergyPath(o_out) = (real *) allocate(MAXsteps(o_out)*sizeof(real));
+    } else if (allocate_orbit (&o_out,Ndim(o_in),nsteps/nsave+1)==0)
 		error ("Error allocating output orbit");
     pot=get_potential(PotName(o_in), PotPars(o_in), PotFile(o_in));
     if (pot==NULL) 
@@ -128,6 +137,7 @@ void nemo_main ()
 
 
     outstr = stropen (outfile,"w");
+    if (nchunk > 0) put_history(outstr);
     prepare();
     match(getparam("mode"),"euler leapfrog test rk2 rk4 me end",&imode);
     if (imode==0x01)
@@ -145,8 +155,12 @@ void nemo_main ()
     else
         error("imode=0x%x; Illegal integration mode=",imode);
 
-    put_history(outstr);
-    write_orbit (outstr,o_out); 		/* write output file */
+    if (nchunk > 0)
+        flush_chunk(nsaved);                    /* last chunk */
+    else {
+        put_history(outstr);
+        write_orbit (outstr,o_out); 		/* write output file */
+    }
     strclose(outstr);
 }
 
@@ -161,6 +175,7 @@ void setparams()
     ndiag=getiparam("ndiag");
     nsave=getiparam("nsave");
     Qvar = getbparam("variable");
+    nchunk = getiparam("chunk");
     if (hasvalue("eta")) 
       eta = getdparam("eta");
     else if (Qvar)
@@ -172,6 +187,58 @@ void prepare()
 {
     Masso(o_out) = Masso(o_in);
 }
+
+/*
+ *  SAVE_STEP: store the next step in the output orbit; with chunk= the
+ *             steps stored so far are written out when it is full
+ */
+
+void save_step(int *isave, double time, double *pos, double *vel)
+{
+    int i = ++(*isave);
+
+    dprintf(2,"writing isave=%d\n",i);
+    if (i >= MAXsteps(o_out)) {
+        if (nchunk == 0) error("Storage error isave=%d",i);
+        flush_chunk(i);
+        *isave = i = 0;
+    }
+    Torb(o_out,i) = time;
+    Xorb(o_out,i) = pos[0];
+    Yorb(o_out,i) = pos[1];
+    Zorb(o_out,i) = pos[2];
+    Uorb(o_out,i) = vel[0];
+    Vorb(o_out,i) = vel[1];
+    Worb(o_out,i) = vel[2];
+    nsaved = i+1;
+}
+
+/*
+ *  FLUSH_CHUNK: write the first n steps of the output orbit as a chunk,
+ *               with their energy (in the rotating frame)
+ */
+
+void flush_chunk(int n)
+{
+    int i, ndim = Ndim(o_out);
+    double time, epot, pos[3], acc[3];
+
+    for (i=0; i<n; i++) {
+        time = Torb(o_out,i);
+        pos[0] = Xorb(o_out,i);
+        pos[1] = Yorb(o_out,i);
+        pos[2] = Zorb(o_out,i);
+        (*pot)(&ndim,pos,acc,&epot,&time);
+        Eorb(o_out,i) = 0.5*(sqr(Uorb(o_out,i))+sqr(Vorb(o_out,i))+sqr(Worb(o_out,i)))
+                        + epot - 0.5*omega2*(sqr(pos[0])+sqr(pos[1])+sqr(pos[2]));
+    }
+    Nsteps(o_out) = n;
+    if (!Qhead) {
+        write_orbit_head(outstr,o_out);
+        Qhead = TRUE;
+    }
+    write_orbit_chunk(outstr,o_out);
+}
 
 /* Standard Euler integration */
 void integrate_euler1()
@@ -220,16 +287,7 @@ void integrate_euler1()
 
 	if (++ksave == nsave) {		/* see if need to store particle */
 	    ksave=0;
-	    isave++;
-	    dprintf(2,"writing isave=%d for i=%d\n",isave,i);
-            if (isave>=Nsteps(o_out)) error("Storage error EULER");
-	    Torb(o_out,isave) = time;
-	    Xorb(o_out,isave) = pos[0];
-	    Yorb(o_out,isave) = pos[1];
-	    Zorb(o_out,isave) = pos[2];
-	    Uorb(o_out,isave) = vel[0];
-	    Vorb(o_out,isave) = vel[1];
-	    Worb(o_out,isave) = vel[2];
+	    save_step(&isave,time,pos,vel);
 	}
     } /* for(;;) */
     if (ndiag)
@@ -290,16 +348,7 @@ void integrate_euler2()
 
 	if (++ksave == nsave) {		/* see if need to store particle */
 	    ksave=0;
-	    isave++;
-	    dprintf(2,"writing isave=%d for i=%d\n",isave,i);
-            if (isave>=Nsteps(o_out)) error("Storage error modified EULER");
-	    Torb(o_out,isave) = time;
-	    Xorb(o_out,isave) = pos[0];
-	    Yorb(o_out,isave) = pos[1];
-	    Zorb(o_out,isave) = pos[2];
-	    Uorb(o_out,isave) = vel[0];
-	    Vorb(o_out,isave) = vel[1];
-	    Worb(o_out,isave) = vel[2];
+	    save_step(&isave,time,pos,vel);
 	}
 	if (i>=nsteps) break;           /* see if need to quit looping */
 
@@ -375,15 +424,7 @@ void integrate_leapfrog1_implicit_test()
 		}
 		if (++ksave == nsave) {
 		    ksave=0;
-		    isave++;
-		    dprintf(2,"writing isave=%d for i=%d\n",isave,i);
-		    Torb(o_out,isave) = time;
-		    Xorb(o_out,isave) = pos[0];
-		    Yorb(o_out,isave) = pos[1];
-		    Zorb(o_out,isave) = pos[2];
-		    Uorb(o_out,isave) = vel[0];
-		    Vorb(o_out,isave) = vel[1];
-		    Worb(o_out,isave) = vel[2];
+		    save_step(&isave,time,pos,vel);
 		}
                 /* put back out of sync */
 #if 0
@@ -444,15 +485,7 @@ void integrate_leapfrog1()
 		}
 		if (++ksave == nsave) {
 		    ksave=0;
-		    isave++;
-		    dprintf(2,"writing isave=%d for i=%d\n",isave,i);
-		    Torb(o_out,isave) = time;
-		    Xorb(o_out,isave) = pos[0];
-		    Yorb(o_out,isave) = pos[1];
-		    Zorb(o_out,isave) = pos[2];
-		    Uorb(o_out,isave) = vel[0];
-		    Vorb(o_out,isave) = vel[1];
-		    Worb(o_out,isave) = vel[2];
+		    save_step(&isave,time,pos,vel);
 		}
                 /* put back out of sync */
         	vel[0] += dt2*(acc[0]+omega2*pos[0]+tomega*vel[1]);
@@ -528,15 +561,7 @@ void integrate_leapfrog2()
 
 		if (++ksave == nsave) {
 			ksave=0;
-			isave++;
-			dprintf(2,"writing isave=%d for i=%d\n",isave,i);
-			Torb(o_out,isave) = time;
-			Xorb(o_out,isave) = pos[0];
-			Yorb(o_out,isave) = pos[1];
-			Zorb(o_out,isave) = pos[2];
-			Uorb(o_out,isave) = vel[0];
-			Vorb(o_out,isave) = vel[1];
-			Worb(o_out,isave) = vel[2];
+			save_step(&isave,time,pos,vel);
 		}
 	}
     if (ndiag)
@@ -595,16 +620,7 @@ void integrate_rk2()
 
 	if (++ksave == nsave) {		/* see if need to store particle */
 	    ksave=0;
-	    isave++;
-	    dprintf(2,"writing isave=%d for i=%d\n",isave,i);
-            if (isave>=Nsteps(o_out)) error("Storage error EULER");
-	    Torb(o_out,isave) = time;
-	    Xorb(o_out,isave) = pos[0];
-	    Yorb(o_out,isave) = pos[1];
-	    Zorb(o_out,isave) = pos[2];
-	    Uorb(o_out,isave) = vel[0];
-	    Vorb(o_out,isave) = vel[1];
-	    Worb(o_out,isave) = vel[2];
+	    save_step(&isave,time,pos,vel);
 	}
     } /* for(;;) */
     if (ndiag)
@@ -664,16 +680,7 @@ void integrate_rk4()
 
 	if (++ksave == nsave) {		/* see if need to store particle */
 	    ksave=0;
-	    isave++;
-	    dprintf(2,"writing isave=%d for i=%d\n",isave,i);
-            if (isave>=Nsteps(o_out)) error("Storage error EULER");
-	    Torb(o_out,isave) = time;
-	    Xorb(o_out,isave) = pos[0];
-	    Yorb(o_out,isave) = pos[1];
-	    Zorb(o_out,isave) = pos[2];
-	    Uorb(o_out,isave) = vel[0];
-	    Vorb(o_out,isave) = vel[1];
-	    Worb(o_out,isave) = vel[2];
+	    save_step(&isave,time,pos,vel);
 	}
     } /* for(;;) */
     if (ndiag)
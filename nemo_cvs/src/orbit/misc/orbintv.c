@@ -3,6 +3,7 @@
  *           for the harder problems
  *
  *      15-may-2011    Cloned off orbint               Peter Teuben
+ *      19-oct-2026    V1.2 chunk= to stream the orbit out as it is integrated
  *
  * @todo
  *    (18-sep-2013) possibly a 64bit issue, now coredumps
@@ -29,7 +30,8 @@ string defv[] = {
   "potfile=\n		extra data-file for potential ",
   "mode=dopri5\n        integration method (dopri5 dop853)",
   "tol=-7\n             tolerance of integration",
-  "VERSION=1.1\n        16-may-11 PJT",
+  "chunk=0\n            if > 0, write the orbit in chunks of this many steps",
+  "VERSION=1.2\n        19-oct-2026",
   NULL,
 };
 
@@ -54,6 +56,9 @@ real   tstop;                           /* stop time */
 real   omega, omega2, tomega;  		/* pattern speed */
 real   tdum=0.0;                        /* time used in potential() */
 real   eta ;                            /* tolerance */
+int    nchunk;                          /* steps per chunk, 0=all at end */
+int    nsaved = 0;                      /* steps stored in o_out */
+bool   Qhead = FALSE;                   /* streamed orbit started */
 
 
 
@@ -65,7 +70,9 @@ proc pot;				/* pointer to the potential */
 void integrate_dopri5(void),
      integrate_dop853(void),
      setparams(void), 
-     prepare(void);
+     prepare(void),
+     save_step(double time, double *posvel, real etot),
+     flush_chunk(void);
 real print_diag(double time, double *posvel);
 
 
@@ -87,8 +94,10 @@ void nemo_main ()
     if (hasvalue("potpars")) PotPars(o_in) = getparam("potpars");
     if (hasvalue("potfile")) PotFile(o_in) = getparam("potfile");
 
-    if (allocate_orbit (&o_out,Ndim(o_in),nsteps)==0)
+    if (allocate_orbit (&o_out,Ndim(o_in),nchunk>0 ? MIN(nchunk,nsteps) : nsteps)==0)
 		error ("Error allocating output orbit");
+    if (nchunk > 0)                     /* streamed: only one chunk */
+        EnergyPath(o_out) = (real *) allocate(MAXsteps(o_out)*sizeof(real));
     pot=get_potential(PotName(o_in), PotPars(o_in), PotFile(o_in));
     if (pot==NULL) 
 		error("Potential %s could not be loaded",PotName(o_in));
@@ -103,6 +112,7 @@ void nemo_main ()
 
 
     outstr = stropen (outfile,"w");
+    if (nchunk > 0) put_history(outstr);
     prepare();
     match(getparam("mode"),"dopri5 dop853 end",&imode);
     if (imode==0x01)
@@ -112,8 +122,12 @@ void nemo_main ()
     else
         error("imode=0x%x; Illegal integration mode=",imode);
 
-    put_history(outstr);
-    write_orbit (outstr,o_out); 		/* write output file */
+    if (nchunk > 0) {
+        if (nsaved > 0) flush_chunk();          /* last chunk */
+    } else {
+        put_history(outstr);
+        write_orbit (outstr,o_out); 		/* write output file */
+    }
     strclose(outstr);
 }
 
@@ -130,6 +144,7 @@ void setparams(void)
     dprintf(0,"nsteps = %d\n",nsteps);
 
     ndiag=getiparam("ndiag");
+    nchunk=getiparam("chunk");
     eta = getdparam("tol");
     if (eta < 0) 
       eta = pow(10.0,eta);
@@ -139,6 +154,41 @@ void prepare(void)
 {
     Masso(o_out) = Masso(o_in);
 }
+
+/*
+ *  SAVE_STEP: store the next step in the output orbit; with chunk= the
+ *             steps stored so far are written out when it is full
+ */
+
+void save_step(double time, double *posvel, real etot)
+{
+    int i;
+
+    if (nsaved == MAXsteps(o_out)) {
+        if (nchunk == 0) error("Storage error at time=%g",time);
+        flush_chunk();
+    }
+    i = nsaved++;
+    Torb(o_out,i) = time;
+    Xorb(o_out,i) = posvel[0]; Yorb(o_out,i) = posvel[1]; Zorb(o_out,i) = posvel[2];
+    Uorb(o_out,i) = posvel[3]; Vorb(o_out,i) = posvel[4]; Worb(o_out,i) = posvel[5];
+    if (EnergyPath(o_out)) Eorb(o_out,i) = etot;
+}
+
+/*
+ *  FLUSH_CHUNK: write the steps stored as a chunk of the output orbit
+ */
+
+void flush_chunk(void)
+{
+    Nsteps(o_out) = nsaved;
+    if (!Qhead) {
+        write_orbit_head(outstr,o_out);
+        Qhead = TRUE;
+    }
+    write_orbit_chunk(outstr,o_out);
+    nsaved = 0;
+}
 
 /* helper functions for the integrator */
 
@@ -175,27 +225,18 @@ void rhs(unsigned n, double x, double *y, double *f)
 void solout5(long nr, double xold, double x, double *y, unsigned n, int *irtrn)
 {
   static double xout;
-  static int isave;
   double pv[6];
+  int k;
 
   if (nr==1) {
     xout = x + dtout;
-    isave = 0;
-    Torb(o_out,isave) = x;
-    Xorb(o_out,isave) = y[0]; Yorb(o_out,isave) = y[1]; Zorb(o_out,isave) = y[2];
-    Uorb(o_out,isave) = y[3]; Vorb(o_out,isave) = y[4]; Worb(o_out,isave) = y[5];
-    (void) print_diag(x, y);
+    nsaved = 0;
+    save_step(x, y, print_diag(x, y));
   } else  {
     while (x >= xout) {
-      isave += 1;
-      Torb(o_out,isave) = xout;
-      pv[0] = Xorb(o_out,isave) = contd5(0,xout);
-      pv[1] = Yorb(o_out,isave) = contd5(1,xout);
-      pv[2] = Zorb(o_out,isave) = contd5(2,xout);
-      pv[3] = Uorb(o_out,isave) = contd5(3,xout);
-      pv[4] = Vorb(o_out,isave) = contd5(4,xout);
-      pv[5] = Worb(o_out,isave) = contd5(5,xout);
-      (void) print_diag(xout, pv);
+      for (k=0; k<6; k++)
+        pv[k] = contd5(k,xout);
+      save_step(xout, pv, print_diag(xout, pv));
       xout += dtout;
     }
   }
@@ -232,27 +273,18 @@ void integrate_dopri5(void)
 void solout8(long nr, double xold, double x, double *y, unsigned n, int *irtrn)
 {
   static double xout;
-  static int isave;
   double pv[6];
+  int k;
 
   if (nr==1) {
     xout = x + dtout;
-    isave = 0;
-    Torb(o_out,isave) = x;
-    Xorb(o_out,isave) = y[0]; Yorb(o_out,isave) = y[1];  Zorb(o_out,isave) = y[2];
-    Uorb(o_out,isave) = y[3]; Vorb(o_out,isave) = y[4];  Worb(o_out,isave) = y[5];
-    (void) print_diag(x, y);
+    nsaved = 0;
+    save_step(x, y, print_diag(x, y));
   } else  {
     while (x >= xout) {
-      isave += 1;
-      Torb(o_out,isave) = xout;
-      pv[0] = Xorb(o_out,isave) = contd8(0,xout);
-      pv[1] = Yorb(o_out,isave) = contd8(1,xout);
-      pv[2] = Zorb(o_out,isave) = contd8(2,xout);
-      pv[3] = Uorb(o_out,isave) = contd8(3,xout);
-      pv[4] = Vorb(o_out,isave) = contd8(4,xout);
-      pv[5] = Worb(o_out,isave) = contd8(5,xout);
-      (void) print_diag(xout, pv);
+      for (k=0; k<6; k++)
+        pv[k] = contd8(k,xout);
+      save_step(xout, pv, print_diag(xout, pv));
       xout += dtout;
     }
   }
@@ -7,6 +7,7 @@
  *	22-may-90  V2.2  minor improvement for new getparam()	PJT
  *	24-jul-92  V2.3  new NEMO - etc. PJT
  *      15-feb-03  V2.4  added format=				PJT
+ *      19-oct-26  V2.5  added times=, reads only that part of an orbit
  */
 
 #include <stdinc.h>		/* also gets <stdio.h	*/
@@ -21,7 +22,8 @@ string defv[] = {
 	"n=1\n              stride in time through the orbit",
         "maxsteps=10000\n   Maximum number of steps allowed",
 	"format=%g\n        Format for output",
-	"VERSION=2.4\n      15-feb-03 PJT",
+	"times=all\n        Time range tmin:tmax to list",
+	"VERSION=2.5\n      19-oct-2026",
 	NULL,
 };
 
@@ -45,10 +47,14 @@ nemo_main ()
 {
 	int ndim;
 	string format = getparam("format");
+	string times = getparam("times");
+	bool Qall = streq(times,"all");
 
 	infile = getparam("in");
 	n = getiparam("n");
         maxsteps = getiparam("maxsteps");
+	if (!Qall && sscanf(times,"%lf:%lf",&trange[0],&trange[1]) != 2)
+	    error("times=%s must be tmin:tmax",times);
 
 	instr = stropen (infile,"r");
 
@@ -57,7 +63,8 @@ nemo_main ()
         allocate_orbit(&optr,ndim,maxsteps);
 #endif
 
-	while (read_orbit(instr,&optr)) {
+	while (Qall ? read_orbit(instr,&optr) :
+	              read_orbit_window(instr,&optr,trange[0],trange[1])) {
 	    list_orbit(optr, -HUGE,  HUGE, n, format);
             Nsteps(optr) = maxsteps;        /* reset */
         }
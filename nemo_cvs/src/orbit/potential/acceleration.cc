@@ -40,6 +40,7 @@
 // version 3.3  17/02/2010  WD  allow for nemo string bug
 // version 3.4  23/08/2010  WD  empty accnames: return 0 (rather than trigger
 //                              Segmentation fault)
+// version 3.5  19/10/2026      reentrant_acceleration()
 //
 //------------------------------------------------------------------------------
 
@@ -390,6 +391,9 @@ namespace {
      bool*,                        // output: acceleration() needs masses?
      bool*);                       // output: acceleration() needs vel's?
 
+  // declare type of pointer to reentrantacceleration()
+  typedef bool(*reent_pter)();     // return: acceleration() reentrant?
+
   // declare type of pointer to inipotential()
   typedef void(*inipot_pter)       // return: void
     (int*,                         // input:  number of parameters
@@ -419,15 +423,30 @@ namespace {
   int       IniAcInd=0;
   char AcNames[IniAcMax][AcNamMax];
   iniacc_pter IniAc[IniAcMax] = {0};
+  bool        IniRe[IniAcMax] = {0};
+  //----------------------------------------------------------------------------
+  // table of accelerations known to be reentrant (see acceleration.h note 7)
+  const int ReMax=256;
+  int       ReInd=0;
+  acc_pter  Reentrant[ReMax];
+  inline acc_pter reentrant(acc_pter ac, bool re)
+  {
+    if(ac && re && ReInd < ReMax)
+      Reentrant[ReInd++] = ac;
+    return ac;
+  }
   //----------------------------------------------------------------------------
   // this routine used to be get_acceleration()
   // we now allow for several accelerations added, the names, parameters, and
   // files of which are seperated by ',', ';', and ';', respectively.
+  // *reent is set to whether the acceleration() returned is reentrant: only
+  // if the file defines reentrantacceleration() which returns true.
   acc_pter single_acceleration(const char*accname,
 			       const char*accpars,
 			       const char*accfile,
 			       bool      *need_mass,
-			       bool      *need_vels)
+			       bool      *need_vels,
+			       bool      *reent)
   {
     //
     // NOTE: the present implementation will NOT try to compile a source code
@@ -450,6 +469,7 @@ namespace {
     } else
       npar = 0;
   
+    *reent = false;
     // 2. load local symbols
     if(first) {
       mysymbols(getparam(const_cast<char*>("argv0")));
@@ -463,6 +483,7 @@ namespace {
 		     "use iniacc_pter known already\n",accname);
 	acc_pter ac;
 	(*IniAc[i])(pars,npar,accfile,&ac,need_mass,need_vels);
+	*reent = IniRe[i];
 	return ac;
       }
 
@@ -492,9 +513,12 @@ namespace {
     //    if found, remember it, call it and return acceleration() given by it
     iniacc_pter ia = (iniacc_pter) findfunc("iniacceleration");
     if(ia) {
+      reent_pter re = (reent_pter) findfunc("reentrantacceleration");
+      *reent = re && (*re)();
       if(IniAcInd < IniAcMax && strlen(accname) < AcNamMax) {
 	strcpy(AcNames[IniAcInd],accname);
 	IniAc[IniAcInd] = ia;
+	IniRe[IniAcInd] = *reent;
 	IniAcInd++;
       }
       acc_pter ac;
@@ -563,24 +587,27 @@ namespace {
 	     const char**accpars,
 	     const char**accfile,
 	     bool       *need_mass,
-	     bool       *need_vels)
+	     bool       *need_vels,
+	     bool       *reent)
     {
       if(nacc > NMAX)
 	error(const_cast<char*>("get_acceleration: more accnames than expected (%d)"),NMAX);
       N = nacc;
       if(need_mass) *need_mass = 0;
       if(need_vels) *need_vels = 0;
+      *reent = 1;
       for(int n=0; n!=N; ++n) {
 	if(accname[n]==0 || accname[n][0] == 0)
 	  error(const_cast<char*>("get_acceleration: accname #%d empty "
 				  "(parse error in \"accname=...\"?)"),n);
-	bool nm,nv;
+	bool nm,nv,re;
 	AC[n] = single_acceleration(accname[n],
 				    (accpars[n] && accpars[n][0])? accpars[n]:0,
 				    (accfile[n] && accfile[n][0])? accfile[n]:0,
-				    &nm,&nv);
+				    &nm,&nv,&re);
 	if(need_mass && nm) *need_mass = 1;
 	if(need_vels && nv) *need_vels = 1;
+	if(!re) *reent = 0;
       }
     }
     //--------------------------------------------------------------------------
@@ -710,10 +737,12 @@ acc_pter get_acceleration(const char*accnames,
   }
   if(nacc == 0) return 0;
   // 1. just one accname, then return single acceleration()
+  bool reent;
   if(nacc == 1) {
     freestrings(accname);
-    return single_acceleration(accnames, accparss, accfiles,
-			       need_mass, need_vels);
+    acc_pter ac = single_acceleration(accnames, accparss, accfiles,
+				      need_mass, need_vels, &reent);
+    return reentrant(ac,reent);
   }
   // 2. several accnames
   // 2.1 split accparss, allow for empty accparss -> all accpars=0
@@ -737,10 +766,17 @@ acc_pter get_acceleration(const char*accnames,
     error(const_cast<char*>("get_acceleration: called more than %d times with multiple accnames"),
 	  AcMax);
   // 2.4 initialize added acceleration and return function using it
-  (Added[AcInd]).set(nacc,accname,accpars,accfile,need_mass,need_vels);
+  (Added[AcInd]).set(nacc,accname,accpars,accfile,need_mass,need_vels,&reent);
   freestrings(accname);
   if(accparss) freestrings(accpars);
   if(accfiles) freestrings(accfile);
-  return AddedAcc[AcInd++];
+  return reentrant(AddedAcc[AcInd++],reent);
+}
+////////////////////////////////////////////////////////////////////////////////
+bool reentrant_acceleration(acc_pter ac)
+{
+  for(int i=0; i!=ReInd; ++i)
+    if(Reentrant[i] == ac) return true;
+  return false;
 }
 ////////////////////////////////////////////////////////////////////////////////
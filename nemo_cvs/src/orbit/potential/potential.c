@@ -38,6 +38,13 @@
  *      20-may-04         c add sqr() for dummy linker
  *      14-jul-05         d made dummy functions global, for new (FC4) linker 
  *      18-sep-08         e make 'r' == SINGLEPREC? 'f' : 'd'              WD
+ *      19-oct-26     V5.5  composite potentials: potname=a+b+c, with
+ *                          potpars/potfile per component separated by ';'
+ *                          and a batched array interface                 
+ *                    V5.6  look up potentials in a precompiled registry
+ *                          (mkpotreg) before searching POTPATH
+ *                    V5.6a a component used twice is an error
+ *                          and no overflow of a long $POTREG or $NEMOOBJ
  *       
  *------------------------------------------------------------------------------
  */
@@ -46,9 +53,14 @@
 #include  <getparam.h>
 #include  <loadobj.h>
 #include  <filefn.h>
+#include  <extstring.h>
+#include  <hash.h>
+#include  <unistd.h>
 #include  <potential.h>
 
 #define MAXPAR 64
+#define MAXCOMP 16              /* max components in a composite potential   */
+#define MAXDIM  3
 
 local double local_par[MAXPAR]; /* NOTE: first par reserved for pattern speed*/
 local int  local_npar=0;        /* actual used number of par's               */
@@ -58,11 +70,26 @@ local proc l_inipotential=NULL; /* actual storage of pointer to exter inits  */
 local bool Qfortran = FALSE;    /* was a fortran routine used ? -- a hack -- */
 local bool first = TRUE;        /* see if first time called for mysymbols()  */
 
+local int  ncomp = 0;                        /* components of last potential */
+local proc comp_pot[MAXCOMP];                /* their potential_double/float */
+local potarr_double comp_arr[MAXCOMP];       /* optional potential_double_array */
+local double *arr_acc = NULL, *arr_pot = NULL; /* scratch for batched sums   */
+local int  arr_max = 0;
+local potarr_double l_potarr=NULL;          /* batched worker of last load  */
+
+local struct Hash_Table *potreg = NULL;      /* name -> potreg_entry         */
+local bool potreg_tried = FALSE;
+
 void potential_dummy_for_c(void);
 
 /* forward declarations */
 
 local proc load_potential(string, string, string, char); /* load by name    */
+local proc load_composite(string, string, string, char); /* load a+b+..     */
+local potreg_entry *potreg_lookup(string);               /* registry        */
+local void composite_double(const int *, const double *, double *, double *, const double *);
+local void composite_float(const int *, const float *, float *, float *, const float *);
+local void composite_array(const int *, const int *, const double *, double *, double *, const double *);
 
 /*-----------------------------------------------------------------------------
  *  get_potential --  returns the pointer ptr to the function which carries out
@@ -73,7 +100,7 @@ potproc_real get_potential(string potname, string potpars, string potfile)
 {
     if (potname == NULL || *potname == 0)	/* if no name provided */
         return NULL;				/* return no potential */
-    l_potential = load_potential(potname, potpars, potfile,'r');
+    l_potential = load_composite(potname, potpars, potfile,'r');
     return l_potential;
 }
 
@@ -81,7 +108,7 @@ potproc_double get_potential_double(string potname, string potpars, string potfi
 {
     if (potname == NULL || *potname == 0)	/* if no name provided */
         return NULL;				/* return no potential */
-    l_potential = load_potential(potname, potpars, potfile,'d');
+    l_potential = load_composite(potname, potpars, potfile,'d');
     return (potproc_double) l_potential;
 }
 
@@ -89,10 +116,24 @@ potproc_float  get_potential_float(string potname, string potpars, string potfil
 {
     if (potname == NULL || *potname == 0)	/* if no name provided */
         return NULL;				/* return no potential */
-    l_potential = load_potential(potname, potpars, potfile,'f');
+    l_potential = load_composite(potname, potpars, potfile,'f');
     return (potproc_float) l_potential;
 }
 
+/*-----------------------------------------------------------------------------
+ *  get_potential_double_array --  as get_potential_double, but returns a
+ *          batched worker that evaluates npos positions (ndim-vectors stored
+ *          consecutively) in one call; components that export their own
+ *          potential_double_array are called once for the whole array.
+ *-----------------------------------------------------------------------------
+ */
+potarr_double get_potential_double_array(string potname, string potpars, string potfile)
+{
+    if (get_potential_double(potname, potpars, potfile) == NULL)
+        return NULL;
+    return composite_array;
+}
+
 /*-----------------------------------------------------------------------------
  *  get_inipotential --  returns the pointer ptr to the last inipotential
  *          function which initializes the potential
@@ -116,6 +157,194 @@ real get_pattern()
     return local_omega;
 }
 
+/*-----------------------------------------------------------------------------
+ *  load_composite -- load one or more potentials, names separated by '+'
+ *       Parameters and data files of the components are separated by ';',
+ *       e.g.  potname=miyamoto+plummer+caustics potpars=0,0,1,1;0,1,1;0
+ *       A single name is passed straight to load_potential. A name cannot
+ *       be used twice: a .so has only one inipotential() and one set of
+ *       parameters, so both components would be the last one.
+ *	BUG: only the last composite is remembered (like l_potential)
+ *-----------------------------------------------------------------------------
+ */
+local proc load_composite(string fname, string parameters, string dataname, char type)
+{
+    string *names, *pars = NULL, *files = NULL;
+    string cpar, cfile;
+    proc  pot;
+    int   i, j, npars = 0, nfiles = 0;
+    real  omega = 0.0;
+
+    names = burststring(fname, "+");
+    ncomp = xstrlen(names, sizeof(string)) - 1;
+    if (ncomp > MAXCOMP)
+        error("get_potential: too many components in %s (%d > %d)", fname, ncomp, MAXCOMP);
+    if (parameters != NULL && *parameters != 0) {
+        pars = burst0string(parameters, ";");
+        npars = xstrlen(pars, sizeof(string)) - 1;
+    }
+    if (dataname != NULL && *dataname != 0) {
+        files = burst0string(dataname, ";");
+        nfiles = xstrlen(files, sizeof(string)) - 1;
+    }
+    if (ncomp > 1 && (npars > ncomp || nfiles > ncomp))
+        warning("get_potential: more potpars/potfile entries than components in %s", fname);
+
+    for (i = 0; i < ncomp; i++)
+        for (j = 0; j < i; j++)
+            if (streq(names[i], names[j]))
+                error("get_potential: %s used twice in %s, not supported",
+                      names[i], fname);
+
+    for (i = 0; i < ncomp; i++) {
+        if (ncomp == 1) {               /* plain potential: no ';' splitting */
+            cpar = parameters;
+            cfile = dataname;
+        } else {
+            cpar  = i < npars  ? pars[i]  : NULL;
+            cfile = i < nfiles ? files[i] : NULL;
+        }
+        pot = load_potential(names[i], cpar, cfile, type);
+        if (local_omega != 0.0 && omega == 0.0)
+            omega = local_omega;        /* first non-zero pattern speed wins */
+        comp_pot[i] = pot;
+        comp_arr[i] = type != 'f' ? l_potarr : NULL;  /* batched is double only */
+        if (comp_arr[i])
+            dprintf(1,"get_potential: %s has potential_double_array\n", names[i]);
+    }
+    if (ncomp > 1) {
+        local_omega = omega;
+        dprintf(1,"get_potential: composite of %d potentials, omega=%g\n",ncomp,local_omega);
+    }
+
+    freestrings(names);
+    if (pars) freestrings(pars);
+    if (files) freestrings(files);
+
+    if (ncomp == 1)
+        return comp_pot[0];
+    if (type=='f' || (type=='r' && sizeof(real)==sizeof(float)))
+        return (proc) composite_float;
+    return (proc) composite_double;
+}
+
+/*-----------------------------------------------------------------------------
+ *  composite_double, composite_float -- sum of all components at one position
+ *-----------------------------------------------------------------------------
+ */
+local void composite_double(const int *ndim, const double *pos, double *acc,
+                            double *pot, const double *time)
+{
+    double a[MAXDIM], p;
+    int i, k;
+
+    (*(potproc_double)comp_pot[0])(ndim, pos, acc, pot, time);
+    for (i = 1; i < ncomp; i++) {
+        (*(potproc_double)comp_pot[i])(ndim, pos, a, &p, time);
+        *pot += p;
+        for (k = 0; k < *ndim; k++)
+            acc[k] += a[k];
+    }
+}
+
+local void composite_float(const int *ndim, const float *pos, float *acc,
+                           float *pot, const float *time)
+{
+    float a[MAXDIM], p;
+    int i, k;
+
+    (*(potproc_float)comp_pot[0])(ndim, pos, acc, pot, time);
+    for (i = 1; i < ncomp; i++) {
+        (*(potproc_float)comp_pot[i])(ndim, pos, a, &p, time);
+        *pot += p;
+        for (k = 0; k < *ndim; k++)
+            acc[k] += a[k];
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ *  composite_array -- sum of all components at npos positions
+ *       The first component writes acc[] and pot[] directly, the others go
+ *       through a scratch buffer that is kept between calls.
+ *-----------------------------------------------------------------------------
+ */
+local void composite_array(const int *npos, const int *ndim, const double *pos,
+                           double *acc, double *pot, const double *time)
+{
+    int i, n, k, nd = *ndim;
+    double *ap, *pp;
+
+    if (ncomp > 1 && *npos > arr_max) {
+        if (arr_acc) free(arr_acc);
+        if (arr_pot) free(arr_pot);
+        arr_max = *npos;
+        arr_acc = (double *) allocate(arr_max * MAXDIM * sizeof(double));
+        arr_pot = (double *) allocate(arr_max * sizeof(double));
+    }
+    for (i = 0; i < ncomp; i++) {
+        ap = i ? arr_acc : acc;
+        pp = i ? arr_pot : pot;
+        if (comp_arr[i])
+            (*comp_arr[i])(npos, ndim, pos, ap, pp, time);
+        else
+            for (n = 0; n < *npos; n++)
+                (*(potproc_double)comp_pot[i])(ndim, pos+n*nd, ap+n*nd, pp+n, time);
+        if (i == 0) continue;
+        for (n = 0; n < *npos; n++) {
+            pot[n] += arr_pot[n];
+            for (k = 0; k < nd; k++)
+                acc[n*nd+k] += arr_acc[n*nd+k];
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------------
+ *  potreg_lookup -- find a potential in the precompiled registry
+ *       The registry (see mkpotreg) is $POTREG, or else
+ *       $NEMOOBJ/potential/potreg.so; it is opened once per process and its
+ *       table hashed, so later lookups touch no files. POTREG= (empty)
+ *       disables the registry.
+ *-----------------------------------------------------------------------------
+ */
+local potreg_entry *potreg_lookup(string name)
+{
+    char  regname[256], pname[32];
+    char  *cp;
+    int   n = 0;
+    potreg_entry *table;
+
+    if (!potreg_tried) {
+        potreg_tried = TRUE;
+        cp = getenv("POTREG");
+        if (cp != NULL)
+            n = snprintf(regname, sizeof(regname), "%s", cp);
+        else if ((cp = getenv("NEMOOBJ")) != NULL)
+            n = snprintf(regname, sizeof(regname), "%s/potential/potreg.so", cp);
+        else
+            regname[0] = 0;
+        if (n < 0 || n >= sizeof(regname))
+            error("get_potential: registry name too long (%d > %d): %s",
+                  n, (int) sizeof(regname) - 1, cp);
+        if (regname[0] && access(regname, R_OK) == 0) {
+            loadobj(regname);
+            strcpy(pname, "potreg_table");
+            mapsys(pname);
+            table = (potreg_entry *) findfn(pname);
+            if (table == NULL)
+                warning("get_potential: no potreg_table in %s", regname);
+            else {
+                potreg = init_Hash_Table();
+                for (; table->name != NULL; table++)
+                    put_hash(potreg, table->name, (void *) table);
+                dprintf(1,"get_potential: using registry %s\n", regname);
+            }
+        }
+    }
+    if (potreg == NULL)
+        return NULL;
+    return (potreg_entry *) get_hash(potreg, name);
+}
+
 /*-----------------------------------------------------------------------------
  *  load_potential -- load the potential from an object file
  *       This routine depends heavily on the object-loader (loadobj(3NEMO))
@@ -128,6 +357,7 @@ local proc load_potential(string fname, string parameters, string dataname, char
     char  name[256], cmd[256], path[256], pname[32];
     char  *fullname, *nemopath, *potpath;
     proc  pot, ini_pot;
+    potreg_entry *reg;
     int never=0;
 
     if (parameters!=NULL && *parameters!=0) {              /* get parameters */
@@ -148,6 +378,32 @@ local proc load_potential(string fname, string parameters, string dataname, char
         mysymbols(getparam("argv0"));      /* get symbols for this program */
         first = FALSE;			   /* and tell it we've initialized */
     }
+    char search_type = type=='r'?
+#ifdef SINGLEPREC
+      'f'
+#else
+      'd'
+#endif
+      : type;
+    if (search_type!='f' && search_type!='d')
+      error("unknown data type '%c'\n",type);
+
+    l_potarr = NULL;
+    reg = potreg_lookup(fname);
+    if (reg) {                               /* precompiled: no file access */
+      dprintf(2,"Potential %s found in registry\n",fname);
+      Qfortran = FALSE;
+      if (search_type=='f')
+        pot = reg->pot_f;
+      else {
+        pot = reg->pot_d ? reg->pot_d : reg->pot;
+        l_potarr = reg->pot_a;
+      }
+      ini_pot = reg->ini;
+      if (pot==NULL)
+        error("Couldn't find a suitable potential for type %c in registry entry %s",
+              type,fname);
+    } else {
     potpath = getenv("POTPATH");	     /* is there customized path ? */
     if (potpath==NULL) {			/* use default path */
        potpath = path;
@@ -210,14 +466,6 @@ local proc load_potential(string fname, string parameters, string dataname, char
   if(pot) dprintf(1,"\"%s\" loaded from file \"%s\"\n",POTENTIAL,fullname);	\
 }
 
-    char search_type = type=='r'?
-#ifdef SINGLEPREC
-      'f'
-#else
-      'd'
-#endif
-      : type;
-
     if(search_type=='f') {                   /* IF type=f                 */
       FIND("potential_float");               /*   try "potential_float"   */
     } else if(search_type=='d') {            /* ELIF type=d               */
@@ -225,8 +473,7 @@ local proc load_potential(string fname, string parameters, string dataname, char
       if( pot==NULL) {                       /*   IF not found            */
 	FIND("potential");                   /*     try "potential"       */
       }
-    } else
-      error("unknown data type '%c'\n",type);
+    }
 #undef FIND
     /* it is perhaps possible that some fortran compilers will add __ for */
     /* routines that have embedded _ in their name.... we're not catching */
@@ -256,6 +503,12 @@ local proc load_potential(string fname, string parameters, string dataname, char
             }
         }
     }
+    if (search_type=='d') {
+        strcpy(pname,"potential_double_array");
+        mapsys(pname);
+        l_potarr = (potarr_double) findfn (pname);	/* optional, C only */
+    }
+    }                                           /* end of: not in registry */
     if (ini_pot)
         if (!Qfortran)
             (*ini_pot)(&local_npar,local_par,dataname); 	/* C */
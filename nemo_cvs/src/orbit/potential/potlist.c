@@ -18,12 +18,17 @@
  *                          e   12-jun-98       fixed bug in NDIM=3
  *			    f   13-sep-01       potproc prototypes
  *                       4.0    18-sep-01       handle float as well as double potentials
+ *                       4.1    19-oct-26       out= for a binary table
+ *                       4.2    19-oct-26       out= written in blocks of NBLOCK rows
  */
 
 #include <stdinc.h>
 #include <getparam.h>
 #include <potential.h>
 #include <vectmath.h>
+#include <filestruct.h>
+#include <history.h>
+#include <table.h>
 
 string defv[] = {
     "potname=???\n  Name of potential",
@@ -38,7 +43,9 @@ string defv[] = {
     "format=%g\n    Format used to print numbers",
     "ndim=3\n       Poission test in 3-dim  (XYZ) or 2-dim (XY)",
     "double=\n      float or double, or automatic detection",
-    "VERSION=4.0b\n  30-may-2011 PJT",
+    "out=\n         Binary table to write instead of ASCII output",
+    "outtype=double\n Type of the columns in out= (double or float)",
+    "VERSION=4.2\n   19-oct-2026",
     NULL,
 };
 
@@ -48,6 +55,8 @@ string usage = "show a NEMO potential";
 #define MAXPT 100001
 #endif
 
+#define NBLOCK 4096	/* rows per Table set of out= */
+
 local potproc_double mypotd;     /* pointer to potential calculator function : double */
 local potproc_float  mypotf;     /* pointer to potential calculator function : float */
 local void do_potential(bool,int *, double *, double *, double *, double *);
@@ -61,8 +70,12 @@ void nemo_main(void)
     double ax,ay,az,epot, dr,da[3];
     double fourpi = 4*PI;
     double omega;
-    bool Qdens, Qdouble;
+    bool Qdens, Qdouble, Qout;
     char *fmt, s[20], pfmt[256];
+    real *col[13];
+    int  ncol = 0, nblock = 0, nrow = 0;
+    stream outstr;
+    string outtype, names;
 
     Qdens = hasvalue("dr");
     if (Qdens) dr = getdparam("dr");
@@ -136,6 +149,25 @@ void nemo_main(void)
     }
     ndim = getiparam("ndim");
     if (ndim != 3 && ndim != 2) error("NDIM=%d must be 2 or 3",ndim);
+
+    Qout = hasvalue("out");                 /* binary table: columns */
+    if (Qout) {
+        outtype = getparam("outtype");
+        if (streq(outtype,"double"))
+            outtype = DoubleType;
+        else if (streq(outtype,"float"))
+            outtype = FloatType;
+        else
+            error("outtype=%s must be double or float",outtype);
+        ncol = Qdens ? 13 : 8;
+        names = Qdens ? "x y z ax ay az phi phixx phiyy phizz rho dr time" :
+                        "x y z ax ay az phi time";
+        nblock = MIN(nsteps, NBLOCK);       /* rows kept in memory */
+        for (i=0; i<ncol; i++)
+            col[i] = (real *) allocate(nblock*sizeof(real));
+        outstr = stropen(getparam("out"),"w");
+        put_history(outstr);
+    }
                   
     for (i=0,ix=0,iy=0,iz=0;i<nsteps;i++) {
         pos[0] = xarr[ix];
@@ -184,6 +216,15 @@ void nemo_main(void)
 
             da[0] /= dr; da[1] /= dr; da[2] /= dr;
         
+            if (Qout) {
+                col[0][nrow] = xarr[ix];  col[1][nrow] = yarr[iy];  col[2][nrow] = zarr[iz];
+                col[3][nrow] = ax;        col[4][nrow] = ay;        col[5][nrow] = az;
+                col[6][nrow] = epot;
+                col[7][nrow] = da[0];     col[8][nrow] = da[1];     col[9][nrow] = da[2];
+                col[10][nrow] = (da[0]+da[1]+da[2])/fourpi;
+                col[11][nrow] = dr;
+                col[12][nrow] = time;
+            } else
             printf (pfmt,
                 xarr[ix], yarr[iy], zarr[iz],		/* positions */
                 ax,       ay,       az,        		/* forces */
@@ -192,6 +233,11 @@ void nemo_main(void)
                 (da[0]+da[1]+da[2])/fourpi,             /* poissonian density */
                 dr,      				/* difference */
                 time);                                  /* time */
+        } else if (Qout) {
+            col[0][nrow] = xarr[ix];  col[1][nrow] = yarr[iy];  col[2][nrow] = zarr[iz];
+            col[3][nrow] = ax;        col[4][nrow] = ay;        col[5][nrow] = az;
+            col[6][nrow] = epot;
+            col[7][nrow] = time;
         } else {
             printf (pfmt,
                 xarr[ix], yarr[iy], zarr[iz],		/* positions */
@@ -199,8 +245,17 @@ void nemo_main(void)
                 epot,					/* potential */
                 time);                                  /* time */
         } 
+        if (Qout && ++nrow == nblock) {     /* a full block: write it */
+            put_btable(outstr, ncol, col, nrow, names, outtype);
+            nrow = 0;
+        }
         ix += stepx; iy += stepy; iz += stepz;
     }
+    if (Qout) {
+        if (nrow > 0)                       /* what is left */
+            put_btable(outstr, ncol, col, nrow, names, outtype);
+        strclose(outstr);
+    }
 }
 
 
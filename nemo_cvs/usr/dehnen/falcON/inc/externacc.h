@@ -4,11 +4,11 @@
 /// \file   inc/externacc.h                                                     
 ///                                                                             
 /// \author Walter Dehnen                                                       
-/// \date   2000-2007                                                           
+/// \date   2000-2007,2026                                                      
 ///                                                                             
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                              
-// Copyright (C) 2000-2007 Walter Dehnen                                        
+// Copyright (C) 2000-2007,2026 Walter Dehnen                                   
 //                                                                              
 // This program is free software; you can redistribute it and/or modify         
 // it under the terms of the GNU General Public License as published by         
@@ -52,6 +52,10 @@ namespace falcON {
   ///  if masses and velocities are not required (as indicated by the           
   ///  routines need_masses() and need_velocities()), NULL pointers may be      
   ///  passed.                                                                  
+  /// \note                                                                     
+  ///  if is_reentrant(), set() may be called concurrently by several threads,  
+  ///  each for a different set of bodies, once it has been called for the     
+  ///  current time (possibly with no bodies).                                  
   //                                                                            
   // ///////////////////////////////////////////////////////////////////////////
   class acceleration {
@@ -67,6 +71,8 @@ namespace falcON {
     virtual bool is_empty()        const=0;        ///< no potential?
     virtual bool need_masses()     const=0;        ///< masses needed?
     virtual bool need_velocities() const=0;        ///< velocities needed?
+    virtual bool is_reentrant()    const           ///< concurrent set()?
+    { return false; }
     //--------------------------------------------------------------------------
     /// computing external gravity at a set of positions
     ///
@@ -120,6 +126,25 @@ namespace falcON {
 	     vectd       *a,
 	     int          add)  const = 0;
     //@}
+  private:
+    /// external gravity for bodies i0 to i0+n-1 of block b
+    void set(const snapshot*snap,
+	     const block   *b,
+	     unsigned       i0,
+	     unsigned       n,
+	     bool           all,
+	     int            add) const
+    {
+      set(snap->time(), n,
+	  need_masses()     ? b->const_data<fieldbit::m>()+i0 : 0,
+	                      b->const_data<fieldbit::x>()+i0,
+	  need_velocities() ? b->const_data<fieldbit::v>()+i0 : 0,
+	  all               ? 0 : b->const_data<fieldbit::f>()+i0,
+	                      b->data<fieldbit::q>()+i0,
+	                      b->data<fieldbit::a>()+i0,
+	  add);
+    }
+  public:
     //--------------------------------------------------------------------------
     /// \name non-virtual functions using the abstract methods above
     //@{
@@ -131,22 +156,35 @@ namespace falcON {
     /// otherwise assigned; if bit 1 is set, the acceleration is added,
     /// otherwise assigned. So, 0 means both are assigned, while the default is
     /// to add acceleration but assign potential to field pex (see fieldset).
+    ///
+    /// With \a nt > 1 and if is_reentrant(), the bodies are split into chunks,
+    /// which \a nt threads take in turn (requires OpenMP).
     /// \param[in] snap  snapshot = time + bodies
     /// \param[in] all   set gravity for all bodies or only active bodies?
     /// \param[in] add   (optional) see detailed description
+    /// \param[in] nt    (optional) # threads
     void set(const snapshot*snap,
 	     bool           all,
-	     int            add = 2) const
+	     int            add = 2,
+	     unsigned       nt  = 1) const
     {
+#ifdef _OPENMP
+      if(nt > 1 && is_reentrant() && snap->N_bodies() > 64*nt) {
+	// first call for this time by this thread, see is_reentrant()
+	set(snap,snap->first_block(),0,0,all,add);
+	const int K = 1 + snap->N_bodies()/(8*nt);
+#pragma omp parallel num_threads(nt)
+	for(const block* b=snap->first_block(); b; b=b->next()) {
+	  const int Nb = b->N_bodies();
+#pragma omp for schedule(dynamic,1) nowait
+	  for(int i=0; i<Nb; i+=K)
+	    set(snap,b,i,std::min(K,Nb-i),all,add);
+	}
+	return;
+      }
+#endif
       for(const block* b=snap->first_block(); b; b=b->next())
-	set(snap->time(), b->N_bodies(),
-	    need_masses()     ? b->const_data<fieldbit::m>() : 0,
-	                        b->const_data<fieldbit::x>(),
-	    need_velocities() ? b->const_data<fieldbit::v>() : 0,
-	    all               ? 0 : b->const_data<fieldbit::f>(),
-	                        b->data<fieldbit::q>(),
-	                        b->data<fieldbit::a>(),
-	    add);
+	set(snap,b,0,b->N_bodies(),all,add);
     }
     //--------------------------------------------------------------------------
     /// computing external gravity at a single position
@@ -374,6 +412,10 @@ namespace falcON {
     bool need_velocities() const {
       return A1->need_velocities() || A2->need_velocities();
     }
+    bool is_reentrant() const {
+      return (A1->is_empty() || A1->is_reentrant())
+	&&   (A2->is_empty() || A2->is_reentrant());
+    }
     /// computing external gravity at a set of positions
     void set(double t, int n, const float*m, const vectf*x, const vectf*v,
 	     const flags*f, float*p, vectf*a, int add) const
@@ -417,6 +459,7 @@ extern "C" {
   typedef void (*pacc)(int,double,int,const void*,const void*,const void*,
 		       const int*, void*, void*, int, char);
   pacc get_acceleration(const char*, const char*, const char*, bool*, bool*);
+  bool reentrant_acceleration(pacc);
 }
 namespace falcON {
   // ///////////////////////////////////////////////////////////////////////////
@@ -438,7 +481,7 @@ namespace falcON {
   class nemo_acc: public acceleration {
   private:
     pacc ACC;
-    bool NeedM, NeedV;
+    bool NeedM, NeedV, Reent;
   public:
     //--------------------------------------------------------------------------
     /// is there any external acceleration at all?
@@ -450,6 +493,9 @@ namespace falcON {
     /// do we need body velocities?
     bool need_velocities() const { return ACC!=0 && NeedV; }
     //--------------------------------------------------------------------------
+    /// may set() be called concurrently? (see reentrant_acceleration())
+    bool is_reentrant() const { return Reent; }
+    //--------------------------------------------------------------------------
     /// computing external gravity at a set of positions
     ///
     /// The parameter \a i indicates whether the accelerations and potential 
@@ -532,7 +578,8 @@ namespace falcON {
     nemo_acc(const char*accname,
 	     const char*accpars,
 	     const char*accfile) : 
-      ACC ( get_acceleration(accname,accpars,accfile,&NeedM,&NeedV) ) {}
+      ACC  ( get_acceleration(accname,accpars,accfile,&NeedM,&NeedV) ),
+      Reent( ACC!=0 && reentrant_acceleration(ACC) ) {}
     /// noon dtor
     virtual~nemo_acc() {}
   };
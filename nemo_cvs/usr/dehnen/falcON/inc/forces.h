@@ -151,6 +151,20 @@ namespace falcON {
     /// reset Newton's gravitational constant                                   
     /// \param G new value for  Newton's gravitational constant                 
     void reset_NewtonsG(real G) const;
+    //--------------------------------------------------------------------------
+    /// set the number of threads for the gravity computation                   
+    ///                                                                         
+    /// With more than one thread, the interactions are split into tasks, which 
+    /// the threads take in turn, each accumulating into its own copy of the    
+    /// leafs' and cells' data; these are added up before the (also            
+    /// multithreaded) evaluation phase. The same threads build the tree.       
+    /// Requires compilation with OpenMP, otherwise the computation is always  
+    /// single-threaded.                                                        
+    /// \param n number of threads; 0: as many as OpenMP offers (default: 1)   
+    void set_threads(unsigned n) const;
+    //--------------------------------------------------------------------------
+    /// # threads actually used for the gravity computation
+    unsigned threads() const;
     //@}
     //==========================================================================
     /// dtor: will delete all allocated structures (tree & estimators)          
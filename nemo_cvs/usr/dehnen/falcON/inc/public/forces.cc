@@ -122,6 +122,16 @@ namespace falcON {
     GRAV->reset_NewtonsG(g);
   }
   //----------------------------------------------------------------------------
+  inline void forces::set_threads (unsigned n) const
+  {
+    GRAV->set_threads(n);
+  }
+  //----------------------------------------------------------------------------
+  inline unsigned forces::threads () const
+  {
+    return GRAV->threads();
+  }
+  //----------------------------------------------------------------------------
   inline void forces::reset_opening(real th, MAC_type mac) const
   {
     GMAC->reset(mac, abs(th), falcON_ORDER);
@@ -137,6 +147,7 @@ namespace falcON {
     SET_I
     Ncrit = max(Ncr,1);
     if(TREE) {
+      TREE->set_threads(GRAV->threads());
       TREE->build(Ncrit,x0);
       GRAV->reset();
 #ifdef falcON_SPH
@@ -147,7 +158,8 @@ namespace falcON {
 	DebugInfo("forces::grow(): tree re-grown with %d leafs\n",
 		  TREE->N_leafs());
     } else {
-      TREE = new OctTree(BODIES,Ncrit,x0);
+      TREE = new OctTree(BODIES,Ncrit,x0,Default::MaxDepth,flags::empty,
+			 0,0,true,GRAV->threads());
       GRAV->new_tree(TREE);
 #ifdef falcON_SPH
       const_cast<SphEstimator*>(SPHT)->new_tree(TREE);
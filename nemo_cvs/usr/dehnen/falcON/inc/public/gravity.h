@@ -44,6 +44,14 @@
 #define WRITE_IACTION_INFO
 #undef  WRITE_IACTION_INFO
 ////////////////////////////////////////////////////////////////////////////////
+// with OpenMP, GravEstimator may use several threads, each accumulating its
+// interactions into its own copy of the leafs' acc & pot and cells' Taylor
+// coefficients; the accessors find these via thread-local pointers.
+// initial-exec TLS costs no function call even in a shared library.
+#ifdef _OPENMP
+#  define falcON_GRAV_TLS __thread __attribute__((tls_model("initial-exec")))
+#endif
+////////////////////////////////////////////////////////////////////////////////
 namespace falcON {
   //
   // namespace falcON::grav
@@ -139,7 +147,13 @@ namespace falcON {
       //------------------------------------------------------------------------
       // private const data access                                              
       //------------------------------------------------------------------------
+#ifdef _OPENMP
+      static falcON_GRAV_TLS int ACPN_SHIFT;       // this thread's acpn copy   
+      acpn_data*       acpn () const {
+	return static_cast<acpn_data*>(PROP) + ACPN_SHIFT; }
+#else
       acpn_data*       acpn () const { return static_cast<acpn_data*>(PROP); }
+#endif
       real            &mass ()       { return SCAL; }
       real       const&mass () const { return SCAL; }
       vect       const&acc  () const { return acpn()->acc(); }
@@ -323,8 +337,18 @@ namespace falcON {
       real const&rcrit () const { return RAD; }
       real       rcrit2() const { return square(rcrit()); }
       real const&eph   () const { return __srce->EPSH; }
-      Cset&Coeffs() const { return *static_cast<Cset*>(AUX2.PTER); }
+      Cset&Coeffs() const { return *static_cast<Cset*>(coeffs()); }
       const Mset&poles () const { return __srce->POLS; }
+      //------------------------------------------------------------------------
+      // pointer to Coeffs: AUX2 or, in a thread other than the first, its own 
+#ifdef _OPENMP
+      static falcON_GRAV_TLS void      **COEFFS;   // this thread's Coeffs pters
+      static falcON_GRAV_TLS const Cell *CELL0;    // first cell: index COEFFS  
+      void*&coeffs() const {
+	return COEFFS? COEFFS[this-CELL0] : const_cast<void*&>(AUX2.PTER); }
+#else
+      void*&coeffs() const { return const_cast<void*&>(AUX2.PTER); }
+#endif
       //------------------------------------------------------------------------
       // simple manipulations                                                   
       //------------------------------------------------------------------------
@@ -336,12 +360,12 @@ namespace falcON {
       }
       //------------------------------------------------------------------------
       void setCoeffs(Cset*coef) {
-	AUX2.PTER = static_cast<void*>(coef); 
+	coeffs() = static_cast<void*>(coef); 
       }
       //------------------------------------------------------------------------
-      void*returnCoeffs()       { return AUX2.PTER; }
-      void resetCoeffs ()       { AUX2.PTER=0; }
-      bool hasCoeffs   () const { return AUX2.PTER != 0; }
+      void*returnCoeffs()       { return coeffs(); }
+      void resetCoeffs ()       { coeffs()=0; }
+      bool hasCoeffs   () const { return coeffs() != 0; }
       //------------------------------------------------------------------------
       // non-const data access via members                                      
       //------------------------------------------------------------------------
@@ -350,7 +374,7 @@ namespace falcON {
       real &rmax  () { return RAD; }
       real &size  () { return RAD; }
       real &eph   () { return __srce->EPSH; }
-      Cset &Coeffs() { return *static_cast<Cset*>(AUX2.PTER); }
+      Cset &Coeffs() { return *static_cast<Cset*>(coeffs()); }
       Mset &poles () { return __srce->POLS; }
 #undef __srce
       //------------------------------------------------------------------------
@@ -418,6 +442,10 @@ namespace falcON {
     Leaf::acpn_data      *LEAF_ACPN;               // memory for leafs          
     unsigned              NCT, NCA, NLA;           // # allocation of these     
     unsigned              NLA_needed;              // # active leafs            
+    unsigned              NLT;                     // # copies of leaf memory   
+    unsigned              NTHREADS;                // # threads; 0: all OpenMP  
+    void                **CELL_COEF;               // other threads' Coeffs     
+    unsigned              NCC;                     // # allocation of these     
     //--------------------------------------------------------------------------
     // private methods                                                          
     //--------------------------------------------------------------------------
@@ -440,7 +468,8 @@ namespace falcON {
     // - set the cells r_crit & r_crit^2                                        
     unsigned pass_up(                              // R: # active cells         
 		     const GravMAC*,               // I: MAC                    
-		     bool          );              // I: reused old tree?       
+		     bool          ,               // I: reused old tree?       
+		     unsigned      =1u);           //[I: # threads]             
     //--------------------------------------------------------------------------
     // prepare for interactions                                                 
     //  - allocate memory for leaf acc/pot/num properties for active leafs      
@@ -448,7 +477,18 @@ namespace falcON {
     //  - pass source properties up the tree, count active cells                
     bool prepare(                                  // R: ALL || all are active  
 		 const GravMAC*,                   // I: MAC                    
-		 bool          );                  // I: all or active only?    
+		 bool          ,                   // I: all or active only?    
+		 unsigned      =1u);               //[I: # threads]             
+#ifdef _OPENMP
+    //--------------------------------------------------------------------------
+    // multithreaded exact() or approx(), after prepare(): interaction phase,  
+    // adding up the threads' contributions, evaluation phase, update bodies    
+    template<typename IACT>
+    void threaded(bool    ,                        // I: all are active?        
+		  bool    ,                        // I: exact (or approx)?     
+		  unsigned,                        // I: # threads              
+		  bool    );                       // I: update eps_i as well?  
+#endif
     //--------------------------------------------------------------------------
     // tree stuff to be superseeded                                             
     //--------------------------------------------------------------------------
@@ -497,7 +537,11 @@ namespace falcON {
       NCT            ( 0u ),
       NCA            ( 0u ),
       NLA            ( 0u ),
-      NLA_needed     ( 0u )
+      NLA_needed     ( 0u ),
+      NLT            ( 0u ),
+      NTHREADS       ( 1u ),
+      CELL_COEF      ( 0 ),
+      NCC            ( 0u )
     {
       const_cast<unsigned*>(DIR)[0]=d[0];
       const_cast<unsigned*>(DIR)[1]=d[1];
@@ -530,6 +574,15 @@ namespace falcON {
       GRAV = g;
     }
     //--------------------------------------------------------------------------
+    // set # threads for exact() and approx(); 0: as many as OpenMP offers.    
+    // Without OpenMP, these always use one thread.                            
+    void set_threads(unsigned n) {
+      NTHREADS = n;
+    }
+    //--------------------------------------------------------------------------
+    // # threads actually used by exact() and approx()                         
+    unsigned threads() const;
+    //--------------------------------------------------------------------------
     // destruction                                                              
     //--------------------------------------------------------------------------
     ~GravEstimator();
@@ -583,6 +636,7 @@ namespace falcON {
     unsigned       const&N_chunks        () const { return Nchunks; }
     unsigned       const&N_elems_in_chunk() const { return Ncsize; }
     bool           const&use_indiv_eps   () const { return INDI_SOFT; }
+    unsigned       const&N_threads       () const { return NTHREADS; }
   };// class GravEstimator {
   // ///////////////////////////////////////////////////////////////////////////
   //                                                                          //
@@ -762,6 +816,15 @@ namespace falcON {
 #undef CELL_B
 #undef LEAF_B
 #undef ADD_SS
+    // add the records of another, e.g. of another thread                       
+    void add(GravStats const&S)
+    {
+      D_BB+=S.D_BB, D_CB+=S.D_CB, D_CC+=S.D_CC, D_CX+=S.D_CX;
+      A_CB+=S.A_CB, A_CC+=S.A_CC;
+#ifdef ENHANCED_IACT_STATS
+      P_CB+=S.P_CB, P_CC+=S.P_CC, P_CX+=S.P_CX;
+#endif
+    }
     // 2 reporting                                                              
     unsigned const&BB_direct_iacts   () const { return D_BB; }
     unsigned const&CB_direct_iacts   () const { return D_CB; }
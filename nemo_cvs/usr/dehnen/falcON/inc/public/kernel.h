@@ -162,7 +162,7 @@ namespace falcON {
 		 kern_type const&k,                // I: type of kernel         
 		 real      const&e,                // I: softening length       
 		 bool      const&s,                // I: type of softening      
-		 unsigned  const&np) :             // I: initial pool size      
+		 unsigned  const&np) :             // I: pool size; 0: no pool  
       KERN       ( k ),                            // set softening kernel      
       INDI_SOFT  ( s ),                            // set softening type        
       EPS        ( e ),                            // set softening length      
@@ -174,7 +174,8 @@ namespace falcON {
       HQ         ( half * EQ ),
       QQ         ( quarter * EQ ),
 #endif
-      COEFF_POOL ( new falcON::pool(max(4u,np), grav::NCOEF*sizeof(real)) ),
+      COEFF_POOL ( np? new falcON::pool(max(4u,np), grav::NCOEF*sizeof(real))
+		     : 0 ),
       NC         ( 0 ),
       MAXNC      ( 0 ) {}
     //--------------------------------------------------------------------------
@@ -217,10 +218,16 @@ namespace falcON {
     void eval_grav    (grav::cell_iter const&, TaylorSeries const&) const;
     void eval_grav_all(grav::cell_iter const&, TaylorSeries const&) const;
     //--------------------------------------------------------------------------
+    // evaluation of a cell's own coeffs and leaf kids only: on return, the     
+    // Taylor series holds what is to be passed on to its cell kids. This      
+    // allows to split the evaluation phase into independent tasks.            
+    void eval_node    (grav::cell_iter const&, TaylorSeries&) const;
+    void eval_node_all(grav::cell_iter const&, TaylorSeries&) const;
+    //--------------------------------------------------------------------------
     // public methods                                                           
     //--------------------------------------------------------------------------
   public:
-    int      const&coeffs_used() const { return MAXNC; }
+    int            coeffs_used() const { return max(MAXNC,NC); }
     unsigned       chunks_used() const {
       return COEFF_POOL?  COEFF_POOL->N_chunks() : 0u; }
     /// given X^2 and Eps^2, compute negative gravitational potential
@@ -1005,6 +1005,8 @@ namespace falcON {
     }
     /// diagnose: compute total pot & kin energy, etc.
     virtual void diagnose  () const { ForceDiagGrav::diagnose_full(); }
+    /// set # threads for gravity (see forces::set_threads())
+    void set_threads(unsigned n) const { FALCON.set_threads(n); }
   };// class falcON::ForceALCON
 #ifdef falcON_NEMO
   //////////////////////////////////////////////////////////////////////////////
@@ -1061,6 +1063,7 @@ namespace falcON {
     /// \param trange time range to read input for (take first if null)
     /// \param read   data to read in addition to required for integration
     /// \param dir    number controlling direct summation
+    /// \param threads # threads for gravity; 0: all OpenMP threads
     FalcONCode(// data input                                                    
 	       const char *       file,
 	       bool               resume,
@@ -1093,7 +1096,8 @@ namespace falcON {
 	       soft_type          soft = global_fixed, 
 	       const char        *trange = 0,
 	       fieldset           read = fieldset::empty,
-	       const unsigned     dir[4] = Default::direct) falcON_THROWING
+	       const unsigned     dir[4] = Default::direct,
+	       unsigned           threads= 1) falcON_THROWING
     : NBodyCode ( file, resume, to_read(read,
 					soft!=global_fixed ? 1 : 0,
 					Grav || aex), trange ),
@@ -1116,6 +1120,7 @@ namespace falcON {
 	falcON_THROW("FalcONCode: ksink=%d < kmax=%d\n",ksink,kmax);
       if(Nlev > 1 && GS.scheme() == 0)
 	falcON_THROW("FalcONCode: time stepping factors=0\n");
+      ForceALCON::set_threads(threads);
       NBodyCode::init(this, kmax, Nlev, &GS, fieldset::x, fieldset::v);
     }
   };// class falcON::FalcONCode
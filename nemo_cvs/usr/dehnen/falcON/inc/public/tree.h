@@ -4,14 +4,14 @@
 /// \file   inc/public/tree.h
 ///
 /// \author Walter Dehnen
-/// \date   2000-2007,2010,2012
+/// \date   2000-2007,2010,2012,2026
 ///
 /// \brief  contains definition of class \a OctTree and macros for access to
 ///         cells & leafs of a tree
 ///
 // /////////////////////////////////////////////////////////////////////////////
 //
-// Copyright (C) 2000-2012  Walter Dehnen
+// Copyright (C) 2000-2012,2026  Walter Dehnen
 //
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License as
@@ -393,6 +393,7 @@ namespace falcON {
     unsigned           NALLOC;                   ///< # bytes allocated         
     state              STATE;                    ///< tree state                
     mutable  usage     USAGE;                    ///< tree usage                
+    unsigned           NTHREADS;                 ///< # threads for building    
     //@}
     //--------------------------------------------------------------------------
     void allocate (unsigned , unsigned , unsigned , real);
@@ -411,6 +412,7 @@ namespace falcON {
     /// \param xmin (optional input) minimum position in each dimension
     /// \param xmax (optional input) maximum position in each dimension
     /// \param putsinksout put leaf for sink particles in root cell
+    /// \param nthreads (optional input) # threads for building (needs OpenMP)
     OctTree(const bodies*B,
 	    int          Nc,
 	    const vect*  C= 0,
@@ -418,7 +420,8 @@ namespace falcON {
 	    flags        S= flags::empty,
 	    const vect  *xmin = 0,
 	    const vect  *xmax = 0,
-	    bool putsinksout  = true);
+	    bool putsinksout  = true,
+	    unsigned nthreads = 1);
     //--------------------------------------------------------------------------
     /// construct as sub-tree
     /// \param T  (input) parent tree
@@ -483,6 +486,11 @@ namespace falcON {
     /// tree-re-use: just update the leafs' positions
     void reuse();
     //--------------------------------------------------------------------------
+    /// set # threads used by build(); without OpenMP, the build is serial
+    void set_threads(unsigned n) { NTHREADS = n? n : 1u; }
+    /// # threads used by build()
+    unsigned const&threads() const { return NTHREADS; }
+    //--------------------------------------------------------------------------
     /// destructor
     ~OctTree();
     //--------------------------------------------------------------------------
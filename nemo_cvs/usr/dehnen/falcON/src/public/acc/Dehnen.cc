@@ -22,6 +22,7 @@
 //                                                                             |
 // Versions                                                                    |
 // 0.1    09/08/2006  WD use $NEMOINC/defacc.h                                 |
+// 0.2    19/10/2026     reentrant (__DEF__REENTRANT)                          |
 //-----------------------------------------------------------------------------+
 #define POT_DEF
 #include <cmath>
@@ -104,6 +105,7 @@ namespace {
 //------------------------------------------------------------------------------
 
 __DEF__ACC(SphericalPot<Dehnen>)
+__DEF__REENTRANT
 __DEF__POT(SphericalPot<Dehnen>)
 
 //------------------------------------------------------------------------------
@@ -22,6 +22,7 @@
 //                                                                             |
 // Versions                                                                    |
 // 0.1    09/08/2006  WD use $NEMOINC/defacc.h                                 |
+// 0.2    19/10/2026     reentrant (__DEF__REENTRANT)                          |
 //-----------------------------------------------------------------------------+
 #undef POT_DEF
 #include <iostream>
@@ -120,5 +121,6 @@ namespace {
 //------------------------------------------------------------------------------
 
 __DEF__ACC(SphericalPot<DehnenMcLaughlin>)
+__DEF__REENTRANT
 
 //------------------------------------------------------------------------------
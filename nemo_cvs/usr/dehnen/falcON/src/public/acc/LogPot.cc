@@ -24,6 +24,7 @@
 // Versions                                                                    |
 // 0.0   23-jun-2011    created                                             WD |
 // 0.1   19-jun-2012    avoid warning about uninitialised vars              WD |
+// 0.2   19-oct-2026    reentrant (__DEF__REENTRANT)                           |
 //-----------------------------------------------------------------------------+
 #include <iostream>
 #include <fstream>
@@ -106,5 +107,6 @@ namespace {
 } // namespace {
 //------------------------------------------------------------------------------
 __DEF__ACC(LogPot)
+__DEF__REENTRANT
 __DEF__POT(LogPot)
 //------------------------------------------------------------------------------
@@ -33,6 +33,7 @@
 // 0.1   18-nov-2002    converted from C++ to C                           WD   |
 // 1.0   23-aug-2004    converted back to C++, implementing acceleration  WD   |
 // 1.1   09-aug-2006    use $NEMOINC/defacc.h                             WD   |
+// 1.2   19-oct-2026    reentrant (__DEF__REENTRANT)                           |
 //-----------------------------------------------------------------------------+
 #define POT_DEF
 #include <cmath>
@@ -92,6 +93,7 @@ namespace {
 //------------------------------------------------------------------------------
 
 __DEF__ACC(SphericalPot<NFWPot>)
+__DEF__REENTRANT
 __DEF__POT(SphericalPot<NFWPot>)
 
 //------------------------------------------------------------------------------
@@ -21,6 +21,7 @@
 //------------------------------------------------------------------------------
 // Versions
 // 0.1    07/07/2010  WD  created.
+// 0.2    19/10/2026      reentrant (__DEF__REENTRANT)
 //------------------------------------------------------------------------------
 #include <cmath>             // for std::sqrt()
 #include <public/default.h>  // $FALCON/inc/public/default.h
@@ -94,6 +95,7 @@ namespace {
 //------------------------------------------------------------------------------
     
 __DEF__ACC(SphericalPot<SoftKernel>)
+__DEF__REENTRANT
 __DEF__POT(SphericalPot<SoftKernel>)
 
 //------------------------------------------------------------------------------
@@ -147,9 +147,11 @@
 // v 3.5    15/06/2011  WD recompute forces if manipulator changes masses
 // v 3.5.1  30/06/2011  WD eps required (no default value)
 // v 3.6    19/06/2011  WD happy gcc 4.7.0
+// v 3.7    19/10/2026     keyword threads: multithreaded gravity (OpenMP)
+// v 3.7.1  19/10/2026     threads also for reentrant external acceleration
 ////////////////////////////////////////////////////////////////////////////////
-#define falcON_VERSION   "3.6"
-#define falcON_VERSION_D "19-jun-2012 Walter Dehnen                          "
+#define falcON_VERSION   "3.7.1"
+#define falcON_VERSION_D "19-oct-2026                                        "
 //------------------------------------------------------------------------------
 #ifndef falcON_NEMO
 #  error You need "NEMO" to compile gyrfalcON
@@ -206,6 +208,7 @@ const char*defv[] = {
   "                   - append output to input (unless out given)        ",
   "give=mxv\n         list of output specifications.                     ",
   "Grav=1\n           Newton's constant of gravity (0-> no self-gravity) ",
+  "threads=1\n        # threads for gravity & reentrant accname; 0: all   ",
   "root_center=\n     if given (3 numbers), forces tree-root centering   ",
   "accname=\n         name of external acceleration field                ",
   "accpars=\n         parameters of external acceleration field          ",
@@ -293,7 +296,9 @@ void falcON::main() falcON_THROWING
 #endif
 		  global_fixed,
 		  getparam_z("time"),
-		  need);
+		  need,
+		  Default::direct,
+		  getuparam ("threads"));
   if(MANIP) {
     const_cast<snapshot*>(NBDY.my_snapshot())->add_fields(MANIP.provide());
     if(getbparam("manipinit"))
@@ -5,7 +5,7 @@
 ///
 /// \author  Walter Dehnen
 ///
-/// \date    2000-2010
+/// \date    2000-2010,2026
 ///
 /// \brief   implements inc/public/gravity.h
 ///
@@ -33,6 +33,11 @@
 #include <public/interact.h>
 #include <public/kernel.h>
 #include <numerics.h>
+#ifdef _OPENMP
+#  include <omp.h>
+#  include <vector>
+#  include <algorithm>
+#endif
 
 using namespace falcON;
 ////////////////////////////////////////////////////////////////////////////////
@@ -235,6 +240,126 @@ namespace {
 		 square(radius(C)+abs(com[1]-center(C)[1])) +
 		 square(radius(C)+abs(com[2]-center(C)[2])) );
   }
+  //----------------------------------------------------------------------------
+  // passes flag, mass, cofm, rmax[, eph], multipoles from the kids of a cell   
+  // to the cell; returns whether the cell is active                            
+  //----------------------------------------------------------------------------
+#define MASS_WEIGHTED_SOFTENING 1
+  template<bool INDI_SOFT>
+  inline bool pass_up_cell(cell_iter const&Ci, bool REUSE)
+  {
+    Ci->reset_active_flag();                       // reset activity flag       
+    Ci->reset_sink_flag();                         // reset sink flag           
+    real eh (zero);                                // reset eps/2               
+    real mon(zero);                                // reset monopole            
+    vect com(zero);                                // reset dipole              
+    LoopCellKids(cell_iter,Ci,c) {                 // LOOP sub-cells c          
+      if(INDI_SOFT) eh += eph (c) *
+#ifdef MASS_WEIGHTED_SOFTENING
+	mass(c)                                    //   sum up M * eps/2        
+#else
+	number(c)
+#endif
+	;
+      mon += mass(c);                              //   sum up monopole         
+      com += mass(c) * cofm(c);                    //   sum up dipole           
+      Ci->add_active_flag(c);                      //   add in activity flag    
+      Ci->add_sink_flag(c);                        //   add in sink flag        
+    }                                              // END LOOP                  
+    LoopLeafKids(cell_iter,Ci,l) {                 // LOOP sub-leafs s          
+#ifdef MASS_WEIGHTED_SOFTENING
+      if(INDI_SOFT) eh += mass(l) * eph(l);        //   sum up M * eps/2        
+#else
+      if(INDI_SOFT) eh += eph (l);                 //   sum up eps/2            
+#endif
+      mon += mass(l);                              //   sum up monopole         
+      com += mass(l) * cofm(l);                    //   sum up dipole           
+      Ci->add_active_flag(l);                      //   add in activity flag    
+      Ci->add_sink_flag(l);                        //   add in sink flag        
+    }                                              // END LOOP                  
+    Ci->mass() = mon;                              // set mass                  
+    mon        = (mon==zero)? zero:one/mon;        // 1/mass                    
+    com       *= mon;                              // cofm = dipole/mass        
+    if(INDI_SOFT) {
+#ifdef MASS_WEIGHTED_SOFTENING
+      eh      /= mass(Ci);                         // mean eps/2                
+#else
+      eh      /= number(Ci);                       // mean eps/2                
+#endif
+      Ci->eph()= eh;                               // set eps/2                 
+    }
+    Mset P(zero);                                  // reset multipoles          
+    real dmax(zero);                               // reset d_max               
+    LoopLeafKids(cell_iter,Ci,l) {                 // LOOP sub-leafs s          
+      vect Xi = cofm(l); Xi-= com;                 //   distance vector         
+      update_max(dmax,norm(Xi));                   //   update d_max^2          
+      P.add_body(Xi,mass(l));                      //   add multipoles          
+    }                                              // END LOOP                  
+    if(has_leaf_kids(Ci)) dmax = sqrt(dmax);       // d_max due to sub-leafs    
+    LoopCellKids(cell_iter,Ci,c) {                 // LOOP sub-cells c          
+      vect Xi = cofm(c); Xi-= com;                 //   distance vector         
+      real Xq = norm(Xi);                          //   distance^2              
+      real x  = dmax - rmax(c);                    //   auxiliary               
+      if(zero>x || Xq>square(x))                   //   IF(d>d_max)             
+	dmax = sqrt(Xq) + rmax(c);                 //     set d_max = d         
+      P.add_cell(Xi,mass(c),poles(c));             //   add multipoles          
+    }                                              // END LOOP                  
+    Ci->rmax() = REUSE? dmax :                     // r_max=d_max               
+                 min(dmax,bmax(com,Ci));           // r_max=min(d_max,b_max)    
+    Ci->cofm() = com;                              // set dipole = mass*cofm    
+    Ci->poles()= P;                                // assign multipoles         
+    return is_active(Ci);
+  }
+#ifdef _OPENMP
+  //----------------------------------------------------------------------------
+  // end of the cell descendants of C: these are contiguous in memory, starting
+  // with C's kids, followed by the descendants of each kid in turn            
+  //----------------------------------------------------------------------------
+  inline cell_iter end_cell_desc(cell_iter C)
+  {
+    for(;;) {
+      cell_iter Ci = C.end_cell_kids();
+      while(Ci != C.begin_cell_kids() && !has_cell_kids(Ci-1)) --Ci;
+      if(Ci == C.begin_cell_kids()) return C.end_cell_kids();
+      C = Ci-1;
+    }
+  }
+  //----------------------------------------------------------------------------
+  // collect cells with more than Nmax bodies (in the order of the tree) and
+  // the sub-trees below them
+  //----------------------------------------------------------------------------
+  void split_cells(cell_iter const&C, unsigned Nmax,
+		   std::vector<cell_iter>&Top, std::vector<cell_iter>&Sub)
+  {
+    if(number(C) > Nmax && has_cell_kids(C)) {
+      Top.push_back(C);
+      LoopCellKids(cell_iter,C,c) split_cells(c,Nmax,Top,Sub);
+    } else
+      Sub.push_back(C);
+  }
+  //----------------------------------------------------------------------------
+  // pass_up_cell() for all cells of a tree using nt threads: the sub-trees
+  // are done in parallel, the cells above them thereafter; returns # active
+  //----------------------------------------------------------------------------
+  template<bool INDI_SOFT>
+  int pass_up_threaded(cell_iter const&root, unsigned nt, bool REUSE)
+  {
+    std::vector<cell_iter> Top,Sub;
+    split_cells(root,max(64u,number(root)/(8*nt)),Top,Sub);
+    int n=0, ns=Sub.size();
+#pragma omp parallel for schedule(dynamic,1) num_threads(nt) reduction(+:n)
+    for(int k=0; k<ns; ++k) {
+      const cell_iter &S=Sub[k];
+      if(has_cell_kids(S))
+	for(cell_iter Ci=end_cell_desc(S)-1; Ci>=S.begin_cell_kids(); --Ci)
+	  if(pass_up_cell<INDI_SOFT>(Ci,REUSE)) ++n;
+      if(pass_up_cell<INDI_SOFT>(S,REUSE)) ++n;
+    }
+    for(int k=int(Top.size())-1; k>=0; --k)
+      if(pass_up_cell<INDI_SOFT>(Top[k],REUSE)) ++n;
+    return n;
+  }
+#endif
   //////////////////////////////////////////////////////////////////////////////
   //                                                                            
   // class GravIactBase                                                         
@@ -359,6 +484,10 @@ namespace {
       direct(A,B);
     }
     //--------------------------------------------------------------------------
+    void direct_summation(cell_iter const&A, cell_iter const&B) const {
+      direct(A,B);
+    }
+    //--------------------------------------------------------------------------
     bool interact(cell_iter const&A) const {
       if(!is_active(A)) return true;               // no interaction -> DONE    
       if(do_direct(A)) {                           // IF(suitable)              
@@ -441,6 +570,16 @@ namespace {
       eval_grav(C,TaylorSeries(cofm(C)));          // start recursion           
     }
     //--------------------------------------------------------------------------
+    // evaluation phase split into tasks (multithreaded approx())               
+    //--------------------------------------------------------------------------
+    void flush() const { flush_buffers(); }
+    void evaluate_node(cell_iter const&C, TaylorSeries&T) const {
+      eval_node(C,T);
+    }
+    void evaluate(cell_iter const&C, TaylorSeries const&T) const {
+      eval_grav(C,T);
+    }
+    //--------------------------------------------------------------------------
     void set_sink(real e, real f)
     {
       reset_eps(e);
@@ -490,6 +629,10 @@ namespace {
       direct(A,B);
     }
     //--------------------------------------------------------------------------
+    void direct_summation(cell_iter const&A, cell_iter const&B) const {
+      direct(A,B);
+    }
+    //--------------------------------------------------------------------------
     bool interact(cell_iter const&A) const {
       if(do_direct(A)) {                           // IF(suitable)              
 	direct(A);                                 //   perform BB iactions     
@@ -568,6 +711,16 @@ namespace {
       eval_grav_all(C,TaylorSeries(cofm(C)));      // start recursion           
     }
     //--------------------------------------------------------------------------
+    // evaluation phase split into tasks (multithreaded approx())               
+    //--------------------------------------------------------------------------
+    void flush() const { flush_buffers(); }
+    void evaluate_node(cell_iter const&C, TaylorSeries&T) const {
+      eval_node_all(C,T);
+    }
+    void evaluate(cell_iter const&C, TaylorSeries const&T) const {
+      eval_grav_all(C,T);
+    }
+    //--------------------------------------------------------------------------
     void set_sink(real e, real f)
     {
       reset_eps(e);
@@ -580,6 +733,157 @@ namespace {
       RFAQ = one;
     }
   };
+#ifdef _OPENMP
+  //////////////////////////////////////////////////////////////////////////////
+  //                                                                          //
+  // class GravTasks                                                          //
+  //                                                                          //
+  // All interactions of the tree as a list of independent tasks, for the     //
+  // multithreaded interaction phase. Self-interactions of cells with more    //
+  // than NMAX bodies are split as in MutualInteractor<>, the root's as in    //
+  // GravEstimator::approx(). Tasks are sorted by estimated cost, biggest     //
+  // first, so that threads taking the next task end at about the same time. //
+  //                                                                          //
+  //////////////////////////////////////////////////////////////////////////////
+  struct GravTask {
+    enum type { CX, CC, CL, LX, RX };              // self, cell-cell, cell-leaf
+                                                   // leaf kids, root leaf kids 
+    type      T;                                   // type of task              
+    bool      S;                                   // C-L: with sink softening? 
+    cell_iter A,B;                                 // cell(s)                   
+    leaf_iter L;                                   // C-L: leaf                 
+    double    W;                                   // estimated cost            
+    friend bool operator<(GravTask const&x, GravTask const&y) {
+      return x.W > y.W;                            // biggest first             
+    }
+  };
+  //----------------------------------------------------------------------------
+  class GravTasks : public std::vector<GravTask> {
+    const bool     ALL, EXACT;                     // all active? exact?        
+    const unsigned NMAX, NDIR;                     // split if more; C-S direct 
+    //--------------------------------------------------------------------------
+    void add(GravTask::type t, cell_iter const&A, cell_iter const&B,
+	     leaf_iter L, bool s, double w) {
+      GravTask x;
+      x.T = t; x.S = s; x.A = A; x.B = B; x.L = L; x.W = w;
+      push_back(x);
+    }
+    //--------------------------------------------------------------------------
+    void pair(cell_iter const&A, cell_iter const&B) {
+      if(ALL || is_active(A) || is_active(B))
+	add(GravTask::CC,A,B,0,0,double(number(A))*double(number(B)));
+    }
+    //--------------------------------------------------------------------------
+    void pair(cell_iter const&A, leaf_iter const&L, bool s) {
+      if(ALL || is_active(A) || is_active(L))
+	add(GravTask::CL,A,cell_iter(),L,s,double(number(A)));
+    }
+    //--------------------------------------------------------------------------
+    void self(cell_iter const&C) {
+      if(!ALL && !is_active(C)) return;            // no interaction            
+      if(number(C) <= NMAX || is_twig(C) || number(C) < NDIR) {
+	add(GravTask::CX,C,cell_iter(),0,0,0.5*square(double(number(C))));
+	return;
+      }
+      if(nleafs(C) > 1)                            // sub L-L                   
+	add(GravTask::LX,C,cell_iter(),0,0,0.5*square(double(nleafs(C))));
+      LoopCellKids(cell_iter,C,c1) {               // LOOP cell kids            
+	self(c1);                                  //   sub C-X                 
+	LoopLeafKids(cell_iter,C,l2) pair(c1,l2,0);//   sub C-L                 
+	LoopCellSecd(cell_iter,C,c1+1,c2)          //   sub C-C                 
+	  pair(c1,c2);
+      }
+    }
+    //--------------------------------------------------------------------------
+  public:
+    GravTasks(cell_iter const&R,                   // I: root                   
+	      bool            all,                 // I: all active?            
+	      bool            exact,               // I: direct summation only? 
+	      unsigned        nmax,                // I: split self if more     
+	      unsigned        ndir) :              // I: C-S direct if fewer    
+      ALL(all), EXACT(exact), NMAX(nmax), NDIR(ndir)
+    {
+      LoopCellKids(cell_iter,R,c1) {
+	self(c1);
+	LoopCellSecd(cell_iter,R,c1+1,c2)
+	  pair(c1,c2);
+	LoopLeafKids(cell_iter,R,s2)
+	  pair(c1,s2,!EXACT && is_sink(s2));
+      }
+      if(nleafs(R) > 1)
+	add(GravTask::RX,R,cell_iter(),0,0,0.5*square(double(nleafs(R))));
+      std::sort(begin(),end());
+    }
+    //--------------------------------------------------------------------------
+    // perform task i with the interactor of the calling thread                 
+    template<typename IACT>
+    void perform(int i, IACT&GK, MutualInteractor<IACT> const&MI,
+		 real eps, real epssink, real fsink) const {
+      GravTask const&X((*this)[i]);
+      switch(X.T) {
+      case GravTask::CX:
+	if(EXACT) GK.direct_summation(X.A);
+	else      MI.cell_self(X.A);
+	break;
+      case GravTask::CC:
+	if(EXACT) GK.direct_summation(X.A,X.B);
+	else      MI.cell_cell(X.A,X.B);
+	break;
+      case GravTask::CL:
+	if(X.S) {                                  // sink: as in approx()      
+	  GK.set_sink(epssink,fsink);
+	  if(ALL) MI.cell_leaf(X.A,X.L);
+	  else    GK.direct_summation(X.A,X.L);
+	  GK.unset_sink(eps);
+	} else if(EXACT)
+	  GK.direct_summation(X.A,X.L);
+	else
+	  MI.cell_leaf(X.A,X.L);
+	break;
+      case GravTask::LX:
+	LoopLeafKids(cell_iter,X.A,l1)
+	  LoopLeafSecd(cell_iter,X.A,l1+1,l2)
+	    MI.leaf_leaf(l1,l2);
+	break;
+      case GravTask::RX:
+	LoopLeafKids(cell_iter,X.A,s1)
+	  LoopLeafSecd(cell_iter,X.A,s1+1,s2)
+	    if(ALL || is_active(s1) || is_active(s2)) {
+	      if(!EXACT && (is_sink(s1) || is_sink(s2))) {
+		GK.set_sink(epssink,fsink);
+		GK.interact(s1,s2);
+		GK.unset_sink(eps);
+	      } else
+		GK.interact(s1,s2);
+	    }
+	break;
+      }
+    }
+  };
+  //////////////////////////////////////////////////////////////////////////////
+  //                                                                          //
+  // SplitEvaluation()                                                        //
+  //                                                                          //
+  // evaluate the top of the tree, down to cells with no more than nmax       //
+  // bodies, which are left as independent tasks                              //
+  //                                                                          //
+  //////////////////////////////////////////////////////////////////////////////
+  typedef std::pair<cell_iter,TaylorSeries> EvalTask;
+  template<typename IACT>
+  void SplitEvaluation(IACT               const&EV,
+		       cell_iter          const&C,
+		       TaylorSeries             G,
+		       unsigned                 nmax,
+		       bool                     all,
+		       std::vector<EvalTask>   &ET)
+  {
+    EV.evaluate_node(C,G);
+    LoopCellKids(cell_iter,C,c) if(all || is_active(c)) {
+      if(number(c) > nmax) SplitEvaluation(EV,c,G,nmax,all,ET);
+      else                 ET.push_back(EvalTask(c,G));
+    }
+  }
+#endif // _OPENMP
   //////////////////////////////////////////////////////////////////////////////
   //                                                                          //
   // UpdateLeafs()                                                            //
@@ -740,125 +1044,52 @@ void GravEstimator::update_leafs()
 GravEstimator::~GravEstimator() {
   if(CELL_SRCE) falcON_DEL_A(CELL_SRCE);
   if(LEAF_ACPN) falcON_DEL_A(LEAF_ACPN);
+  if(CELL_COEF) falcON_DEL_A(CELL_COEF);
+}
+//------------------------------------------------------------------------------
+#ifdef _OPENMP
+falcON_GRAV_TLS int                  GravEstimator::Leaf::ACPN_SHIFT = 0;
+falcON_GRAV_TLS void               **GravEstimator::Cell::COEFFS     = 0;
+falcON_GRAV_TLS const GravEstimator::Cell*GravEstimator::Cell::CELL0 = 0;
+#endif
+//------------------------------------------------------------------------------
+unsigned GravEstimator::threads() const
+{
+#ifdef _OPENMP
+  unsigned n = NTHREADS? NTHREADS : unsigned(omp_get_max_threads());
+  return n? n : 1u;
+#else
+  return 1u;
+#endif
 }
 //------------------------------------------------------------------------------
 unsigned GravEstimator::pass_up(const GravMAC*MAC,
-				bool          REUSE)
+				bool          REUSE,
+				unsigned      nt)
 {
   // passes up: flag, mass, cofm, rmax[, eph], multipoles; sets rcrit           
   report REPORT("GravEstimator::pass_up_for_approx()");
   int n=0;                                         // counter: active cells     
+#ifdef _OPENMP
+  if(nt > 1)                                       // IF multithreaded          
+    n = INDI_SOFT?                                 //   pass up sub-trees in    
+      pass_up_threaded<1>(root(),nt,REUSE) :       //   parallel, then the top  
+      pass_up_threaded<0>(root(),nt,REUSE) ;       //   cells                   
+  else
+#endif
   if(INDI_SOFT) {                                  // IF(individual eps_i)      
     // 1    with eps_i: pass flag, mass, N*eps/2, cofm, rmax, multipoles
-#define MASS_WEIGHTED_SOFTENING 1
-    LoopCellsUp(grav::cell_iter,TREE,Ci) {         //   LOOP cells upwards      
-      Ci->reset_active_flag();                     //     reset activity flag   
-      Ci->reset_sink_flag();                       //     reset sink flag       
-      real eh (zero);                              //     reset eps/2           
-      real mon(zero);                              //     reset monopole        
-      vect com(zero);                              //     reset dipole          
-      LoopCellKids(cell_iter,Ci,c) {               //     LOOP sub-cells c      
-	eh  += eph (c) *
-#ifdef MASS_WEIGHTED_SOFTENING
-	    mass(c)                                //       sum up M * eps/2    
-#else
-	    number(c)
-#endif
-	    ;
-	mon += mass(c);                            //       sum up monopole     
-	com += mass(c) * cofm(c);                  //       sum up dipole       
-	Ci->add_active_flag(c);                    //       add in activity flag
-	Ci->add_sink_flag(c);                      //       add in sink flag    
-      }                                            //     END LOOP              
-      LoopLeafKids(cell_iter,Ci,l) {               //     LOOP sub-leafs s      
-#ifdef MASS_WEIGHTED_SOFTENING
-	eh  += mass(l) * eph(l);                   //       sum up M * eps/2    
-#else
-	eh  += eph (l);                            //       sum up eps/2        
-#endif
-	mon += mass(l);                            //       sum up monopole     
-	com += mass(l) * cofm(l);                  //       sum up dipole       
-	Ci->add_active_flag(l);                    //       add in activity flag
-	Ci->add_sink_flag(l);                      //       add in sink flag    
-      }                                            //     END LOOP              
-      if(is_active(Ci)) n++;                       //     count active cells    
-      Ci->mass() = mon;                            //     set mass              
-      mon        = (mon==zero)? zero:one/mon;      //     1/mass                
-      com       *= mon;                            //     cofm = dipole/mass    
-#ifdef MASS_WEIGHTED_SOFTENING
-      eh        /= mass(Ci);                       //     mean eps/2            
-#else
-      eh        /= number(Ci);                     //     mean eps/2            
-#endif
-      Ci->eph()  = eh;                             //     set eps/2             
-      Mset P(zero);                                //     reset multipoles      
-      real dmax(zero);                             //     reset d_max           
-      LoopLeafKids(cell_iter,Ci,l) {               //     LOOP sub-leafs s      
-	vect Xi = cofm(l); Xi-= com;               //       distance vector     
-	update_max(dmax,norm(Xi));                 //       update d_max^2      
-	P.add_body(Xi,mass(l));                    //       add multipoles      
-      }                                            //     END LOOP              
-      if(has_leaf_kids(Ci)) dmax = sqrt(dmax);     //     d_max due to sub-leafs
-      LoopCellKids(cell_iter,Ci,c) {               //     LOOP sub-cells c      
-	vect Xi = cofm(c); Xi-= com;               //       distance vector     
-	real Xq = norm(Xi);                        //       distance^2          
-	real x  = dmax - rmax(c);                  //       auxiliary           
-	if(zero>x || Xq>square(x))                 //       IF(d>d_max)         
-	  dmax = sqrt(Xq) + rmax(c);               //         set d_max = d     
-	P.add_cell(Xi,mass(c),poles(c));           //       add multipoles      
-      }                                            //     END LOOP              
-      Ci->rmax() = REUSE? dmax :                   //     r_max=d_max           
-	           min(dmax,bmax(com,Ci));         //     r_max=min(d_max,b_max)
-      Ci->cofm() = com;                            //     set dipole = mass*cofm
-      Ci->poles()= P;                              //     assign multipoles     
-    }                                              //   END LOOP                
+    LoopCellsUp(grav::cell_iter,TREE,Ci)           //   LOOP cells upwards      
+      if(pass_up_cell<1>(Ci,REUSE)) n++;           //     pass up, count active 
   } else {                                         // ELSE (no individual eps)  
     // 2    without eps_i: pass flag, mass, cofm, rmax, multipoles              
-    LoopCellsUp(grav::cell_iter,TREE,Ci) {         //   LOOP cells upwards      
-      Ci->reset_active_flag();                     //     reset activity flag   
-      Ci->reset_sink_flag();                       //     reset sink flag       
-      real mon(zero);                              //     reset monopole        
-      vect com(zero);                              //     reset dipole          
-      LoopCellKids(cell_iter,Ci,c) {               //     LOOP sub-cells c      
-	mon += mass(c);                            //       sum up monopole     
-	com += mass(c) * cofm(c);                  //       sum up dipole       
-	Ci->add_active_flag(c);                    //       add in activity flag
-	Ci->add_sink_flag(c);                      //       add in sink flag    
-      }                                            //     END LOOP              
-      LoopLeafKids(cell_iter,Ci,l) {               //     LOOP sub-leafs s      
-	mon += mass(l);                            //       sum up monopole     
-	com += mass(l) * cofm(l);                  //       sum up dipole       
-	Ci->add_active_flag(l);                    //       add in activity flag
-	Ci->add_sink_flag(l);                      //       add in sink flag    
-      }                                            //     END LOOP              
-      if(is_active(Ci)) n++;                       //     count active cells    
-      Ci->mass() = mon;                            //     set mass              
-      mon        = (mon==zero)? zero:one/mon;      //     1/mass                
-      com       *= mon;                            //     cofm = dipole/mass    
-      Mset P(zero);                                //     reset multipoles      
-      real dmax(zero);                             //     reset d_max           
-      LoopLeafKids(cell_iter,Ci,l) {               //     LOOP sub-leafs s      
-	vect Xi = cofm(l); Xi-= com;               //       distance vector     
-	update_max(dmax,norm(Xi));                 //       update d_max^2      
-	P.add_body(Xi,mass(l));                    //       add multipoles      
-      }                                            //     END LOOP              
-      if(has_leaf_kids(Ci)) dmax = sqrt(dmax);     //     d_max due to sub-leafs
-      LoopCellKids(cell_iter,Ci,c) {               //     LOOP sub-cells c      
-	vect Xi = cofm(c); Xi-= com;               //       distance vector     
-	real Xq = norm(Xi);                        //       distance^2          
-	real x  = dmax - rmax(c);                  //       auxiliary           
-	if(zero>x || Xq>square(x))                 //       IF(d>d_max)         
-	  dmax = sqrt(Xq) + rmax(c);               //         set d_max = d     
-	P.add_cell(Xi,mass(c),poles(c));           //       add multipoles      
-      }                                            //     END LOOP              
-      Ci->rmax() = REUSE? dmax :                   //     r_max=d_max           
-	           min(dmax,bmax(com,Ci));         //     r_max=min(d_max,b_max)
-      Ci->cofm() = com;                            //     set dipole = mass*cofm
-      Ci->poles()= P;                              //     assign multipoles     
-    }                                              //   END LOOP                
+    LoopCellsUp(grav::cell_iter,TREE,Ci)           //   LOOP cells upwards      
+      if(pass_up_cell<0>(Ci,REUSE)) n++;           //     pass up, count active 
   }                                                // ENDIF                     
   // 3  normalize multipoles                                                    
-  for(unsigned i=0; i!=TREE->N_cells(); ++i)       // LOOP cell sources         
+  const int nc=TREE->N_cells();
+#pragma omp parallel for if(nt > 1) num_threads(nt)
+  for(int i=0; i<nc; ++i)                          // LOOP cell sources         
     CELL_SRCE[i].normalize_poles();                //   normalize multipoles    
   // 4  set rcrit                                                               
   if(MAC) MAC->set_rcrit(this);                    // set r_crit for all cells  
@@ -866,7 +1097,8 @@ unsigned GravEstimator::pass_up(const GravMAC*MAC,
 }
 //------------------------------------------------------------------------------
 bool GravEstimator::prepare(const GravMAC*MAC,
-			    bool          al)
+			    bool          al,
+			    unsigned      nt)
 {
   SET_I
   if(al) NLA_needed = TREE->N_leafs();             // all leafs are active      
@@ -875,10 +1107,12 @@ bool GravEstimator::prepare(const GravMAC*MAC,
     return 1;
   }
   //  - allocate memory for leaf acc/pot/num properties for active leafs        
-  if(NLA!=NLA_needed) {                            // IF #active leafs changed  
+  //    with a copy for each thread                                             
+  if(NLA!=NLA_needed || NLT<nt) {                  // IF #active leafs changed  
     if(LEAF_ACPN) falcON_DEL_A(LEAF_ACPN);         //   delete old allocation   
     NLA = NLA_needed;                              //   # new allocation        
-    LEAF_ACPN=falcON_NEW(Leaf::acpn_data,NLA);     //   allocate memory         
+    NLT = nt;                                      //   # copies                
+    LEAF_ACPN=falcON_NEW(Leaf::acpn_data,NLA*NLT); //   allocate memory         
   }                                                // ENDIF                     
   const bool all = al || NLA==TREE->N_leafs();     // are all active?           
   Leaf::acpn_data*si=LEAF_ACPN;                    // pter to leafs' acpn data  
@@ -910,7 +1144,7 @@ bool GravEstimator::prepare(const GravMAC*MAC,
       Ci->resetCoeffs();                           //     reset cell: Coeffs    
     }                                              //   END LOOP                
     //    - pass source properties up the tree, count active cells              
-    NCA = pass_up(MAC,TREE->is_re_used());         //   pass source data up tree
+    NCA = pass_up(MAC,TREE->is_re_used(),nt);      //   pass source data up tree
     if(debug(11)) {
       std::ofstream dump;
       dump.open("/tmp/leafs");
@@ -949,7 +1183,8 @@ void GravEstimator::exact(bool       al
 #ifdef falcON_ADAP
   adjust_eph(al,Nsoft,emin,EPS,Nref,efac);
 #endif
-  const bool all = prepare(0,al);
+  const unsigned nt = threads();
+  const bool all = prepare(0,al,nt);
   if(N_active_cells()==0)
     return falcON_Warning("GravEstimator::exact(): nobody active");
   STATS->reset(
@@ -959,6 +1194,19 @@ void GravEstimator::exact(bool       al
                );
   if(TREE->my_bodies()->N_bodies(bodytype::sink) && EPSSINK != EPS)
     falcON_Warning("GravEstimator::exact(): will ignore eps_sink\n");
+#ifdef _OPENMP
+  if(nt > 1) {
+#ifdef falcON_ADAP
+    const bool U = INDI_SOFT && Nsoft;
+#else
+    const bool U = 0;
+#endif
+    if(all) threaded<GravIactAll>(1,1,nt,U);
+    else    threaded<GravIact   >(0,1,nt,U);
+    TREE->mark_grav_usage();
+    return;
+  }
+#endif
   if(all) {
     GravIactAll K(KERNEL,STATS,EPS,0,INDI_SOFT);
     K.direct_summation(root());
@@ -1006,7 +1254,8 @@ void GravEstimator::approx(const GravMAC*GMAC,
   SET_T(" time: GravEstimator::adjust_eph():    ");
 #endif
   // prepare tree: allocate memory (leafs & cells), pass up source, count active
-  const bool all = prepare(GMAC,al);
+  const unsigned nt = threads();
+  const bool all = prepare(GMAC,al,nt);
   if(!all && N_active_cells()==0)
     return falcON_Warning("[GravEstimator::approx()]: nobody active");
   SET_T(" time: GravEstimator::prepare():       ");
@@ -1017,6 +1266,20 @@ void GravEstimator::approx(const GravMAC*GMAC,
 #endif
                );
   Ncsize = 4+(all? TREE->N_cells() : N_active_cells())/16;
+#ifdef _OPENMP
+  if(nt > 1) {                                     // IF multithreaded          
+#ifdef falcON_ADAP
+    const bool U = INDI_SOFT && Nsoft;
+#else
+    const bool U = 0;
+#endif
+    if(all) threaded<GravIactAll>(1,0,nt,U);       //   interaction, evaluation 
+    else    threaded<GravIact   >(0,0,nt,U);       //   & update bodies         
+    TREE->mark_grav_usage();
+    SET_T(" time: multithreaded gravity:           ");
+    return;
+  }                                                // ENDIF                     
+#endif
   if(all) {                                        // IF all are active         
     GravIactAll GK(KERNEL,STATS,EPS,Ncsize,INDI_SOFT,DIR);
                                                    //   init gravity kernel     
@@ -1126,6 +1389,130 @@ void GravEstimator::approx(const GravMAC*GMAC,
   TREE->mark_grav_usage();
   SET_T(" time: updating bodies gravity:         ");
 }
+#ifdef _OPENMP
+//------------------------------------------------------------------------------
+// multithreaded version of the interaction & evaluation phases and updating   
+// of the bodies, called from exact() and approx() after prepare().            
+//                                                                              
+// The interactions are split into tasks (class GravTasks), which the threads  
+// take one after the other, biggest first. Each thread accumulates its        
+// interactions into its own copy of the leafs' acc & pot (leaf memory is      
+// allocated by prepare() for all threads) and cells' Taylor coefficients      
+// (pointers in CELL_COEF to its own pool); thread 0 uses the ordinary ones.   
+// These copies are then added up, in parallel over leafs and cells. Finally,  
+// the evaluation phase is split into tasks at cells with no more than about   
+// N/(16 T) bodies. Its kernels have no pool, so the cells' coeffs, which come  
+// from all threads' pools, are not freed until these are destroyed at the end.
+//------------------------------------------------------------------------------
+template<typename IACT>
+void GravEstimator::threaded(bool     all,
+			     bool     exact,
+			     unsigned nt,
+			     bool
+#ifdef falcON_ADAP
+			     U
+#endif
+			     )
+{
+  const int       NL   = TREE->N_leafs();
+  const int       NC   = TREE->N_cells();
+  const unsigned  NMAX = max(64u, TREE->N_leafs()/(16*nt));
+  Leaf*const      L0   = static_cast<Leaf*>(TREE->FstLeaf());
+  Cell*const      C0   = static_cast<Cell*>(TREE->FstCell());
+  const bodies*   B    = TREE->my_bodies();
+  const GravTasks TL(root(),all,exact,NMAX,exact? 0u : DIR[3]);
+  if(!exact && NCC < (nt-1)*NC) {                  // other threads' coeffs     
+    if(CELL_COEF) falcON_DEL_A(CELL_COEF);
+    NCC       = (nt-1)*NC;
+    CELL_COEF = falcON_NEW(void*,NCC);
+  }
+  GravStats*ST = falcON_NEW(GravStats,nt);
+  for(unsigned t=0; t!=nt; ++t)
+    ST[t].reset(
+#ifdef WRITE_IACTION_INFO
+		TREE
+#endif
+		);
+  CheckMissingBodyData(B,fieldset::a|fieldset::p);
+#ifdef falcON_ADAP
+  if(U) CheckMissingBodyData(B,fieldset::e);
+#endif
+  std::vector<EvalTask> ET;
+  int nc=0, nk=0;
+#pragma omp parallel num_threads(nt) reduction(+:nc,nk)
+  {
+    const int T = omp_get_num_threads();
+    const int t = omp_get_thread_num();
+    // 1 interaction phase into this thread's copy of leafs' & cells' data
+    IACT GK(KERNEL,ST+t,EPS,exact? 0u:Ncsize,INDI_SOFT,DIR);
+    MutualInteractor<IACT> MI(&GK,TREE->depth()-1);
+    if(t) {
+      for(Leaf::acpn_data*a=LEAF_ACPN+t*NLA; a!=LEAF_ACPN+(t+1)*NLA; ++a)
+	a->reset();
+      Leaf::ACPN_SHIFT = t*NLA;
+      if(!exact) {
+	Cell::COEFFS = CELL_COEF+(t-1)*NC;
+	Cell::CELL0  = C0;
+	for(int i=0; i!=NC; ++i) Cell::COEFFS[i] = 0;
+      }
+    }
+#pragma omp for schedule(dynamic,1)
+    for(int i=0; i<int(TL.size()); ++i)
+      TL.perform(i,GK,MI,EPS,EPSSINK,FSINK);
+    GK.flush();
+    Leaf::ACPN_SHIFT = 0;
+    Cell::COEFFS     = 0;
+    nc += GK.coeffs_used();
+    nk += GK.chunks_used();
+    // 2 add up the threads' contributions (implicit barrier before)
+#pragma omp for schedule(static)
+    for(int i=0; i<int(NLA); ++i)
+      for(int s=1; s<T; ++s)
+	LEAF_ACPN[i] += LEAF_ACPN[s*NLA+i];
+    if(exact) {
+#pragma omp for schedule(static)
+      for(int i=0; i<NL; ++i)
+	if(all || is_active(L0+i)) L0[i].normalize_grav();
+    } else {
+#pragma omp for schedule(static)
+      for(int i=0; i<NC; ++i)
+	for(int s=1; s<T; ++s) {
+	  Cell::Cset*X = static_cast<Cell::Cset*>(CELL_COEF[(s-1)*NC+i]);
+	  if(X) {
+	    if(C0[i].hasCoeffs()) C0[i].Coeffs() += *X;
+	    else                  C0[i].setCoeffs(X);
+	  }
+	}
+      // 3 evaluation phase
+      IACT EV(KERNEL,ST+t,EPS,0u,INDI_SOFT,DIR);
+#pragma omp single
+      SplitEvaluation(EV,root(),TaylorSeries(cofm(root())),NMAX,all,ET);
+#pragma omp for schedule(dynamic,1)
+      for(int i=0; i<int(ET.size()); ++i)
+	EV.evaluate(ET[i].first,ET[i].second);
+#pragma omp for schedule(static)
+      for(int i=0; i<NC; ++i)
+	C0[i].resetCoeffs();
+    }
+    // 4 update bodies' gravity
+#pragma omp for schedule(static)
+    for(int i=0; i<NL; ++i) if(all || is_active(L0+i)) {
+#ifdef falcON_ADAP
+      if(U) L0[i].copy_to_bodies_eps(B);
+#endif
+      if(GRAV!=one) L0[i].copy_to_bodies_grav(B,GRAV);
+      else          L0[i].copy_to_bodies_grav(B);
+    }
+  }
+  for(unsigned t=0; t!=nt; ++t)
+    STATS->add(ST[t]);
+  falcON_DEL_A(ST);
+  if(!exact) {
+    Ncoeffs = nc;
+    Nchunks = nk;
+  }
+}
+#endif // _OPENMP
 //------------------------------------------------------------------------------
 namespace {
   using namespace falcON;
@@ -5,7 +5,7 @@
 //
 /// \brief   implements inc/public/kernel.h
 /// \author  Walter Dehnen
-/// \date    2000-2010,2012
+/// \date    2000-2010,2012,2026
 //
 // /////////////////////////////////////////////////////////////////////////////
 //
@@ -121,30 +121,42 @@ extract_grav(leaf_iter const&L) const {            // I: leaf to get grav to
 // class falcON::GravKernBase                                                   
 //                                                                              
 ////////////////////////////////////////////////////////////////////////////////
-void GravKernBase::eval_grav(cell_iter    const&C,
-			     TaylorSeries const&T) const
+inline void GravKernBase::eval_node(cell_iter const&C,
+				    TaylorSeries   &G) const
 {
-  TaylorSeries G(T);                               // G = copy of T             
   G.shift_and_add(C);                              // shift G; G+=T_C           
   take_coeffs(C);                                  // free memory: C's coeffs   
   LoopLeafKids(cell_iter,C,l) if(is_active(l)) {   // LOOP C's active leaf kids 
     l->normalize_grav();                           //   pot,acc/=mass           
     if(!is_empty(G)) G.extract_grav(l);            //   add pot,acc due to G    
   }                                                // END LOOP                  
-  LoopCellKids(cell_iter,C,c) if(is_active(c))     // LOOP C's active cell kids 
-    eval_grav(c,G);                                //   recursive call          
 }
 //------------------------------------------------------------------------------
-void GravKernBase::eval_grav_all(cell_iter    const&C,
-				 TaylorSeries const&T) const
+inline void GravKernBase::eval_node_all(cell_iter const&C,
+					TaylorSeries   &G) const
 {
-  TaylorSeries G(T);                               // G = copy of T             
   G.shift_and_add(C);                              // shift G; G+=T_C           
   take_coeffs(C);                                  // free memory: C's coeffs   
   LoopLeafKids(cell_iter,C,l) {                    // LOOP C's leaf kids        
     l->normalize_grav();                           //   pot,acc/=mass           
     if(!is_empty(G)) G.extract_grav(l);            //   add pot,acc due to G    
   }                                                // END LOOP                  
+}
+//------------------------------------------------------------------------------
+void GravKernBase::eval_grav(cell_iter    const&C,
+			     TaylorSeries const&T) const
+{
+  TaylorSeries G(T);                               // G = copy of T             
+  eval_node(C,G);                                  // C's coeffs & leaf kids    
+  LoopCellKids(cell_iter,C,c) if(is_active(c))     // LOOP C's active cell kids 
+    eval_grav(c,G);                                //   recursive call          
+}
+//------------------------------------------------------------------------------
+void GravKernBase::eval_grav_all(cell_iter    const&C,
+				 TaylorSeries const&T) const
+{
+  TaylorSeries G(T);                               // G = copy of T             
+  eval_node_all(C,G);                              // C's coeffs & leaf kids    
   LoopCellKids(cell_iter,C,c)                      // LOOP C's cell kids        
     eval_grav_all(c,G);                            //   recursive call          
 }
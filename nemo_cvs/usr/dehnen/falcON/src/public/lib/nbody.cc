@@ -944,7 +944,7 @@ void ForceALCON::set_tree_and_forces(bool all, bool build_tree) const
   }
   // 3 compute external gravity
   if(acc_ext()) {
-    acc_ext() -> set(snap_shot(), all, SELF_GRAV? 2 : 0);
+    acc_ext() -> set(snap_shot(), all, SELF_GRAV? 2 : 0, FALCON.threads());
     Integrator::record_cpu(cpu,CPU_AEX);           // record CPU consumption    
   }
 }
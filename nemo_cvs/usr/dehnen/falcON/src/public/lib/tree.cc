@@ -5,11 +5,11 @@
 ///                                                                             
 /// \author  Walter Dehnen                                                      
 ///                                                                             
-/// \date    2000-2010                                                          
+/// \date    2000-2010,2026                                                     
 ///                                                                             
 ////////////////////////////////////////////////////////////////////////////////
 //                                                                              
-// Copyright (C) 2000-2010  Walter Dehnen                                       
+// Copyright (C) 2000-2010,2026  Walter Dehnen                                  
 //                                                                              
 // This program is free software; you can redistribute it and/or modify         
 // it under the terms of the GNU General Public License as published by         
@@ -31,6 +31,10 @@
 #include <memory.h>
 #include <body.h>
 #include <sstream>
+#include <radix.h>
+#ifdef _OPENMP
+#  include <vector>
+#endif
 
 #ifdef  falcON_PROPER
 #  define falcON_track_bug
@@ -355,6 +359,7 @@ namespace {
     //--------------------------------------------------------------------------
     bool marked_as_box  (int const&i) const { return TYPE & (1<<i); }
     bool marked_as_dot  (int const&i) const { return !marked_as_box(i); }
+    bool marked_as_task ()            const { return TYPE & (1<<Nsub); }
     vect const&centre   ()            const { return pos(); }
 #if 0 // not used
     /// octant of position \e x within box (not checked)
@@ -384,6 +389,7 @@ namespace {
     // non-const methods                                                        
     //--------------------------------------------------------------------------
     void mark_as_box(int const&i) { TYPE |=  (1<<i); }
+    void mark_as_task()           { TYPE |=  (1<<Nsub); }
     vect&centre     ()            { return pos(); }
     //--------------------------------------------------------------------------
     box& reset_octants() {
@@ -473,12 +479,69 @@ namespace {
       }
     }
   }
+  //////////////////////////////////////////////////////////////////////////////
+  //                                                                          //
+  // Morton ordering of dots                                                  //
+  //                                                                          //
+  // dots are sorted by their Morton (Z-order) key on a grid of 1024^3 over   //
+  // their extent, such that dots near in space are also near in memory, and  //
+  // adding them to the box-dot tree accesses the boxes in much the same order//
+  //                                                                          //
+  //////////////////////////////////////////////////////////////////////////////
+  using WDutils::uint32_t;
+  struct morton {
+    uint32_t KEY;                                  // Morton key                
+    dot     *DOT;                                  // dot                       
+  };
+  // traits for WDutils::Radix::SortBits<>
+  struct morton_traits {
+    typedef morton   input_type;
+    typedef uint32_t integer_type;
+    static integer_type integer(morton const&m) { return m.KEY; }
+  };
+  //----------------------------------------------------------------------------
+  // the lowest 10 bits of i spread to every third bit                          
+  //----------------------------------------------------------------------------
+  inline uint32_t spread_bits(uint32_t i) {
+    i &= 0x3ff;
+    i  = (i | (i<<16)) & 0x030000ff;
+    i  = (i | (i<< 8)) & 0x0300f00f;
+    i  = (i | (i<< 4)) & 0x030c30c3;
+    i  = (i | (i<< 2)) & 0x09249249;
+    return i;
+  }
 } // namespace {
 ////////////////////////////////////////////////////////////////////////////////
 falcON_TRAITS(::dot,"{tree.cc}::dot");
 falcON_TRAITS(::box,"{tree.cc}::box");
+falcON_TRAITS(::morton,"{tree.cc}::morton");
 ////////////////////////////////////////////////////////////////////////////////
 namespace {
+  //----------------------------------------------------------------------------
+  // sort the dots [D,DN[ with positions in [xmin,xmax] by their Morton keys,   
+  // whose bits are ordered like octants, using a stable radix sort             
+  //----------------------------------------------------------------------------
+  void morton_order(dot*D, dot*DN, vect const&xmin, vect const&xmax)
+  {
+    const unsigned N = DN-D;
+    real s = zero;
+    LoopDims update_max(s,xmax[d]-xmin[d]);
+    if(N < 2 || s <= zero) return;
+    const real f = real(1023.99)/s;
+    morton*M = falcON_NEW(morton,N+N);
+    for(unsigned i=0; i!=N; ++i) {
+      uint32_t k = 0;
+      LoopDims k |= spread_bits(uint32_t(f*(D[i].pos()[d]-xmin[d]))) << d;
+      M[i].KEY = k;
+      M[i].DOT = D+i;
+    }
+    WDutils::Radix::SortBits<32,morton_traits>::sort(N,M,M+N);
+    dot*T = falcON_NEW(dot,N);
+    for(unsigned i=0; i!=N; ++i) T[i] = *(M[i].DOT);
+    for(unsigned i=0; i!=N; ++i) D[i] = T[i];
+    falcON_DEL_A(T);
+    falcON_DEL_A(M);
+  }
   //////////////////////////////////////////////////////////////////////////////
   //                                                                          //
   // class falcON::estimate_N_alloc                                           //
@@ -779,6 +842,27 @@ namespace {
 #endif
     }
     //--------------------------------------------------------------------------
+    // to be called instead of reset() for adding dots to box P of tree T.      
+    // Only the boxes below P are allocated here, so that several such trees    
+    // can be built in parallel, each below another box of T.                   
+    void reset_sub(const BoxDotTree*T,             // I: tree owning P          
+		   box          *P,                // I: root box               
+		   size_t        nl)               // I: N_dots                 
+    {
+      NCRIT    = T->NCRIT;
+      DMAX     = T->DMAX;
+      NDOTS    = nl;
+      if(BM) falcON_DEL_O(BM);
+      BM       = new block_alloc<box>(1+NDOTS/4);
+      TREE     = T->TREE;
+      if(RA) falcON_DEL_A(RA);
+      RA       = falcON_NEW(real,DMAX+1);
+      for(int l=0; l<=DMAX; ++l) RA[l] = T->RA[l];
+      P0       = P;
+      D0       = T->D0;
+      DN       = T->DN;
+    }
+    //--------------------------------------------------------------------------
     ~BoxDotTree()
     {
       if(BM) falcON_DEL_O(BM);
@@ -964,11 +1048,71 @@ namespace {
     dep++;                                         // increment depth           
     return dep;                                    // return cell's depth       
   }
+#ifdef _OPENMP
+  //////////////////////////////////////////////////////////////////////////////
+  //
+  // class falcON::SubBoxDotTree
+  //
+  // for building the box-dot tree below a box at the top of another one and
+  // linking it to the cell-leaf tree. Several of these can work in parallel.
+  //
+  //////////////////////////////////////////////////////////////////////////////
+  class SubBoxDotTree : public BoxDotTree {
+    SubBoxDotTree           (const SubBoxDotTree&);// not implemented
+    SubBoxDotTree& operator=(const SubBoxDotTree&);// not implemented
+    //--------------------------------------------------------------------------
+    // data of class SubBoxDotTree
+    //--------------------------------------------------------------------------
+    dot           *DB, *DE;                        // dots to be added
+    int            OCT, KEY;                       // octant, peano key of root
+    OctTree::Cell *C, *CF;                         // root's cell, free cells
+    OctTree::Leaf *LF;                             // free leafs
+    //--------------------------------------------------------------------------
+    // public methods
+    //--------------------------------------------------------------------------
+  public:
+    // dots [b,e[ are to be added to box P of tree T
+    SubBoxDotTree(const BoxDotTree*T, box*P, dot*b, dot*e)
+      : DB(b), DE(e), OCT(0), KEY(0), C(0), CF(0), LF(0) {
+      reset_sub(T,P,size_t(e-b));
+    }
+    //--------------------------------------------------------------------------
+    box*const&root() const { return P0; }
+    //--------------------------------------------------------------------------
+    // add the dots to the box-dot tree
+    void build() {
+      size_t nl=0;
+      if(Ncrit() > 1)
+	for(dot*Di=DB; Di!=DE; ++Di,++nl) adddot_N(P0,Di,nl);
+      else
+	for(dot*Di=DB; Di!=DE; ++Di,++nl) adddot_1(P0,Di,nl);
+    }
+    //--------------------------------------------------------------------------
+    // the root is to be linked to cell c in octant o, its descendants to the
+    // free cells from cf and free leafs from lf
+    void set_link(int o, int k, OctTree::Cell*c,
+		  OctTree::Cell*cf, OctTree::Leaf*lf) {
+      OCT = o; KEY = k; C = c; CF = cf; LF = lf;
+    }
+    //--------------------------------------------------------------------------
+    // link the box-dot tree to the cell-leaf tree
+    void link() {
+#ifdef falcON_track_bug
+      LEND  = EndLeaf(TREE);
+      CEND  = EndCell(TREE);
+#endif
+      DEPTH = Ncrit() > 1?
+	link_cells_N(P0,OCT,KEY,C,CF,LF) :
+	link_cells_1(P0,OCT,KEY,C,CF,LF) ;
+    }
+  };
+#endif
   //////////////////////////////////////////////////////////////////////////////
   //                                                                            
   // class falcON::TreeBuilder                                                  
   //                                                                            
-  // for serial tree-building                                                   
+  // for tree-building, serial or, with OpenMP, in parallel below the top of
+  // the tree
   //                                                                            
   //////////////////////////////////////////////////////////////////////////////
   class TreeBuilder : public BoxDotTree {
@@ -981,6 +1125,38 @@ namespace {
     const bool  OUT;                               // # put sink in root only?
     size_t      NOUT;                              // # dots only in root
     vect        XAVE, XMIN, XMAX;                  // extreme positions         
+    const unsigned NT;                             // # threads
+#ifdef _OPENMP
+    std::vector<SubBoxDotTree*> SUBS;              // trees below top boxes
+    dot        *DT;                                // dots: temporary storage
+    //--------------------------------------------------------------------------
+    // RECURSIVE
+    // sorts dots into the octants of a branch box: octants with one dot hold
+    // it, octants with up to Ncrit dots become twig boxes, octants with more
+    // than Nmax dots become branch boxes split further, and all others boxes
+    // whose dots are added later by a SubBoxDotTree.
+    void split_top(box*,                           // I: branch box to split
+		   dot*,                           // I: first dot in box
+		   dot*,                           // I: end of dots in box
+		   size_t);                        // I: Nmax
+    //--------------------------------------------------------------------------
+    // the box-dot tree is split at the top, the trees below are built in
+    // parallel
+    void build_parallel();
+    //--------------------------------------------------------------------------
+    // RECURSIVE
+    // as link_cells_N(), but for the top of the box-dot tree: the boxes of
+    // the SubBoxDotTrees are only allotted cells and leafs, which these link
+    // later in parallel
+    int link_top(                                  // R:   tree depth of cell
+		 const box*     ,                  // I:   current box
+		 int            ,                  // I:   octant of current box
+		 int            ,                  // I:   local peano key
+		 OctTree::Cell* ,                  // I:   current cell
+		 OctTree::Cell*&,                  // I/O: index: free cells
+		 OctTree::Leaf*&,                  // I/O: index: free leafs
+		 unsigned      &);                 // I/O: index: SubBoxDotTrees
+#endif
     //--------------------------------------------------------------------------
     // This routines returns the root centre nearest to the mean position       
     inline vect root_centre() {
@@ -1039,6 +1215,18 @@ namespace {
       OctTree::Cell*C0 = FstCell(TREE), *Cf=C0+1;
       OctTree::Leaf*Lf = FstLeaf(TREE) + NOUT;
       pacell_(C0) = OctTree::Cell::INVALID;
+#ifdef _OPENMP
+      if(!SUBS.empty()) {
+	unsigned ns=0;
+	DEPTH = link_top(P0,0,0,C0,Cf,Lf,ns);
+	const int n = SUBS.size();
+#pragma omp parallel for schedule(dynamic,1) num_threads(NT)
+	for(int k=0; k<n; ++k)
+	  SUBS[k]->link();
+	for(int k=0; k!=n; ++k)
+	  update_max(DEPTH, SUBS[k]->root()->LEVEL + SUBS[k]->depth());
+      } else
+#endif
       DEPTH = NCRIT > 1?
 	link_cells_N(P0,0,0,C0,Cf,Lf) :
 	link_cells_1(P0,0,0,C0,Cf,Lf) ;
@@ -1059,6 +1247,16 @@ namespace {
       }
     }
     //--------------------------------------------------------------------------
+    // # boxes, including those of the SubBoxDotTrees
+    size_t N_boxes() const {
+      size_t n = BoxDotTree::N_boxes();
+#ifdef _OPENMP
+      for(unsigned k=0; k!=SUBS.size(); ++k)
+	n += SUBS[k]->N_boxes();
+#endif
+      return n;
+    }
+    //--------------------------------------------------------------------------
     // constructors of class TreeBuilder                                        
     //--------------------------------------------------------------------------
     // 1   completely from scratch                                              
@@ -1092,6 +1290,10 @@ namespace {
     //--------------------------------------------------------------------------
     inline ~TreeBuilder()  {
       falcON_DEL_A(D0);
+#ifdef _OPENMP
+      for(unsigned k=0; k!=SUBS.size(); ++k)
+	falcON_DEL_O(SUBS[k]);
+#endif
     }
     //--------------------------------------------------------------------------
   };
@@ -1101,6 +1303,10 @@ namespace {
   void TreeBuilder::build()
   {
     report REPORT("TreeBuilder::build()");
+#ifdef _OPENMP
+    if(NT > 1 && size_t(DN-D0) > NOUT+64*NT)       // IF multithreaded
+      return build_parallel();                     //   build in parallel
+#endif
     size_t nl=0;                                   // counter: # dots added     
     dot   *Di;                                     // actual dot loaded         
     if(Ncrit() > 1)                                // IF(N_crit > 1)            
@@ -1110,6 +1316,131 @@ namespace {
       for(Di=D0+NOUT; Di!=DN; ++Di,++nl)           //   LOOP(dots)              
 	adddot_1(P0,Di,nl);                        //     add dots              
   }
+#ifdef _OPENMP
+  //----------------------------------------------------------------------------
+  void TreeBuilder::split_top(box*P, dot*b, dot*e, size_t Nmax)
+  {
+    int NUM[Nsub]={0};                             // # dots per octant
+    dot*Do[Nsub];                                  // begin of dots per octant
+    for(dot*Di=b; Di!=e; ++Di) ++NUM[P->octant(Di)];
+    Do[0] = DT + (b-D0);                           // sort dots into octants,
+    for(int i=1; i!=Nsub; ++i) Do[i] = Do[i-1]+NUM[i-1];
+    for(dot*Di=b; Di!=e; ++Di) *(Do[P->octant(Di)]++) = *Di;
+    for(dot*Di=b,*Dt=DT+(b-D0); Di!=e; ++Di,++Dt) *Di = *Dt;
+    dot*Di=b;                                      // keeping their order
+    for(int i=0; i!=Nsub; Di+=NUM[i++]) {          // LOOP octants
+      if(NUM[i] == 0) continue;                    //   empty: nothing to do
+      if(NUM[i] == 1) {                            //   single dot:
+	P->OCT[i] = Di;                            //     put in octant
+	continue;                                  //     done
+      }                                            //   ELSE
+      box*sub = make_subbox(P,i,size_t(Di-D0),Di,0);
+      P->OCT[i] = sub;                             //     set octant=sub-box
+      P->mark_as_box(i);                           //     mark octant as box
+      if(NCRIT > 1 && NUM[i] <= NCRIT)             //     IF twig box
+	for(dot*Dj=Di; Dj!=Di+NUM[i]; ++Dj)        //       LOOP dots
+	  sub->adddot_to_list(Dj);                 //         add to list
+      else if(size_t(NUM[i]) > Nmax) {             //     ELIF too large
+	sub->NUMBER = NUM[i];                      //       set number
+	split_top(sub,Di,Di+NUM[i],Nmax);          //       split further
+      } else {                                     //     ELSE
+	sub->mark_as_task();                       //       done by a
+	SUBS.push_back(new SubBoxDotTree(this,sub,Di,Di+NUM[i]));
+      }                                            //       SubBoxDotTree later
+    }                                              // END LOOP
+  }
+  //----------------------------------------------------------------------------
+  void TreeBuilder::build_parallel()
+  {
+    const size_t Nd = size_t(DN-D0)-NOUT;          // # dots to add
+    DT = falcON_NEW(dot,DN-D0);
+    P0->NUMBER = Nd;
+    split_top(P0,D0+NOUT,DN,max(size_t(NCRIT),Nd/(8*NT)));
+    falcON_DEL_A(DT);
+    const int n = SUBS.size();
+#pragma omp parallel for schedule(dynamic,1) num_threads(NT)
+    for(int k=0; k<n; ++k)
+      SUBS[k]->build();
+    DebugInfo(4,"TreeBuilder: %d sub-trees built by %d threads\n",n,NT);
+  }
+  //----------------------------------------------------------------------------
+  int TreeBuilder::link_top(const box*     P,
+			    int            o,
+#ifdef falcON_MPI
+			    int            k,
+#else
+			    int             ,
+#endif
+			    OctTree::Cell* C,
+			    OctTree::Cell*&Cf,
+			    OctTree::Leaf*&Lf,
+			    unsigned      &ns)
+  {
+    if(P->is_twig())                               // twig: no SubBoxDotTrees
+      return link_cells_N(P,o,
+#ifdef falcON_MPI
+			  k,
+#else
+			  0,
+#endif
+			  C,Cf,Lf);
+    int dep=0;                                     // depth of cell
+    level_ (C) = P->LEVEL;                         // copy level
+    octant_(C) = o;                                // set octant
+#ifdef falcON_MPI
+    peano_ (C) = P->PEANO;                         // copy peano map
+    key_   (C) = k;                                // set local peano key
+#endif
+    centre_(C) = P->centre();                      // copy centre
+    number_(C) = P->NUMBER;                        // copy number
+    fcleaf_(C) = NoLeaf(TREE,Lf);                  // set cell: leaf kids
+    nleafs_(C) = 0;                                // reset cell: # leaf kids
+    int i,nsub=0;                                  // octant, # sub-boxes
+    node*const*N;                                  // sub-node pointer
+    for(i=0,N=P->OCT; i!=Nsub; ++i,++N) if(*N) {   // LOOP non-empty octants
+      if(P->marked_as_box(i)) ++nsub;              //   IF   sub-boxes: count
+      else {                                       //   ELIF sub-dots:
+	static_cast<dot*>(*N)->set_leaf(Lf++);     //     set leaf
+	nleafs_(C)++;                              //     inc # sub-leafs
+      }                                            //   END IF
+    }                                              // END LOOP
+    if(nsub) {                                     // IF has sub-boxes
+      int c = NoCell(TREE,C);                      //   index of cell
+      OctTree::Cell*Ci=Cf;                         //   remember free cells
+      fccell_(C) = NoCell(TREE,Ci);                //   set cell: 1st sub-cell
+      ncells_(C) = nsub;                           //   set cell: # cell kids
+      Cf += nsub;                                  //   reserve nsub cells
+      for(i=0, N=P->OCT; i!=Nsub; ++i,++N)         //   LOOP octants
+	if(*N && P->marked_as_box(i)) {            //     IF sub-box
+	  const box*B = static_cast<box*>(*N);
+	  int kB =
+#ifdef falcON_MPI
+	    P->PEANO.key(i);
+#else
+	    0;
+#endif
+	  pacell_(Ci) = c;                         //       sub-cell's parent
+	  if(B->marked_as_task()) {                //       IF SubBoxDotTree's
+	    SubBoxDotTree*S = SUBS[ns++];          //         allot its cells
+	    if(S->root() != B)                     //         and leafs
+	      falcON_Error("TreeBuilder::link_top(): box mismatch");
+	    S->set_link(i,kB,Ci++,Cf,Lf);
+	    Cf += S->N_boxes();
+	    Lf += B->NUMBER;
+	    if(dep < 1) dep = 1;
+	  } else {                                 //       ELSE
+	    int de = link_top(B,i,kB,Ci++,Cf,Lf,ns);//        link it here
+	    if(de>dep) dep=de;                     //         update depth
+	  }                                        //       ENDIF
+	}                                          //   END LOOP
+    } else {                                       // ELSE (no sub-boxes)
+      fcCell_(C) =-1;                              //   set cell: 1st sub-cell
+      ncells_(C) = 0;                              //   set cell: # sub-cells
+    }                                              // ENDIF
+    dep++;                                         // increment depth
+    return dep;                                    // return cell's depth
+  }
+#endif
   //----------------------------------------------------------------------------
   void TreeBuilder::report_infnan() const falcON_THROWING
   {
@@ -1148,6 +1479,7 @@ namespace {
     DN    = Di;
     XAVE /= real(DN-D0);
     if(XAVE.isnan() || XAVE.isinf()) report_infnan();
+    morton_order(D0+NOUT,DN,XMIN,XMAX);
     if(xmin) XMIN = *xmin;
     if(xmax) XMAX = *xmax;
   }
@@ -1196,7 +1528,7 @@ namespace {
 			   const vect   *xmin,
 			   const vect   *xmax,
 			   bool          out) falcON_THROWING
-  : ROOTCENTRE(x0), OUT(out)
+  : ROOTCENTRE(x0), OUT(out), NT(tr->threads())
   {
     report REPORT("TreeBuilder::TreeBuilder(): 1");
     TREE = tr;
@@ -1211,7 +1543,7 @@ namespace {
 			   int           nc,
 			   int           dm,
 			   bool          out) falcON_THROWING
-  : ROOTCENTRE(x0), OUT(out)
+  : ROOTCENTRE(x0), OUT(out), NT(tr->threads())
   {
     report REPORT("TreeBuilder::TreeBuilder(): 2");
     TREE = tr;
@@ -1330,9 +1662,10 @@ OctTree::OctTree(const bodies*bb,                  // I: body sources
 		 flags        sp,                  // I: flag specifying bodies 
 		 const vect  *xi,                  // I: x_min                  
 		 const vect  *xa,                  // I: x_max                  
-		 bool         out) :               // I: sink under root?
+		 bool         out,                 // I: sink under root?
+		 unsigned     nt) :                // I: # threads
   BSRCES(bb), SPFLAG(sp), LEAFS(0), CELLS(0), ALLOC(0), NALLOC(0u),
-  STATE(fresh), USAGE(un_used)
+  STATE(fresh), USAGE(un_used), NTHREADS(nt? nt : 1u)
 {
   SET_I
     TreeBuilder TB(this,x0,nc,dm,bb,sp,xi,xa,out); // initialize TreeBuilder    
@@ -1362,7 +1695,8 @@ OctTree::OctTree(const OctTree*par,                // I: parent tree
   SPFLAG(par->SP_flag() | F),                      // copy body specific flag   
   LEAFS(0), CELLS(0), ALLOC(0), NALLOC(0u),        // reset some data           
   STATE ( state( par->STATE | sub_tree) ),         // set state                 
-  USAGE ( un_used )                                // set usage                 
+  USAGE ( un_used ),                               // set usage
+  NTHREADS ( par->NTHREADS )                       // copy # threads
 {
   par->mark_for_subtree(F,Ncrit,Nc,Ns);            // mark parent tree          
   if(Ns==0 || Nc==0) {                             // IF no nodes marked        
@@ -0,0 +1,370 @@
+// -*- C++ -*-
+////////////////////////////////////////////////////////////////////////////////
+///
+/// \file   src/public/manip/caustic_crossings.cc
+///
+/// \brief  provided manipulator caustic_crossings
+///
+/// \author Walter Dehnen
+/// \date   2026
+///
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2026 Walter Dehnen
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc., 675
+// Mass Ave, Cambridge, MA 02139, USA.
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// history:
+//
+// v 0.0    19/10/2026  created
+// v 0.1    19/10/2026  threads take chunks of bodies, not whole blocks
+// v 0.2    19/10/2026  tricusp test from NEMO's tricusp.h
+////////////////////////////////////////////////////////////////////////////////
+#include <public/defman.h>
+#include <forces.h>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <tricusp.h>                  // NEMO: the tricusp, shared with unsio
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+namespace falcON { namespace Manipulate {
+  // ///////////////////////////////////////////////////////////////////////////
+  //
+  // struct tricusp
+  //
+  /// cross section of a caustic ring: a tricusp (deltoid) in the (R,z) plane
+  ///
+  /// The caustic ring of radius a and width p has, in the plane of the
+  /// symmetry axis, the cross section R = a + p (1-T)(1-2T),
+  /// z = +/- 2 p T sqrt(T(1-T)), T in [0,1], a deltoid with centre at
+  /// R = a + p/4, radius p/4 and cusps at (a+p,0) and (a-p/8,+/-sqrt(27)p/8).
+  /// With x = (R-C)/r, y = z/r, q = x^2+y^2 the deltoid is F(x,y) = 0 with
+  /// F = q^2 + 18 q - 27 - 8 x (x^2 - 3 y^2), negative inside.\n
+  /// The test itself is in NEMO's tricusp.h, which unsio's frame catalog
+  /// uses as well, so that both agree on the bodies inside a ring.
+  ///
+  // ///////////////////////////////////////////////////////////////////////////
+  struct tricusp : public tricusp_t {
+    //--------------------------------------------------------------------------
+    void set(double a, double p) {
+      tricusp_set(this,a,p);
+    }
+    /// is (R,z) within the bounding box?
+    bool in_box(double R, double z) const {
+      return tricusp_in_box(this,R,z);
+    }
+    /// implicit function, negative inside
+    double F(double R, double z) const {
+      return tricusp_f(this,R,z);
+    }
+  };
+  // ///////////////////////////////////////////////////////////////////////////
+  //
+  // class caustic_crossings
+  //
+  /// manipulator: detects crossings of caustic rings, writes them to file
+  ///
+  /// This manipulator follows all bodies in_subset() (default: all, see
+  /// set_subset) through the tricusp cross sections of N caustic rings
+  /// (flows), which are axisymmetric about the z-axis through 'xcen'
+  /// (default: origin). Whenever a body's position relative to a tricusp
+  /// (inside or outside) has changed since the previous call, a line
+  ///
+  ///   time key n dir R z |dv|
+  ///
+  /// is written to file, where time, R and z are linearly interpolated to
+  /// the crossing, dir is +1 (in) or -1 (out), and |dv| is the change of
+  /// velocity over the step. At the end, the counts of crossings in and out
+  /// of each ring are appended.\n
+  /// Bodies are checked against a ring only if they were inside or are now
+  /// within its bounding box, and only if they are within the band in (R,z)
+  /// covering all rings, so most bodies cost no more than a cylindrical
+  /// radius. With gyrfalcON, bodies are split into chunks, which as many
+  /// threads as gravity uses take in turn, each collecting its crossings in
+  /// its own buffer.
+  /// \note
+  /// A crossing entirely within one interval between calls, e.g. one step,
+  /// is missed: the steps must be short compared to p/|v|.
+  ///
+  /// Meaning of the parameters:\n
+  /// par[2n-2]: radius a_n of caustic ring n=1..N\n
+  /// par[2n-1]: width p_n of caustic ring n=1..N\n
+  /// file:      file name for output of table with crossings\n
+  ///
+  /// Usage of pointers: uses 'xcen' and 'forces'\n
+  /// Usage of flags:    uses in_subset()\n
+  ///
+  // ///////////////////////////////////////////////////////////////////////////
+  class caustic_crossings : public manipulator {
+  private:
+    static const int NMAX = 32;            ///< max # rings (bits in mask)
+    /// a crossing
+    struct event {
+      double T;                            ///< time of crossing
+      unsigned K;                          ///< key (or index) of body
+      int    N;                            ///< ring
+      int    D;                            ///< +1: in, -1: out
+      double R, Z;                         ///< position of crossing
+      double DV;                           ///< |v1-v0| over step
+      bool operator<(event const&e) const {
+	return T<e.T || (T==e.T && (K<e.K || (K==e.K && N<e.N)));
+      }
+    };
+    typedef std::vector<event> buffer;
+    //--------------------------------------------------------------------------
+    int                   N;               ///< # rings
+    tricusp               RING[NMAX];      ///< rings
+    double                RLO,RHI,ZHI;     ///< band covering all rings
+    mutable output        OUT;             ///< output
+    mutable unsigned      NB;              ///< # bodies of state
+    mutable uint32_t     *IN;              ///< per body: inside rings?
+    mutable float        *RZ;              ///< per body: (R,z) at T0
+    mutable vect         *V0;              ///< per body: v at T0
+    mutable double        T0;              ///< time of state
+    mutable std::vector<buffer> BUF;       ///< per thread: crossings found
+    mutable unsigned      NCR[NMAX][2];    ///< # crossings in, out
+    //--------------------------------------------------------------------------
+    void free_state() const {
+      if(IN) { falcON_DEL_A(IN); IN=0; }
+      if(RZ) { falcON_DEL_A(RZ); RZ=0; }
+      if(V0) { falcON_DEL_A(V0); V0=0; }
+      NB = 0;
+    }
+    /// mask of rings containing (R,z)
+    uint32_t inside(double R, double z) const {
+      uint32_t m=0;
+      if(R >= RLO && R <= RHI && std::abs(z) <= ZHI)
+	for(int n=0; n!=N; ++n)
+	  if(RING[n].in_box(R,z) && RING[n].F(R,z) < 0) m |= 1u<<n;
+      return m;
+    }
+    /// find crossings of bodies in block, update their state
+    /// a chunk of bodies: \a N bodies of block \a B from its body \a I on
+    struct chunk {
+      const bodies::block*B;
+      unsigned            I, N;
+    };
+    void process(chunk const&, vect const&, double, buffer&) const;
+    //--------------------------------------------------------------------------
+  public:
+    const char* name    () const { return "caustic_crossings"; }
+    const char* describe() const {
+      return
+	"writes crossings of bodies in_subset() (default: all) through "
+	"caustic rings around \"xcen\" (default: origin) to file";
+    }
+    //--------------------------------------------------------------------------
+    fieldset need   () const { return fieldset::x | fieldset::v; }
+    fieldset provide() const { return fieldset::empty; }
+    fieldset change () const { return fieldset::empty; }
+    //--------------------------------------------------------------------------
+    bool manipulate(const snapshot*) const;
+    //--------------------------------------------------------------------------
+    caustic_crossings(const double*pars,
+		      int          npar,
+		      const char  *file) falcON_THROWING
+    : N   ( npar/2 ),
+      OUT ( file? file : ".", true),
+      NB  ( 0 ), IN ( 0 ), RZ ( 0 ), V0 ( 0 ), T0 ( 0. )
+    {
+      if(debug(2) || file == 0 || npar < 2)
+	std::cerr<<
+	  " Manipulator \""<<name()<<"\":\n"
+	  " detects crossings of bodies in_subset() (default: all) through\n"
+	  " caustic rings, axisymmetric about the z-axis through 'xcen'\n"
+	  " (default: origin), and writes them to file.\n"
+	  " par[2n-2]: radius of caustic ring n=1..N\n"
+	  " par[2n-1]: width  of caustic ring n=1..N\n";
+      if(file == 0)
+	falcON_ErrorN("Manipulator \"%s\": no output file given\n",name());
+      if(!OUT.is_open())
+	falcON_ErrorN("Manipulator \"%s\": couldn't open output\n",name());
+      if(npar < 2 || npar & 1)
+	falcON_ErrorN("Manipulator \"%s\": need pairs of parameters "
+		      "(radius,width), got %d parameters\n",name(),npar);
+      if(N > NMAX)
+	falcON_ErrorN("Manipulator \"%s\": at most %d rings supported\n",
+		      name(),NMAX);
+      for(int n=0; n!=N; ++n) {
+	if(pars[n+n] <= 0. || pars[n+n+1] <= 0.)
+	  falcON_ErrorN("Manipulator \"%s\": ring %d: radius and width "
+			"must be positive\n",name(),n+1);
+	RING[n].set(pars[n+n],pars[n+n+1]);
+	if(n==0 || RING[n].rmin < RLO) RLO = RING[n].rmin;
+	if(n==0 || RING[n].rmax > RHI) RHI = RING[n].rmax;
+	if(n==0 || RING[n].zmax > ZHI) ZHI = RING[n].zmax;
+	NCR[n][0] = NCR[n][1] = 0;
+      }
+    }
+    //--------------------------------------------------------------------------
+    ~caustic_crossings();
+  };
+  //////////////////////////////////////////////////////////////////////////////
+  caustic_crossings::~caustic_crossings() {
+    if(NB) {
+      OUT  << "#\n# crossings:  ring        in       out\n";
+      for(int n=0; n!=N; ++n)
+	OUT<< "#          "
+	   << std::setw(6)  << n+1
+	   << std::setw(10) << NCR[n][0]
+	   << std::setw(10) << NCR[n][1] << '\n';
+    }
+    free_state();
+  }
+  //----------------------------------------------------------------------------
+  void caustic_crossings::process(chunk const&C, vect const&X0,
+				  double T1, buffer&E) const
+  {
+    const bodies::block*B = C.B;
+    const flags*F = B->has_field(fieldbit::f)? B->const_data<fieldbit::f>():0;
+    const unsigned*K = B->has_field(fieldbit::k)? B->const_data<fieldbit::k>():0;
+    const vect *X = B->const_data<fieldbit::x>();
+    const vect *V = B->const_data<fieldbit::v>();
+    for(unsigned i=C.I,j=B->first()+C.I; i!=C.I+C.N; ++i,++j) {
+      if(F && !in_subset(F+i)) continue;
+      vect   x = X[i]-X0;
+      double R = std::sqrt(x[0]*x[0]+x[1]*x[1]), z = x[2];
+      uint32_t m0 = IN[j];
+      // prefilter: outside all rings before and outside the band now
+      if(m0 || (R >= RLO && R <= RHI && std::abs(z) <= ZHI)) {
+	double R0 = RZ[j+j], z0 = RZ[j+j+1];
+	uint32_t m1 = 0;
+	for(int n=0; n!=N; ++n) {
+	  uint32_t bit = 1u<<n;
+	  if(!(m0 & bit) && !RING[n].in_box(R,z)) continue;
+	  double f1 = RING[n].F(R,z);
+	  if(f1 < 0) m1 |= bit;
+	  if((m1 ^ m0) & bit) {
+	    double f0 = RING[n].F(R0,z0);
+	    double w  = f0==f1? 0.5 : f0/(f0-f1);
+	    if(w < 0.) w = 0.; else if(w > 1.) w = 1.;
+	    event e;
+	    e.T  = T0 + w*(T1-T0);
+	    e.K  = K? K[i] : j;
+	    e.N  = n+1;
+	    e.D  = (m1 & bit)? 1 : -1;
+	    e.R  = R0 + w*(R-R0);
+	    e.Z  = z0 + w*(z-z0);
+	    e.DV = abs(V[i]-V0[j]);
+	    E.push_back(e);
+	  }
+	}
+	IN[j] = m1;
+      }
+      RZ[j+j]   = R;
+      RZ[j+j+1] = z;
+      V0[j]     = V[i];
+    }
+  }
+  //----------------------------------------------------------------------------
+  bool caustic_crossings::manipulate(const snapshot*S) const
+  {
+    // 0 check for required data
+    if( !CheckMissingBodyData(S,need()) )
+      return false;
+    const vect*Xc = S->pointer<vect>("xcen");
+    const vect X0 = Xc? *Xc : vect(zero);
+    // 1 first call or # bodies changed: initialise state, no crossings
+    if(NB != S->N_bodies()) {
+      if(NB == 0) {
+	OUT  << "#\n# output from Manipulator \"" << name() << "\"\n#\n";
+	RunInfo::header(OUT);
+	OUT  << "# rings (radius,width):";
+	for(int n=0; n!=N; ++n)
+	  OUT<< " (" << RING[n].a << ',' << RING[n].p << ')';
+	OUT  << "\n#\n#          time        key ring dir"
+	     << "            R            z         |dv|\n";
+      } else
+	falcON_WarningN("Manipulator \"%s\": # bodies changed from %u to %u:"
+			" restart tracking\n",name(),NB,S->N_bodies());
+      free_state();
+      NB = S->N_bodies();
+      IN = falcON_NEW(uint32_t,NB);
+      RZ = falcON_NEW(float,NB+NB);
+      V0 = falcON_NEW(vect,NB);
+      T0 = S->time();
+      for(const bodies::block*B=S->first_block(); B; B=B->next()) {
+	const vect *X = B->const_data<fieldbit::x>();
+	const vect *V = B->const_data<fieldbit::v>();
+	for(unsigned i=0,j=B->first(); i!=B->N_bodies(); ++i,++j) {
+	  vect   x = X[i]-X0;
+	  double R = std::sqrt(x[0]*x[0]+x[1]*x[1]);
+	  IN[j]     = inside(R,x[2]);
+	  RZ[j+j]   = R;
+	  RZ[j+j+1] = x[2];
+	  V0[j]     = V[i];
+	}
+      }
+      return false;
+    }
+    // 2 find crossings since last call, per chunk of bodies, in parallel
+    //   (a block may hold all bodies, so it is cut as in externacc::set())
+    const forces*FO = S->pointer<forces>("forces");
+    unsigned nt = FO? FO->threads() : 1;
+    if(nt < 1) nt = 1;
+    if(BUF.size() < nt) BUF.resize(nt);
+    const double T1 = S->time();
+    const unsigned K = nt > 1? 1 + S->N_bodies()/(8*nt) : S->N_bodies();
+    std::vector<chunk> CH;
+    for(const bodies::block*B=S->first_block(); B; B=B->next())
+      for(unsigned i=0; i<B->N_bodies(); i+=K) {
+	chunk c = { B, i, std::min(K,B->N_bodies()-i) };
+	CH.push_back(c);
+      }
+    const int nc = CH.size();
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nt)
+    {
+      buffer&E = BUF[omp_get_thread_num()];
+#pragma omp for schedule(dynamic,1) nowait
+      for(int c=0; c<nc; ++c)
+	process(CH[c],X0,T1,E);
+    }
+#else
+    for(int c=0; c<nc; ++c)
+      process(CH[c],X0,T1,BUF[0]);
+#endif
+    T0 = T1;
+    // 3 merge, sort and write crossings
+    buffer&E = BUF[0];
+    for(unsigned t=1; t<BUF.size(); ++t) {
+      E.insert(E.end(),BUF[t].begin(),BUF[t].end());
+      BUF[t].clear();
+    }
+    std::sort(E.begin(),E.end());
+    for(buffer::const_iterator e=E.begin(); e!=E.end(); ++e) {
+      NCR[e->N-1][e->D > 0? 0:1]++;
+      OUT << ' '  << print(e->T,14,8)
+	  << ' '  << std::setw(10) << e->K
+	  << ' '  << std::setw(4)  << e->N
+	  << ' '  << std::setw(3)  << e->D
+	  << ' '  << print(e->R,12,6)
+	  << ' '  << print(e->Z,12,6)
+	  << ' '  << print(e->DV,12,6) << '\n';
+    }
+    if(!E.empty()) OUT << std::flush;
+    E.clear();
+    return false;
+  }
+  //////////////////////////////////////////////////////////////////////////////
+} }
+
+__DEF__MAN(falcON::Manipulate::caustic_crossings)
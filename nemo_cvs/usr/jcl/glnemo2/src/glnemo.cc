@@ -36,7 +36,7 @@
 #include "mainwindow.h"
 using namespace std;
 
-#define RELEASE_VERSION "1.6.1"
+#define RELEASE_VERSION "1.6.2"
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
 // Import snapshot plugins
@@ -125,6 +125,7 @@ Q_IMPORT_PLUGIN(networkplugin);
     "cbfs=13\n   size of the fonts used to display CB             ",
     "com=t\n           centering according Center Of Mass               ", 
     "cod=f\n           centering according Center Of Density            ",
+    "lod=0\n           draw huge objects from ~lod particles, then refine",
     "point=f\n         show particles as points                         ",
     "selphys=1\n        select physical quantity to display\n           "
     "             (1:density, 2:temperature, 3:pressure)                ",
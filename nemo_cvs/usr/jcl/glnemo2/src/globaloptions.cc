@@ -120,6 +120,8 @@ GlobalOptions::GlobalOptions()
   new_frame = false;
   // cod
   cod=false;
+  // level of detail
+  lod=0;
   // memory
   duplicate_mem = true;
   octree_enable = false;
@@ -322,6 +324,8 @@ const GlobalOptions& GlobalOptions::operator=(const GlobalOptions &m)
   new_frame = m.new_frame;
   // cod
   cod = m.cod;
+  // level of detail
+  lod = m.lod;
   // memory
   duplicate_mem = m.duplicate_mem;
   // physical value
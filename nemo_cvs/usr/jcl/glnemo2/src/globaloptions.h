@@ -116,6 +116,8 @@ public:
     bool vel_req;
     // cod
     bool cod;
+    // level of detail, #particles of the first level (0: off)
+    int lod;
     // method
     void copyTransform(const GlobalOptions &m);
     // frame
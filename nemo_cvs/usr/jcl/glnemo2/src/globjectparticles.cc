@@ -397,7 +397,7 @@ void GLObjectParticles::updateVbo()
 #if ! GLDRAWARRAYS
         phys_itv.clear();
 #endif
-        for (int i=0; i < po->npart; i+=po->step) {         
+        for (int i=0; i < po->nDraw(); i+=po->step) {         
           if (phys_select && phys_select->isValid()) {
 #if ! GLDRAWARRAYS
             int index=po->index_tab[i];
@@ -454,17 +454,17 @@ void GLObjectParticles::buildVboPos()
   tbloc.restart();
   
   std::vector <GLfloat> vertices;
-  vertices.reserve(((po->npart/po->step)+1)*3);
+  vertices.reserve(((po->nDraw()/po->step)+1)*3);
   
   //rho.clear();      // clear rho density vector
   phys_itv.clear(); // clear ohysical value vector
   rho_itv.clear();
   vindex_sel.clear();   // clear zdepth vector     
-  rho_itv.reserve(((po->npart/po->step)+1));
-  vindex_sel.reserve(((po->npart/po->step)+1));
-  phys_itv.reserve(((po->npart/po->step)+1));
+  rho_itv.reserve(((po->nDraw()/po->step)+1));
+  vindex_sel.reserve(((po->nDraw()/po->step)+1));
+  phys_itv.reserve(((po->nDraw()/po->step)+1));
   
-  for (int i=0; i < po->npart; i+=po->step) {
+  for (int i=0; i < po->nDraw(); i+=po->step) {
     int index=po->index_tab[i];
     if (phys_select && phys_select->isValid()) {
       GLObjectIndexTab myphys;
@@ -510,7 +510,7 @@ void GLObjectParticles::buildVboPos()
 #endif
   // select vertices
   tbloc.restart();
-  for (int i=0; i < po->npart; i+=po->step) {
+  for (int i=0; i < po->nDraw(); i+=po->step) {
     int index;
     if (po->rhoSorted() &&
         phys_select && phys_select->getType() != PhysicalData::rho && part_data->rho) {
@@ -538,7 +538,7 @@ void GLObjectParticles::buildVboPos()
   tbloc.restart();
   // bind VBO buffer for sending data
   glBindBufferARB(GL_ARRAY_BUFFER_ARB, vbo_pos);
-  assert( nvert_pos <= (po->npart/po->step)+1);
+  assert( nvert_pos <= (po->nDraw()/po->step)+1);
   std::cerr << "buildVbo Pos nvert_pos="<<nvert_pos<<"\n";
   
   // upload data to VBO
@@ -559,10 +559,10 @@ void GLObjectParticles::buildVboHsml()
   tbench.restart();
   
   std::vector <GLfloat> hsml_value;
-  hsml_value.reserve(((po->npart/po->step)+1));
+  hsml_value.reserve(((po->nDraw()/po->step)+1));
 
   // loop on all the object's particles
-  for (int i=0; i < po->npart; i+=po->step) {
+  for (int i=0; i < po->nDraw(); i+=po->step) {
     int index;
 #if 0
     if (phys_select && phys_select->isValid()) index = phys_itv[i].index;
@@ -589,7 +589,7 @@ void GLObjectParticles::buildVboHsml()
   // bind VBO buffer for sending data
   glBindBufferARB(GL_ARRAY_BUFFER_ARB, vbo_size);
   
-  assert( (int) hsml_value.size() <= (po->npart/po->step)+1);
+  assert( (int) hsml_value.size() <= (po->nDraw()/po->step)+1);
   // upload data to VBO
   glBufferDataARB(GL_ARRAY_BUFFER_ARB, hsml_value.size() * sizeof(float), &hsml_value[0], GL_STATIC_DRAW_ARB);
   //checkVboAllocation((int) (nvert_pos * 3 * sizeof(float)));
@@ -608,10 +608,10 @@ void GLObjectParticles::buildVboPhysData()
   tbench.restart();
 
   std::vector <GLfloat> phys_data;
-  phys_data.reserve(((po->npart/po->step)+1));
+  phys_data.reserve(((po->nDraw()/po->step)+1));
 
   // loop on all the object's particles
-  for (int i=0; i < po->npart; i+=po->step) {
+  for (int i=0; i < po->nDraw(); i+=po->step) {
     int index;
 #if 0
     if (phys_select && phys_select->isValid()) index = phys_itv[i].index;
@@ -636,7 +636,7 @@ void GLObjectParticles::buildVboPhysData()
   // bind VBO buffer for sending data
   glBindBufferARB(GL_ARRAY_BUFFER_ARB, vbo_data);
   
-  assert( (int)phys_data.size() <= (po->npart/po->step)+1);
+  assert( (int)phys_data.size() <= (po->nDraw()/po->step)+1);
   // upload data to VBO
   glBufferDataARB(GL_ARRAY_BUFFER_ARB,phys_data.size() * sizeof(float), &phys_data[0], GL_STATIC_DRAW_ARB);
   checkGlError("2222");
@@ -801,7 +801,7 @@ void GLObjectParticles::buildDisplayList()
   glBegin(GL_POINTS);
   
   // draw all the selected points 
-  for (int i=0; i < po->npart; i+=po->step) {
+  for (int i=0; i < po->nDraw(); i+=po->step) {
     int index=po->index_tab[i];
     float
       x=part_data->pos[index*3  ],
@@ -827,7 +827,7 @@ void GLObjectParticles::buildVelDisplayList()
     
     // draw all the selected points
     const float vfactor = po->getVelSize();// / part_data->getMaxVelNorm(); // requested by Peter Teuben
-    for (int i=0; i < po->npart; i+=po->step) {
+    for (int i=0; i < po->nDraw(); i+=po->step) {
       int index=po->index_tab[i];
       float
         x=part_data->pos[index*3  ],
@@ -873,7 +873,7 @@ void GLObjectParticles::selectParticles()
 { 
   phys_itv.clear();   // clear physical value vector
   vindex_sel.clear(); // clear vindex vector     
-  for (int i=0; i < po->npart; i+=po->step) {
+  for (int i=0; i < po->nDraw(); i+=po->step) {
     int index=po->index_tab[i];
     if (phys_select && phys_select->isValid()) {
       GLObjectIndexTab myphys;
@@ -936,7 +936,7 @@ void GLObjectParticles::buildIndexHisto()
     
     int cpt=0;
     // find first index of particle in the percentage
-    for (int i=0; i < po->npart; i+=po->step) {
+    for (int i=0; i < po->nDraw(); i+=po->step) {
       int index;//phys_itv[i].index;
 #if 1
       if (po->rhoSorted() &&
@@ -1037,9 +1037,9 @@ void GLObjectParticles::sortByDensity()
     PHYS_MAX = phys_select->getMax();
   }
   index_min = 0;
-  index_max = po->npart;
+  index_max = po->nDraw();
   int cpt=0;
-  for (int i=0; i < po->npart; i+=po->step) {
+  for (int i=0; i < po->nDraw(); i+=po->step) {
     int index;
     if (part_data->rho) index = phys_itv[i].i_point;
     
@@ -1079,7 +1079,7 @@ void GLObjectParticles::sortByDepth()
   // get ModelView Matrix
   glGetDoublev(GL_MODELVIEW_MATRIX, (GLdouble *) mModel);
   nind_sorted=0;
-  for (int i=0; i < po->npart; i+=po->step) {
+  for (int i=0; i < po->nDraw(); i+=po->step) {
     int index=po->index_tab[i];
     if (part_data->rho->data[index] >= PHYS_MIN && part_data->rho->data[index] <= PHYS_MAX) {
     float
@@ -1152,7 +1152,7 @@ void GLObjectParticles::displaySprites(const double * mModel)
   float rot=0.0;
   float new_texture_size = po->getGazSize()/2.;
   // loop on all particles
-  for (int i=0; i < po->npart; i+=po->step) {
+  for (int i=0; i < po->nDraw(); i+=po->step) {
     int index=po->index_tab[i];
     float
       x=part_data->pos[index*3  ],
@@ -11,6 +11,7 @@
 // See the complete license in LICENSE and/or "http://www.cecill.info".        
 // ============================================================================
 #include "loadingthread.h"
+#include "lodoctree.h"
 #include <assert.h>
 
 namespace glnemo {
@@ -53,6 +54,8 @@ void LoadingThread::run()
     assert(crv->size());
     user_select->setSelection(select,crv,pov);
     if (current_data->nextFrame(user_select->getIndexesTab(),user_select->getNSel())) {
+      if (store_options->lod > 0) // particles in level of detail order
+        LodOctree::buildObjects(current_data->part_data,pov,store_options->lod);
       valid_new_frame = true;
       store_options->new_frame = true;
     }
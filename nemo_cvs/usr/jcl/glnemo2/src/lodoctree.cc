@@ -0,0 +1,217 @@
+// ============================================================================
+// Copyright Jean-Charles LAMBERT - 2007-2014                                  
+// e-mail:   Jean-Charles.Lambert@lam.fr                                      
+// address:  Centre de donneeS Astrophysique de Marseille (CeSAM)              
+//           Laboratoire d'Astrophysique de Marseille                          
+//           Ple de l'Etoile, site de Chteau-Gombert                         
+//           38, rue Frdric Joliot-Curie                                     
+//           13388 Marseille cedex 13 France                                   
+//           CNRS U.M.R 7326                                                   
+// ============================================================================
+// See the complete license in LICENSE and/or "http://www.cecill.info".        
+// ============================================================================
+#include "lodoctree.h"
+#include "particlesdata.h"
+#include "particlesobject.h"
+#include <algorithm>
+#include <assert.h>
+#ifdef _OPENMP
+#include <parallel/algorithm>
+#include <omp.h>
+#endif
+
+#define MAXDEPTH 10   // Morton keys have 10 bits per dimension
+namespace glnemo {
+
+// ============================================================================
+// Constructor                                                                 
+LodOctree::LodOctree(const int _nfirst, const int _nleaf)
+{
+  nfirst = std::max(1,_nfirst);
+  nleaf  = std::max(1,_nleaf);
+  nlevel = 0;
+}
+// ============================================================================
+// Destructor                                                                  
+LodOctree::~LodOctree()
+{
+}
+// ============================================================================
+// buildObjects                                                                
+// sort the particles of each object in LOD order, objects with less than     
+// nfirst particles are drawn at once                                         
+void LodOctree::buildObjects(const ParticlesData * p_data,
+                             ParticlesObjectVector * pov, const int _nfirst)
+{
+  for (unsigned int i=0; i<pov->size(); i++) {
+    ParticlesObject * po = &((*pov)[i]);
+    po->lod_level = 0;
+    if (po->index_tab && po->npart > _nfirst) {
+      LodOctree tree(_nfirst);
+      tree.build(p_data->pos,po->index_tab,po->npart,po->lod_end);
+    }
+    else po->lod_end.clear();
+  }
+}
+// ============================================================================
+// build                                                                       
+void LodOctree::build(const float * pos, int * index, const int n,
+                      std::vector <int> & lod_end)
+{
+  long long int nl = nfirst;
+  for (nlevel=0; nl < n; nlevel++) nl *= 8;   // n <= nfirst*8^K
+  sortKeys(pos,index,n);
+  buildNodes();
+  setLevels();
+  sortLevels(index,lod_end);
+  std::vector <unsigned long long>().swap(key);  // release memory
+  std::vector <unsigned char>().swap(level);
+}
+// ============================================================================
+// sortKeys                                                                    
+// Morton key of each particle, on a 1024^3 grid over the bounding cube       
+void LodOctree::sortKeys(const float * pos, const int * index, const int n)
+{
+  float xmin=pos[3*index[0]], ymin=pos[3*index[0]+1], zmin=pos[3*index[0]+2];
+  float xmax=xmin, ymax=ymin, zmax=zmin;
+#pragma omp parallel for reduction(min:xmin,ymin,zmin) reduction(max:xmax,ymax,zmax)
+  for (int i=0; i<n; i++) {
+    const float * x = pos+3*index[i];
+    xmin = std::min(xmin,x[0]); xmax = std::max(xmax,x[0]);
+    ymin = std::min(ymin,x[1]); ymax = std::max(ymax,x[1]);
+    zmin = std::min(zmin,x[2]); zmax = std::max(zmax,x[2]);
+  }
+  double size = std::max(xmax-xmin,std::max(ymax-ymin,zmax-zmin));
+  double scale = size > 0. ? 1023.99/size : 0.;
+  key.resize(n);
+#pragma omp parallel for
+  for (int i=0; i<n; i++) {
+    const float * x = pos+3*index[i];
+    unsigned long long k[3] = { (unsigned long long) ((x[0]-xmin)*scale),
+                                (unsigned long long) ((x[1]-ymin)*scale),
+                                (unsigned long long) ((x[2]-zmin)*scale) };
+    for (int d=0; d<3; d++) {   // spread 10 bits every 3 bits
+      k[d] = (k[d] | (k[d] << 16)) & 0x030000FF;
+      k[d] = (k[d] | (k[d] <<  8)) & 0x0300F00F;
+      k[d] = (k[d] | (k[d] <<  4)) & 0x030C30C3;
+      k[d] = (k[d] | (k[d] <<  2)) & 0x09249249;
+    }
+    key[i] = ((k[0] << 2 | k[1] << 1 | k[2]) << 32) | (unsigned int) index[i];
+  }
+  std::sort(key.begin(),key.end()); // parallel with _GLIBCXX_PARALLEL
+}
+// ============================================================================
+// buildNodes                                                                  
+// breadth first, down to depth K-1: deeper nodes would sample everything     
+void LodOctree::buildNodes()
+{
+  node.clear();
+  LodNode root = { 0, (int) key.size(), 0, true };
+  node.push_back(root);
+  int b=0, e=1; // nodes of the current depth
+  for (int d=0; d<nlevel-1 && d<MAXDEPTH && b<e; d++) {
+    const int shift = 32 + 3*(MAXDEPTH-1-d); // octant bits of depth d+1
+    std::vector <int> bound(9*(e-b));
+#pragma omp parallel for schedule(dynamic)
+    for (int i=b; i<e; i++) {   // octant boundaries in each node
+      int * bd = &bound[9*(i-b)];
+      bd[0] = -1;
+      if (node[i].count <= nleaf) continue;
+      const unsigned long long * k0 = &key[node[i].first];
+      const unsigned long long * k1 = k0 + node[i].count;
+      bd[0] = node[i].first;
+      for (int o=1; o<8; o++) {
+        const unsigned long long * ko = k0;
+        int len = k1-k0;
+        while (len > 0) {       // first key of octant >= o
+          int half = len/2;
+          if ((int) ((ko[half] >> shift) & 7) < o) { ko += half+1; len -= half+1; }
+          else len = half;
+        }
+        bd[o] = node[i].first + (ko-k0);
+      }
+      bd[8] = node[i].first + node[i].count;
+    }
+    for (int i=b; i<e; i++) {   // children of the next depth
+      const int * bd = &bound[9*(i-b)];
+      if (bd[0] < 0) continue;
+      node[i].leaf = false;
+      for (int o=0; o<8; o++)
+        if (bd[o+1] > bd[o]) {
+          LodNode child = { bd[o], bd[o+1]-bd[o], d+1, true };
+          node.push_back(child);
+        }
+    }
+    b = e;
+    e = node.size();
+  }
+}
+// ============================================================================
+// setLevels                                                                   
+// a node of depth d takes the particles first+j*8^(K-d); in a leaf, particle 
+// first+x is also taken at each depth D > d where 8^(K-D) divides x          
+void LodOctree::setLevels()
+{
+  const int nnode = node.size();
+  level.resize(key.size());
+#pragma omp parallel for schedule(dynamic)
+  for (int i=0; i<nnode; i++) { // leaves partition the particles
+    const LodNode * p = &node[i];
+    if (! p->leaf) continue;
+    level[p->first] = std::min(p->depth,nlevel);
+    for (int x=1; x<p->count; x++) {
+      int t=0;                  // x = 8^t * y
+      for (int y=x; t<nlevel && y%8==0; y/=8) t++;
+      level[p->first+x] = std::min(nlevel,std::max(p->depth,nlevel-t));
+    }
+  }
+  for (int i=0; i<nnode; i++) { // inner nodes: few particles each
+    const LodNode * p = &node[i];
+    if (p->leaf) continue;
+    long long int m=1;
+    for (int d=p->depth; d<nlevel; d++) m *= 8;
+    for (long long int x=0; x<p->count; x+=m)
+      level[p->first+x] = std::min((int) level[p->first+x],p->depth);
+  }
+}
+// ============================================================================
+// sortLevels                                                                  
+// stable counting sort of the particles by level, each thread does a chunk  
+void LodOctree::sortLevels(int * index, std::vector <int> & lod_end)
+{
+  const int n = key.size(), nl = nlevel+1;
+  std::vector <int> count;
+  lod_end.assign(nl,0);
+#pragma omp parallel
+  {
+    int nt=1, t=0;
+#ifdef _OPENMP
+    nt = omp_get_num_threads();
+    t  = omp_get_thread_num();
+#endif
+#pragma omp single
+    count.assign(nt*nl,0);      // implicit barrier
+    const int i0 = (long long int) n* t   /nt;
+    const int i1 = (long long int) n*(t+1)/nt;
+    int * c = &count[t*nl];
+    for (int i=i0; i<i1; i++) c[level[i]]++;
+#pragma omp barrier
+#pragma omp single
+    {                           // start of each thread in each level
+      int off=0;
+      for (int l=0; l<nl; l++) {
+        for (int u=0; u<nt; u++) {
+          int cnt = count[u*nl+l];
+          count[u*nl+l] = off;
+          off += cnt;
+        }
+        lod_end[l] = off;
+      }
+    }
+    for (int i=i0; i<i1; i++)
+      index[c[level[i]]++] = (int) (key[i] & 0xFFFFFFFF);
+  }
+  assert(lod_end[nlevel] == n);
+}
+
+}
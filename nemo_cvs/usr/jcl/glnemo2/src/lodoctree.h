@@ -0,0 +1,71 @@
+// ============================================================================
+// Copyright Jean-Charles LAMBERT - 2007-2014                                  
+// e-mail:   Jean-Charles.Lambert@lam.fr                                      
+// address:  Centre de donneeS Astrophysique de Marseille (CeSAM)              
+//           Laboratoire d'Astrophysique de Marseille                          
+//           Ple de l'Etoile, site de Chteau-Gombert                         
+//           38, rue Frdric Joliot-Curie                                     
+//           13388 Marseille cedex 13 France                                   
+//           CNRS U.M.R 7326                                                   
+// ============================================================================
+// See the complete license in LICENSE and/or "http://www.cecill.info".        
+// ============================================================================
+// LodOctree: level of detail (LOD) ordering of the particles of an object     
+//                                                                             
+// The particles are sorted along a Morton (Z-order) curve, which visits the   
+// octree leaves depth first, and the top levels of the octree are built as a  
+// flat array of nodes, each one a range of that order. A node at depth d      
+// takes every 8^(K-d)-th of its particles, from its first one, as its         
+// representative subsample, and a particle gets the smallest depth where it   
+// is taken: its LOD level. The index table is then sorted by level, keeping   
+// the Morton order inside a level, so that the particles up to level l form a 
+// spatially stratified subsample of about nfirst*8^l particles, where every   
+// node of depth <= l shows up, even in sparse regions. Level K has them all.  
+// ParticlesObject is only declared here, this header does not need Qt.        
+// ============================================================================
+#ifndef GLNEMOLODOCTREE_H
+#define GLNEMOLODOCTREE_H
+/**
+        @author Jean-Charles Lambert <jean-charles.lambert@lam.fr>
+ */
+#include <vector>
+
+namespace glnemo {
+class ParticlesData;
+class ParticlesObject;
+
+class LodNode {
+  public:
+    int first, count;  // range in Morton order
+    int depth;
+    bool leaf;
+};
+
+class LodOctree {
+  public:
+    LodOctree(const int _nfirst=1000000, const int _nleaf=64);
+    ~LodOctree();
+    // sort index[0..n) by level, lod_end[l] = #particles up to level l
+    void build(const float * pos, int * index, const int n,
+               std::vector <int> & lod_end);
+    // apply to all the objects with more than nfirst particles
+    static void buildObjects(const ParticlesData *,
+                             std::vector <ParticlesObject> *, const int _nfirst);
+    int nLevel() const { return nlevel; }
+    int nNode()  const { return node.size(); }
+  private:
+    int nfirst;        // #particles of level 0
+    int nleaf;         // nodes with no more particles are not split
+    int nlevel;        // #levels - 1 (K)
+    std::vector <LodNode> node;              // breadth first
+    std::vector <unsigned long long> key;    // Morton key << 32 | index
+    std::vector <unsigned char> level;       // level of each key
+    void sortKeys(const float *, const int *, const int);
+    void buildNodes();
+    void setLevels();
+    void sortLevels(int *, std::vector <int> &);
+};
+
+}
+
+#endif
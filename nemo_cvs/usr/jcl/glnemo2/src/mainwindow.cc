@@ -33,11 +33,13 @@
 #include "snapshotinterface.h"
 #include "globjectparticles.h"
 #include "snapshotnetwork.h"
+#include "lodoctree.h"
 
 #include "ftmio.h"
 #include "nemo.h"
 namespace glnemo {
 #define ICONSIZE 25
+#define LOD_DELAY 100 // ms between two levels of detail
 // -----------------------------------------------------------------------------
 // MainWindow constructor                                                       
 // -----------------------------------------------------------------------------
@@ -754,6 +756,8 @@ void MainWindow::loadNewData(const std::string select,
     
     if (current_data->nextFrame(user_select->getIndexesTab(),user_select->getNSel())) {
       qDebug("Time elapsed to load snapshot: %d s", tbench.elapsed()/1000);
+      if (store_options->lod > 0) // particles in level of detail order
+        LodOctree::buildObjects(current_data->part_data,&pov,store_options->lod);
       store_options->new_frame=true;
       mutex_data->unlock();
       listObjects(pov);
@@ -811,6 +815,7 @@ void MainWindow::loadNewData(const std::string select,
       }
       gl_window->update( current_data->part_data, &pov2,store_options);
       qDebug("Time elapsed to update GL with new data: %d s", tbench.elapsed()/1000);
+      if (store_options->lod > 0) lod_timer->start(LOD_DELAY); // refine
       if (!reload && bestzoom) gl_window->bestZoomFit();
       statusBar()->showMessage(tr("Snapshot loaded."));
     }
@@ -853,6 +858,9 @@ void MainWindow::startTimers()
   connect(bench_gup_timer, SIGNAL(timeout()), gl_window, SLOT(updateGL()));
   bench_nframe_timer = new QTimer(this);
   connect(bench_nframe_timer, SIGNAL(timeout()),this, SLOT(updateBenchFrame()));
+  lod_timer = new QTimer(this);
+  lod_timer->setSingleShot(true);
+  connect(lod_timer, SIGNAL(timeout()),this, SLOT(refineLod()));
 
 }
 // -----------------------------------------------------------------------------
@@ -989,6 +997,7 @@ void MainWindow::parseNemoParameters()
   
   store_options->auto_com           =getbparam((char *) "com");
   store_options->cod                =getbparam((char *) "cod");
+  store_options->lod                =getiparam((char *) "lod");
   // textures
   store_options->auto_texture_size  =getbparam((char *) "auto_ts");
   store_options->texture_size       =getdparam((char *) "texture_s");
@@ -1718,6 +1727,8 @@ void MainWindow::uploadNewFrame()
       //mutex_data->unlock();
     } else {
       //pov2=pov; // modif orbits
+      if (store_options->lod > 0) // LOD order of the new frame
+        ParticlesObject::copyVVLod(pov,pov2);
     }
     //!!!!
     
@@ -1736,6 +1747,7 @@ void MainWindow::uploadNewFrame()
        actionCenterToCom(false);
     } 
     gl_window->update( current_data->part_data, &pov2,store_options);
+    if (store_options->lod > 0) lod_timer->start(LOD_DELAY); // refine
     if (first && bestzoom) {
       first=false;
       //gl_window->bestZoomFit();
@@ -1762,6 +1774,24 @@ void MainWindow::uploadNewFrame()
   }
 }
 // -----------------------------------------------------------------------------
+// refineLod()                                                                  
+// display one more level of detail of the objects, if nothing else is going on
+void MainWindow::refineLod()
+{
+  if (loading_thread || is_key_pressed || is_mouse_pressed) {
+    lod_timer->start(LOD_DELAY); // try later
+    return;
+  }
+  bool more=false;
+  for (unsigned int i=0; i<pov2.size(); i++) {
+    if (pov2[i].lodRefine()) more=true;
+  }
+  if (more) {
+    gl_window->update( current_data->part_data, &pov2,store_options);
+    lod_timer->start(LOD_DELAY);
+  }
+}
+// -----------------------------------------------------------------------------
 // pressedKeyMouse()                                                            
 void MainWindow::pressedKeyMouse(const bool k, const bool m)
 {
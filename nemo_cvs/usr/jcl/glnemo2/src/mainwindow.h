@@ -103,6 +103,7 @@ class MainWindow : public QMainWindow {
     void playOneFrame();
     void pressedKeyMouse(const bool, const bool);
     void uploadNewFrame();
+    void refineLod();
     void takeScreenshot(const int, const int, std::string name="");
     void selectPart(const std::string, const bool);
     void startBench(const bool);
@@ -231,6 +232,8 @@ class MainWindow : public QMainWindow {
     QTimer * auto_rotu_timer, * auto_rotv_timer, * auto_rotw_timer;
     // bench
     QTimer * bench_gup_timer, * bench_nframe_timer;
+    // level of detail
+    QTimer * lod_timer;
     int total_frame;
     // divers stuff
     void initVariables();
@@ -53,6 +53,8 @@ void ParticlesObject::copyDataObject(const ParticlesObject&m, const bool garbage
   first        = m.first;
   last         = m.last;
   step         = m.step;
+  lod_end      = m.lod_end;
+  lod_level    = m.lod_level;
   
   copyProperties(m);
   
@@ -283,6 +285,20 @@ void ParticlesObject::backupVVProperties(ParticlesObjectVector& src,ParticlesObj
   }
 }
 // ============================================================================
+// copyVVLod                                                                   
+// LOD order of the particles (index_tab and lod_end) from src to dest, for the
+// objects which have the same particles, drawn again from level 0             
+void ParticlesObject::copyVVLod(ParticlesObjectVector& src,ParticlesObjectVector& dest)
+{
+  for (unsigned int i=0; i<src.size() && i<dest.size(); i++) {
+    if (src[i].index_tab && dest[i].index_tab && src[i].npart==dest[i].npart) {
+      memcpy(dest[i].index_tab,src[i].index_tab,sizeof(int)*src[i].npart);
+      dest[i].lod_end   = src[i].lod_end;
+      dest[i].lod_level = 0;
+    }
+  }
+}
+// ============================================================================
 // clearOrbitsVectorPOV                                                        
 void ParticlesObject::clearOrbitsVectorPOV(ParticlesObjectVector& pov)
 {
@@ -355,6 +371,7 @@ void ParticlesObject::init(const ObjFrom _of, const std::string _name)
   vel_alpha    =  255;
   vel_factor   =  1.0;
   index_tab    =  NULL;
+  lod_level    =  0;
   freed        = false;
   orbits       = false;
   o_record     = false;
@@ -381,6 +398,7 @@ void ParticlesObject:: buildIndexList(std::vector<int> & indexes)
   first = 0;
   last  = npart-1;
   step  = 1;
+  lod_end.clear();
   index_tab    = new int[npart];
   cpt += npart;
   for (int i=0; i<npart; i++) {
@@ -400,6 +418,7 @@ void ParticlesObject::buildIndexList( const int _npart, const int _first,
   first = _first;
   last  = _last;
   step  = _step;
+  lod_end.clear();
   index_tab    = new int[npart];
   cpt += npart;
   for (int i=0; i<npart; i++) {
@@ -51,6 +51,7 @@ class ParticlesObject{
     };
     static void copyVVkeepProperties(ParticlesObjectVector&,ParticlesObjectVector&, const int nbody);
     static void backupVVProperties(ParticlesObjectVector& src,ParticlesObjectVector& dest, const int nsel);
+    static void copyVVLod(ParticlesObjectVector& src,ParticlesObjectVector& dest);
     static void clearOrbitsVectorPOV(ParticlesObjectVector&);   
     static void initOrbitsVectorPOV(ParticlesObjectVector&);   
     void buildIndexList(const int, const int, const int, const int _step=1);
@@ -64,6 +65,19 @@ class ParticlesObject{
     int step;        // incremental step between particles.
     int * index_tab; // particles's indexes
     //
+    // Level of detail stuff (see LodOctree)
+    //
+    std::vector <int> lod_end; // #particles of index_tab up to each level
+    int lod_level;             // level displayed
+    int nDraw() const {        // #particles of index_tab displayed
+      return lod_level < (int) lod_end.size() ? lod_end[lod_level] : npart;
+    }
+    bool lodRefine() {         // display one more level
+      if (lod_level >= (int) lod_end.size()-1) return false;
+      lod_level++;
+      return true;
+    }
+    //
     // Orbits stuff
     //
     OrbitsVector ov;
@@ -39,6 +39,7 @@ HEADERS += mainwindow.h \
     formoptions.h \
     orbits.h \
     gloctree.h \
+    lodoctree.h \
     densityhisto.h \
     colormap.h \
     densitycolorbar.h \
@@ -79,6 +80,7 @@ SOURCES += glnemo.cc \
     orbits.cc \
     glew/glew.c \
     gloctree.cc \
+    lodoctree.cc \
     densityhisto.cc \
     colormap.cc \
     densitycolorbar.cc \
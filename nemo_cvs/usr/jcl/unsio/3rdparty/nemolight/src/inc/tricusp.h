@@ -0,0 +1,65 @@
+/*
+ * TRICUSP.H: cross section of a caustic ring, a tricusp (deltoid) in the
+ *            (R,z) plane. The one definition of "inside a caustic ring",
+ *            used by the caustic_crossings manipulator of falcON and by
+ *            the frame catalog of unsio (CFrameCatalog), so the crossings
+ *            of one and the caustics table of the other agree; unsio's
+ *            3rdparty/nemolight/src/inc has a copy for builds without NEMO.
+ *
+ *  19-oct-2026  created, from caustic_crossings.cc
+ *
+ * The caustic ring of radius a and width p has, in the plane of the
+ * symmetry axis, the cross section R = a + p (1-T)(1-2T),
+ * z = +/- 2 p T sqrt(T(1-T)), T in [0,1]: a deltoid with centre at
+ * R = a + p/4, radius p/4 and cusps at (a+p,0) and (a-p/8,+/-sqrt(27)p/8).
+ * With x = (R-C)/r, y = z/r, q = x^2+y^2 the deltoid is F(x,y) = 0 with
+ *
+ *	F = q^2 + 18 q - 27 - 8 x (x^2 - 3 y^2),   negative inside.
+ *
+ * Only needs <math.h>, and can be used from C (C99) and C++.
+ */
+
+#ifndef _tricusp_h
+#define _tricusp_h
+
+#include <math.h>
+
+typedef struct {
+    double a, p;		/* radius and width of the ring */
+    double c;			/* R of the centre */
+    double ir;			/* 1/radius */
+    double rmin, rmax;		/* range in R */
+    double zmax;		/* range in |z| */
+} tricusp_t;
+
+static inline void tricusp_set(tricusp_t *t, double a, double p)
+{
+    t->a    = a;
+    t->p    = p;
+    t->c    = a + 0.25*p;
+    t->ir   = 4./p;
+    t->rmin = a - 0.125*p;
+    t->rmax = a + p;
+    t->zmax = sqrt(27.)*0.125*p;
+}
+
+/* is (R,z) within the bounding box? */
+static inline int tricusp_in_box(const tricusp_t *t, double R, double z)
+{
+    return R >= t->rmin && R <= t->rmax && fabs(z) <= t->zmax;
+}
+
+/* implicit function, negative inside */
+static inline double tricusp_f(const tricusp_t *t, double R, double z)
+{
+    double x = t->ir*(R-t->c), y = t->ir*z, q = x*x+y*y;
+    return q*q + 18*q - 27 - 8*x*(x*x-3*y*y);
+}
+
+/* is (R,z) inside the tricusp? */
+static inline int tricusp_inside(const tricusp_t *t, double R, double z)
+{
+    return tricusp_in_box(t, R, z) && tricusp_f(t, R, z) < 0;
+}
+
+#endif
@@ -0,0 +1,409 @@
+// ============================================================================
+// Copyright Jean-Charles LAMBERT - 2008-2014
+//           Centre de donneeS Astrophysiques de Marseille (CeSAM)          
+// e-mail:   Jean-Charles.Lambert@lam.fr                                      
+// address:  Aix Marseille Universite, CNRS, LAM 
+//           Laboratoire d'Astrophysique de Marseille                          
+//           Pole de l'Etoile, site de Chateau-Gombert                         
+//           38, rue Frederic Joliot-Curie                                     
+//           13388 Marseille cedex 13 France                                   
+//           CNRS UMR 7326                                       
+// ============================================================================
+
+/* 
+  @author Jean-Charles Lambert <Jean-Charles.Lambert@lam.fr>
+ */
+#ifndef NOSQLITE3  // do not compile if no sqlite3 lib
+#include "framecatalog.h"
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <cmath>
+#include <sys/stat.h>
+#include "tricusp.h"      // NEMO: the tricusp of falcON's caustic_crossings
+
+namespace uns {
+// ----------------------------------------------------------------------------
+// constructor
+CFrameCatalog::CFrameCatalog(const std::string db, const bool verb)
+{
+  verbose = verb;
+  time    = 0.;
+  nframe  = 0;
+  offset  = -1;
+  sql = new jclt::CSQLite3(db);
+  if (sql->isOpen()) {
+    createTables();
+    loadRings();
+  }
+  if (verbose) {
+    std::cerr << "CFrameCatalog: frames indexed in ["<<db<<"], "<<ring_a.size()<<" ring(s)\n";
+  }
+}
+// ----------------------------------------------------------------------------
+// destructor
+CFrameCatalog::~CFrameCatalog()
+{
+  delete sql;
+}
+// ----------------------------------------------------------------------------
+// exe
+bool CFrameCatalog::exe(const std::string s)
+{
+  sql->exe(s);
+  if (!sql->isOk()) {
+    std::cerr << "CFrameCatalog: sql error for ["<<s<<"]\n";
+  }
+  return sql->isOk();
+}
+// ----------------------------------------------------------------------------
+// createTables
+bool CFrameCatalog::createTables()
+{
+  return
+    exe("create table if not exists frames (file text, frame integer, offset integer,"
+        " time real, nbody integer, ngas integer, nhalo integer, ndisk integer,"
+        " nbulge integer, nstars integer, nbndry integer,"
+        " xmin real, xmax real, ymin real, ymax real, zmin real, zmax real,"
+        " primary key (file,frame))") &&
+    exe("create index if not exists frames_time on frames (time)") &&
+    exe("create table if not exists boxes (file text, frame integer, comp text,"
+        " n integer, xmin real, xmax real, ymin real, ymax real, zmin real, zmax real,"
+        " primary key (file,frame,comp))") &&
+    exe("create table if not exists rings (ring integer primary key, a real, p real)") &&
+    exe("create table if not exists caustics (file text, frame integer, ring integer,"
+        " ninside integer, nin integer, nout integer, primary key (file,frame,ring))");
+}
+// ----------------------------------------------------------------------------
+// loadRings : rings 1..N already in the catalog
+void CFrameCatalog::loadRings()
+{
+  ring_a.clear();
+  ring_p.clear();
+  if (exe("select ring,a,p from rings order by ring")) {
+    for (unsigned int i=0; i+2<sql->vdata.size(); i+=3) {
+      if (atoi(sql->vdata[i].c_str()) != (int) ring_a.size()+1) {
+        std::cerr << "CFrameCatalog: rings must be numbered 1..N, ring "
+                  << sql->vdata[i] << " ignored\n";
+        continue;
+      }
+      ring_a.push_back(atof(sql->vdata[i+1].c_str()));
+      ring_p.push_back(atof(sql->vdata[i+2].c_str()));
+    }
+  }
+}
+// ----------------------------------------------------------------------------
+// addRing
+int CFrameCatalog::addRing(const float a, const float p)
+{
+  std::ostringstream s;
+  s << std::setprecision(9) << "insert into rings values ("
+    << ring_a.size()+1 << "," << a << "," << p << ")";
+  if (!exe(s.str())) return -1;
+  ring_a.push_back(a);
+  ring_p.push_back(p);
+  return ring_a.size();
+}
+// ----------------------------------------------------------------------------
+// addPos : bounding box of the n positions of comp, and the bodies in the
+// rings, compared with the previous frame by endSave()
+void CFrameCatalog::addPos(const std::string comp, const int n, const float * pos)
+{
+  const std::string key = (comp=="dm" ? "halo" : comp);
+  CCompStat & s = stat[key];
+  s.n = n;
+  for (int k=0; k<6; k++) s.box[k] = 0.;
+  for (int i=0; i<n; i++) {
+    for (int k=0; k<3; k++) {
+      const float x = pos[3*i+k];
+      if (i==0 || x < s.box[2*k  ]) s.box[2*k  ] = x;
+      if (i==0 || x > s.box[2*k+1]) s.box[2*k+1] = x;
+    }
+  }
+  const int nring = ring_a.size();
+  s.ninside.assign(nring,0);
+  s.nin.assign(nring,0);
+  s.nout.assign(nring,0);
+  s.now.assign(n*nring,false);
+  if (nring == 0) return;
+  std::vector<bool> & now = s.now;
+  for (int r=0; r<nring; r++) {
+    // tricusp of radius a and width p, as in falcON's caustic_crossings
+    tricusp_t t;
+    tricusp_set(&t,ring_a[r],ring_p[r]);
+    for (int i=0; i<n; i++) {
+      const double R = std::sqrt(pos[3*i]*pos[3*i]+pos[3*i+1]*pos[3*i+1]);
+      if (tricusp_inside(&t,R,pos[3*i+2])) {
+        now[i*nring+r] = true;
+        s.ninside[r]++;
+      }
+    }
+  }
+}
+// ----------------------------------------------------------------------------
+// crossings : bodies of comp which came in or went out of the rings since
+// the previous frame of the file
+void CFrameCatalog::crossings(const std::string key, CCompStat & s)
+{
+  const int nring = ring_a.size();
+  if (nring == 0) return;
+  std::vector<bool> & was = inside[key];
+  const bool same = (int) was.size() == s.n*nring;
+  for (int r=0; r<nring; r++) {
+    for (int i=0; same && i<s.n; i++) {
+      if ( s.now[i*nring+r] && !was[i*nring+r]) s.nin [r]++;
+      if (!s.now[i*nring+r] &&  was[i*nring+r]) s.nout[r]++;
+    }
+    if (!same) s.nin[r] = s.nout[r] = -1;
+  }
+  was.swap(s.now);
+}
+// ----------------------------------------------------------------------------
+// beginSave : called before saving a frame to file, appended to it or not
+void CFrameCatalog::beginSave(const std::string _file, const bool append)
+{
+  if (_file != file || !append) {
+    file   = _file;
+    nframe = 0;
+    inside.clear();                     // no previous frame to compare with
+  }
+  offset = (file == "-" ? -1 : 0);
+  if (nframe > 0 && file != "-") {      // where the frame will start
+    struct stat st;
+    fflush(NULL);                       // pending output of previous frames
+    offset = (::stat(file.c_str(),&st)==0 ? (long long) st.st_size : -1);
+  }
+}
+// ----------------------------------------------------------------------------
+// endSave : called after the frame is saved, index it
+bool CFrameCatalog::endSave()
+{
+  if (file == "-") {                    // standard output, not indexed
+    stat.clear();
+    return false;
+  }
+  std::map<std::string, CCompStat>::iterator it;
+  for (it=stat.begin(); it!=stat.end(); it++) {
+    crossings(it->first,it->second);
+  }
+  std::string name = file;
+  char path[PATH_MAX];
+  if (realpath(file.c_str(),path)) name = path;
+  const std::string qname = jclt::CSQLite3::quote(name);
+
+  // totals, from "all" or from the components
+  CCompStat all;
+  it = stat.find("all");
+  if (it != stat.end()) {
+    all = it->second;
+  } else {
+    all.n = 0;
+    for (int k=0; k<6; k++) all.box[k] = 0.;
+    all.ninside.assign(ring_a.size(),0);
+    all.nin.assign(ring_a.size(),0);
+    all.nout.assign(ring_a.size(),0);
+    for (it=stat.begin(); it!=stat.end(); it++) {
+      const CCompStat & s = it->second;
+      if (s.n == 0) continue;
+      for (int k=0; k<3; k++) {
+        if (all.n==0 || s.box[2*k  ] < all.box[2*k  ]) all.box[2*k  ] = s.box[2*k  ];
+        if (all.n==0 || s.box[2*k+1] > all.box[2*k+1]) all.box[2*k+1] = s.box[2*k+1];
+      }
+      all.n += s.n;
+      for (unsigned int r=0; r<ring_a.size(); r++) {
+        all.ninside[r] += s.ninside[r];
+        all.nin [r] = (all.nin [r]<0 || s.nin [r]<0 ? -1 : all.nin [r]+s.nin [r]);
+        all.nout[r] = (all.nout[r]<0 || s.nout[r]<0 ? -1 : all.nout[r]+s.nout[r]);
+      }
+    }
+  }
+  const char * comps[] = { "gas", "halo", "disk", "bulge", "stars", "bndry" };
+  std::ostringstream s;
+  s << std::setprecision(9);
+  s << "insert or replace into frames values (" << qname << "," << nframe << ","
+    << offset << "," << time << "," << all.n;
+  for (int c=0; c<6; c++) {
+    it = stat.find(comps[c]);
+    s << "," << (it != stat.end() ? it->second.n : 0);
+  }
+  for (int k=0; k<6; k++) s << "," << all.box[k];
+  s << ");\n";
+  for (it=stat.begin(); it!=stat.end(); it++) {
+    s << "insert or replace into boxes values (" << qname << "," << nframe << ","
+      << jclt::CSQLite3::quote(it->first) << "," << it->second.n;
+    for (int k=0; k<6; k++) s << "," << it->second.box[k];
+    s << ");\n";
+  }
+  for (unsigned int r=0; r<ring_a.size(); r++) {
+    s << "insert or replace into caustics values (" << qname << "," << nframe << ","
+      << r+1 << "," << all.ninside[r] << "," << all.nin[r] << "," << all.nout[r] << ");\n";
+  }
+  bool ok = exe("begin");
+  if (ok && nframe == 0) {              // a new file, forget the old one
+    ok = exe("delete from frames where file="+qname+";"
+             "delete from boxes where file="+qname+";"
+             "delete from caustics where file="+qname);
+  }
+  ok = ok && exe(s.str());
+  exe(ok ? "commit" : "rollback");
+  if (verbose) {
+    std::cerr << "CFrameCatalog: frame "<<nframe<<" of ["<<name<<"] at offset "
+              <<offset<<", time "<<time<<(ok ? " indexed\n" : " NOT indexed\n");
+  }
+  nframe++;
+  stat.clear();
+  return ok;
+}
+// ----------------------------------------------------------------------------
+// select : run a query on file,frame,offset,time
+int CFrameCatalog::select(const std::string query, std::vector<CFrameEntry> & frames)
+{
+  frames.clear();
+  if (!exe(query)) return -1;
+  for (unsigned int i=0; i+3<sql->vdata.size(); i+=4) {
+    CFrameEntry f;
+    f.file   = sql->vdata[i];
+    f.frame  = atoi(sql->vdata[i+1].c_str());
+    f.offset = atoll(sql->vdata[i+2].c_str());
+    f.time   = atof(sql->vdata[i+3].c_str());
+    frames.push_back(f);
+  }
+  return frames.size();
+}
+// ----------------------------------------------------------------------------
+// selectTime : frames with t1 <= time <= t2
+int CFrameCatalog::selectTime(const float t1, const float t2,
+                              std::vector<CFrameEntry> & frames)
+{
+  std::ostringstream s;
+  s << std::setprecision(9)
+    << "select file,frame,offset,time from frames where time between "
+    << t1 << " and " << t2 << " order by time,file,frame";
+  return select(s.str(),frames);
+}
+// ----------------------------------------------------------------------------
+// selectBox : frames with t1 <= time <= t2 and bodies in a bounding box
+// which overlaps box (xmin,xmax,ymin,ymax,zmin,zmax)
+int CFrameCatalog::selectBox(const float t1, const float t2, const float box[6],
+                             std::vector<CFrameEntry> & frames)
+{
+  std::ostringstream s;
+  s << std::setprecision(9)
+    << "select file,frame,offset,time from frames where time between "
+    << t1 << " and " << t2 << " and nbody>0"
+    << " and xmin<=" << box[1] << " and xmax>=" << box[0]
+    << " and ymin<=" << box[3] << " and ymax>=" << box[2]
+    << " and zmin<=" << box[5] << " and zmax>=" << box[4]
+    << " order by time,file,frame";
+  return select(s.str(),frames);
+}
+// ----------------------------------------------------------------------------
+// selectRing : frames with t1 <= time <= t2 and bodies inside ring
+int CFrameCatalog::selectRing(const float t1, const float t2, const int ring,
+                              std::vector<CFrameEntry> & frames)
+{
+  std::ostringstream s;
+  s << std::setprecision(9)
+    << "select f.file,f.frame,f.offset,f.time from frames f, caustics c"
+    << " where f.file=c.file and f.frame=c.frame and c.ring=" << ring
+    << " and c.ninside>0 and f.time between " << t1 << " and " << t2
+    << " order by f.time,f.file,f.frame";
+  return select(s.str(),frames);
+}
+
+// ----------------------------------------------------------------------------
+// CSnapshotCatalogOut
+// ----------------------------------------------------------------------------
+// constructor
+CSnapshotCatalogOut::CSnapshotCatalogOut(CSnapshotInterfaceOut * _snapshot,
+                                         CFrameCatalog * _catalog,
+                                         const std::string _n, const std::string _t,
+                                         const bool _append, const bool verb):
+  CSnapshotInterfaceOut(_n,_t,verb)
+{
+  snapshot = _snapshot;
+  catalog  = _catalog;
+  append   = _append;
+  interface_type = snapshot->getInterfaceType();
+  file_structure = snapshot->getFileStructure();
+}
+// ----------------------------------------------------------------------------
+// destructor
+CSnapshotCatalogOut::~CSnapshotCatalogOut()
+{
+  delete snapshot;
+  delete catalog;
+}
+// ----------------------------------------------------------------------------
+// setCatalog : index the next frames in another catalog
+void CSnapshotCatalogOut::setCatalog(CFrameCatalog * _catalog)
+{
+  if (catalog != _catalog) delete catalog;
+  catalog = _catalog;
+}
+// ----------------------------------------------------------------------------
+// addPos : positions by address may still change until save()
+void CSnapshotCatalogOut::addPos(const std::string comp, const int n, float * pos,
+                                 const bool _addr)
+{
+  if (!pos) return;
+  if (_addr) {
+    CPosAddr p;
+    p.comp = comp;
+    p.n    = n;
+    p.pos  = pos;
+    posaddr.push_back(p);
+  } else {
+    catalog->addPos(comp,n,pos);
+  }
+}
+// ----------------------------------------------------------------------------
+// setData prop fvalue
+int CSnapshotCatalogOut::setData(std::string prop, float fvalue)
+{
+  if (prop=="time") catalog->setTime(fvalue);
+  return snapshot->setData(prop,fvalue);
+}
+// ----------------------------------------------------------------------------
+// setData prop farray
+int CSnapshotCatalogOut::setData(std::string prop, const int n, float * farray,
+                                 const bool _addr)
+{
+  if (prop=="pos") addPos("all",n,farray,_addr);
+  return snapshot->setData(prop,n,farray,_addr);
+}
+// ----------------------------------------------------------------------------
+// setData comp prop farray
+int CSnapshotCatalogOut::setData(std::string comp, std::string prop, const int n,
+                                 float * farray, const bool _addr)
+{
+  if (prop=="pos") addPos(comp,n,farray,_addr);
+  return snapshot->setData(comp,prop,n,farray,_addr);
+}
+// ----------------------------------------------------------------------------
+// setData comp mass pos vel
+int CSnapshotCatalogOut::setData(std::string comp, const int n, float * mass,
+                                 float * pos, float * vel, const bool _addr)
+{
+  addPos(comp,n,pos,_addr);
+  return snapshot->setData(comp,n,mass,pos,vel,_addr);
+}
+// ----------------------------------------------------------------------------
+// save : index the frame written by snapshot
+int CSnapshotCatalogOut::save()
+{
+  for (unsigned int i=0; i<posaddr.size(); i++) {
+    catalog->addPos(posaddr[i].comp,posaddr[i].n,posaddr[i].pos);
+  }
+  posaddr.clear();
+  catalog->beginSave(simname,append);
+  int status = snapshot->save();
+  catalog->endSave();
+  return status;
+}
+
+} // namespace uns
+#endif // NOSQLITE3
@@ -0,0 +1,154 @@
+// ============================================================================
+// Copyright Jean-Charles LAMBERT - 2008-2014
+//           Centre de donneeS Astrophysiques de Marseille (CeSAM)              
+// e-mail:   Jean-Charles.Lambert@lam.fr                                      
+// address:  Aix Marseille Universite, CNRS, LAM 
+//           Laboratoire d'Astrophysique de Marseille                          
+//           Pole de l'Etoile, site de Chateau-Gombert                         
+//           38, rue Frederic Joliot-Curie                                     
+//           13388 Marseille cedex 13 France                                   
+//           CNRS UMR 7326                                       
+// ============================================================================
+
+/**
+	@author Jean-Charles Lambert <Jean-Charles.Lambert@lam.fr>
+ */
+
+// ============================================================================
+// CFrameCatalog: SQLite3 catalog of the frames written by CunsOut
+//
+// Each frame saved by a CunsOut which has a catalog (CunsOut::setCatalog(db),
+// or UNSIO_CATALOG=db in the environment) is indexed in the database db.
+// CunsOut then writes through a CSnapshotCatalogOut, which hands the time
+// and positions to the catalog on their way to the real output snapshot, so
+// frames written with unsout->snapshot->setData() and save() are indexed too:
+//
+//  frames   (file,frame,offset,time,nbody,ngas,nhalo,ndisk,nbulge,nstars,
+//            nbndry,xmin,xmax,ymin,ymax,zmin,zmax)   one row per frame
+//  boxes    (file,frame,comp,n,xmin,...,zmax)         per component
+//  rings    (ring,a,p)                                caustic rings
+//  caustics (file,frame,ring,ninside,nin,nout)        per frame and ring
+//
+// offset is the position of the frame in the file (-1 if unknown) and frame
+// its number in the file. Caustic ring n, of radius a and width p, is
+// axisymmetric about the z axis, with the tricusp cross section of the
+// caustic_crossings manipulator of falcON: both use NEMO's tricusp.h (see
+// test_src/testtricusp.cc). ninside counts the bodies inside it, nin and
+// nout the bodies which came in or went out since the previous frame of the
+// same file (-1 if the bodies are not the same).
+//
+// Frames can then be selected without reading the snapshots, with the
+// select*() methods below, or with plain SQL, e.g.
+//
+//   select f.file,f.offset,f.time from frames f, caustics c
+//   where f.file=c.file and f.frame=c.frame and c.ring=2 and c.ninside>0
+//   and f.time between 1.0 and 2.0;
+
+#ifndef FRAMECATALOG_H
+#define FRAMECATALOG_H
+#ifndef NOSQLITE3
+#include <string>
+#include <vector>
+#include <map>
+#include "sqlite_tools.h"
+#include "snapshotinterface.h"
+
+namespace uns {
+
+  class CFrameEntry {
+  public:
+    std::string file;
+    int frame;
+    long long offset;
+    float time;
+  };
+
+  class CFrameCatalog {
+  public:
+    CFrameCatalog(const std::string db, const bool verb=false);
+    ~CFrameCatalog();
+    bool isOpen() { return sql->isOpen(); }
+    // rings
+    int  addRing(const float a, const float p);    // returns its number
+    int  getNRing() const { return ring_a.size(); }
+    // filled by CunsOut
+    void setTime(const float t) { time = t; }
+    void addPos(const std::string comp, const int n, const float * pos);
+    void beginSave(const std::string file, const bool append);
+    bool endSave();
+    // queries, frames ordered by time
+    int selectTime(const float t1, const float t2, std::vector<CFrameEntry> &);
+    int selectBox (const float t1, const float t2, const float box[6],
+                   std::vector<CFrameEntry> &);
+    int selectRing(const float t1, const float t2, const int ring,
+                   std::vector<CFrameEntry> &);
+
+  private:
+    // statistics of the positions given for one component
+    class CCompStat {
+    public:
+      int n;
+      float box[6];                    // xmin,xmax,ymin,ymax,zmin,zmax
+      std::vector<int> ninside, nin, nout;
+      std::vector<bool> now;           // in rings, per body and ring
+    };
+    jclt::CSQLite3 * sql;
+    bool verbose;
+    float time;
+    std::string file;                  // file being written
+    int nframe;                        // frames saved in it
+    long long offset;
+    std::map<std::string, CCompStat> stat;
+    std::map<std::string, std::vector<bool> > inside; // in rings, previous frame
+    std::vector<float> ring_a, ring_p;
+    bool exe(const std::string);
+    bool createTables();
+    void loadRings();
+    void crossings(const std::string, CCompStat &);
+    int  select(const std::string, std::vector<CFrameEntry> &);
+  };
+
+  // CSnapshotCatalogOut: output snapshot which indexes the frames saved by
+  // snapshot in catalog. It owns both.
+  class CSnapshotCatalogOut : public CSnapshotInterfaceOut {
+  public:
+    CSnapshotCatalogOut(CSnapshotInterfaceOut *, CFrameCatalog *,
+                        const std::string _n, const std::string _t,
+                        const bool append, const bool verb=false);
+    ~CSnapshotCatalogOut();
+    CFrameCatalog * getCatalog() { return catalog; }
+    void setCatalog(CFrameCatalog *);
+    int setHeader(void * h) { return snapshot->setHeader(h); }
+    int setNbody(const int n) { return snapshot->setNbody(n); }
+    int setData(std::string, float);
+    int setData(std::string, const int, float *, const bool _addr=false);
+    int setData(std::string, std::string, const int, float *, const bool _addr=false);
+    int setData(std::string comp, std::string prop, const int n, int * i, const bool _addr=false) {
+      return snapshot->setData(comp,prop,n,i,_addr);
+    }
+    int setData(std::string, const int, float *, float *, float *, const bool _addr=false);
+    int setData(std::string prop, const int n, int * i, const bool _addr=false) {
+      return snapshot->setData(prop,n,i,_addr);
+    }
+    int save();
+    std::vector<double> moveToCom() { return snapshot->moveToCom(); }
+    int close() { return snapshot->close(); }
+
+  private:
+    // positions given by address, read by save()
+    class CPosAddr {
+    public:
+      std::string comp;
+      int n;
+      float * pos;
+    };
+    CSnapshotInterfaceOut * snapshot;
+    CFrameCatalog * catalog;
+    bool append;                       // frames are appended to simname
+    std::vector<CPosAddr> posaddr;
+    void addPos(const std::string, const int, float *, const bool);
+  };
+
+} // namespace
+#endif
+#endif
@@ -17,6 +17,10 @@
 
 #include <sstream>
 #include <cstdlib>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "snapshotgadget.h"
 #include "uns.h"
 #include "ctools.h"
@@ -166,6 +170,7 @@ int CSnapshotGadgetIn::open(const std::string myfile)
   int fail=0;
   in.clear();
   in.open(myfile.c_str(),std::ios::in | std::ios::binary);
+  opened = myfile;
   if ( ! in.is_open()) {
    in.close();
    in.clear(); // mandatory under win32 !
@@ -176,6 +181,7 @@ int CSnapshotGadgetIn::open(const std::string myfile)
    if (in.is_open()) {
 //     assert(in.good());
      lonely_file=false;
+     opened = file0;
      PRINT("It's a multiple gadget file.\n";)
    }
   }
@@ -220,7 +226,7 @@ template <class T> int CSnapshotGadgetIn::readCompData(T ** data, const int * in
     if (header.npart[k]>0) { // there are particles for the component
       int idx=index2[npartOffset[k]];                
       if (idx != -1) {
-        readData((char *) &ptr[dim*idx], sizeof(T), dim*header.npart[k]);
+        queueData((char *) &ptr[dim*idx], sizeof(T), dim*header.npart[k]);
       } else {
         skipData(sizeof(T)*dim*header.npart[k]);
       }
@@ -247,11 +253,11 @@ template <class T> int CSnapshotGadgetIn::readGasStarsUnknownArray(T ** data, in
   // read gas DATA
   int idx=compOffset[0]*(*nguess); // set index to the correct offset
   assert((idx+(*nguess)*header.npart[0])<=(*nguess)*(header.npartTotal[0]+header.npartTotal[4]));
-  readData((char *) &ptr[idx], sizeof(float),(*nguess)*header.npart[0]);
+  queueData((char *) &ptr[idx], sizeof(float),(*nguess)*header.npart[0]);
   // read stars DATA
   idx=header.npartTotal[0]*(*nguess)+compOffset[4]*(*nguess);
   assert((idx+(*nguess)*header.npart[4])<=(*nguess)*(header.npartTotal[0]+header.npartTotal[4]));
-  readData((char *) &ptr[idx], sizeof(float),(*nguess)*header.npart[4]);
+  queueData((char *) &ptr[idx], sizeof(float),(*nguess)*header.npart[4]);
   int len2 = readFRecord();
   if (len2==len1) ; // remove warning....
   assert(in.good() && len2==len1 && len1==bytes_counter);
@@ -270,7 +276,7 @@ template <class T> int CSnapshotGadgetIn::readOneArray(T ** data, const int comp
   T * ptr = *data;
   int idx=compOffset[0]; // set index to the correct offset
   assert((idx+header.npart[compid])<=header.npartTotal[compid]);
-  readData((char *) &ptr[idx], sizeof(float),header.npart[compid] );
+  queueData((char *) &ptr[idx], sizeof(float),header.npart[compid] );
   int len2 = readFRecord();
   if (len2==len1) ; // remove warning....
   assert(in.good() && len1==len2 && len1==bytes_counter);
@@ -382,6 +388,14 @@ int CSnapshotGadgetIn::read(uns::UserSelection &user_select)
           // allocate memory if NULL pointer
           if (! mass )  mass = new float[nsel  ];
           for(int k=0;k<6;k++) {
+            if (header.mass[k] == 0 && header.npart[k] > 0) {    // variable masses
+              int idx0=index2[npartOffset[k]], n=0;
+              while (idx0 != -1 && n<header.npart[k] && index2[npartOffset[k]+n]==idx0+n) n++;
+              if (n == header.npart[k]) {                        // all selected, in a row
+                queueData((char *) &mass[idx0], sizeof(float), n);
+                continue;
+              }
+            }
             for(int n=0;n<header.npart[k];n++){
               int idx=index2[npartOffset[k]+n];
               assert(idx<nsel);
@@ -573,6 +587,7 @@ int CSnapshotGadgetIn::read(uns::UserSelection &user_select)
       age_offset += header.npart[4];
       im_offset  += header.npart[4];
     } // end of loop on numfiles
+    readJobs(); // read the blocks queued
 
     // garbage collecting
     delete [] index2;
@@ -841,6 +856,132 @@ int CSnapshotGadgetIn::readData(char * ptr,const size_t size_bytes,const int ite
   return 1;
 }
 // ============================================================================
+// queueData:
+// as readData, but the data are read later, by readJobs, together with
+// the other big blocks of all the files of the snapshot. Data which must
+// be converted are read now.
+int CSnapshotGadgetIn::queueData(char * ptr,const size_t size_bytes,const int items)
+{
+  if (array_vs_file_size!=0) {
+    return readData(ptr,size_bytes,items);
+  }
+  CGadgetReadJob job;
+  job.file   = opened;
+  job.offset = (long long) in.tellg();
+  job.bytes  = size_bytes*items;
+  job.ptr    = ptr;
+  job.size   = size_bytes;
+  job.fd     = -1;                 // opened by readJobs
+  jobs.push_back(job);
+  bytes_counter += job.bytes;
+  in.seekg(job.bytes,std::ios::cur);
+  return in.good();
+}
+// ============================================================================
+// readJobs:
+// read the data queued by queueData. They are cut in chunks, which are read
+// with pread and swapped by $UNSIO_THREADS threads (default: one per core,
+// at most 16), from all the files at once.
+#define GADGET_CHUNK (1<<24) // bytes per chunk
+#define GADGET_MAXTHREADS 16
+typedef struct {
+  std::vector<CGadgetReadJob> chunk;
+  std::map<std::string,int> fd;
+  size_t next;                // next chunk to read
+  bool swap, fail;
+  pthread_mutex_t lock;
+} t_gadget_read;
+
+static void * gadgetReadChunks(void * arg)
+{
+  t_gadget_read * gr = (t_gadget_read *) arg;
+  for (;;) {
+    pthread_mutex_lock(&gr->lock);
+    size_t i = gr->next++;
+    pthread_mutex_unlock(&gr->lock);
+    if (i >= gr->chunk.size()) break;
+    const CGadgetReadJob & c = gr->chunk[i];
+    size_t done=0;
+    while (done < c.bytes) {
+      ssize_t r = pread(c.fd, c.ptr+done, c.bytes-done, (off_t) (c.offset+done));
+      if (r <= 0) break;
+      done += r;
+    }
+    if (done != c.bytes) {
+      pthread_mutex_lock(&gr->lock);
+      gr->fail = true;
+      pthread_mutex_unlock(&gr->lock);
+    }
+    if (gr->swap && c.size > 1) {     // swap each value
+      for (char * p=c.ptr; p<c.ptr+done; p+=c.size) {
+        for (size_t k=0; k<c.size/2; k++) {
+          char t=p[k]; p[k]=p[c.size-k-1]; p[c.size-k-1]=t;
+        }
+      }
+    }
+  }
+  return NULL;
+}
+
+int CSnapshotGadgetIn::readJobs()
+{
+  t_gadget_read gr;
+  gr.next = 0;
+  gr.swap = swap;
+  gr.fail = false;
+  // open every file once, and cut jobs in chunks, which carry the file
+  // descriptor: the threads do not look into gr.fd
+  for (unsigned int i=0; i<jobs.size(); i++) {
+    CGadgetReadJob c = jobs[i];
+    std::map<std::string,int>::iterator it = gr.fd.find(c.file);
+    if (it == gr.fd.end()) {
+      it = gr.fd.insert(std::make_pair(c.file, ::open(c.file.c_str(), O_RDONLY))).first;
+      if (it->second < 0) {
+        std::cerr << "CSnapshotGadgetIn::readJobs unable to open file ["<<c.file<<"]\n";
+        gr.fail = true;
+      }
+    }
+    c.fd = it->second;
+    const size_t chunk = (GADGET_CHUNK/c.size)*c.size;
+    for (size_t done=0; done<jobs[i].bytes; done+=chunk) {
+      c.offset = jobs[i].offset+done;
+      c.ptr    = jobs[i].ptr+done;
+      c.bytes  = std::min(chunk, jobs[i].bytes-done);
+      gr.chunk.push_back(c);
+    }
+  }
+  jobs.clear();
+  int nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+  char * env = getenv("UNSIO_THREADS");
+  if (env) nthreads = atoi(env);
+  nthreads = std::max(1, std::min(std::min(nthreads, GADGET_MAXTHREADS),
+                                  (int) gr.chunk.size()));
+  if (verbose) {
+    std::cerr << "CSnapshotGadgetIn::readJobs "<<gr.chunk.size()<<" chunks from "
+              <<gr.fd.size()<<" file(s) with "<<nthreads<<" thread(s)\n";
+  }
+  if (!gr.fail) {
+    pthread_mutex_init(&gr.lock, NULL);
+    std::vector<pthread_t> threads(nthreads);
+    int nstarted=0;
+    for (int i=1; i<nthreads; i++) {  // this thread is the first one
+      if (pthread_create(&threads[nstarted], NULL, gadgetReadChunks, &gr) == 0)
+        nstarted++;
+    }
+    gadgetReadChunks(&gr);
+    for (int i=0; i<nstarted; i++)
+      pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&gr.lock);
+  }
+  for (std::map<std::string,int>::iterator it=gr.fd.begin(); it!=gr.fd.end(); it++)
+    if (it->second >= 0) ::close(it->second);
+  if (gr.fail) {
+    std::cerr << "CSnapshotGadgetIn::readJobs error while reading ["<<filename<<"], aborting...\n";
+  }
+  assert(!gr.fail);
+  return !gr.fail;
+}
+// ============================================================================
 // getData                                                               
 // return requested array according 'name' selection                                               
 bool CSnapshotGadgetIn::getData(const std::string comp, std::string name, int *n,float **data)
@@ -101,6 +101,21 @@ typedef struct particle_data_lite
 } t_particle_data_lite;
 
 
+  // ---------------------------------------------------
+  // CGadgetReadJob
+  // part of a block to be read later, with pread, straight
+  // into its array (see CSnapshotGadgetIn::readJobs)
+  // ---------------------------------------------------
+  class CGadgetReadJob {
+  public:
+    std::string file;  // file to read
+    long long offset;  // from the beginning of the file
+    size_t bytes;      // to read
+    char * ptr;        // where to
+    size_t size;       // of one value, for swapping
+    int fd;            // file opened by readJobs
+  };
+
   // ---------------------------------------------------
   // CSnapshotGadgetIn
   // READING class
@@ -136,6 +151,7 @@ typedef struct particle_data_lite
    int   getNtotal() const { return npartTotal;}
      std::string filename,file0;
   std::ifstream in;
+  std::string opened; // file being read
 
   int multiplefiles;
   bool lonely_file;
@@ -218,6 +234,10 @@ typedef struct particle_data_lite
   int readHeader(const int);
 
   int readData(char * ptr,const size_t size_bytes,const  int items);
+  // parallel reading
+  std::vector<CGadgetReadJob> jobs;
+  int queueData(char * ptr,const size_t size_bytes,const  int items);
+  int readJobs();
   bool guessVersion();
   int version;
   void unitConversion();
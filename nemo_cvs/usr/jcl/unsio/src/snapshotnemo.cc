@@ -18,6 +18,7 @@
 #include <cstdlib>
 #include <assert.h>
 #include <algorithm>
+#include <vector>
 #include <cctype> // for toupper()
 #include "snapshotnemo.h"
 #include "ctools.h"
@@ -26,6 +27,118 @@
 #define DEBUG 0
 #include "unsdebug.h"
 
+#ifdef PartsTag
+// ============================================================================
+// Partitioned snapshots (see NEMO's strpart.c): a manifest with, for every
+// snapshot, its Parameters and where its bodies went, plus part files which
+// each hold a range of the bodies. Every part is read or written by its own
+// thread; the arrays hold all bodies and each part fills its own range.
+namespace {
+  struct NemoParts {
+    stream * part;            // part streams
+    int * nobj, * first;      // bodies in each part, and where they start
+    int * bits;               // NEMO bits of each part read
+    int nmax;                 // bodies the arrays have room for
+    float time;
+    float * pos, * vel, * mass, * rho, * aux, * acc, * pot, * eps;
+    int * keys;
+  };
+  // read [n][dim] floats named tag into *data, from body first on;
+  // a missing array is only allocated when alloc, i.e. for part 0
+  bool readItem(stream str, const char * tag, float ** data, int nmax,
+                int first, int n, int dim, bool alloc)
+  {
+    if (!get_tag_ok(str,(char *) tag)) return false;
+    if (!*data) {
+      if (!alloc) return false;
+      *data = (float *) malloc(sizeof(float)*nmax*dim);
+    }
+    if (dim==1) get_data_coerced(str,(char *) tag,(char *) FloatType,*data+first,n,0);
+    else        get_data_coerced(str,(char *) tag,(char *) FloatType,*data+first*dim,n,dim,0);
+    return true;
+  }
+  void readPart(int k, void * arg)
+  {
+    NemoParts * np = (NemoParts *) arg;
+    stream str = np->part[k];
+    int n = np->nobj[k], f = np->first[k], b = 0;
+    bool alloc = (k==0); // part 0 is read first, before the threads start
+    get_set(str,(char *) SnapShotTag);
+    if (get_tag_ok(str,(char *) ParticlesTag)) {
+      get_set(str,(char *) ParticlesTag);
+      if (readItem(str,MassTag,&np->mass,np->nmax,f,n,1,alloc)) b |= MassBit;
+      if (get_tag_ok(str,(char *) PhaseSpaceTag)) {
+        if (alloc && !np->pos) np->pos = (float *) malloc(sizeof(float)*np->nmax*3);
+        if (alloc && !np->vel) np->vel = (float *) malloc(sizeof(float)*np->nmax*3);
+        if (np->pos && np->vel) {
+          float * ps = (float *) malloc(sizeof(float)*n*6);
+          get_data_coerced(str,(char *) PhaseSpaceTag,(char *) FloatType,ps,n,2,3,0);
+          for (int i=0; i<n; i++)
+            for (int j=0; j<3; j++) {
+              np->pos[(f+i)*3+j] = ps[i*6+j];
+              np->vel[(f+i)*3+j] = ps[i*6+3+j];
+            }
+          free(ps);
+          b |= PosBit | VelBit;
+        }
+      } else {
+        if (readItem(str,PosTag,&np->pos,np->nmax,f,n,3,alloc)) b |= PosBit;
+        if (readItem(str,VelTag,&np->vel,np->nmax,f,n,3,alloc)) b |= VelBit;
+      }
+      if (readItem(str,PotentialTag,&np->pot,np->nmax,f,n,1,alloc))    b |= PotentialBit;
+      if (readItem(str,AccelerationTag,&np->acc,np->nmax,f,n,3,alloc)) b |= AccelerationBit;
+      if (readItem(str,AuxTag,&np->aux,np->nmax,f,n,1,alloc))          b |= AuxBit;
+      if (readItem(str,DensityTag,&np->rho,np->nmax,f,n,1,alloc))      b |= DensBit;
+      if (readItem(str,EpsTag,&np->eps,np->nmax,f,n,1,alloc))          b |= EpsBit;
+      if (get_tag_ok(str,(char *) KeyTag)) {
+        if (alloc && !np->keys) np->keys = (int *) malloc(sizeof(int)*np->nmax);
+        if (np->keys) {
+          get_data(str,(char *) KeyTag,(char *) IntType,np->keys+f,n,0);
+          b |= KeyBit;
+        }
+      }
+      get_tes(str,(char *) ParticlesTag);
+    }
+    get_tes(str,(char *) SnapShotTag);
+    np->bits[k] = b;
+  }
+  void readRest(int k, void * arg)
+  {
+    readPart(k+1,arg);
+  }
+  // write the Particles set of bodies first..first+n-1
+  void writeParticles(stream str, NemoParts * np, int first, int n)
+  {
+    int cs = CSCode(Cartesian, 3, 2);
+    put_set(str,(char *) ParticlesTag);
+    put_data(str,(char *) CoordSystemTag,(char *) IntType,&cs,0);
+    if (np->mass) put_data(str,(char *) MassTag,(char *) FloatType,np->mass+first,n,0);
+    if (np->pos)  put_data(str,(char *) PosTag,(char *) FloatType,np->pos+first*3,n,3,0);
+    if (np->vel)  put_data(str,(char *) VelTag,(char *) FloatType,np->vel+first*3,n,3,0);
+    if (np->pot)  put_data(str,(char *) PotentialTag,(char *) FloatType,np->pot+first,n,0);
+    if (np->acc)  put_data(str,(char *) AccelerationTag,(char *) FloatType,np->acc+first*3,n,3,0);
+    if (np->aux)  put_data(str,(char *) AuxTag,(char *) FloatType,np->aux+first,n,0);
+    if (np->keys) put_data(str,(char *) KeyTag,(char *) IntType,np->keys+first,n,0);
+    if (np->rho)  put_data(str,(char *) DensityTag,(char *) FloatType,np->rho+first,n,0);
+    if (np->eps)  put_data(str,(char *) EpsTag,(char *) FloatType,np->eps+first,n,0);
+    put_tes(str,(char *) ParticlesTag);
+  }
+  void writePart(int k, void * arg)
+  {
+    NemoParts * np = (NemoParts *) arg;
+    stream str = np->part[k];
+    put_set(str,(char *) SnapShotTag);
+    put_set(str,(char *) ParametersTag);
+    put_data(str,(char *) NobjTag,(char *) IntType,&np->nobj[k],0);
+    put_data(str,(char *) TimeTag,(char *) FloatType,&np->time,0);
+    put_tes(str,(char *) ParametersTag);
+    writeParticles(str,np,np->first[k],np->nobj[k]);
+    put_tes(str,(char *) SnapShotTag);
+    fflush(str);
+  }
+}
+#endif
+
 namespace uns {
 
 // ============================================================================
@@ -66,6 +179,9 @@ CSnapshotNemoIn::CSnapshotNemoIn(const std::string _name,
   eps    = NULL;
   last_nbody=0;
   last_nemobits=-1;
+  mstr   = NULL;
+  parts  = false;
+  parts_nmax=0;
   reset_history();
   initparam(const_cast<char**>(argv),const_cast<char**>(defv));
   valid=isValidNemo();
@@ -124,8 +240,36 @@ bool CSnapshotNemoIn::isValidNemo()
     if ( ! str )  status = false; // failed to open
     if (qsf(str)) status = true;  // it's a structured binary file (NEMO)
     else          status = false; // it's not                            
+#ifdef PartsTag
+    if (status) {                 // a partitioned snapshot has Parts
+      rewind(str);                // instead of Particles (qsf read ahead)
+      get_history(str);
+      if (get_tag_ok(str,(char *) SnapShotTag)) {
+        get_set(str,(char *) SnapShotTag);
+        if (get_tag_ok(str,(char *) PartsTag) && get_tag_ok(str,(char *) ParametersTag)) {
+          parts = true;
+          nemobits = (int   *) malloc(sizeof(int));
+          iotime   = (float *) malloc(sizeof(float));
+          ionbody  = (int   *) malloc(sizeof(int));
+          *nemobits = 0;
+          *iotime   = 0.0;
+          get_set(str,(char *) ParametersTag);
+          get_data(str,(char *) NobjTag,(char *) IntType,ionbody,0);
+          if (get_tag_ok(str,(char *) TimeTag)) {
+            get_data_coerced(str,(char *) TimeTag,(char *) FloatType,iotime,0);
+            *nemobits |= TimeBit;
+          }
+          get_tes(str,(char *) ParametersTag);
+          full_nbody = *ionbody;
+        }
+        get_tes(str,(char *) SnapShotTag);
+      }
+    }
+#endif
     strclose(str);
-    if (status)  {                // it's a NEMO snapshot
+    if (parts) {                  // frames are read by readParts()
+      mstr = stropen(filename.c_str(),(char *) "r");
+    } else if (status)  {         // it's a NEMO snapshot
       int * ptr=NULL;      // get the full nbody
       if (io_nemo(filename.c_str(),"float,read,n,t,b",&ptr,&iotime,&nemobits) != 0) {
         io_nemo(filename.c_str(),"close");
@@ -175,6 +319,9 @@ int CSnapshotNemoIn::nextFrame(uns::UserSelection &user_select)
   int status;  // io_nemo status
   std::string force_select = "all";
   if (! first_stream) { // normal file or second reading (stream)
+    if (parts)
+      status=readParts();
+    else
     status=io_nemo(filename.c_str(),"float,read,sp,n,pos,vel,mass,dens,aux,acc,pot,key,e,t,st,b",
                    force_select.c_str(),&ionbody,&iopos,&iovel,&iomass,&iorho,&ioaux,&ioacc,&iopot,&iokeys,&ioeps,
                    &iotime, select_time.c_str(),&nemobits);
@@ -270,13 +417,83 @@ int CSnapshotNemoIn::nextFrame(uns::UserSelection &user_select)
 int CSnapshotNemoIn::close()
 {
   int status=0;
-  if (valid) {
+  if (valid && parts) {
+    if (mstr) strclose(mstr);   // closes the part files too
+    mstr = NULL;
+    end_of_data = false;
+  }
+  else if (valid) {
     status = io_nemo(filename.c_str(),"close");
     end_of_data = false;
   }
   return status;
 }
 // ============================================================================
+// readParts()                                                                 
+// read the next selected frame of a partitioned snapshot, its parts in
+// parallel; return 1, or 0 at the end of the file
+int CSnapshotNemoIn::readParts()
+{
+#ifdef PartsTag
+  for (;;) {
+    get_history(mstr);
+    if (! get_tag_ok(mstr,(char *) SnapShotTag)) return 0;
+    get_set(mstr,(char *) SnapShotTag);
+    int nbody=0, b=0;
+    float t=0.0;
+    if (get_tag_ok(mstr,(char *) ParametersTag)) {
+      get_set(mstr,(char *) ParametersTag);
+      get_data(mstr,(char *) NobjTag,(char *) IntType,&nbody,0);
+      if (get_tag_ok(mstr,(char *) TimeTag)) {
+        get_data_coerced(mstr,(char *) TimeTag,(char *) FloatType,&t,0);
+        b |= TimeBit;
+      }
+      get_tes(mstr,(char *) ParametersTag);
+    }
+    bool sel = select_time == "all" ||
+               ((b & TimeBit) && within(t,(char *) select_time.c_str(),0.001));
+    NemoParts np;
+    int nparts=0;
+    np.part = NULL;
+    if (sel) np.part = get_parts(mstr,(char *) SnapShotTag,&nparts,&np.nobj);
+    if (np.part) {
+      if (nbody > parts_nmax) { // arrays too small: part 0 makes new ones
+        free(iopos);  free(iovel); free(iomass); free(iorho); free(ioaux);
+        free(ioacc);  free(iopot); free(iokeys); free(ioeps);
+        iopos=iovel=iomass=iorho=ioaux=ioacc=iopot=ioeps=NULL;
+        iokeys=NULL;
+        parts_nmax = nbody;
+      }
+      std::vector<int> first(nparts,0), bits(nparts,0);
+      for (int k=1; k<nparts; k++) first[k] = first[k-1] + np.nobj[k-1];
+      np.first = &first[0];
+      np.bits  = &bits[0];
+      np.nmax  = parts_nmax;
+      np.pos = iopos; np.vel = iovel; np.mass = iomass; np.rho  = iorho;
+      np.aux = ioaux; np.acc = ioacc; np.pot  = iopot;  np.keys = iokeys;
+      np.eps = ioeps;
+      readPart(0,&np);          // allocates the arrays
+      if (nparts > 1) run_parts(nparts-1,readRest,&np);
+      iopos = np.pos; iovel = np.vel; iomass = np.mass; iorho  = np.rho;
+      ioaux = np.aux; ioacc = np.acc; iopot  = np.pot;  iokeys = np.keys;
+      ioeps = np.eps;
+      int pb = bits[0];
+      for (int k=1; k<nparts; k++) pb &= bits[k];
+      b |= pb;
+    }
+    get_tes(mstr,(char *) SnapShotTag);
+    if (sel) {
+      *ionbody  = nbody;
+      *iotime   = t;
+      *nemobits = b;
+      return 1;
+    }
+  }
+#else
+  return 0;
+#endif
+}
+// ============================================================================
 // checkBits                                                                   
 void CSnapshotNemoIn::checkBits(std::string comp,const int bits)
 {
@@ -608,6 +825,7 @@ CSnapshotNemoOut::CSnapshotNemoOut(const std::string _n, const std::string _t, c
   bits = 0;
   is_saved=false;
   is_closed=false;
+  mstr = NULL;
 }
 // ----------------------------------------------------------------------------
 // desstructor
@@ -850,6 +1068,11 @@ int CSnapshotNemoOut::setArray(const int _n, const int dim, int * src, int ** de
 //
 int CSnapshotNemoOut::save()
 {
+#ifdef PartsTag
+  const char * np = getenv("NEMOPARTS");
+  if (mstr || (np && atoi(np) > 1)) // partitioned snapshot
+    return saveParts();
+#endif
   int   * n = &nbody;
   float * t = &time;
   int   * b = &bits;
@@ -867,11 +1090,58 @@ int CSnapshotNemoOut::close()
   int status=0;
   if (is_saved && !is_closed) {
     is_closed = true;
-    status = io_nemo(simname.c_str(),"close");    
+    if (mstr) strclose(mstr);   // closes the part files too
+    else      status = io_nemo(simname.c_str(),"close");    
+    mstr = NULL;
   }
   return status;
 }
 // ============================================================================
+// saveParts()                                                                 
+// save a frame as a partitioned snapshot, with $NEMOPARTS part files
+// written in parallel
+int CSnapshotNemoOut::saveParts()
+{
+#ifdef PartsTag
+  if (!mstr) {
+    mstr = stropen(simname.c_str(),(char *) "w");
+    put_history(mstr);
+  }
+  NemoParts np;
+  np.time = time;
+  np.mass = (bits & MassBit)         ? mass : NULL;
+  np.pos  = (bits & PosBit)          ? pos  : NULL;
+  np.vel  = (bits & VelBit)          ? vel  : NULL;
+  np.pot  = (bits & PotentialBit)    ? pot  : NULL;
+  np.acc  = (bits & AccelerationBit) ? acc  : NULL;
+  np.aux  = (bits & AuxBit)          ? aux  : NULL;
+  np.keys = (bits & KeyBit)          ? keys : NULL;
+  np.rho  = (bits & DensBit)         ? rho  : NULL;
+  np.eps  = (bits & EpsBit)          ? eps  : NULL;
+  put_set(mstr,(char *) SnapShotTag);
+  put_set(mstr,(char *) ParametersTag);
+  put_data(mstr,(char *) NobjTag,(char *) IntType,&nbody,0);
+  put_data(mstr,(char *) TimeTag,(char *) FloatType,&time,0);
+  put_tes(mstr,(char *) ParametersTag);
+  int nparts;
+  np.part = put_parts(mstr,nbody,&nparts,&np.nobj);
+  if (np.part) {
+    std::vector<int> first(nparts,0);
+    for (int k=1; k<nparts; k++) first[k] = first[k-1] + np.nobj[k-1];
+    np.first = &first[0];
+    run_parts(nparts,writePart,&np);
+    put_parts_tes(mstr);
+  } else                        // a pipe: all bodies in the one file
+    writeParticles(mstr,&np,0,nbody);
+  put_tes(mstr,(char *) SnapShotTag);
+  fflush(mstr);
+  is_saved=true;
+  return 1;
+#else
+  return 0;
+#endif
+}
+// ============================================================================
 // moveToCom()                                                                     
 std::vector<double> CSnapshotNemoOut::moveToCom()
 {
@@ -54,6 +54,11 @@ private:
     bool first_stream;
     int status_ionemo;
     int last_nbody,last_nemobits;
+    // partitioned snapshot (manifest + part files), read in parallel
+    stream mstr;
+    bool parts;
+    int parts_nmax;
+    int readParts();
     void checkBits(std::string,const int);
     bool isValidNemo();
     float *  getPos()  { //checkBits("pos",PosBit); 
@@ -101,6 +106,9 @@ private:
     int nbody;
     int bits;
     bool is_saved, is_closed;
+    // partitioned snapshot (manifest + part files), written in parallel
+    stream mstr;
+    int saveParts();
     // array
     int setArray(const int _n, const int _d, float * src, float ** dest, const char * name, const int tbits, const bool addr);
     int setArray(const int _n, const int _d, int   * src, int   ** dest, const char * name, const int tbits, const bool addr);
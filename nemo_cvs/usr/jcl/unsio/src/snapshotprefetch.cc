@@ -0,0 +1,479 @@
+// ============================================================================
+// Copyright Jean-Charles LAMBERT - 2008-2014
+//           Centre de donneeS Astrophysiques de Marseille (CeSAM)              
+// e-mail:   Jean-Charles.Lambert@lam.fr                                      
+// address:  Aix Marseille Universite, CNRS, LAM 
+//           Laboratoire d'Astrophysique de Marseille                          
+//           Pole de l'Etoile, site de Chateau-Gombert                         
+//           38, rue Frederic Joliot-Curie                                     
+//           13388 Marseille cedex 13 France                                   
+//           CNRS UMR 7326                                       
+// ============================================================================
+
+/**
+	@author Jean-Charles Lambert <Jean-Charles.Lambert@lam.fr>
+ */
+#include "snapshotprefetch.h"
+#include "ctools.h"
+#include <functional>
+#include <iostream>
+#include <assert.h>
+
+namespace uns {
+  // properties copied in each frame, with the bit which requests them
+  // and their number of values per body
+  struct PrefetchProp {
+    const char * name;
+    unsigned int bit;
+    int dim;
+  };
+  static const PrefetchProp float_props[] = {
+    { "pos"  , POS_BIT  , 3 }, { "vel"  , VEL_BIT  , 3 }, { "acc"  , ACC_BIT , 3 },
+    { "mass" , MASS_BIT , 1 }, { "pot"  , POT_BIT  , 1 }, { "eps"  , EPS_BIT , 1 },
+    { "rho"  , RHO_BIT  , 1 }, { "hsml" , HSML_BIT , 1 }, { "u"    , U_BIT   , 1 },
+    { "temp" , TEMP_BIT , 1 }, { "age"  , AGE_BIT  , 1 }, { "metal", METAL_BIT,1 },
+    { "gas_metal", METAL_BIT, 1 }, { "stars_metal", METAL_BIT, 1 },
+    { "aux"  , AUX_BIT  , 1 }, { "zs"   , ZS_BIT   , 1 }, { "zsmt" , ZSMT_BIT, 1 },
+    { "im"   , IM_BIT   , 1 }, { "ssl"  , SSL_BIT  , 1 }, { "cm"   , CM_BIT  , 1 },
+    { NULL, 0, 0 }
+  };
+  static const PrefetchProp int_props[] = {
+    { "id"   , ID_BIT   , 1 }, { "keys" , KEYS_BIT , 1 },
+    { NULL, 0, 0 }
+  };
+  static const char * float_values[] = { "time", "redshift", NULL };
+  static const char * int_values[]   = { "nsel", "nbody", "ngas", "nhalo", "ndisk",
+                                         "nbulge", "nstars", "nbndry", "czs", "czsmt",
+                                         NULL };
+
+  // ----------------------------------------------------------------------------
+  // constructor
+  CSnapshotPrefetchIn::CSnapshotPrefetchIn(CSnapshotInterfaceIn * _snapshot,
+                                           const int ahead,
+                                           const bool verb)
+    :CSnapshotInterfaceIn(_snapshot->getFileName(), _snapshot->getSelectPart(),
+                          _snapshot->getSelectTime(), verb)
+  {
+    snapshot       = _snapshot;
+    valid          = snapshot->isValidData();
+    interface_type = snapshot->getInterfaceType();
+    file_structure = snapshot->getFileStructure();
+    nbuf   = (ahead > 0 ? ahead : 1) + 1; // ahead frames + the caller's one
+    frame.resize(nbuf);
+    head   = tail = 0;
+    nready = 0;
+    nfree  = nbuf;
+    cur    = -1;
+    started= stop = done = threaded = false;
+    pthread_mutex_init(&lock , NULL);
+    pthread_mutex_init(&slock, NULL);
+    pthread_cond_init(&more, NULL);
+    pthread_cond_init(&less, NULL);
+  }
+  // ----------------------------------------------------------------------------
+  // destructor
+  CSnapshotPrefetchIn::~CSnapshotPrefetchIn()
+  {
+    stopReader();
+    delete snapshot;
+    pthread_mutex_destroy(&lock);
+    pthread_mutex_destroy(&slock);
+    pthread_cond_destroy(&more);
+    pthread_cond_destroy(&less);
+  }
+  // ============================================================================
+  // nextFrame : hand the next frame read to the caller, and give the buffer
+  // of the previous one back to the reader.
+  int CSnapshotPrefetchIn::nextFrame(std::string bits)
+  {
+    if (!started) {
+      started = true;
+      req     = bits;
+      computeBits(bits);
+      threaded = pthread_create(&reader, NULL, startReader, this) == 0;
+      if (!threaded)
+        std::cerr << "CSnapshotPrefetchIn: unable to start the reader thread, "
+                  << "reading synchronously...\n";
+      else if (verbose)
+        std::cerr << "CSnapshotPrefetchIn: reading " << nbuf-1 << " frame(s) ahead\n";
+    }
+    else if (bits != req) {
+      std::cerr << "CSnapshotPrefetchIn: frames are read with bits ["<<req
+                << "], bits ["<<bits<<"] ignored...\n";
+    }
+    if (!threaded) {                   // read it now, in the only buffer
+      if (done) return 0;
+      cur = 0;
+      pthread_mutex_lock(&slock);
+      fillFrame(frame[0], snapshot->nextFrame(req));
+      pthread_mutex_unlock(&slock);
+      done = frame[0].status == 0;
+    }
+    else {
+      pthread_mutex_lock(&lock);
+      if (cur >= 0) {                  // release the previous frame
+        head = (head+1) % nbuf;
+        nfree++;
+        cur = -1;
+        pthread_cond_signal(&less);
+      }
+      while (nready == 0 && !done)
+        pthread_cond_wait(&more, &lock);
+      if (nready == 0) {               // end reached already
+        pthread_mutex_unlock(&lock);
+        end_of_data = true;
+        return 0;
+      }
+      cur = head;
+      nready--;
+      pthread_mutex_unlock(&lock);
+    }
+    const CPrefetchFrame & f = frame[cur];
+    nsel        = f.nsel;
+    end_of_data = f.end_of_data;
+    std::map<std::string, float>::const_iterator it = f.fvalue.find("time");
+    if (it != f.fvalue.end()) time = it->second;
+    return f.status;
+  }
+  // ============================================================================
+  // nextFrame : with the caller's selection, read directly
+  int CSnapshotPrefetchIn::nextFrame(uns::UserSelection & user_select)
+  {
+    if (started) {
+      std::cerr << "CSnapshotPrefetchIn: frames are prefetched already, "
+                << "selection ignored...\n";
+      return nextFrame(req);
+    }
+    int status = snapshot->nextFrame(user_select);
+    nsel = snapshot->getNSel();
+    return status;
+  }
+  // ============================================================================
+  // startReader
+  void * CSnapshotPrefetchIn::startReader(void * arg)
+  {
+    static_cast<CSnapshotPrefetchIn *>(arg)->readFrames();
+    return NULL;
+  }
+  // ============================================================================
+  // readFrames : the reader thread, fill the free buffers with the next
+  // frames until the end of the snapshot, or until stopped.
+  void CSnapshotPrefetchIn::readFrames()
+  {
+    bool last=false;
+    while (!last) {
+      pthread_mutex_lock(&lock);
+      while (nfree == 0 && !stop)
+        pthread_cond_wait(&less, &lock);
+      if (stop) {
+        pthread_mutex_unlock(&lock);
+        break;
+      }
+      int slot = tail;
+      pthread_mutex_unlock(&lock);
+
+      pthread_mutex_lock(&slock);      // read without the lock
+      fillFrame(frame[slot], snapshot->nextFrame(req));
+      pthread_mutex_unlock(&slock);
+      last = frame[slot].status == 0;
+
+      pthread_mutex_lock(&lock);
+      tail = (tail+1) % nbuf;
+      nfree--;
+      nready++;
+      if (last) done = true;
+      pthread_cond_signal(&more);
+      pthread_mutex_unlock(&lock);
+    }
+  }
+  // ============================================================================
+  // fillFrame : copy the data of the frame just read by the snapshot,
+  // with the lock of the snapshot held
+  void CSnapshotPrefetchIn::fillFrame(CPrefetchFrame & f, const int status)
+  {
+    f.status      = status;
+    f.end_of_data = snapshot->isEndOfData();
+    f.nsel        = snapshot->getNSel();
+    f.filename    = snapshot->getFileName();
+    f.fvalue.clear();
+    f.ivalue.clear();
+    f.fview.clear();
+    f.iview.clear();
+    f.crv.clear();
+    f.crv_sel.clear();
+    f.nfarray = f.niarray = 0;         // arrays are kept for the next frame
+    if (status == 0) return;           // end of data; <0 is a frame too (NEMO)
+
+    ComponentRangeVector * crvp = snapshot->getSnapshotRange();
+    if (crvp) f.crv = *crvp;
+    crvp = snapshot->getCrvFromSelection();
+    if (crvp) f.crv_sel = *crvp;
+
+    for (int i=0; float_values[i]; i++) {
+      float v;
+      if (snapshot->getData(float_values[i], &v)) f.fvalue[float_values[i]] = v;
+    }
+    for (int i=0; int_values[i]; i++) {
+      int v;
+      if (snapshot->getData(int_values[i], &v)) f.ivalue[int_values[i]] = v;
+    }
+    // components : "all" first, so that the components which are parts of
+    // the "all" arrays are not copied again, then those of the snapshot
+    // and the selected ones
+    std::vector<std::string> comps;
+    comps.push_back("all");
+    for (unsigned int i=0; i<f.crv.size()+f.crv_sel.size(); i++) {
+      const std::string type = (i<f.crv.size() ? f.crv[i].type :
+                                f.crv_sel[i-f.crv.size()].type);
+      bool found=false;
+      for (unsigned int j=0; j<comps.size(); j++)
+        if (comps[j] == type) found=true;
+      if (!found && type != "") comps.push_back(type);
+    }
+    comps.push_back("");               // getData(prop,...)
+    std::vector<const float *> fsrc;
+    std::vector<const int   *> isrc;
+    std::vector<int> flen, ilen;
+    for (unsigned int c=0; c<comps.size(); c++) {
+      for (int i=0; i<2 && comps[c]!=""; i++) { // getData(comp,"nbody",&n,&f)
+        const char * count = (i==0 ? "nbody" : "nsel");
+        int n=0;
+        float * data=NULL;
+        if (snapshot->getData(comps[c], count, &n, &data)) {
+          CPrefetchView view;
+          view.array  = -1;            // no data
+          view.offset = 0;
+          view.n      = n;
+          f.fview[comps[c]+":"+count] = view;
+        }
+      }
+      for (int i=0; float_props[i].name; i++)
+        if (req_bits & float_props[i].bit)
+          copyFloat(f, comps[c], float_props[i].name, fsrc, flen);
+      for (int i=0; int_props[i].name; i++)
+        if (req_bits & int_props[i].bit)
+          copyInt(f, comps[c], int_props[i].name, isrc, ilen);
+    }
+  }
+  // ============================================================================
+  // copyFloat : copy comp:prop in the frame, or point into an array of the
+  // frame if the snapshot returned a part of an array already copied
+  void CSnapshotPrefetchIn::copyFloat(CPrefetchFrame & f, const std::string comp,
+                                      const std::string prop,
+                                      std::vector<const float *> & src,
+                                      std::vector<int> & len)
+  {
+    int n=0, dim=1;
+    float * data=NULL;
+    bool ok = (comp=="" ? snapshot->getData(prop, &n, &data) :
+                          snapshot->getData(comp, prop, &n, &data));
+    if (!ok || !data || n <= 0) return;
+    for (int i=0; float_props[i].name; i++)
+      if (prop == float_props[i].name) dim = float_props[i].dim;
+    const int size = n*dim;
+    CPrefetchView view;
+    view.n = n;
+    std::less<const float *> lt;
+    for (unsigned int a=0; a<src.size(); a++) {
+      if (!lt(data, src[a]) && !lt(src[a]+len[a], data+size)) {
+        view.array  = a;
+        view.offset = data - src[a];
+        f.fview[comp+":"+prop] = view;
+        return;
+      }
+    }
+    if (f.nfarray == (int) f.farray.size()) f.farray.resize(f.nfarray+1);
+    std::vector<float> & v = f.farray[f.nfarray];
+    v.assign(data, data+size);         // keeps its capacity
+    view.array  = f.nfarray++;
+    view.offset = 0;
+    f.fview[comp+":"+prop] = view;
+    src.push_back(data);
+    len.push_back(size);
+  }
+  // ============================================================================
+  // copyInt : as copyFloat
+  void CSnapshotPrefetchIn::copyInt(CPrefetchFrame & f, const std::string comp,
+                                    const std::string prop,
+                                    std::vector<const int *> & src,
+                                    std::vector<int> & len)
+  {
+    int n=0;
+    int * data=NULL;
+    bool ok = (comp=="" ? snapshot->getData(prop, &n, &data) :
+                          snapshot->getData(comp, prop, &n, &data));
+    if (!ok || !data || n <= 0) return;
+    CPrefetchView view;
+    view.n = n;
+    std::less<const int *> lt;
+    for (unsigned int a=0; a<src.size(); a++) {
+      if (!lt(data, src[a]) && !lt(src[a]+len[a], data+n)) {
+        view.array  = a;
+        view.offset = data - src[a];
+        f.iview[comp+":"+prop] = view;
+        return;
+      }
+    }
+    if (f.niarray == (int) f.iarray.size()) f.iarray.resize(f.niarray+1);
+    f.iarray[f.niarray].assign(data, data+n);
+    view.array  = f.niarray++;
+    view.offset = 0;
+    f.iview[comp+":"+prop] = view;
+    src.push_back(data);
+    len.push_back(n);
+  }
+  // ============================================================================
+  // stopReader
+  void CSnapshotPrefetchIn::stopReader()
+  {
+    if (threaded) {
+      pthread_mutex_lock(&lock);
+      stop = true;
+      pthread_cond_signal(&less);
+      pthread_mutex_unlock(&lock);
+      pthread_join(reader, NULL);      // waits for the frame being read
+      threaded = false;
+      done     = true;
+    }
+  }
+  // ============================================================================
+  // close
+  int CSnapshotPrefetchIn::close()
+  {
+    stopReader();
+    pthread_mutex_lock(&slock);
+    int status = snapshot->close();
+    pthread_mutex_unlock(&slock);
+    return status;
+  }
+  // ============================================================================
+  // getSnapshotRange
+  ComponentRangeVector * CSnapshotPrefetchIn::getSnapshotRange()
+  {
+    if (cur >= 0) return &frame[cur].crv;
+    pthread_mutex_lock(&slock);
+    ComponentRangeVector * crvp = snapshot->getSnapshotRange();
+    pthread_mutex_unlock(&slock);
+    return crvp;
+  }
+  // ============================================================================
+  // getCrvFromSelection
+  ComponentRangeVector * CSnapshotPrefetchIn::getCrvFromSelection()
+  {
+    if (cur >= 0) return &frame[cur].crv_sel;
+    pthread_mutex_lock(&slock);
+    ComponentRangeVector * crvp = snapshot->getCrvFromSelection();
+    pthread_mutex_unlock(&slock);
+    return crvp;
+  }
+  // ============================================================================
+  // getData : from the current frame, or from the snapshot itself before
+  // the first frame
+  bool CSnapshotPrefetchIn::getData(const std::string comp, const std::string prop,
+                                    int * n, float ** data)
+  {
+    if (cur < 0) {
+      pthread_mutex_lock(&slock);
+      bool ok = (comp=="" ? snapshot->getData(prop, n, data) :
+                            snapshot->getData(comp, prop, n, data));
+      pthread_mutex_unlock(&slock);
+      return ok;
+    }
+    CPrefetchFrame & f = frame[cur];
+    std::map<std::string, CPrefetchView>::const_iterator it =
+      f.fview.find((comp=="dm" ? std::string("halo") : comp)+":"+prop);
+    if (it == f.fview.end()) return false;
+    *n    = it->second.n;
+    *data = (it->second.array < 0 ? NULL :
+             &f.farray[it->second.array][it->second.offset]);
+    return true;
+  }
+  // ----------------------------------------------------------------------------
+  bool CSnapshotPrefetchIn::getData(const std::string prop, int * n, float ** data)
+  {
+    return getData("", prop, n, data);
+  }
+  // ----------------------------------------------------------------------------
+  bool CSnapshotPrefetchIn::getData(const std::string comp, const std::string prop,
+                                    int * n, int ** data)
+  {
+    if (cur < 0) {
+      pthread_mutex_lock(&slock);
+      bool ok = (comp=="" ? snapshot->getData(prop, n, data) :
+                            snapshot->getData(comp, prop, n, data));
+      pthread_mutex_unlock(&slock);
+      return ok;
+    }
+    CPrefetchFrame & f = frame[cur];
+    std::map<std::string, CPrefetchView>::const_iterator it =
+      f.iview.find((comp=="dm" ? std::string("halo") : comp)+":"+prop);
+    if (it == f.iview.end()) return false;
+    *n    = it->second.n;
+    *data = &f.iarray[it->second.array][it->second.offset];
+    return true;
+  }
+  // ----------------------------------------------------------------------------
+  bool CSnapshotPrefetchIn::getData(const std::string prop, int * n, int ** data)
+  {
+    return getData("", prop, n, data);
+  }
+  // ----------------------------------------------------------------------------
+  bool CSnapshotPrefetchIn::getData(const std::string prop, float * value)
+  {
+    if (cur < 0) {
+      pthread_mutex_lock(&slock);
+      bool ok = snapshot->getData(prop, value);
+      pthread_mutex_unlock(&slock);
+      return ok;
+    }
+    std::map<std::string, float>::const_iterator it = frame[cur].fvalue.find(prop);
+    if (it == frame[cur].fvalue.end()) return false;
+    *value = it->second;
+    return true;
+  }
+  // ----------------------------------------------------------------------------
+  bool CSnapshotPrefetchIn::getData(const std::string prop, int * value)
+  {
+    if (cur < 0) {
+      pthread_mutex_lock(&slock);
+      bool ok = snapshot->getData(prop, value);
+      pthread_mutex_unlock(&slock);
+      return ok;
+    }
+    std::map<std::string, int>::const_iterator it = frame[cur].ivalue.find(prop);
+    if (it == frame[cur].ivalue.end()) return false;
+    *value = it->second;
+    return true;
+  }
+  // ============================================================================
+  // getFileName
+  std::string CSnapshotPrefetchIn::getFileName()
+  {
+    if (cur >= 0) return frame[cur].filename;
+    pthread_mutex_lock(&slock);
+    std::string name = snapshot->getFileName();
+    pthread_mutex_unlock(&slock);
+    return name;
+  }
+  // ============================================================================
+  // getEps
+  float CSnapshotPrefetchIn::getEps(const std::string comp)
+  {
+    pthread_mutex_lock(&slock);
+    float eps = snapshot->getEps(comp);
+    pthread_mutex_unlock(&slock);
+    return eps;
+  }
+  // ============================================================================
+  // getCod
+  int CSnapshotPrefetchIn::getCod(const std::string select, const float time,
+                                  float * tcod, const std::string base,
+                                  const std::string ext)
+  {
+    pthread_mutex_lock(&slock);
+    int status = snapshot->getCod(select, time, tcod, base, ext);
+    pthread_mutex_unlock(&slock);
+    return status;
+  }
+}
+//
@@ -0,0 +1,117 @@
+// ============================================================================
+// Copyright Jean-Charles LAMBERT - 2008-2014
+//           Centre de donneeS Astrophysiques de Marseille (CeSAM)              
+// e-mail:   Jean-Charles.Lambert@lam.fr                                      
+// address:  Aix Marseille Universite, CNRS, LAM 
+//           Laboratoire d'Astrophysique de Marseille                          
+//           Pole de l'Etoile, site de Chateau-Gombert                         
+//           38, rue Frederic Joliot-Curie                                     
+//           13388 Marseille cedex 13 France                                   
+//           CNRS UMR 7326                                       
+// ============================================================================
+
+// ============================================================================
+// CSnapshotPrefetchIn: reads the frames of any input snapshot (NEMO, Gadget,
+// Ramses, list, simulation) ahead, in a background thread, so that frame k+1
+// is decoded while the caller works on frame k.
+//
+// The data of each frame is copied into one of a pool of frame buffers which
+// are recycled, so the arrays returned by getData() are not reallocated from
+// frame to frame. Arrays returned by getData() stay valid until the next
+// call to nextFrame(). The frames are read with the bits of the first call
+// to nextFrame(): the thread is started by that call.
+//
+//   uns::CunsIn * uns = new uns::CunsIn(simname,select_c,select_t);
+//   uns->prefetch(1);                   // one frame ahead
+//   while (uns->snapshot->nextFrame("mxv")) {
+//     uns->snapshot->getData("halo","pos",&n,&pos);
+//     ...
+//   }
+//
+// UNSIO_PREFETCH=n in the environment does the same for every CunsIn.
+// A caller which does its own selection with nextFrame(UserSelection &),
+// as CSnapshotList does, reads the snapshot directly, without prefetching.
+
+/**
+	@author Jean-Charles Lambert <Jean-Charles.Lambert@lam.fr>
+*/
+#ifndef CSNAPSHOTPREFETCH_H
+#define CSNAPSHOTPREFETCH_H
+#include "snapshotinterface.h"
+#include <map>
+#include <pthread.h>
+
+namespace uns {
+
+  // where getData(comp,prop) finds its data in a frame buffer
+  class CPrefetchView {
+  public:
+    int array;   // index of the array in the frame, -1 for no data
+    int offset;  // first value in the array
+    int n;       // #bodies returned
+  };
+
+  class CPrefetchFrame {
+  public:
+    int status;                         // returned by nextFrame
+    bool end_of_data;
+    int nsel;
+    std::string filename;
+    ComponentRangeVector crv, crv_sel;  // snapshot's and user's ranges
+    std::map<std::string, float> fvalue;
+    std::map<std::string, int  > ivalue;
+    std::map<std::string, CPrefetchView> fview, iview; // "comp:prop"
+    std::vector< std::vector<float> > farray;          // kept from frame to frame
+    std::vector< std::vector<int  > > iarray;
+    int nfarray, niarray;               // arrays in use
+  };
+
+  class CSnapshotPrefetchIn : public CSnapshotInterfaceIn {
+
+  public:
+    CSnapshotPrefetchIn(CSnapshotInterfaceIn *, const int ahead=1,
+                        const bool verb=false);
+    ~CSnapshotPrefetchIn();
+    int nextFrame(std::string bits="");
+    int nextFrame(uns::UserSelection &);
+    int close();
+    ComponentRangeVector * getSnapshotRange();
+    ComponentRangeVector * getCrvFromSelection();
+    bool getData(const std::string,int *,float **);
+    bool getData(const std::string,      float * );
+    bool getData(const std::string,int *,int   **);
+    bool getData(const std::string,      int   * );
+    bool getData(const std::string, const std::string ,int *,float **);
+    bool getData(const std::string, const std::string ,int *,int   **);
+    std::string getFileName();
+    bool isEndOfData() const { return cur<0 ? snapshot->isEndOfData() : end_of_data; }
+    void setNsel(const int _nsel) { nsel = _nsel; snapshot->setNsel(_nsel); }
+    void setReqBits(const unsigned int bits) { req_bits = bits; snapshot->setReqBits(bits); }
+    float getEps(const std::string);
+    int   getCod(const std::string select, const float time,
+                 float * tcod, const std::string base="ANALYSIS/cod",
+                 const std::string ext="cod");
+
+  private:
+    CSnapshotInterfaceIn * snapshot;    // the real one
+    std::vector<CPrefetchFrame> frame;  // ring of buffers
+    int nbuf, head, tail;               // next frame to return, to read
+    int nready, nfree, cur;             // cur: frame held by the caller
+    bool started, stop, done, threaded;
+    std::string req;                    // bits of the frames read
+    pthread_t reader;
+    pthread_mutex_t lock, slock;        // ring, snapshot
+    pthread_cond_t more, less;          // signal frames read, freed
+    static void * startReader(void *);
+    void readFrames();
+    void fillFrame(CPrefetchFrame &, const int);
+    void copyFloat(CPrefetchFrame &, const std::string, const std::string,
+                   std::vector<const float *> &, std::vector<int> &);
+    void copyInt(CPrefetchFrame &, const std::string, const std::string,
+                 std::vector<const int *> &, std::vector<int> &);
+    void stopReader();
+  };
+
+} // namespace
+
+#endif
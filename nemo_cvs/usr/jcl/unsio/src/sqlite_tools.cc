@@ -61,6 +61,17 @@ int CSQLite3::exe(std::string s_exe)
   return ((rc==SQLITE_OK&&ncol>1)?1:0);
 }
 // ----------------------------------------------------------------------------
+// quote : 'it''s' for it's
+std::string CSQLite3::quote(const std::string s)
+{
+  std::string q="'";
+  for (unsigned int i=0; i<s.length(); i++) {
+    if (s[i]=='\'') q += '\'';
+    q += s[i];
+  }
+  return q+"'";
+}
+// ----------------------------------------------------------------------------
 //
 void CSQLite3::display()
 {
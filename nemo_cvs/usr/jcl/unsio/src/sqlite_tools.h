@@ -46,7 +46,9 @@ namespace jclt {
     int exe(std::string s_exe);
     ~CSQLite3();
     bool isOpen() { return db_open;};
+    bool isOk() { return rc==SQLITE_OK;}    // last exe() succeeded
     void display();
+    static std::string quote(const std::string); // as SQL string literal
   };
 
 }
@@ -21,6 +21,8 @@
 #include "snapshotnemo.h"
 #include "snapshotsim.h"
 #include "snapshotlist.h"
+#include "snapshotprefetch.h"
+#include "framecatalog.h"
 #include "userselection.h"
 #include "ctools.h"
 
@@ -112,6 +114,21 @@ void CunsIn::init(const std::string _name ,const std::string _comp ,const std::s
   if (!valid){
     std::cerr << "\nFile ["<< snapshot->getFileName() <<"], unknown UNS file format, aborting.....\n\n";
   }
+  char * prefetch_env = getenv("UNSIO_PREFETCH");
+  if (valid && prefetch_env) {
+    prefetch(atoi(prefetch_env));
+  }
+}
+// ----------------------------------------------------------------------------
+// prefetch : read nframes frames ahead, in a background thread
+bool CunsIn::prefetch(const int nframes)
+{
+  if (!valid || nframes <= 0 ||
+      dynamic_cast<CSnapshotPrefetchIn *>(snapshot) != NULL) {
+    return false;
+  }
+  snapshot = new CSnapshotPrefetchIn(snapshot, nframes, verbose);
+  return true;
 }
 // ----------------------------------------------------------------------------
 // destructor for READING operations
@@ -263,6 +280,7 @@ CunsOut::CunsOut(const std::string _name, const std::string _type, const bool _v
   simtype  = tools::Ctools::fixFortran(_type.c_str(),false);
   verbose = _verb;
   snapshot= NULL;
+  catalog = NULL;
   if (verbose) {
     std::cerr << "CunsOut::CunsOut -- UNSIO version = "<<uns::getVersion()<< "\n";
   }
@@ -280,12 +298,40 @@ CunsOut::CunsOut(const std::string _name, const std::string _type, const bool _v
       std::exit(1);
     }
   }
+  char * catalog_env = getenv("UNSIO_CATALOG");
+  if (catalog_env) {
+    setCatalog(catalog_env);
+  }
 }
 // ----------------------------------------------------------------------------
 // destructor for READING operations
 CunsOut::~CunsOut()
 {
-  if (snapshot) delete snapshot;
+  if (snapshot) delete snapshot;           // and its catalog
+}
+// ----------------------------------------------------------------------------
+// setCatalog
+bool CunsOut::setCatalog(const std::string db)
+{
+#ifndef NOSQLITE3
+  CFrameCatalog * c = new CFrameCatalog(db,verbose);
+  if (!c->isOpen()) {
+    delete c;
+    return false;
+  }
+  CSnapshotCatalogOut * sc = dynamic_cast<CSnapshotCatalogOut *>(snapshot);
+  if (sc) {                                // already indexed, new catalog
+    sc->setCatalog(c);
+  } else {                                 // nemo frames are appended
+    snapshot = new CSnapshotCatalogOut(snapshot,c,simname,simtype,
+                                       simtype=="nemo",verbose);
+  }
+  catalog = c;
+  return true;
+#else
+  std::cerr << "CunsOut::setCatalog unsio compiled without sqlite3, no catalog ["<<db<<"]\n";
+  return false;
+#endif
 }
 // ----------------------------------------------------------------------------
 // setData comp prop farray
@@ -92,6 +92,8 @@ enum StringData {
     ~CunsIn();
     bool isValid() { return valid;}
     uns::CSnapshotInterfaceIn * snapshot; // object to store data
+    // read nframes frames ahead in a background thread (CSnapshotPrefetchIn)
+    bool prefetch(const int nframes=1);
 
     // Map to associate component with a type
     static std::map<std::string, int> s_mapCompInt;
@@ -130,6 +132,8 @@ enum StringData {
     bool verbose;
   };
 
+  class CFrameCatalog;
+
   // class CunsOut                                              
   // manage Unified Nbody Snapshot Output operations            
   class CunsOut {
@@ -165,9 +169,15 @@ enum StringData {
     int save();
     // py wrapper
 
+    // index the frames saved in the SQLite3 catalog db (CFrameCatalog):
+    // snapshot becomes a CSnapshotCatalogOut writing to the real one
+    bool setCatalog(const std::string db);
+    CFrameCatalog * getCatalog() { return catalog; }
+
     static  void initializeStringMap(const bool);
   private:
     std::string simname, simtype;           // OUT
+    CFrameCatalog * catalog;                // owned by snapshot
     
     //bool findSim();
     bool valid;
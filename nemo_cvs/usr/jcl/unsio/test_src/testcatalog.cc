@@ -0,0 +1,132 @@
+// ============================================================================
+// Copyright Jean-Charles LAMBERT - 2026
+// e-mail:   Jean-Charles.Lambert@lam.fr
+// address:  Aix Marseille Universite, CNRS, LAM
+//           Laboratoire d'Astrophysique de Marseille
+//           Pole de l'Etoile, site de Chateau-Gombert
+//           38, rue Frederic Joliot-Curie
+//           13388 Marseille cedex 13 France
+//           CNRS UMR 7326
+// ============================================================================
+// test the catalog of the frames written (CFrameCatalog): write a NEMO
+// snapshot frame by frame and a Gadget snapshot through unsout->snapshot,
+// as most writers do, with a body moving in and out of a caustic ring, and
+// select the frames back with selectTime and selectRing.
+#include <iostream>                                   // C++ I/O
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include "uns.h"
+#include "framecatalog.h"
+
+#define _vectmath_h // put this statement to avoid conflict with C++ vector class
+extern "C" {
+#include <nemo.h>                                     // NEMO basics
+}
+
+using namespace std; // prevent writing statment like 'std::cerr'
+
+// NEMO parameters
+const char * defv[] = {
+  "out=testcatalog\n    basename of the snapshots (.nemo, .gadget) and catalog (.db)",
+  "nframe=6\n           frames of the NEMO snapshot",
+  "nbody=1000\n         particles per frame",
+  "VERSION=1.0\n        compiled on <"__DATE__"> JCL  ",
+  NULL
+};
+const char * usage="test the SQLite3 catalog of the frames written by the uns library";
+
+#ifndef NOSQLITE3
+//------------------------------------------------------------------------------
+// fill : n particles far from ring 1 (a=1,p=0.4), but the first one, which
+// is in its tricusp (centre at R=1.1) in odd frames
+void fill(const int n, const int frame, vector<float> & m, vector<float> & x, vector<float> & v)
+{
+  m.resize(n); x.resize(3*n); v.resize(3*n);
+  for (int i=0; i<n; i++) {
+    m[i] = 1./n;
+    for (int k=0; k<3; k++) {
+      x[3*i+k] = 5.+cos(0.1*i+k+frame);
+      v[3*i+k] = sin(0.3*i-k+frame);
+    }
+  }
+  if (frame%2) {
+    x[0] = 1.1; x[1] = 0.; x[2] = 0.;
+  }
+}
+//------------------------------------------------------------------------------
+// check : frames selected against the frames expected
+void check(const char * what, const int nsel, vector<uns::CFrameEntry> & frames,
+           const int nexp, const float * texp)
+{
+  if (nsel != nexp || (int) frames.size() != nexp)
+    error("%s: %d frame(s) selected, %d expected",what,nsel,nexp);
+  for (int i=0; i<nexp; i++) {
+    if (frames[i].time != texp[i])
+      error("%s: frame at time %g, %g expected",what,frames[i].time,texp[i]);
+    if (i>0 && frames[i].file==frames[i-1].file && frames[i].offset <= frames[i-1].offset)
+      error("%s: frame %d at offset %lld, before the previous one",what,
+            frames[i].frame,frames[i].offset);
+  }
+  cerr << what << ": " << nsel << " frame(s) selected\n";
+}
+#endif
+//------------------------------------------------------------------------------
+// main
+int main(int argc, char ** argv )
+{
+  //   start  NEMO
+  initparam(const_cast<char**>(argv),const_cast<char**>(defv));
+  if (argc) {;} // remove compiler warning :)
+#ifndef NOSQLITE3
+  std::string out = getparam((char *) "out");
+  int nframe = getiparam((char *) "nframe");
+  int nbody  = getiparam((char *) "nbody");
+  vector<float> m, x, v;
+  std::string db = out+".db", nemo = out+".nemo", gadget = out+".gadget";
+  remove(db.c_str());
+  remove(nemo.c_str());
+
+  // NEMO, several frames
+  uns::CunsOut * unsout = new uns::CunsOut(nemo,"nemo");
+  if (!unsout->setCatalog(db)) error("cannot open catalog %s",db.c_str());
+  if (unsout->getCatalog()->addRing(1.,0.4) != 1) error("cannot add ring");
+  for (int i=0; i<nframe; i++) {
+    fill(nbody,i,m,x,v);
+    unsout->snapshot->setData("time",(float) i);
+    unsout->snapshot->setData("all",nbody,&m[0],&x[0],&v[0],false);
+    unsout->snapshot->save();
+  }
+  delete unsout;
+
+  // Gadget, at time 0.5, halo in the ring
+  unsout = new uns::CunsOut(gadget,"gadget2");
+  if (!unsout->setCatalog(db)) error("cannot open catalog %s",db.c_str());
+  fill(nbody,1,m,x,v);
+  unsout->snapshot->setData("time",0.5f);
+  unsout->snapshot->setData("halo",nbody,&m[0],&x[0],&v[0],false);
+  unsout->snapshot->save();
+  delete unsout;
+
+  uns::CFrameCatalog catalog(db);
+  vector<uns::CFrameEntry> frames;
+  const float tall[]  = { 0., 0.5, 1., 2., 3., 4., 5. };
+  const float tmid[]  = { 1., 2., 3. };
+  const float tring[] = { 0.5, 1., 3., 5. };
+  if (nframe == 6) {
+    check("selectTime(0,10)",catalog.selectTime(0.,10.,frames),frames,7,tall);
+    check("selectTime(0.8,3.2)",catalog.selectTime(0.8,3.2,frames),frames,3,tmid);
+    check("selectRing(0,10,1)",catalog.selectRing(0.,10.,1,frames),frames,4,tring);
+    check("selectRing(0,10,2)",catalog.selectRing(0.,10.,2,frames),frames,0,tring);
+  } else {
+    warning("frames only checked for nframe=6");
+  }
+#else
+  warning("uns library compiled without sqlite3, no catalog");
+#endif
+  //   finish NEMO
+  finiparam();
+}
+// ----------- End Of [testcatalog.cc] ------------------------------------
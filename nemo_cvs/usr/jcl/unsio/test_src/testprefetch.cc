@@ -0,0 +1,159 @@
+// ============================================================================
+// Copyright Jean-Charles LAMBERT - 2026
+// e-mail:   Jean-Charles.Lambert@lam.fr                                      
+// address:  Aix Marseille Universite, CNRS, LAM 
+//           Laboratoire d'Astrophysique de Marseille                          
+//           Pole de l'Etoile, site de Chateau-Gombert                         
+//           38, rue Frederic Joliot-Curie                                     
+//           13388 Marseille cedex 13 France                                   
+//           CNRS UMR 7326                                       
+// ============================================================================
+// test the prefetching reader (CSnapshotPrefetchIn): write a NEMO snapshot
+// with several frames and a Gadget snapshot with halo and disk, read them
+// with and without UNSIO_PREFETCH, and compare what getData returns.
+#include <iostream>                                   // C++ I/O     
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include "uns.h"
+
+#define _vectmath_h // put this statement to avoid conflict with C++ vector class
+extern "C" {
+#include <nemo.h>                                     // NEMO basics
+}
+
+using namespace std; // prevent writing statment like 'std::cerr'
+
+// NEMO parameters
+const char * defv[] = {
+  "out=testprefetch\n   basename of the snapshots written (.nemo, .gadget)",
+  "nframe=5\n           frames of the NEMO snapshot",
+  "nhalo=1700\n         halo particles",
+  "ndisk=800\n          disk particles",
+  "VERSION=1.0\n        compiled on <"__DATE__"> JCL  ",
+  NULL
+};
+const char * usage="test the prefetching reader of the uns library";
+
+//------------------------------------------------------------------------------
+// fill : positions, velocities and masses of n particles
+void fill(const int n, const float t, vector<float> & m, vector<float> & x, vector<float> & v)
+{
+  m.resize(n); x.resize(3*n); v.resize(3*n);
+  for (int i=0; i<n; i++) {
+    m[i] = 1./n;
+    for (int k=0; k<3; k++) {
+      x[3*i+k] = cos(0.1*i+k+t);
+      v[3*i+k] = sin(0.3*i-k+t);
+    }
+  }
+}
+//------------------------------------------------------------------------------
+// dump : everything getData returns, frame by frame
+std::string dump(const std::string simname, const bool prefetch)
+{
+  if (prefetch) setenv("UNSIO_PREFETCH","1",1);
+  else          unsetenv("UNSIO_PREFETCH");
+  ostringstream out;
+  out << setprecision(9);
+  const char * comps[] = { "all", "gas", "halo", "disk", "bulge", "stars", "bndry", NULL };
+  const char * fprops[]= { "pos", "vel", "mass", NULL };
+  uns::CunsIn * uns = new uns::CunsIn(simname,"all","all");
+  if (!uns->isValid()) error("unable to read %s",simname.c_str());
+  int nframe=0;
+  while (uns->snapshot->nextFrame("mxvI")) {
+    float time;
+    bool ok = uns->snapshot->getData("time",&time);
+    out << "frame " << nframe++ << " time " << ok << " " << time << "\n";
+    for (int c=0; comps[c]; c++) {
+      int n;
+      float * f;
+      ok = uns->snapshot->getData(comps[c],"nbody",&n,&f);
+      out << comps[c] << " nbody " << ok << " " << (ok ? n : 0) << "\n";
+      for (int p=0; fprops[p]; p++) {
+        ok = uns->snapshot->getData(comps[c],fprops[p],&n,&f);
+        out << comps[c] << " " << fprops[p] << " " << ok;
+        if (ok) {
+          out << " " << n;
+          for (int i=0; i<n*(std::string(fprops[p])=="mass" ? 1 : 3); i++) out << " " << f[i];
+        }
+        out << "\n";
+      }
+      int * id;
+      ok = uns->snapshot->getData(comps[c],"id",&n,&id);
+      out << comps[c] << " id " << ok;
+      if (ok) {
+        out << " " << n;
+        for (int i=0; i<n; i++) out << " " << id[i];
+      }
+      out << "\n";
+    }
+  }
+  delete uns;
+  return out.str();
+}
+//------------------------------------------------------------------------------
+// compare
+void compare(const std::string simname, const int nframe)
+{
+  std::string direct = dump(simname,false);
+  std::string ahead  = dump(simname,true);
+  int nread=0;
+  for (std::string::size_type i=0; (i=direct.find("frame ",i)) != std::string::npos; i++) nread++;
+  if (nread != nframe)
+    error("%s: %d frames read, %d written",simname.c_str(),nread,nframe);
+  if (direct != ahead) {
+    istringstream d(direct), a(ahead);
+    std::string ld, la;
+    while (getline(d,ld) && getline(a,la) && ld==la) ;
+    error("%s: prefetched data differ\n  direct  : %.70s\n  prefetch: %.70s",
+          simname.c_str(),ld.c_str(),la.c_str());
+  }
+  cerr << simname << ": " << nframe << " frame(s), same data with UNSIO_PREFETCH\n";
+}
+//------------------------------------------------------------------------------
+// main
+int main(int argc, char ** argv )
+{
+  //   start  NEMO
+  initparam(const_cast<char**>(argv),const_cast<char**>(defv));
+  if (argc) {;} // remove compiler warning :)
+  std::string out = getparam((char *) "out");
+  int nframe = getiparam((char *) "nframe");
+  int nhalo  = getiparam((char *) "nhalo");
+  int ndisk  = getiparam((char *) "ndisk");
+  vector<float> m, x, v, mh, xh, vh;
+
+  // NEMO, several frames
+  std::string nemo = out+".nemo";
+  remove(nemo.c_str());
+  uns::CunsOut * unsout = new uns::CunsOut(nemo,"nemo");
+  for (int i=0; i<nframe; i++) {
+    fill(nhalo+ndisk,i,m,x,v);
+    unsout->snapshot->setData("time",(float) i);
+    unsout->snapshot->setData("all",nhalo+ndisk,&m[0],&x[0],&v[0],false);
+    unsout->save();
+  }
+  delete unsout;
+  compare(nemo,nframe);
+
+  // Gadget, halo and disk
+  std::string gadget = out+".gadget";
+  unsout = new uns::CunsOut(gadget,"gadget2");
+  fill(nhalo,0.5,mh,xh,vh);
+  fill(ndisk,1.5,m,x,v);
+  unsout->snapshot->setData("time",0.5f);
+  unsout->snapshot->setData("halo",nhalo,&mh[0],&xh[0],&vh[0],false);
+  unsout->snapshot->setData("disk",ndisk,&m[0],&x[0],&v[0],false);
+  unsout->save();
+  delete unsout;
+  compare(gadget,1);
+
+  //   finish NEMO
+  finiparam();
+}
+// ----------- End Of [testprefetch.cc] ------------------------------------
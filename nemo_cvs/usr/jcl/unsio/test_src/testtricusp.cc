@@ -0,0 +1,136 @@
+// ============================================================================
+// Copyright Jean-Charles LAMBERT - 2026
+// e-mail:   Jean-Charles.Lambert@lam.fr
+// address:  Aix Marseille Universite, CNRS, LAM
+//           Laboratoire d'Astrophysique de Marseille
+//           Pole de l'Etoile, site de Chateau-Gombert
+//           38, rue Frederic Joliot-Curie
+//           13388 Marseille cedex 13 France
+//           CNRS UMR 7326
+// ============================================================================
+// test that the frame catalog (CFrameCatalog) and falcON's caustic_crossings
+// manipulator see the same bodies inside a caustic ring: random points around
+// the tricusp are given to the catalog, one body per frame, and the frames
+// it finds in the ring are compared with tricusp.h, the test of the
+// manipulator, and with the tricusp as a polygon from its parametric form.
+#include <iostream>                                   // C++ I/O
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include "uns.h"
+#include "framecatalog.h"
+#include "tricusp.h"
+
+#define _vectmath_h // put this statement to avoid conflict with C++ vector class
+extern "C" {
+#include <nemo.h>                                     // NEMO basics
+}
+
+using namespace std; // prevent writing statment like 'std::cerr'
+
+// NEMO parameters
+const char * defv[] = {
+  "out=testtricusp.db\n catalog written",
+  "npoint=400\n         points (frames) tested",
+  "ring=1.0,0.4\n       radius and width of the caustic ring",
+  "seed=123\n           random seed",
+  "VERSION=1.0\n        compiled on <"__DATE__"> JCL  ",
+  NULL
+};
+const char * usage="test the caustic ring test of the catalog against falcON's";
+
+//------------------------------------------------------------------------------
+// inPolygon : is (R,z) inside the tricusp R = a + p (1-T)(1-2T),
+// z = +/- 2 p T sqrt(T(1-T)), taken as a polygon of 2*nt vertices
+bool inPolygon(const double a, const double p, const double R, const double z)
+{
+  const int nt=2000;
+  vector<double> vr, vz;
+  for (int i=0; i<=nt; i++) {                        // upper half, T 0->1
+    const double T=double(i)/nt;
+    vr.push_back(a+p*(1-T)*(1-2*T));
+    vz.push_back(2*p*T*sqrt(T*(1-T)));
+  }
+  for (int i=nt-1; i>0; i--) {                       // lower half, T 1->0
+    vr.push_back(vr[i]);
+    vz.push_back(-vz[i]);
+  }
+  bool in=false;                                     // ray casting along R
+  for (unsigned int i=0, j=vr.size()-1; i<vr.size(); j=i++)
+    if ((vz[i]>z) != (vz[j]>z) &&
+        R < vr[i]+(vr[j]-vr[i])*(z-vz[i])/(vz[j]-vz[i])) in = !in;
+  return in;
+}
+//------------------------------------------------------------------------------
+// main
+int main(int argc, char ** argv )
+{
+  //   start  NEMO
+  initparam(const_cast<char**>(argv),const_cast<char**>(defv));
+  if (argc) {;} // remove compiler warning :)
+#ifndef NOSQLITE3
+  std::string db = getparam((char *) "out");
+  int npoint = getiparam((char *) "npoint");
+  double ring[2];
+  if (nemoinpd(getparam((char *) "ring"),ring,2) != 2 || ring[0]<=0 || ring[1]<=0)
+    error("ring=%s: need radius and width, both positive",getparam((char *) "ring"));
+  init_xrandom(getparam((char *) "seed"));
+  remove(db.c_str());
+  const double a=ring[0], p=ring[1];
+
+  // points around the tricusp, one per frame at time i
+  vector<float> pos(3*npoint);
+  uns::CFrameCatalog * catalog = new uns::CFrameCatalog(db);
+  if (!catalog->isOpen()) error("cannot open catalog %s",db.c_str());
+  if (catalog->addRing(a,p) != 1) error("cannot add ring");
+  for (int i=0; i<npoint; i++) {
+    const double R=xrandom(a-0.3*p,a+1.2*p), z=xrandom(-0.8*p,0.8*p);
+    const double phi=xrandom(0.,2*M_PI);
+    pos[3*i]   = R*cos(phi);
+    pos[3*i+1] = R*sin(phi);
+    pos[3*i+2] = z;
+    catalog->beginSave("testtricusp.points",true);
+    catalog->setTime(i);
+    catalog->addPos("all",1,&pos[3*i]);
+    if (!catalog->endSave()) error("cannot index frame %d",i);
+  }
+  vector<uns::CFrameEntry> frames;
+  catalog->selectRing(-1.,npoint,1,frames);
+
+  // compare
+  tricusp_t t;
+  tricusp_set(&t,a,p);
+  int nin=0, npoly=0;
+  unsigned int f=0;
+  for (int i=0; i<npoint; i++) {
+    const double R = sqrt(pos[3*i]*pos[3*i]+pos[3*i+1]*pos[3*i+1]);
+    const double z = pos[3*i+2];
+    const bool cat = f<frames.size() && frames[f].time==i;
+    if (cat) f++;
+    const bool fal = tricusp_inside(&t,R,z);
+    if (cat != fal)
+      error("point %d (R=%g,z=%g): catalog says %s, tricusp.h %s",i,R,z,
+            cat ? "in" : "out", fal ? "in" : "out");
+    if (fal) nin++;
+    if (std::abs(tricusp_f(&t,R,z)) < 0.05) continue;  // on the boundary
+    if (inPolygon(a,p,R,z) != fal)
+      error("point %d (R=%g,z=%g): tricusp.h says %s, the parametric form not",
+            i,R,z,fal ? "in" : "out");
+    npoly++;
+  }
+  if (f != frames.size()) error("catalog has %d frames in the ring, %d expected",
+                                (int) frames.size(),nin);
+  if (nin == 0 || nin == npoint) warning("all %d points on one side",npoint);
+  delete catalog;
+  cerr << npoint << " points, " << nin << " inside ring (" << a << "," << p
+       << "): same for the catalog and tricusp.h, " << npoly
+       << " off the boundary same as the parametric form\n";
+#else
+  warning("uns library compiled without sqlite3, no catalog");
+#endif
+  //   finish NEMO
+  finiparam();
+}
+// ----------- End Of [testtricusp.cc] ------------------------------------